@@ -0,0 +1,473 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file AnnotationScene.cpp
+ * @brief 截图标注模型实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "AnnotationScene.h"
+#include "MosaicFilter.h"
+#include "BoxBlur.h"
+#include "ImageBuffer.h"
+#include <QPainter>
+#include <QPen>
+#include <QPainterPath>
+#include <QLineF>
+#include <QPolygonF>
+#include <QFontMetricsF>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+constexpr double kArrowHeadLength = 18.0;   ///< 箭头两翼长度（逻辑像素）
+constexpr double kPi = 3.14159265358979323846;
+constexpr qint64 kDefaultUndoBudget = qint64(64) << 20;   ///< 默认撤销快照预算
+
+constexpr int kMosaicCell = 6;              ///< 马赛克格子边长（逻辑像素）
+
+/**
+ * @brief 马赛克笔刷大小（逻辑像素）
+ */
+int mosaicBlockSize(int thickness)
+{
+    return qMax(4, thickness * 6);
+}
+
+/**
+ * @brief 模糊半径（逻辑像素，三次盒式模糊，近似标准差相同的高斯模糊）
+ */
+int blurRadius(int thickness)
+{
+    return qMax(4, thickness * 3);
+}
+
+/**
+ * @brief 合成图格式：马赛克和模糊在缓冲区中原地计算，需要32位格式
+ */
+QImage compositeBase(const QImage &original)
+{
+    return ImageBuffer::adopt(original);
+}
+
+/**
+ * @brief 箭头两翼的端点
+ */
+void arrowHead(const QPointF &from, const QPointF &to, QPointF *left, QPointF *right)
+{
+    const QLineF line(from, to);
+    const double angle = std::atan2(-line.dy(), line.dx());
+    *left = to + QPointF(-kArrowHeadLength * std::cos(angle + kPi / 6.0), kArrowHeadLength * std::sin(angle + kPi / 6.0));
+    *right = to + QPointF(-kArrowHeadLength * std::cos(angle - kPi / 6.0), kArrowHeadLength * std::sin(angle - kPi / 6.0));
+}
+
+/**
+ * @brief 画笔轨迹第 i 段（points[i] → points[i+1]）追加到路径
+ */
+void appendStrokeSegment(QPainterPath &path, const QVector<QPointF> &points, int i, bool smooth)
+{
+    const QPointF &p1 = points.at(i);
+    const QPointF &p2 = points.at(i + 1);
+    if (!smooth) {
+        path.lineTo(p2);
+        return;
+    }
+    // 均匀Catmull-Rom：端点处以自身代替缺失的相邻点
+    const QPointF &p0 = points.at(qMax(0, i - 1));
+    const QPointF &p3 = points.at(qMin(int(points.size()) - 1, i + 2));
+    path.cubicTo(p1 + (p2 - p0) / 6.0, p2 - (p3 - p1) / 6.0, p2);
+}
+
+/**
+ * @brief 画笔轨迹第 first 到第 last 个控制点之间的路径
+ */
+QPainterPath strokePath(const QVector<QPointF> &points, bool smooth, int first, int last)
+{
+    QPainterPath path(points.at(first));
+    for (int i = first; i < last; ++i) {
+        appendStrokeSegment(path, points, i, smooth);
+    }
+    return path;
+}
+
+} // namespace
+
+QRectF Annotation::bounds() const {
+    if (points.isEmpty()) {
+        return QRectF();
+    }
+    if (type == Text) {
+        const QFontMetricsF fm(font);
+        return fm.boundingRect(text).translated(points.first() + QPointF(0, fm.ascent())).adjusted(-1, -1, 1, 1);
+    }
+
+    if (type == Blur) {
+        // 只改写区域内的像素，外扩1像素容纳预览时的虚线边框
+        return QRectF(points.first(), points.last()).normalized().adjusted(-1, -1, 1, 1);
+    }
+
+    // 平滑曲线可能略超出控制点范围，取贝塞尔控制点的外接矩形
+    QRectF rect = (type == Pen && smooth && points.size() > 1)
+        ? strokePath(points, true, 0, int(points.size()) - 1).controlPointRect()
+        : QPolygonF(points).boundingRect();
+    double margin = thickness / 2.0 + 1.0;
+    if (type == Mosaic) {
+        // 与笔刷相交的格子整体处理，最多超出笔刷一个格子
+        margin = mosaicBlockSize(thickness) / 2.0 + kMosaicCell + 1.0;
+    } else if (type == Arrow) {
+        margin += kArrowHeadLength;
+    }
+    return rect.adjusted(-margin, -margin, margin, margin);
+}
+
+AnnotationScene::AnnotationScene()
+    : m_original()
+    , m_composite()
+    , m_commands()
+    , m_count(0)
+    , m_rendered(0)
+    , m_snapshots()
+    , m_snapshotBytes(0)
+    , m_undoBudget(kDefaultUndoBudget)
+{
+}
+
+AnnotationScene::AnnotationScene(const QImage &original)
+    : m_original(original)
+    , m_composite(compositeBase(original))
+    , m_commands()
+    , m_count(0)
+    , m_rendered(0)
+    , m_snapshots()
+    , m_snapshotBytes(0)
+    , m_undoBudget(kDefaultUndoBudget)
+{
+}
+
+QSize AnnotationScene::displaySize() const {
+    if (m_original.isNull()) {
+        return QSize();
+    }
+    return m_original.size() / m_original.devicePixelRatio();
+}
+
+void AnnotationScene::setUndoBudget(qint64 bytes) {
+    m_undoBudget = qMax<qint64>(0, bytes);
+    trimSnapshots();
+}
+
+void AnnotationScene::push(const Annotation &annotation, const QImage &raster) {
+    // 先把尚未生效的撤销写回合成图（此时还需要被撤销命令的快照），之后 m_rendered == m_count
+    composite();
+
+    // 新命令使可重做的命令及其快照失效
+    for (int i = m_count; i < m_snapshots.size(); ++i) {
+        dropSnapshot(i);
+    }
+    m_commands.resize(m_count);
+    m_snapshots.resize(m_count);
+    m_commands.append(annotation);
+    m_snapshots.append(TileSnapshot());
+    ++m_count;
+
+    const bool canBlit = !raster.isNull() && !m_original.isNull() && annotation.type != Annotation::Mosaic
+        && annotation.type != Annotation::Blur
+        && m_rendered == m_count - 1 && raster.size() == m_composite.size()
+        && qFuzzyCompare(raster.devicePixelRatio(), m_composite.devicePixelRatio());
+    if (!canBlit) {
+        composite();
+        return;
+    }
+
+    // 叠加已光栅化的图形：与直接绘制等价（透明背景上的同一图形按SourceOver合成）
+    const QRectF bounds = annotation.bounds();
+    captureTiles(m_count - 1, bounds);
+    const QRect rect = bounds.toAlignedRect().intersected(QRect(QPoint(0, 0), displaySize()));
+    if (!rect.isEmpty()) {
+        const qreal dpr = raster.devicePixelRatio();
+        QPainter painter(&m_composite);
+        painter.drawImage(QRectF(rect), raster, QRectF(QPointF(rect.topLeft()) * dpr, QSizeF(rect.size()) * dpr));
+    }
+    ++m_rendered;
+    trimSnapshots();
+}
+
+QRectF AnnotationScene::extend(const QPointF &point) {
+    if (m_count == 0 || m_count != m_commands.size()) {
+        return QRectF();
+    }
+    Annotation &annotation = m_commands[m_count - 1];
+    annotation.points.append(point);
+    if (m_rendered != m_count) {
+        return QRectF();
+    }
+    const QRectF changed = render(m_count - 1, annotation.points.size() - 1);
+    trimSnapshots();
+    return changed;
+}
+
+bool AnnotationScene::undo() {
+    if (!canUndo()) {
+        return false;
+    }
+    --m_count;
+    return true;
+}
+
+bool AnnotationScene::redo() {
+    if (!canRedo()) {
+        return false;
+    }
+    ++m_count;
+    return true;
+}
+
+const QImage &AnnotationScene::composite() const {
+    if (m_original.isNull()) {
+        return m_original;
+    }
+    // 撤销：依次写回被撤销命令绘制前的分块，快照已被丢弃时改为重放
+    int restoredTiles = 0;
+    while (m_rendered > m_count) {
+        TileSnapshot &snapshot = m_snapshots[m_rendered - 1];
+        if (!snapshot.isValid()) {
+            replay();
+            return m_composite;
+        }
+        restoredTiles += snapshot.restore(m_composite);
+        dropSnapshot(m_rendered - 1);
+        --m_rendered;
+    }
+    if (restoredTiles > 0) {
+        qDebug() << "[Annotation] Undo restored" << restoredTiles << "tiles";
+    }
+
+    // 新增或重做：只绘制尚未绘制的命令
+    while (m_rendered < m_count) {
+        render(m_rendered++);
+    }
+    trimSnapshots();
+    return m_composite;
+}
+
+QImage AnnotationScene::flatten() const {
+    if (m_count == 0) {
+        return m_original;
+    }
+    return composite();
+}
+
+void AnnotationScene::paint(QPainter &painter, const Annotation &annotation) {
+    const QVector<QPointF> &pts = annotation.points;
+    if (pts.isEmpty() || annotation.type == Annotation::Mosaic) {
+        return;
+    }
+
+    painter.save();
+    painter.setRenderHint(QPainter::Antialiasing);
+    if (annotation.type == Annotation::Text) {
+        painter.setPen(annotation.color);
+        painter.setFont(annotation.font);
+        const QFontMetricsF fm(annotation.font);
+        painter.drawText(pts.first() + QPointF(0, fm.ascent()), annotation.text);
+        painter.restore();
+        return;
+    }
+
+    QPen pen(annotation.color);
+    pen.setWidth(annotation.thickness);
+    pen.setCapStyle(Qt::RoundCap);
+    pen.setJoinStyle(Qt::RoundJoin);
+    painter.setPen(pen);
+    painter.setBrush(Qt::NoBrush);
+
+    const QPointF start = pts.first();
+    const QPointF end = pts.last();
+    switch (annotation.type) {
+    case Annotation::Pen:
+        paintStroke(painter, annotation, 0, int(pts.size()) - 1);
+        break;
+    case Annotation::Line:
+        painter.drawLine(start, end);
+        break;
+    case Annotation::Arrow: {
+        QPointF left;
+        QPointF right;
+        arrowHead(start, end, &left, &right);
+        painter.drawLine(start, end);
+        painter.drawLine(end, left);
+        painter.drawLine(end, right);
+        break;
+    }
+    case Annotation::Ellipse:
+        painter.drawEllipse(QRectF(start, end).normalized());
+        break;
+    case Annotation::Rect:
+        painter.drawRect(QRectF(start, end).normalized());
+        break;
+    case Annotation::Blur:
+        // 模糊本身由 render() 在合成图上计算，这里只画出区域（拖动中的预览）
+        painter.setRenderHint(QPainter::Antialiasing, false);
+        painter.setPen(QPen(Qt::white, 1, Qt::DashLine));
+        painter.setBrush(QColor(0, 0, 0, 48));
+        painter.drawRect(QRectF(start, end).normalized());
+        break;
+    default:
+        break;
+    }
+    painter.restore();
+}
+
+void AnnotationScene::paintStroke(QPainter &painter, const Annotation &annotation, int first, int last) {
+    const QVector<QPointF> &pts = annotation.points;
+    first = qMax(0, first);
+    last = qMin(last, int(pts.size()) - 1);
+    if (first >= last) {
+        return;
+    }
+
+    const QPainterPath path = strokePath(pts, annotation.smooth, first, last);
+    QPen pen(annotation.color);
+    pen.setWidth(annotation.thickness);
+    pen.setCapStyle(Qt::RoundCap);
+    pen.setJoinStyle(Qt::RoundJoin);
+    painter.save();
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(pen);
+    painter.setBrush(Qt::NoBrush);
+    painter.drawPath(path);
+    painter.restore();
+}
+
+QRectF AnnotationScene::render(int index, int from) const {
+    const Annotation &annotation = m_commands.at(index);
+    if (annotation.type == Annotation::Pen && from > 0) {
+        // 拖动中的画笔只补画新增的一段
+        Annotation part = annotation;
+        part.points = annotation.points.mid(qMax(0, from - 2));
+        const QRectF bounds = part.bounds();
+        captureTiles(index, bounds);
+        QPainter painter(&m_composite);
+        paintStroke(painter, annotation, from - 1, from);
+        return bounds;
+    }
+
+    if (annotation.type == Annotation::Mosaic) {
+        // 新增的点与前一个点之间的整段路径都要处理，快速拖动时不留空隙
+        Annotation part = annotation;
+        part.points = annotation.points.mid(qMax(0, from - 1));
+        const QRectF bounds = part.bounds();
+        captureTiles(index, bounds);
+        const QVector<QPointF> &pts = annotation.points;
+        if (from == 0 && !pts.isEmpty()) {
+            applyMosaic(pts.first(), annotation.thickness);
+        }
+        for (int i = qMax(1, from); i < pts.size(); ++i) {
+            sweepMosaic(pts.at(i - 1), pts.at(i), annotation.thickness);
+        }
+        return bounds;
+    }
+
+    const QRectF bounds = annotation.bounds();
+    captureTiles(index, bounds);
+    if (annotation.type == Annotation::Blur) {
+        applyBlur(QRectF(annotation.points.first(), annotation.points.last()).normalized(), annotation.thickness);
+        return bounds;
+    }
+    QPainter painter(&m_composite);
+    paint(painter, annotation);
+    return bounds;
+}
+
+void AnnotationScene::captureTiles(int index, const QRectF &bounds) const {
+    if (m_undoBudget <= 0) {
+        return;
+    }
+    const qreal dpr = m_composite.devicePixelRatio();
+    const QRect deviceRect = QRectF(bounds.topLeft() * dpr, bounds.size() * dpr).toAlignedRect();
+    TileSnapshot &snapshot = m_snapshots[index];
+    const qint64 before = snapshot.byteSize();
+    snapshot.capture(m_composite, deviceRect);
+    m_snapshotBytes += snapshot.byteSize() - before;
+}
+
+void AnnotationScene::replay() const {
+    // 从原图重放（共享原图，首次绘制时才复制像素）
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < m_snapshots.size(); ++i) {
+        dropSnapshot(i);
+    }
+    m_composite = compositeBase(m_original);
+    m_rendered = 0;
+    while (m_rendered < m_count) {
+        render(m_rendered++);
+    }
+    trimSnapshots();
+    qDebug() << "[Annotation] Replayed" << m_count << "commands in" << timer.elapsed() << "ms";
+}
+
+void AnnotationScene::trimSnapshots() const {
+    // 最近绘制的命令可能仍在拖动中追加分块，它的快照始终保留（单条命令超出预算时预算暂时超出）
+    for (int i = 0; i < m_rendered - 1 && m_snapshotBytes > m_undoBudget; ++i) {
+        if (m_snapshots.at(i).isValid()) {
+            dropSnapshot(i);
+            qDebug() << "[Annotation] Undo budget exceeded, dropped snapshot of command" << i;
+        }
+    }
+}
+
+void AnnotationScene::dropSnapshot(int index) const {
+    TileSnapshot &snapshot = m_snapshots[index];
+    m_snapshotBytes -= snapshot.byteSize();
+    snapshot.clear();
+}
+
+void AnnotationScene::sweepMosaic(const QPointF &from, const QPointF &to, int thickness) const {
+    // 以半个笔刷为步长沿线段推进，相邻笔刷重叠的格子重复处理结果不变
+    const double step = qMax(1.0, mosaicBlockSize(thickness) / 2.0);
+    const int steps = qMax(1, int(std::ceil(QLineF(from, to).length() / step)));
+    for (int k = 1; k <= steps; ++k) {
+        applyMosaic(from + (to - from) * (double(k) / steps), thickness);
+    }
+}
+
+void AnnotationScene::applyMosaic(const QPointF &center, int thickness) const {
+    // 笔刷和格子都换算为设备像素，高DPI截图上格子大小与屏幕显示一致
+    const qreal dpr = m_composite.devicePixelRatio();
+    const double block = mosaicBlockSize(thickness) * dpr;
+    const QPointF c = center * dpr;
+    const QRect dab = QRectF(c.x() - block / 2.0, c.y() - block / 2.0, block, block).toAlignedRect();
+    MosaicFilter::pixelate(m_composite, dab, qMax(1, qRound(kMosaicCell * dpr)));
+}
+
+void AnnotationScene::applyBlur(const QRectF &area, int thickness) const {
+    // 区域和半径换算为设备像素，高DPI截图上模糊程度与屏幕显示一致
+    const qreal dpr = m_composite.devicePixelRatio();
+    const QRect rect = QRectF(area.topLeft() * dpr, area.size() * dpr).toAlignedRect();
+    QElapsedTimer timer;
+    timer.start();
+    const QRect blurred = BoxBlur::blur(m_composite, rect, qMax(1, qRound(blurRadius(thickness) * dpr)));
+    qDebug() << "[Annotation] Blurred" << blurred.size() << "in" << timer.elapsed() << "ms";
+}
@@ -0,0 +1,247 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file AnnotationScene.h
+ * @brief 截图标注模型：原图 + 矢量标注命令列表
+ *
+ * 编辑窗口中的画笔、直线、箭头、圆形、矩形、马赛克、模糊和文字都记录为命令，
+ * 原图始终不变，合成图按需增量绘制，只在导出时展平
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef ANNOTATIONSCENE_H
+#define ANNOTATIONSCENE_H
+
+#include <QImage>
+#include <QColor>
+#include <QFont>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QVector>
+#include "TileSnapshot.h"
+
+class QPainter;
+class QPainterPath;
+
+/**
+ * @struct Annotation
+ * @brief 一条标注命令（逻辑坐标，与编辑窗口中的坐标一致）
+ */
+struct Annotation
+{
+    /**
+     * @brief 标注类型
+     */
+    enum Type {
+        Pen,        ///< 画笔：points为轨迹（smooth时按Catmull-Rom样条平滑）
+        Line,       ///< 直线：points为起点和终点
+        Arrow,      ///< 箭头：points为起点和终点（箭头在终点）
+        Ellipse,    ///< 圆形：points为外接矩形的两个对角
+        Rect,       ///< 矩形：points为两个对角
+        Mosaic,     ///< 马赛克：points为拖动经过的中心点
+        Blur,       ///< 模糊：points为区域的两个对角（thickness决定模糊半径）
+        Text        ///< 文字：points[0]为左上角
+    };
+
+    Type type = Pen;            ///< 类型
+    QColor color;               ///< 颜色
+    int thickness = 3;          ///< 线宽（马赛克为块大小系数，模糊为半径系数）
+    bool smooth = false;        ///< 画笔轨迹是否平滑
+    QVector<QPointF> points;    ///< 控制点
+    QString text;               ///< 文字内容
+    QFont font;                 ///< 文字字体
+
+    /**
+     * @brief 绘制后可能改变的区域（逻辑坐标，含线宽和箭头）
+     */
+    QRectF bounds() const;
+};
+
+/**
+ * @class AnnotationScene
+ * @brief 原图之上的标注命令列表
+ *
+ * - 原图只共享不修改，没有标注时 flatten() 直接返回原图（cacheKey不变，另存为可直接复制历史文件）
+ * - 合成图缓存已应用的命令，新增命令只在缓存上绘制这一条
+ * - 撤销/重做只移动命令列表中的位置，合成图在下次取用时更新：
+ *   撤销写回该命令绘制前保存的分块（TileSnapshot），重做则增量绘制
+ * - 分块快照总量受字节预算限制，超出时丢弃最旧的快照；
+ *   更早的命令仍可撤销，只是改为由原图重放（马赛克和模糊依赖其下方的像素，按命令顺序重放结果相同）
+ */
+class AnnotationScene
+{
+public:
+    AnnotationScene();
+
+    /**
+     * @brief 构造函数
+     * @param original 原图（共享，不复制）
+     */
+    explicit AnnotationScene(const QImage &original);
+
+    /**
+     * @brief 原图
+     */
+    const QImage &original() const { return m_original; }
+
+    /**
+     * @brief 逻辑尺寸（像素尺寸除以设备像素比）
+     */
+    QSize displaySize() const;
+
+    /**
+     * @brief 当前生效的命令数
+     */
+    int count() const { return m_count; }
+
+    bool isEmpty() const { return m_count == 0; }
+    bool canUndo() const { return m_count > 0; }
+    bool canRedo() const { return m_count < m_commands.size(); }
+
+    /**
+     * @brief 设置撤销快照的字节预算
+     * @param bytes 字节数（0表示不保存快照，撤销总是重放）
+     */
+    void setUndoBudget(qint64 bytes);
+
+    /**
+     * @brief 当前撤销快照占用的字节数
+     */
+    qint64 undoBytes() const { return m_snapshotBytes; }
+
+    /**
+     * @brief 追加命令（丢弃可重做的命令），立即绘制到合成图
+     *
+     * 提供 raster 时（编辑窗口拖动中已绘制好的预览层，只含这一个图形），
+     * 若其尺寸和设备像素比与合成图一致，直接把图形区域叠加到合成图，不再重新光栅化
+     *
+     * @param annotation 命令
+     * @param raster 已光栅化的图形（透明背景，与合成图同尺寸），可为空
+     */
+    void push(const Annotation &annotation, const QImage &raster = QImage());
+
+    /**
+     * @brief 为最后一条命令追加控制点（拖动中的画笔、马赛克），只绘制新增部分
+     * @param point 控制点
+     * @return 合成图中改动的区域（逻辑坐标）
+     */
+    QRectF extend(const QPointF &point);
+
+    /**
+     * @brief 撤销最后一条命令
+     * @return 是否有可撤销的命令
+     */
+    bool undo();
+
+    /**
+     * @brief 重做最近撤销的命令
+     * @return 是否有可重做的命令
+     */
+    bool redo();
+
+    /**
+     * @brief 原图与当前命令的合成图（按需更新）
+     */
+    const QImage &composite() const;
+
+    /**
+     * @brief 展平为导出用的图像
+     * @return 没有标注时为原图本身，否则为合成图（共享像素）
+     */
+    QImage flatten() const;
+
+    /**
+     * @brief 绘制一条非马赛克命令（模糊命令只绘制区域边框，供拖动中预览）
+     * @param painter 绘图器（逻辑坐标）
+     * @param annotation 命令
+     */
+    static void paint(QPainter &painter, const Annotation &annotation);
+
+    /**
+     * @brief 绘制画笔轨迹中的一段（第 first 到第 last 个控制点之间）
+     *
+     * 平滑时每段是经过相邻控制点的Catmull-Rom样条（转为三次贝塞尔），
+     * 第 i 段只依赖第 i-1 到 i+2 个控制点，拖动中新增控制点后只需补画前一段
+     *
+     * @param painter 绘图器（逻辑坐标）
+     * @param annotation 画笔命令
+     * @param first 起始控制点
+     * @param last 结束控制点
+     */
+    static void paintStroke(QPainter &painter, const Annotation &annotation, int first, int last);
+
+private:
+    /**
+     * @brief 把第 index 条命令从第 from 个控制点开始的部分绘制到合成图，先保存将被改动的分块
+     * @return 改动的区域（逻辑坐标）
+     */
+    QRectF render(int index, int from = 0) const;
+
+    /**
+     * @brief 保存第 index 条命令将改动的分块
+     * @param bounds 改动区域（逻辑坐标）
+     */
+    void captureTiles(int index, const QRectF &bounds) const;
+
+    /**
+     * @brief 从原图重放全部生效的命令
+     */
+    void replay() const;
+
+    /**
+     * @brief 超出预算时从最旧的命令开始丢弃快照
+     */
+    void trimSnapshots() const;
+
+    /**
+     * @brief 丢弃一条命令的快照
+     */
+    void dropSnapshot(int index) const;
+
+    /**
+     * @brief 沿线段对合成图应用马赛克（不含起点）
+     */
+    void sweepMosaic(const QPointF &from, const QPointF &to, int thickness) const;
+
+    /**
+     * @brief 在合成图上对一个中心点应用马赛克（MosaicFilter原地处理，格子按设备像素对齐）
+     */
+    void applyMosaic(const QPointF &center, int thickness) const;
+
+    /**
+     * @brief 在合成图上模糊一个区域（BoxBlur原地处理，区域按设备像素对齐）
+     */
+    void applyBlur(const QRectF &area, int thickness) const;
+
+private:
+    QImage m_original;                  ///< 原图（共享，不修改）
+    mutable QImage m_composite;         ///< 合成图缓存
+    QVector<Annotation> m_commands;     ///< 命令列表（m_count之后为可重做的命令）
+    int m_count;                        ///< 生效的命令数
+    mutable int m_rendered;             ///< 合成图中已绘制的命令数
+    mutable QVector<TileSnapshot> m_snapshots;  ///< 每条命令绘制前的分块内容（与m_commands对应）
+    mutable qint64 m_snapshotBytes;     ///< 快照总字节数
+    qint64 m_undoBudget;                ///< 快照字节预算
+};
+
+#endif // ANNOTATIONSCENE_H
@@ -0,0 +1,417 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file BoxBlur.cpp
+ * @brief 多次可分离盒式模糊实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "BoxBlur.h"
+#include "SimdSupport.h"
+#include "ImageBuffer.h"
+#include "ParallelBands.h"
+#include <QVector>
+#include <cstring>
+
+namespace {
+
+constexpr int kMaxRadius = 1 << 20;    ///< 半径上限（窗口和不超出32位）
+constexpr int kFixedShift = 24;     ///< 标量除法的定点精度（窗口和最大为 255 × 窗口宽度）
+
+/**
+ * @brief 窗口宽度的倒数：标量路径用定点数，SIMD路径用浮点数
+ */
+struct Divisor
+{
+    quint64 fixed;  ///< 2^kFixedShift / 窗口宽度
+    float scale;    ///< 1 / 窗口宽度
+};
+
+Divisor divisorFor(int radius)
+{
+    const int window = 2 * radius + 1;
+    return Divisor{ (quint64(1) << kFixedShift) / quint64(window), 1.0f / float(window) };
+}
+
+inline quint32 channel(quint32 px, int c)
+{
+    return (px >> (c * 8)) & 0xff;
+}
+
+inline quint32 averageScalar(const qint32 *sum, const Divisor &div)
+{
+    quint32 value = 0;
+    for (int c = 0; c < 4; ++c) {
+        const quint64 avg = (quint64(sum[c]) * div.fixed + (quint64(1) << (kFixedShift - 1))) >> kFixedShift;
+        value |= quint32(qMin<quint64>(avg, 255)) << (c * 8);
+    }
+    return value;
+}
+
+/**
+ * @brief 把一行（或一行中的一段）按权重累加到各通道和中（acc[x * 4 + c]）
+ */
+void accumulateRow(qint32 *acc, const quint32 *row, int width, qint32 weight)
+{
+    for (int x = 0; x < width; ++x) {
+        for (int c = 0; c < 4; ++c) {
+            acc[x * 4 + c] += qint32(channel(row[x], c)) * weight;
+        }
+    }
+}
+
+/**
+ * @brief 窗口在 x = 0 处的初始和：左侧越界的 radius 个像素取 src[0]，右侧越界的取最后一个像素
+ */
+void initialWindow(const quint32 *src, int width, int radius, qint32 *sum)
+{
+    const int last = width - 1;
+    const int inside = qMin(radius, last);
+    std::memset(sum, 0, 4 * sizeof(qint32));
+    accumulateRow(sum, src, 1, radius + 1);
+    for (int k = 1; k <= inside; ++k) {
+        accumulateRow(sum, src + k, 1, 1);
+    }
+    if (radius > last) {
+        accumulateRow(sum, src + last, 1, radius - last);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 水平方向：窗口和沿行滑动，每个像素加入一个、移出一个
+// ---------------------------------------------------------------------------
+
+void boxRowScalar(const quint32 *src, quint32 *dst, int width, int radius, const Divisor &div)
+{
+    const int last = width - 1;
+    qint32 sum[4];
+    initialWindow(src, width, radius, sum);
+    for (int x = 0; x < width; ++x) {
+        dst[x] = averageScalar(sum, div);
+        const quint32 in = src[qMin(x + radius + 1, last)];
+        const quint32 out = src[qMax(x - radius, 0)];
+        for (int c = 0; c < 4; ++c) {
+            sum[c] += qint32(channel(in, c)) - qint32(channel(out, c));
+        }
+    }
+}
+
+#if defined(CAPSTEP_SIMD_SSE2)
+inline __m128i expandPixelSse2(quint32 px)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(px)), zero);
+    return _mm_unpacklo_epi16(v, zero);
+}
+
+inline __m128i divideSse2(__m128i sum, __m128 scale)
+{
+    return _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(sum), scale));
+}
+
+/**
+ * @brief SSE2：4个通道的和放在一个寄存器中，逐像素滑动
+ */
+void boxRowSse2(const quint32 *src, quint32 *dst, int width, int radius, const Divisor &div)
+{
+    const int last = width - 1;
+    const __m128 scale = _mm_set1_ps(div.scale);
+    qint32 init[4];
+    initialWindow(src, width, radius, init);
+    __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i *>(init));
+    for (int x = 0; x < width; ++x) {
+        __m128i q = divideSse2(sum, scale);
+        q = _mm_packs_epi32(q, q);
+        dst[x] = quint32(_mm_cvtsi128_si32(_mm_packus_epi16(q, q)));
+        sum = _mm_add_epi32(sum, expandPixelSse2(src[qMin(x + radius + 1, last)]));
+        sum = _mm_sub_epi32(sum, expandPixelSse2(src[qMax(x - radius, 0)]));
+    }
+}
+#endif
+
+#if defined(CAPSTEP_SIMD_NEON)
+inline int32x4_t expandPixelNeon(quint32 px)
+{
+    const uint16x8_t v = vmovl_u8(vcreate_u8(px));
+    return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v)));
+}
+
+inline uint32x4_t divideNeon(int32x4_t sum, float32x4_t scale)
+{
+    // vcvtq_u32_f32向零取整，先加0.5实现四舍五入
+    return vcvtq_u32_f32(vaddq_f32(vmulq_f32(vcvtq_f32_s32(sum), scale), vdupq_n_f32(0.5f)));
+}
+
+void boxRowNeon(const quint32 *src, quint32 *dst, int width, int radius, const Divisor &div)
+{
+    const int last = width - 1;
+    const float32x4_t scale = vdupq_n_f32(div.scale);
+    qint32 init[4];
+    initialWindow(src, width, radius, init);
+    int32x4_t sum = vld1q_s32(init);
+    for (int x = 0; x < width; ++x) {
+        const uint16x4_t q = vmovn_u32(divideNeon(sum, scale));
+        const uint8x8_t bytes = vmovn_u16(vcombine_u16(q, q));
+        dst[x] = vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+        sum = vaddq_s32(sum, expandPixelNeon(src[qMin(x + radius + 1, last)]));
+        sum = vsubq_s32(sum, expandPixelNeon(src[qMax(x - radius, 0)]));
+    }
+}
+#endif
+
+using BoxRowFn = void (*)(const quint32 *, quint32 *, int, int, const Divisor &);
+
+BoxRowFn selectBoxRow()
+{
+#if defined(CAPSTEP_SIMD_SSE2)
+    if (SimdSupport::hasSse2()) {
+        return boxRowSse2;
+    }
+#endif
+#if defined(CAPSTEP_SIMD_NEON)
+    if (SimdSupport::hasNeon()) {
+        return boxRowNeon;
+    }
+#endif
+    return boxRowScalar;
+}
+
+// ---------------------------------------------------------------------------
+// 垂直方向：一段列的窗口和放在数组中，逐行整行加入、移出，天然适合向量化
+// ---------------------------------------------------------------------------
+
+/**
+ * @brief 输出一行并把窗口下移一行（标量，处理 [from, width) 的像素）
+ */
+void slideRowScalar(qint32 *acc, quint32 *dst, const quint32 *in, const quint32 *out,
+                    int from, int width, const Divisor &div)
+{
+    for (int x = from; x < width; ++x) {
+        qint32 *sum = acc + x * 4;
+        dst[x] = averageScalar(sum, div);
+        for (int c = 0; c < 4; ++c) {
+            sum[c] += qint32(channel(in[x], c)) - qint32(channel(out[x], c));
+        }
+    }
+}
+
+#if defined(CAPSTEP_SIMD_SSE2)
+/**
+ * @brief SSE2：每次4个像素（16个通道和），差值在16位中计算后符号扩展累加
+ * @return 已处理的像素数
+ */
+int slideRowSse2(qint32 *acc, quint32 *dst, const quint32 *in, const quint32 *out, int width, const Divisor &div)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(div.scale);
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i *sum = reinterpret_cast<__m128i *>(acc + x * 4);
+        __m128i a0 = _mm_loadu_si128(sum);
+        __m128i a1 = _mm_loadu_si128(sum + 1);
+        __m128i a2 = _mm_loadu_si128(sum + 2);
+        __m128i a3 = _mm_loadu_si128(sum + 3);
+
+        const __m128i lo = _mm_packs_epi32(divideSse2(a0, scale), divideSse2(a1, scale));
+        const __m128i hi = _mm_packs_epi32(divideSse2(a2, scale), divideSse2(a3, scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(lo, hi));
+
+        const __m128i pin = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + x));
+        const __m128i pout = _mm_loadu_si128(reinterpret_cast<const __m128i *>(out + x));
+        const __m128i dlo = _mm_sub_epi16(_mm_unpacklo_epi8(pin, zero), _mm_unpacklo_epi8(pout, zero));
+        const __m128i dhi = _mm_sub_epi16(_mm_unpackhi_epi8(pin, zero), _mm_unpackhi_epi8(pout, zero));
+        const __m128i slo = _mm_srai_epi16(dlo, 15);
+        const __m128i shi = _mm_srai_epi16(dhi, 15);
+        a0 = _mm_add_epi32(a0, _mm_unpacklo_epi16(dlo, slo));
+        a1 = _mm_add_epi32(a1, _mm_unpackhi_epi16(dlo, slo));
+        a2 = _mm_add_epi32(a2, _mm_unpacklo_epi16(dhi, shi));
+        a3 = _mm_add_epi32(a3, _mm_unpackhi_epi16(dhi, shi));
+        _mm_storeu_si128(sum, a0);
+        _mm_storeu_si128(sum + 1, a1);
+        _mm_storeu_si128(sum + 2, a2);
+        _mm_storeu_si128(sum + 3, a3);
+    }
+    return x;
+}
+#endif
+
+#if defined(CAPSTEP_SIMD_NEON)
+int slideRowNeon(qint32 *acc, quint32 *dst, const quint32 *in, const quint32 *out, int width, const Divisor &div)
+{
+    const float32x4_t scale = vdupq_n_f32(div.scale);
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        qint32 *sum = acc + x * 4;
+        int32x4_t a0 = vld1q_s32(sum);
+        int32x4_t a1 = vld1q_s32(sum + 4);
+        int32x4_t a2 = vld1q_s32(sum + 8);
+        int32x4_t a3 = vld1q_s32(sum + 12);
+
+        const uint16x8_t lo = vcombine_u16(vmovn_u32(divideNeon(a0, scale)), vmovn_u32(divideNeon(a1, scale)));
+        const uint16x8_t hi = vcombine_u16(vmovn_u32(divideNeon(a2, scale)), vmovn_u32(divideNeon(a3, scale)));
+        vst1q_u8(reinterpret_cast<uint8_t *>(dst + x), vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+
+        const uint8x16_t pin = vld1q_u8(reinterpret_cast<const uint8_t *>(in + x));
+        const uint8x16_t pout = vld1q_u8(reinterpret_cast<const uint8_t *>(out + x));
+        const int16x8_t dlo = vreinterpretq_s16_u16(vsubl_u8(vget_low_u8(pin), vget_low_u8(pout)));
+        const int16x8_t dhi = vreinterpretq_s16_u16(vsubl_u8(vget_high_u8(pin), vget_high_u8(pout)));
+        vst1q_s32(sum, vaddw_s16(a0, vget_low_s16(dlo)));
+        vst1q_s32(sum + 4, vaddw_s16(a1, vget_high_s16(dlo)));
+        vst1q_s32(sum + 8, vaddw_s16(a2, vget_low_s16(dhi)));
+        vst1q_s32(sum + 12, vaddw_s16(a3, vget_high_s16(dhi)));
+    }
+    return x;
+}
+#endif
+
+/**
+ * @brief 一段列（每行从 column 开始的 width 个像素）的一次垂直盒式模糊
+ */
+void boxColumns(const uchar *srcBits, uchar *dstBits, qsizetype stride, int column, int width, int height,
+                int radius, const Divisor &div, qint32 *acc, bool sse2, bool neon)
+{
+    const auto srcRow = [&](int y) {
+        return reinterpret_cast<const quint32 *>(srcBits + y * stride) + column;
+    };
+    const int last = height - 1;
+
+    std::memset(acc, 0, size_t(width) * 4 * sizeof(qint32));
+    accumulateRow(acc, srcRow(0), width, radius + 1);
+    for (int k = 1; k <= qMin(radius, last); ++k) {
+        accumulateRow(acc, srcRow(k), width, 1);
+    }
+    if (radius > last) {
+        accumulateRow(acc, srcRow(last), width, radius - last);
+    }
+
+    for (int y = 0; y < height; ++y) {
+        quint32 *dst = reinterpret_cast<quint32 *>(dstBits + y * stride) + column;
+        const quint32 *in = srcRow(qMin(y + radius + 1, last));
+        const quint32 *out = srcRow(qMax(y - radius, 0));
+        int x = 0;
+#if defined(CAPSTEP_SIMD_SSE2)
+        if (sse2) {
+            x = slideRowSse2(acc, dst, in, out, width, div);
+        }
+#endif
+#if defined(CAPSTEP_SIMD_NEON)
+        if (neon) {
+            x = slideRowNeon(acc, dst, in, out, width, div);
+        }
+#endif
+        slideRowScalar(acc, dst, in, out, x, width, div);
+    }
+    Q_UNUSED(sse2)
+    Q_UNUSED(neon)
+}
+
+} // namespace
+
+bool BoxBlur::supports(QImage::Format format) {
+    return format == QImage::Format_RGB32
+        || format == QImage::Format_ARGB32
+        || format == QImage::Format_ARGB32_Premultiplied;
+}
+
+QRect BoxBlur::blur(QImage &image, const QRect &rect, int radius, int passes) {
+    const QRect clipped = rect.intersected(image.rect());
+    if (clipped.isEmpty() || radius < 1 || passes < 1 || !supports(image.format())) {
+        return QRect();
+    }
+    // 限制半径使窗口和不超出32位（超出图像的部分都是重复的边缘像素，结果只随半径缓慢变化）
+    radius = qMin(radius, kMaxRadius);
+
+    // 区域外 radius × passes 以内的像素会影响区域内的结果
+    const int margin = int(qMin<qint64>(qint64(radius) * passes, qMax(image.width(), image.height())));
+    const QRect area = clipped.adjusted(-margin, -margin, margin, margin).intersected(image.rect());
+    const int width = area.width();
+    const int height = area.height();
+
+    // 两个对齐缓冲区交替作为源和目标，同一个 QImage 的像素不在多个线程中分离
+    QImage work = ImageBuffer::allocate(area.size(), 1.0, image.format());
+    QImage spare = ImageBuffer::allocate(area.size(), 1.0, image.format());
+    if (work.isNull() || spare.isNull()) {
+        return QRect();
+    }
+    uchar *workBits = work.bits();
+    uchar *spareBits = spare.bits();
+    const qsizetype stride = work.bytesPerLine();
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(workBits + y * stride, image.constScanLine(area.top() + y) + area.left() * sizeof(quint32),
+                    size_t(width) * sizeof(quint32));
+    }
+    const Divisor div = divisorFor(radius);
+
+    // 水平：每行的全部次数在行内依次完成，行数据始终在缓存中
+    const BoxRowFn boxRow = selectBoxRow();
+    ParallelBands::run(height, qint64(width) * height, [&](int begin, int end) {
+        QVector<quint32> temp(width);
+        for (int y = begin; y < end; ++y) {
+            quint32 *row = reinterpret_cast<quint32 *>(workBits + y * stride);
+            quint32 *src = row;
+            quint32 *dst = temp.data();
+            for (int pass = 0; pass < passes; ++pass) {
+                boxRow(src, dst, width, radius, div);
+                std::swap(src, dst);
+            }
+            if (src != row) {
+                std::memcpy(row, src, size_t(width) * sizeof(quint32));
+            }
+        }
+    });
+
+    // 垂直：列之间互不依赖，只处理区域内的列，每段列的全部次数在同一线程完成
+    const bool sse2 = SimdSupport::hasSse2();
+    const bool neon = SimdSupport::hasNeon();
+    const int firstColumn = clipped.left() - area.left();
+    const int columns = clipped.width();
+    ParallelBands::run(columns, qint64(columns) * height, [&](int begin, int end) {
+        const int bandWidth = end - begin;
+        QVector<qint32> acc(bandWidth * 4);
+        uchar *src = workBits;
+        uchar *dst = spareBits;
+        for (int pass = 0; pass < passes; ++pass) {
+            boxColumns(src, dst, stride, firstColumn + begin, bandWidth, height, radius, div, acc.data(), sse2, neon);
+            std::swap(src, dst);
+        }
+    });
+    const uchar *resultBits = (passes % 2 == 1) ? spareBits : workBits;
+
+    uchar *bits = image.bits();     // 共享时在此分离
+    const qsizetype imageStride = image.bytesPerLine();
+    const int top = clipped.top() - area.top();
+    for (int y = 0; y < clipped.height(); ++y) {
+        std::memcpy(bits + (clipped.top() + y) * imageStride + clipped.left() * sizeof(quint32),
+                    resultBits + (top + y) * stride + firstColumn * sizeof(quint32),
+                    size_t(columns) * sizeof(quint32));
+    }
+    return clipped;
+}
+
+QImage BoxBlur::blurred(const QImage &source, int radius, int passes) {
+    if (source.isNull() || radius < 1 || passes < 1) {
+        return source;
+    }
+    QImage image = supports(source.format()) ? source : ImageBuffer::adopt(source);
+    blur(image, image.rect(), radius, passes);
+    return image;
+}
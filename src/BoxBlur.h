@@ -0,0 +1,72 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file BoxBlur.h
+ * @brief 多次可分离盒式模糊（近似高斯模糊）
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef BOXBLUR_H
+#define BOXBLUR_H
+
+#include <QImage>
+#include <QRect>
+
+/**
+ * @class BoxBlur
+ * @brief 32位图像的盒式模糊，重复 passes 次近似高斯模糊（3次时误差约3%）
+ *
+ * - 先逐行做水平方向，再逐列做垂直方向，每个方向用滑动窗口累加和，
+ *   每个像素的计算量与半径无关
+ * - 水平方向按行带、垂直方向按列带分配到线程池，小区域在当前线程完成
+ * - 累加与除法（乘以倒数）使用SSE2/NEON，没有时退回标量实现
+ * - 超出图像边界的像素取最近的边缘像素
+ */
+class BoxBlur
+{
+public:
+    /**
+     * @brief 是否支持该像素格式（RGB32 / ARGB32 / ARGB32_Premultiplied）
+     */
+    static bool supports(QImage::Format format);
+
+    /**
+     * @brief 模糊图像中的一个矩形区域（读取区域外 radius × passes 范围内的像素，只改写区域内）
+     * @param image 图像（共享时先分离）
+     * @param rect 区域（设备像素）
+     * @param radius 每次盒式模糊的半径（窗口宽度 2 × radius + 1）
+     * @param passes 重复次数
+     * @return 实际改动的区域（与图像相交后）；格式不支持或半径小于1时为空
+     */
+    static QRect blur(QImage &image, const QRect &rect, int radius, int passes = 3);
+
+    /**
+     * @brief 模糊整幅图像（供批量处理使用，其他格式先转换为统一格式）
+     * @param source 源图像
+     * @param radius 每次盒式模糊的半径
+     * @param passes 重复次数
+     * @return 模糊后的图像（半径小于1时为源图像本身）
+     */
+    static QImage blurred(const QImage &source, int radius, int passes = 3);
+};
+
+#endif // BOXBLUR_H
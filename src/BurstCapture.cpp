@@ -0,0 +1,283 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file BurstCapture.cpp
+ * @brief 定时连拍截图实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "BurstCapture.h"
+#include "PngEncoder.h"
+#include <QTimer>
+#include <QThread>
+#include <QDir>
+#include <QMutexLocker>
+#include <QDebug>
+#include <cstring>
+
+BurstCapture::BurstCapture(QObject *parent)
+    : QObject(parent)
+    , m_grab()
+    , m_timer(nullptr)
+    , m_writer(nullptr)
+    , m_outputDir()
+    , m_memoryBudget(0)
+    , m_maxFrames(0)
+    , m_running(false)
+    , m_stopping(false)
+    , m_captured(0)
+    , m_written(0)
+    , m_dropped(0)
+{
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &BurstCapture::captureFrame);
+}
+
+BurstCapture::~BurstCapture()
+{
+    stop();
+    if (m_writer) {
+        m_writer->wait();
+        delete m_writer;
+        m_writer = nullptr;
+    }
+}
+
+bool BurstCapture::start(const GrabFunction &grab, int intervalMs, qint64 memoryBudgetBytes,
+                         const QString &outputDir, int maxFrames) {
+    // 上一次连拍的写入线程尚未结束时不允许开始
+    if (m_running || m_writer) {
+        qWarning() << "[Burst] Already running";
+        return false;
+    }
+    if (!QDir().mkpath(outputDir)) {
+        qWarning() << "[Burst] Failed to create output folder:" << outputDir;
+        return false;
+    }
+
+    m_grab = grab;
+    m_outputDir = outputDir;
+    m_memoryBudget = memoryBudgetBytes;
+    m_maxFrames = maxFrames;
+    m_slots.clear();
+    m_freeSlots.clear();
+    m_readySlots.clear();
+    m_stopping = false;
+    m_captured = 0;
+    m_written = 0;
+    m_dropped = 0;
+    m_running = true;
+
+    // 写入线程：低优先级，避免与截图和界面争抢CPU
+    m_writer = QThread::create([this]() { writerLoop(); });
+    connect(m_writer, &QThread::finished, this, &BurstCapture::onWriterFinished);
+    m_writer->start(QThread::LowPriority);
+
+    qDebug() << "[Burst] Started, interval:" << intervalMs << "ms, budget:"
+             << (memoryBudgetBytes >> 20) << "MB, output:" << outputDir;
+
+    m_timer->start(qMax(intervalMs, 10));
+    captureFrame();
+    return true;
+}
+
+void BurstCapture::stop() {
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    m_timer->stop();
+
+    QMutexLocker locker(&m_mutex);
+    m_stopping = true;
+    m_frameReady.wakeAll();
+    qDebug() << "[Burst] Stopping, frames pending:" << m_readySlots.size();
+}
+
+void BurstCapture::captureFrame() {
+    if (!m_running) {
+        return;
+    }
+    if (m_maxFrames > 0 && m_captured >= m_maxFrames) {
+        stop();
+        return;
+    }
+
+    QImage frame = m_grab ? m_grab() : QImage();
+    if (frame.isNull()) {
+        qWarning() << "[Burst] Grab failed, skipping frame";
+        return;
+    }
+
+    // 第一帧决定槽位尺寸，之后不再分配帧内存
+    if (m_slots.isEmpty() && !allocateSlots(frame)) {
+        stop();
+        return;
+    }
+    const Slot &reference = m_slots.at(0);
+    if (frame.size() != reference.image.size()) {
+        // 屏幕布局变化导致尺寸不同：不重新分配，直接丢弃
+        qWarning() << "[Burst] Frame size changed from" << reference.image.size() << "to" << frame.size() << ", dropped";
+        QMutexLocker locker(&m_mutex);
+        ++m_dropped;
+        return;
+    }
+    if (frame.format() != reference.image.format()) {
+        frame = frame.convertToFormat(reference.image.format());
+    }
+
+    // 取一个空闲槽位；没有空闲时覆盖最旧的待写入帧
+    int index = -1;
+    int sequence = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_freeSlots.isEmpty()) {
+            index = m_freeSlots.takeLast();
+        } else if (!m_readySlots.isEmpty()) {
+            index = m_readySlots.dequeue();
+            ++m_dropped;
+        } else {
+            ++m_dropped;
+            return;
+        }
+        m_slots[index].state = SlotFilling;
+        sequence = ++m_captured;
+        m_slots[index].sequence = sequence;
+    }
+
+    // 槽位归截图线程所有，锁外复制像素
+    Slot &slot = m_slots[index];
+    const qsizetype rowBytes = qMin(frame.bytesPerLine(), slot.stride);
+    for (int y = 0; y < frame.height(); ++y) {
+        std::memcpy(slot.bits + y * slot.stride, frame.constScanLine(y), size_t(rowBytes));
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_slots[index].state = SlotReady;
+        m_readySlots.enqueue(index);
+        m_frameReady.wakeOne();
+    }
+}
+
+bool BurstCapture::allocateSlots(const QImage &frame) {
+    QImage::Format format = frame.format();
+    if (format != QImage::Format_RGB32 && format != QImage::Format_ARGB32_Premultiplied
+        && format != QImage::Format_ARGB32) {
+        format = QImage::Format_ARGB32_Premultiplied;
+    }
+
+    const qint64 frameBytes = qint64(frame.width()) * frame.height() * 4;
+    int count = frameBytes > 0 ? int(qMin<qint64>(m_memoryBudget / frameBytes, 1024)) : 0;
+    if (count < 2) {
+        // 至少两个槽位：一个在写入，一个接收新帧
+        qWarning() << "[Burst] Memory budget" << (m_memoryBudget >> 20) << "MB is below two frames of"
+                   << (frameBytes >> 20) << "MB, using two slots";
+        count = 2;
+    }
+
+    QVector<Slot> slots(count);
+    for (int i = 0; i < count; ++i) {
+        slots[i].image = QImage(frame.size(), format);
+        if (slots[i].image.isNull()) {
+            qWarning() << "[Burst] Failed to allocate frame slot" << i;
+            return false;
+        }
+        slots[i].image.setDevicePixelRatio(frame.devicePixelRatio());
+        // 预先取出裸指针，之后截图线程只通过指针写入，不再调用QImage的非const接口
+        slots[i].bits = slots[i].image.bits();
+        slots[i].stride = slots[i].image.bytesPerLine();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_slots = slots;
+    m_freeSlots.clear();
+    for (int i = count - 1; i >= 0; --i) {
+        m_freeSlots.append(i);
+    }
+    qDebug() << "[Burst] Allocated" << count << "slots of" << frame.size()
+             << "(" << ((frameBytes * count) >> 20) << "MB )";
+    return true;
+}
+
+void BurstCapture::writerLoop() {
+    forever {
+        int index = -1;
+        int sequence = 0;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_readySlots.isEmpty() && !m_stopping) {
+                m_frameReady.wait(&m_mutex);
+            }
+            if (m_readySlots.isEmpty()) {
+                break;  // 已停止且缓冲已写完
+            }
+            index = m_readySlots.dequeue();
+            m_slots[index].state = SlotWriting;
+            sequence = m_slots.at(index).sequence;
+        }
+
+        const QString filePath = m_outputDir + QString("/frame_%1.png").arg(sequence, 6, 10, QChar('0'));
+        // 连拍优先写入速度：zlib级别1（最快的压缩，仍比不压缩的文件小得多、写盘更快）
+        const bool ok = PngEncoder::save(m_slots.at(index).image, filePath, 1);
+        if (!ok) {
+            qWarning() << "[Burst] Failed to write frame:" << filePath;
+        }
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_slots[index].state = SlotFree;
+            m_freeSlots.append(index);
+            if (ok) {
+                ++m_written;
+            }
+        }
+        if (ok) {
+            QMetaObject::invokeMethod(this, [this, sequence, filePath]() {
+                emit frameWritten(sequence, filePath);
+            }, Qt::QueuedConnection);
+        }
+    }
+}
+
+void BurstCapture::onWriterFinished() {
+    int captured = 0;
+    int written = 0;
+    int dropped = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        captured = m_captured;
+        written = m_written;
+        dropped = m_dropped;
+        // 释放环形缓冲
+        m_slots.clear();
+        m_freeSlots.clear();
+        m_readySlots.clear();
+    }
+
+    m_writer->deleteLater();
+    m_writer = nullptr;
+
+    qDebug() << "[Burst] Finished, captured:" << captured << "written:" << written << "dropped:" << dropped;
+    emit finished(m_outputDir, captured, written, dropped);
+}
@@ -0,0 +1,176 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file BurstCapture.h
+ * @brief 定时连拍截图
+ *
+ * 按固定间隔截取区域或全屏，帧写入预分配的环形缓冲区（固定内存预算），
+ * 由后台写入线程编码落盘，内存占用不随连拍时长增长
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef BURSTCAPTURE_H
+#define BURSTCAPTURE_H
+
+#include <QObject>
+#include <QImage>
+#include <QRect>
+#include <QString>
+#include <QVector>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <functional>
+
+class QTimer;
+class QThread;
+
+/**
+ * @class BurstCapture
+ * @brief 定时连拍截图
+ *
+ * - 第一帧到达时按帧尺寸和内存预算一次性分配所有槽位，之后不再分配帧内存
+ * - 截图线程（GUI线程）把帧复制到空闲槽位，写入线程按顺序取出编码
+ * - 写入跟不上时丢弃最旧的未写入帧，保证最新画面总能进入缓冲
+ */
+class BurstCapture : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// 截取一帧的函数（在GUI线程调用）
+    using GrabFunction = std::function<QImage()>;
+
+    explicit BurstCapture(QObject *parent = nullptr);
+    ~BurstCapture();
+
+    /**
+     * @brief 开始连拍
+     * @param grab 截取一帧的函数
+     * @param intervalMs 截图间隔（毫秒）
+     * @param memoryBudgetBytes 环形缓冲区内存预算（字节）
+     * @param outputDir 输出目录
+     * @param maxFrames 最多截取帧数（0表示直到手动停止）
+     * @return 是否成功开始
+     */
+    bool start(const GrabFunction &grab, int intervalMs, qint64 memoryBudgetBytes,
+               const QString &outputDir, int maxFrames = 0);
+
+    /**
+     * @brief 停止连拍（已缓冲的帧会继续写完）
+     */
+    void stop();
+
+    /**
+     * @brief 是否正在连拍
+     */
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief 获取输出目录
+     */
+    QString outputDir() const { return m_outputDir; }
+
+signals:
+    /**
+     * @brief 帧已写入磁盘
+     * @param sequence 帧序号
+     * @param filePath 文件路径
+     */
+    void frameWritten(int sequence, const QString &filePath);
+
+    /**
+     * @brief 连拍结束（所有缓冲帧已写完）
+     * @param outputDir 输出目录
+     * @param captured 截取的帧数
+     * @param written 写入的帧数
+     * @param dropped 因写入跟不上而丢弃的帧数
+     */
+    void finished(const QString &outputDir, int captured, int written, int dropped);
+
+private slots:
+    /**
+     * @brief 截取一帧并放入环形缓冲
+     */
+    void captureFrame();
+
+private:
+    /**
+     * @brief 槽位状态
+     */
+    enum SlotState {
+        SlotFree,       ///< 空闲
+        SlotFilling,    ///< 截图线程正在写入
+        SlotReady,      ///< 等待写入磁盘
+        SlotWriting     ///< 写入线程正在编码
+    };
+
+    /**
+     * @brief 环形缓冲槽位
+     */
+    struct Slot {
+        QImage image;           ///< 预分配的帧缓冲
+        uchar *bits = nullptr;  ///< 像素指针（分配时取出，避免跨线程分离）
+        qsizetype stride = 0;   ///< 每行字节数
+        int sequence = 0;       ///< 帧序号
+        SlotState state = SlotFree;
+    };
+
+    /**
+     * @brief 按帧尺寸与内存预算分配槽位
+     * @param frame 第一帧
+     * @return 是否成功
+     */
+    bool allocateSlots(const QImage &frame);
+
+    /**
+     * @brief 写入线程主循环
+     */
+    void writerLoop();
+
+    /**
+     * @brief 写入线程退出后的收尾（GUI线程）
+     */
+    void onWriterFinished();
+
+private:
+    GrabFunction m_grab;                ///< 截帧函数
+    QTimer *m_timer;                    ///< 截图定时器
+    QThread *m_writer;                  ///< 写入线程
+    QString m_outputDir;                ///< 输出目录
+    qint64 m_memoryBudget;              ///< 内存预算（字节）
+    int m_maxFrames;                    ///< 最大帧数
+    bool m_running;                     ///< 是否正在连拍
+
+    // 以下成员由 m_mutex 保护
+    QMutex m_mutex;
+    QWaitCondition m_frameReady;        ///< 有帧待写入
+    QVector<Slot> m_slots;              ///< 槽位（分配后数量固定）
+    QVector<int> m_freeSlots;           ///< 空闲槽位索引
+    QQueue<int> m_readySlots;           ///< 待写入槽位索引（按帧序）
+    bool m_stopping;                    ///< 写入线程应在写完后退出
+    int m_captured;                     ///< 已截取帧数
+    int m_written;                      ///< 已写入帧数
+    int m_dropped;                      ///< 丢弃帧数
+};
+
+#endif // BURSTCAPTURE_H
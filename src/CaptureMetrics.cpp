@@ -0,0 +1,289 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file CaptureMetrics.cpp
+ * @brief 截图热路径延迟统计实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "CaptureMetrics.h"
+#include <QMutexLocker>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QCoreApplication>
+#include <QtAlgorithms>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// 同时进行中的采集上限（取消的采集不会走到最后阶段，超出后淘汰最旧的）
+constexpr int kMaxActiveCaptures = 16;
+
+inline double toMs(qint64 ns)
+{
+    return ns / 1e6;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Histogram
+// ---------------------------------------------------------------------------
+
+int CaptureMetrics::Histogram::bucketIndex(quint64 value) {
+    if (value < quint64(SubBuckets)) {
+        return int(value);
+    }
+    // 最高位决定区间，其后3位决定子桶
+    const int msb = 63 - int(qCountLeadingZeroBits(value));
+    const int sub = int((value >> (msb - 3)) & (SubBuckets - 1));
+    return (msb - 2) * SubBuckets + sub;
+}
+
+quint64 CaptureMetrics::Histogram::bucketUpperBound(int index) {
+    if (index < SubBuckets) {
+        return quint64(index);
+    }
+    const int msb = index / SubBuckets + 2;
+    const quint64 sub = quint64(index % SubBuckets);
+    const quint64 lower = (quint64(SubBuckets) + sub) << (msb - 3);
+    return lower + (quint64(1) << (msb - 3)) - 1;
+}
+
+void CaptureMetrics::Histogram::record(qint64 ns) {
+    if (ns < 0) {
+        ns = 0;
+    }
+    ++m_buckets[bucketIndex(quint64(ns))];
+    m_min = m_count ? qMin(m_min, ns) : ns;
+    m_max = qMax(m_max, ns);
+    m_sum += ns;
+    ++m_count;
+}
+
+qint64 CaptureMetrics::Histogram::percentile(double p) const {
+    if (m_count == 0) {
+        return 0;
+    }
+    const quint64 target = qMax<quint64>(1, quint64(std::ceil(p * m_count)));
+    quint64 cumulative = 0;
+    for (int i = 0; i < Buckets; ++i) {
+        cumulative += m_buckets[i];
+        if (cumulative >= target) {
+            return qMin(qint64(bucketUpperBound(i)), m_max);
+        }
+    }
+    return m_max;
+}
+
+void CaptureMetrics::Histogram::clear() {
+    *this = Histogram();
+}
+
+// ---------------------------------------------------------------------------
+// CaptureMetrics
+// ---------------------------------------------------------------------------
+
+CaptureMetrics::CaptureMetrics()
+    : m_mutex()
+    , m_clock()
+    , m_nextId(0)
+    , m_active()
+    , m_recent()
+{
+    m_clock.start();
+}
+
+CaptureMetrics &CaptureMetrics::instance() {
+    static CaptureMetrics s_instance;
+    return s_instance;
+}
+
+const char *CaptureMetrics::stageName(Stage stage) {
+    switch (stage) {
+    case StageHotkey: return "hotkey";
+    case StageOverlayVisible: return "overlay_visible";
+    case StageSelectionConfirmed: return "selection_confirmed";
+    case StageCropReady: return "crop_ready";
+    case StageEditorShown: return "editor_shown";
+    case StageClipboardPublished: return "clipboard_published";
+    case StageHistoryWritten: return "history_written";
+    case StageCount: break;
+    }
+    return "unknown";
+}
+
+quint64 CaptureMetrics::beginCapture() {
+    QMutexLocker locker(&m_mutex);
+
+    // 淘汰最旧的未完成采集（通常是被取消的）
+    while (m_active.size() >= kMaxActiveCaptures) {
+        quint64 oldest = m_nextId + 1;
+        for (auto it = m_active.constBegin(); it != m_active.constEnd(); ++it) {
+            oldest = qMin(oldest, it.key());
+        }
+        m_active.remove(oldest);
+    }
+
+    Trace trace;
+    trace.id = ++m_nextId;
+    std::fill(std::begin(trace.stamps), std::end(trace.stamps), qint64(-1));
+    trace.stamps[StageHotkey] = m_clock.nsecsElapsed();
+    trace.lastStage = StageHotkey;
+    m_active.insert(trace.id, trace);
+    m_sinceHotkey[StageHotkey].record(0);
+    return trace.id;
+}
+
+void CaptureMetrics::mark(quint64 captureId, Stage stage) {
+    if (captureId == 0 || stage <= StageHotkey || stage >= StageCount) {
+        return;
+    }
+    const qint64 now = m_clock.nsecsElapsed();
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_active.find(captureId);
+    if (it == m_active.end() || it->stamps[stage] >= 0) {
+        return;
+    }
+
+    it->stamps[stage] = now;
+    m_sinceHotkey[stage].record(now - it->stamps[StageHotkey]);
+    m_stageDelta[stage].record(now - it->stamps[it->lastStage]);
+    it->lastStage = stage;
+}
+
+void CaptureMetrics::endCapture(quint64 captureId) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_active.find(captureId);
+    if (it == m_active.end()) {
+        return;
+    }
+    m_recent.append(*it);
+    while (m_recent.size() > RecentTraces) {
+        m_recent.removeFirst();
+    }
+    m_active.erase(it);
+}
+
+void CaptureMetrics::reset() {
+    QMutexLocker locker(&m_mutex);
+    m_active.clear();
+    m_recent.clear();
+    for (int i = 0; i < StageCount; ++i) {
+        m_sinceHotkey[i].clear();
+        m_stageDelta[i].clear();
+    }
+}
+
+QString CaptureMetrics::report() const {
+    QMutexLocker locker(&m_mutex);
+
+    QString text;
+    text += QString("CapStep %1 capture metrics (ms, since hotkey | since previous stage)\n")
+                .arg(QCoreApplication::applicationVersion());
+    text += QString("%1 %2 %3 %4 %5 %6 | %7 %8 %9\n")
+                .arg("stage", -20).arg("count", 6)
+                .arg("p50", 8).arg("p95", 8).arg("p99", 8).arg("max", 8)
+                .arg("p50", 8).arg("p95", 8).arg("p99", 8);
+    for (int i = StageOverlayVisible; i < StageCount; ++i) {
+        const Histogram &total = m_sinceHotkey[i];
+        const Histogram &delta = m_stageDelta[i];
+        text += QString("%1 %2 %3 %4 %5 %6 | %7 %8 %9\n")
+                    .arg(QString::fromLatin1(stageName(Stage(i))), -20)
+                    .arg(total.count(), 6)
+                    .arg(toMs(total.percentile(0.50)), 8, 'f', 2)
+                    .arg(toMs(total.percentile(0.95)), 8, 'f', 2)
+                    .arg(toMs(total.percentile(0.99)), 8, 'f', 2)
+                    .arg(toMs(total.max()), 8, 'f', 2)
+                    .arg(toMs(delta.percentile(0.50)), 8, 'f', 2)
+                    .arg(toMs(delta.percentile(0.95)), 8, 'f', 2)
+                    .arg(toMs(delta.percentile(0.99)), 8, 'f', 2);
+    }
+    text += QString("captures: %1, in flight: %2\n").arg(m_nextId).arg(m_active.size());
+    return text;
+}
+
+QByteArray CaptureMetrics::toJson() const {
+    QMutexLocker locker(&m_mutex);
+
+    auto summarize = [](const Histogram &h) {
+        QJsonObject obj;
+        obj["count"] = double(h.count());
+        obj["min_ms"] = toMs(h.min());
+        obj["mean_ms"] = h.mean() / 1e6;
+        obj["p50_ms"] = toMs(h.percentile(0.50));
+        obj["p95_ms"] = toMs(h.percentile(0.95));
+        obj["p99_ms"] = toMs(h.percentile(0.99));
+        obj["max_ms"] = toMs(h.max());
+        return obj;
+    };
+
+    QJsonObject stages;
+    for (int i = StageOverlayVisible; i < StageCount; ++i) {
+        QJsonObject stage;
+        stage["since_hotkey"] = summarize(m_sinceHotkey[i]);
+        stage["since_previous"] = summarize(m_stageDelta[i]);
+        stages[QString::fromLatin1(stageName(Stage(i)))] = stage;
+    }
+
+    // 最近采集的原始时间戳（相对热键，毫秒；未到达的阶段省略）
+    QJsonArray traces;
+    for (const Trace &trace : m_recent) {
+        QJsonObject obj;
+        obj["id"] = double(trace.id);
+        for (int i = StageOverlayVisible; i < StageCount; ++i) {
+            if (trace.stamps[i] >= 0) {
+                obj[QString::fromLatin1(stageName(Stage(i)))] = toMs(trace.stamps[i] - trace.stamps[StageHotkey]);
+            }
+        }
+        traces.append(obj);
+    }
+
+    QJsonObject root;
+    root["version"] = QCoreApplication::applicationVersion();
+    root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    root["captures"] = double(m_nextId);
+    root["stages"] = stages;
+    root["recent"] = traces;
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+bool CaptureMetrics::dumpToFile(const QString &filePath) const {
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[Metrics] Failed to open dump file:" << filePath << file.errorString();
+        return false;
+    }
+    file.write(toJson());
+    if (!file.commit()) {
+        qWarning() << "[Metrics] Failed to write dump file:" << filePath << file.errorString();
+        return false;
+    }
+    qDebug() << "[Metrics] Dumped to:" << filePath;
+    return true;
+}
@@ -0,0 +1,171 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file CaptureMetrics.h
+ * @brief 截图热路径延迟统计
+ *
+ * 记录每次截图各阶段的单调时间戳，并按阶段累积延迟直方图（p50/p95/p99），
+ * 可通过 CapStepInstance 本地套接字查询或导出到文件
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef CAPTUREMETRICS_H
+#define CAPTUREMETRICS_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QElapsedTimer>
+
+/**
+ * @class CaptureMetrics
+ * @brief 截图热路径延迟统计（进程内单例，线程安全）
+ *
+ * 每次截图分配一个采集ID，各阶段调用 mark() 记录时间戳。每个阶段维护两组直方图：
+ * - 自热键触发以来的累计延迟
+ * - 自上一个已记录阶段以来的阶段耗时
+ *
+ * 直方图采用对数分桶（每个2的幂区间再分8个子桶），相对误差不超过12.5%，
+ * 内存固定，记录为O(1)
+ */
+class CaptureMetrics
+{
+public:
+    /**
+     * @brief 截图热路径阶段（按发生顺序）
+     */
+    enum Stage {
+        StageHotkey = 0,            ///< 热键触发
+        StageOverlayVisible,        ///< 覆盖层首帧绘制
+        StageSelectionConfirmed,    ///< 选区确认
+        StageCropReady,             ///< 裁剪完成
+        StageEditorShown,           ///< 编辑窗口显示
+        StageClipboardPublished,    ///< 剪贴板发布
+        StageHistoryWritten,        ///< 历史记录写入
+        StageCount
+    };
+
+    /**
+     * @brief 获取全局实例
+     */
+    static CaptureMetrics &instance();
+
+    /**
+     * @brief 开始一次截图采集，记录热键时间戳
+     * @return 采集ID
+     */
+    quint64 beginCapture();
+
+    /**
+     * @brief 记录阶段时间戳
+     * @param captureId 采集ID（0表示忽略）
+     * @param stage 阶段
+     */
+    void mark(quint64 captureId, Stage stage);
+
+    /**
+     * @brief 结束一次采集，释放其跟踪状态
+     * @param captureId 采集ID
+     */
+    void endCapture(quint64 captureId);
+
+    /**
+     * @brief 清空所有统计
+     */
+    void reset();
+
+    /**
+     * @brief 生成文本报告（各阶段计数与p50/p95/p99，单位毫秒）
+     */
+    QString report() const;
+
+    /**
+     * @brief 生成JSON（直方图摘要与最近的采集时间戳）
+     */
+    QByteArray toJson() const;
+
+    /**
+     * @brief 导出JSON到文件
+     * @param filePath 文件路径
+     * @return 是否成功
+     */
+    bool dumpToFile(const QString &filePath) const;
+
+    /**
+     * @brief 获取阶段名称
+     */
+    static const char *stageName(Stage stage);
+
+private:
+    CaptureMetrics();
+
+    /**
+     * @brief 对数分桶直方图（纳秒）
+     */
+    class Histogram
+    {
+    public:
+        static constexpr int SubBuckets = 8;            ///< 每个2的幂区间的子桶数
+        static constexpr int Buckets = 64 * SubBuckets; ///< 总桶数
+
+        void record(qint64 ns);
+        qint64 percentile(double p) const;
+        quint64 count() const { return m_count; }
+        qint64 min() const { return m_count ? m_min : 0; }
+        qint64 max() const { return m_max; }
+        double mean() const { return m_count ? double(m_sum) / m_count : 0.0; }
+        void clear();
+
+    private:
+        static int bucketIndex(quint64 value);
+        static quint64 bucketUpperBound(int index);
+
+        quint32 m_buckets[Buckets] = {};
+        quint64 m_count = 0;
+        qint64 m_min = 0;
+        qint64 m_max = 0;
+        qint64 m_sum = 0;
+    };
+
+    /**
+     * @brief 单次采集的时间戳（纳秒，-1表示未到达）
+     */
+    struct Trace {
+        quint64 id = 0;
+        qint64 stamps[StageCount];
+        int lastStage = -1;         ///< 最近一次记录的阶段
+    };
+
+    static constexpr int RecentTraces = 32;     ///< 保留的最近采集数
+
+    mutable QMutex m_mutex;                     ///< 保护以下所有成员
+    QElapsedTimer m_clock;                      ///< 进程内单调时钟
+    quint64 m_nextId;                           ///< 下一个采集ID
+    QHash<quint64, Trace> m_active;             ///< 进行中的采集
+    QList<Trace> m_recent;                      ///< 最近完成的采集
+    Histogram m_sinceHotkey[StageCount];        ///< 自热键以来的累计延迟
+    Histogram m_stageDelta[StageCount];         ///< 自上一阶段以来的耗时
+};
+
+#endif // CAPTUREMETRICS_H
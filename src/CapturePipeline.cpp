@@ -0,0 +1,214 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file CapturePipeline.cpp
+ * @brief 截图后处理流水线实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "CapturePipeline.h"
+#include "HistoryWriter.h"
+#include "QoiCodec.h"
+#include "ClipboardMimeData.h"
+#include "TiledImage.h"
+#include <QGuiApplication>
+#include <QScreen>
+#include <QStandardPaths>
+#include <QSettings>
+#include <QTimer>
+#include <QDebug>
+
+CapturePipeline::CapturePipeline(QObject *parent)
+    : QObject(parent)
+    , m_nextJobId(0)
+    , m_jobs()
+    , m_historyWriter(nullptr)
+    , m_historyJobs()
+{
+}
+
+CapturePipeline::~CapturePipeline()
+{
+    // 历史写入线程在析构时写完队列；未完成的信号随对象销毁而丢弃
+    if (!m_jobs.isEmpty()) {
+        qDebug() << "[Pipeline] Destroyed with" << m_jobs.size() << "pending jobs";
+    }
+    delete m_historyWriter;
+    m_historyWriter = nullptr;
+}
+
+quint64 CapturePipeline::submit(const ImageView &screenshot, const QPoint &editorPos, int stages,
+                                const QRect &captureRect) {
+    if (screenshot.isNull()) {
+        return 0;
+    }
+    // 只物化一次：后续所有阶段共享这份零拷贝QImage，只有写入者才会触发复制
+    return startJob(screenshot.image(), QSharedPointer<const TiledImage>(), editorPos, stages, captureRect);
+}
+
+quint64 CapturePipeline::submitTiled(const QSharedPointer<const TiledImage> &image, const QImage &preview,
+                                     const QPoint &editorPos, int stages, const QRect &captureRect) {
+    if (!image || preview.isNull()) {
+        return 0;
+    }
+    return startJob(preview, image, editorPos, stages, captureRect);
+}
+
+quint64 CapturePipeline::startJob(const QImage &image, const QSharedPointer<const TiledImage> &tiled,
+                                  const QPoint &editorPos, int stages, const QRect &captureRect) {
+    const quint64 jobId = ++m_nextJobId;
+    Job &job = m_jobs[jobId];
+    job.timer.start();
+    job.pendingStages = stages | StageCrop;
+    job.image = image;
+    job.tiled = tiled;
+    job.captureRect = captureRect;
+
+    qDebug() << "[Pipeline] Job" << jobId << "submitted, size:" << image.size()
+             << "DPR:" << image.devicePixelRatio();
+    if (tiled) {
+        qDebug() << "[Pipeline] Job" << jobId << "full size:" << tiled->width() << "x" << tiled->height();
+    }
+
+    // 阶段1：裁剪结果就绪，立即交给编辑窗口（直接连接，同步显示）
+    completeStage(jobId, StageCrop);
+    if (stages & StageEditor) {
+        emit cropReady(jobId, image, editorPos);
+        completeStage(jobId, StageEditor);
+    }
+
+    if (!m_jobs.contains(jobId)) {
+        return jobId;
+    }
+
+    if (stages & StageHistory) {
+        startHistoryStage(jobId);
+    }
+    if (stages & StageClipboard) {
+        startClipboardStage(jobId);
+    }
+    return jobId;
+}
+
+QString CapturePipeline::historyFolderPath() {
+    QString appData = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return appData + "/ScreenshotHistory/images";
+}
+
+void CapturePipeline::completeStage(quint64 jobId, Stage stage) {
+    auto it = m_jobs.find(jobId);
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    const qint64 elapsed = it->timer.elapsed();
+    it->pendingStages &= ~stage;
+    const bool done = (it->pendingStages == 0);
+
+    qDebug() << "[Pipeline] Job" << jobId << "stage" << stage << "completed in" << elapsed << "ms";
+    emit stageCompleted(jobId, stage, elapsed);
+
+    if (done) {
+        m_jobs.remove(jobId);
+        emit jobFinished(jobId);
+    }
+}
+
+HistoryWriter *CapturePipeline::historyWriter() {
+    if (!m_historyWriter) {
+        // 队列上限按未编码像素计算，默认约可容纳30张4K截图。
+        // 入队发生在GUI线程，超出上限时丢弃最旧的未写入截图并提示，而不是等待写入线程
+        QSettings settings("CapStep", "Capture");
+        const qint64 budget = qint64(qMax(16, settings.value("historyQueueMB", 1024).toInt())) << 20;
+        m_historyWriter = new HistoryWriter(historyFolderPath(), budget, HistoryWriter::OverflowDropOldest);
+        connect(m_historyWriter, &HistoryWriter::entryWritten, this, &CapturePipeline::onHistoryEntryWritten);
+        connect(m_historyWriter, &HistoryWriter::entriesDropped, this, &CapturePipeline::historyDropped);
+
+        // 保留策略：默认不删除任何截图，只把一周前的截图重新压缩
+        HistoryRetention::Policy policy;
+        policy.maxTotalBytes = qint64(qMax(0, settings.value("historyMaxMB", 0).toInt())) << 20;
+        policy.maxAgeDays = qMax(0, settings.value("historyMaxDays", 0).toInt());
+        policy.recompressAfterDays = qMax(0, settings.value("historyRecompressDays", 7).toInt());
+        policy.ioBytesPerSecond = qint64(qMax(0, settings.value("historyIoMBps", 8).toInt())) << 20;
+        m_historyWriter->setRetentionPolicy(policy);
+        // "qoi"：截图以QOI快速写入，空闲时再转为PNG
+        if (settings.value("historyFormat", "png").toString() == QoiCodec::Suffix) {
+            m_historyWriter->setFileFormat(HistoryWriter::FormatQoi);
+        }
+    }
+    return m_historyWriter;
+}
+
+void CapturePipeline::compactHistoryIndex() {
+    historyWriter()->requestCompact();
+}
+
+void CapturePipeline::startHistoryStage(quint64 jobId) {
+    const Job &job = m_jobs[jobId];
+    // 跨屏选区记录中心所在的屏幕
+    QString screenName;
+    if (job.captureRect.isValid()) {
+        if (QScreen *screen = QGuiApplication::screenAt(job.captureRect.center())) {
+            screenName = screen->name();
+        }
+    }
+
+    // ID与文件名在入队时按提交顺序分配；只有队列超出上限时才会等待写入线程
+    const quint64 entryId = job.tiled
+        ? historyWriter()->enqueueTiled(job.tiled, job.image, job.captureRect, screenName)
+        : historyWriter()->enqueue(job.image, job.captureRect, screenName);
+    if (entryId == 0) {
+        emit historySaved(jobId, QString(), false);
+        completeStage(jobId, StageHistory);
+        return;
+    }
+    m_historyJobs.insert(entryId, jobId);
+}
+
+void CapturePipeline::onHistoryEntryWritten(quint64 entryId, const QString &filePath, bool success) {
+    const quint64 jobId = m_historyJobs.take(entryId);
+    if (jobId == 0) {
+        return;
+    }
+    if (success) {
+        qDebug() << "[History] Screenshot saved to:" << filePath;
+    } else {
+        qWarning() << "[History] Failed to save screenshot to:" << filePath;
+    }
+    emit historySaved(jobId, filePath, success);
+    completeStage(jobId, StageHistory);
+}
+
+void CapturePipeline::startClipboardStage(quint64 jobId) {
+    // 排队到事件循环，让编辑窗口先完成首帧绘制
+    QTimer::singleShot(0, this, [this, jobId]() {
+        auto it = m_jobs.find(jobId);
+        if (it == m_jobs.end()) {
+            return;
+        }
+        // 自动复制截图到剪贴板，用户可以直接Ctrl+V粘贴；各格式在粘贴时才编码
+        ClipboardMimeData::publish(it->image);
+        qDebug() << "[AutoCopy] Screenshot automatically copied to clipboard";
+        emit clipboardPublished(jobId);
+        completeStage(jobId, StageClipboard);
+    });
+}
@@ -0,0 +1,239 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file CapturePipeline.h
+ * @brief 截图后处理流水线
+ *
+ * 将截图确认后的处理拆分为多个阶段：裁剪 → 显示编辑窗口 → 编码/保存历史 → 发布剪贴板，
+ * 耗时的编码阶段在工作线程中执行，避免阻塞GUI线程
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef CAPTUREPIPELINE_H
+#define CAPTUREPIPELINE_H
+
+#include <QObject>
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSharedPointer>
+#include "ImageView.h"
+
+class HistoryWriter;
+class TiledImage;
+
+/**
+ * @class CapturePipeline
+ * @brief 截图后处理流水线
+ *
+ * 每次截图对应一个任务（job），按以下顺序推进：
+ * - StageCrop：裁剪结果就绪，通过 cropReady 信号交给编辑窗口（GUI线程）
+ * - StageEditor：编辑窗口已显示
+ * - StageHistory：交给 HistoryWriter 在专用线程编码并写入历史文件夹
+ * - StageClipboard：发布到系统剪贴板（GUI线程，排在编辑窗口显示之后）
+ *
+ * 每个阶段完成后都会发出 stageCompleted 信号，并附带自任务提交以来的耗时
+ */
+class CapturePipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 流水线阶段
+     */
+    enum Stage {
+        StageCrop      = 0x1,   ///< 裁剪完成
+        StageEditor    = 0x2,   ///< 编辑窗口已显示
+        StageHistory   = 0x4,   ///< 历史记录已保存
+        StageClipboard = 0x8    ///< 剪贴板已发布
+    };
+    Q_ENUM(Stage)
+
+    /// 默认执行的全部阶段
+    static constexpr int AllStages = StageCrop | StageEditor | StageHistory | StageClipboard;
+
+    explicit CapturePipeline(QObject *parent = nullptr);
+    ~CapturePipeline();
+
+    /**
+     * @brief 提交一次截图结果，启动流水线
+     *
+     * 视图只在这里物化一次为共享的QImage，编辑窗口、历史编码和剪贴板共用同一份像素
+     *
+     * @param screenshot 裁剪结果视图（共享冻结背景的缓冲区）
+     * @param editorPos 编辑窗口期望位置（全局坐标）
+     * @param stages 需要执行的阶段组合（Stage按位或）
+     * @param captureRect 截图区域（逻辑坐标，记录到历史索引）
+     * @return 任务ID
+     */
+    quint64 submit(const ImageView &screenshot, const QPoint &editorPos, int stages = AllStages,
+                   const QRect &captureRect = QRect());
+
+    /**
+     * @brief 提交一张分块长图（滚动长截图），启动流水线
+     *
+     * 历史记录按段写入全尺寸长图；编辑窗口和剪贴板使用预览图。提交后调用方不能再读取分块图像
+     *
+     * @param image 全尺寸分块长图
+     * @param preview 缩小的预览图
+     * @param editorPos 编辑窗口期望位置（全局坐标）
+     * @param stages 需要执行的阶段组合（Stage按位或）
+     * @param captureRect 截图区域（逻辑坐标，记录到历史索引）
+     * @return 任务ID
+     */
+    quint64 submitTiled(const QSharedPointer<const TiledImage> &image, const QImage &preview,
+                        const QPoint &editorPos, int stages = AllStages, const QRect &captureRect = QRect());
+
+    /**
+     * @brief 获取下一次submit将分配的任务ID
+     *
+     * 编辑窗口在submit内同步显示，调用方可据此提前登记任务的关联信息
+     *
+     * @return 任务ID
+     */
+    quint64 nextJobId() const { return m_nextJobId + 1; }
+
+    /**
+     * @brief 获取仍在执行中的任务数量
+     * @return 任务数量
+     */
+    int pendingJobs() const { return m_jobs.size(); }
+
+    /**
+     * @brief 获取历史截图文件夹路径
+     * @return 历史截图文件夹路径
+     */
+    static QString historyFolderPath();
+
+    /**
+     * @brief 请求在历史写入线程中重写历史索引
+     */
+    void compactHistoryIndex();
+
+signals:
+    /**
+     * @brief 裁剪结果就绪信号，接收方应立即显示编辑窗口
+     * @param jobId 任务ID
+     * @param screenshot 截图
+     * @param editorPos 编辑窗口期望位置
+     */
+    void cropReady(quint64 jobId, const QImage &screenshot, const QPoint &editorPos);
+
+    /**
+     * @brief 阶段完成信号
+     * @param jobId 任务ID
+     * @param stage 完成的阶段
+     * @param elapsedMs 自任务提交以来的耗时（毫秒）
+     */
+    void stageCompleted(quint64 jobId, CapturePipeline::Stage stage, qint64 elapsedMs);
+
+    /**
+     * @brief 历史记录保存完成信号
+     * @param jobId 任务ID
+     * @param filePath 保存路径
+     * @param success 是否保存成功
+     */
+    void historySaved(quint64 jobId, const QString &filePath, bool success);
+
+    /**
+     * @brief 剪贴板发布完成信号
+     * @param jobId 任务ID
+     */
+    void clipboardPublished(quint64 jobId);
+
+    /**
+     * @brief 历史写入跟不上，丢弃了尚未保存的截图
+     * @param count 丢弃的截图数
+     */
+    void historyDropped(int count);
+
+    /**
+     * @brief 任务全部阶段完成信号
+     * @param jobId 任务ID
+     */
+    void jobFinished(quint64 jobId);
+
+private:
+    /**
+     * @brief 单个任务的状态
+     */
+    struct Job {
+        QImage image;           ///< 各阶段共享的图像（只读，可跨线程）
+        QSharedPointer<const TiledImage> tiled; ///< 全尺寸分块长图（存在时 image 为预览）
+        QRect captureRect;      ///< 截图区域（逻辑坐标）
+        QElapsedTimer timer;    ///< 任务计时器
+        int pendingStages = 0;  ///< 尚未完成的阶段
+    };
+
+    /**
+     * @brief 标记阶段完成并发出信号
+     * @param jobId 任务ID
+     * @param stage 完成的阶段
+     */
+    void completeStage(quint64 jobId, Stage stage);
+
+    /**
+     * @brief 创建任务并推进各阶段
+     * @param image 各阶段共享的图像
+     * @param tiled 全尺寸分块长图（普通截图为空）
+     * @return 任务ID
+     */
+    quint64 startJob(const QImage &image, const QSharedPointer<const TiledImage> &tiled,
+                     const QPoint &editorPos, int stages, const QRect &captureRect);
+
+    /**
+     * @brief 获取历史写入线程（首次使用时创建）
+     */
+    HistoryWriter *historyWriter();
+
+    /**
+     * @brief 把截图交给历史写入线程
+     * @param jobId 任务ID
+     */
+    void startHistoryStage(quint64 jobId);
+
+    /**
+     * @brief 在GUI线程中发布剪贴板
+     * @param jobId 任务ID
+     */
+    void startClipboardStage(quint64 jobId);
+
+    /**
+     * @brief 历史记录写入完成
+     * @param entryId 历史记录ID
+     * @param filePath 文件路径
+     * @param success 是否成功
+     */
+    void onHistoryEntryWritten(quint64 entryId, const QString &filePath, bool success);
+
+private:
+    quint64 m_nextJobId;            ///< 下一个任务ID
+    QHash<quint64, Job> m_jobs;     ///< 执行中的任务
+    HistoryWriter *m_historyWriter; ///< 历史写入线程（首次保存时创建）
+    QHash<quint64, quint64> m_historyJobs; ///< 历史记录ID → 任务ID
+};
+
+#endif // CAPTUREPIPELINE_H
@@ -0,0 +1,104 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ClipboardMimeData.cpp
+ * @brief 按需编码的剪贴板图像数据实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "ClipboardMimeData.h"
+#include "EncodedImageCache.h"
+#include "QoiCodec.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+
+const QString kPngMimeType = QStringLiteral("image/png");
+const QString kBmpMimeType = QStringLiteral("image/bmp");
+/// Qt内部图像格式：Windows的CF_DIB/CF_DIBV5、macOS的TIFF等由平台插件从QImage按需转换
+const QString kQtImageMimeType = QStringLiteral("application/x-qt-image");
+
+} // namespace
+
+ClipboardMimeData::ClipboardMimeData(const QImage &image)
+    : QMimeData()
+    , m_image(image)
+    , m_encoded()
+{
+}
+
+void ClipboardMimeData::publish(const QImage &image) {
+    if (image.isNull()) {
+        return;
+    }
+    QApplication::clipboard()->setMimeData(new ClipboardMimeData(image));
+}
+
+QStringList ClipboardMimeData::formats() const {
+    return QStringList() << kQtImageMimeType << kPngMimeType << kBmpMimeType << QString(QoiMimeType);
+}
+
+bool ClipboardMimeData::hasFormat(const QString &mimeType) const {
+    return formats().contains(mimeType);
+}
+
+QVariant ClipboardMimeData::retrieveData(const QString &mimeType, QMetaType type) const {
+    // 请求QImage时直接给出原图，平台转换（如DIB）由Qt在真正粘贴时完成
+    if (mimeType == kQtImageMimeType || type.id() == QMetaType::QImage) {
+        return m_image;
+    }
+    const QByteArray bytes = encoded(mimeType);
+    if (bytes.isEmpty()) {
+        return QMimeData::retrieveData(mimeType, type);
+    }
+    return bytes;
+}
+
+QByteArray ClipboardMimeData::encoded(const QString &mimeType) const {
+    auto it = m_encoded.constFind(mimeType);
+    if (it != m_encoded.constEnd()) {
+        return it.value();
+    }
+
+    QByteArray format;
+    if (mimeType == kPngMimeType) {
+        format = "png";
+    } else if (mimeType == kBmpMimeType) {
+        format = "bmp";
+    } else if (mimeType == QLatin1String(QoiMimeType)) {
+        format = QoiCodec::Suffix;
+    } else {
+        return QByteArray();
+    }
+
+    // 历史写入或另存为已编码过同一图像时直接复用（历史PNG从文件读回）
+    QElapsedTimer timer;
+    timer.start();
+    const QByteArray bytes = EncodedImageCache::instance().encode(m_image, format);
+    qDebug() << "[Clipboard] Provided" << mimeType << "on demand," << bytes.size() << "bytes in"
+             << timer.elapsed() << "ms";
+    m_encoded.insert(mimeType, bytes);
+    return bytes;
+}
@@ -0,0 +1,86 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ClipboardMimeData.h
+ * @brief 按需编码的剪贴板图像数据
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef CLIPBOARDMIMEDATA_H
+#define CLIPBOARDMIMEDATA_H
+
+#include <QMimeData>
+#include <QImage>
+#include <QHash>
+#include <QByteArray>
+
+/**
+ * @class ClipboardMimeData
+ * @brief 按需编码的剪贴板图像数据
+ *
+ * 发布时只保存共享像素的QImage，声明 image/png、image/bmp、image/x-qoi 和Qt内部图像格式，
+ * 某种格式真正被粘贴方请求时才通过 EncodedImageCache 取得编码（与历史写入、另存为共享），
+ * 结果在本对象中保留，同一格式不会编码第二次。
+ * 没有人粘贴的截图不产生任何编码开销。
+ *
+ * 系统剪贴板在GUI线程中回调 retrieveData()，缓存不需要加锁
+ */
+class ClipboardMimeData : public QMimeData
+{
+    Q_OBJECT
+
+public:
+    /// QOI格式的MIME类型（非标准，供支持QOI的程序使用）
+    static constexpr const char *QoiMimeType = "image/x-qoi";
+
+    /**
+     * @brief 构造函数
+     * @param image 图像（共享像素，不复制）
+     */
+    explicit ClipboardMimeData(const QImage &image);
+
+    /**
+     * @brief 把图像发布到系统剪贴板（剪贴板接管对象所有权）
+     * @param image 图像
+     */
+    static void publish(const QImage &image);
+
+    QStringList formats() const override;
+    bool hasFormat(const QString &mimeType) const override;
+
+protected:
+    QVariant retrieveData(const QString &mimeType, QMetaType type) const override;
+
+private:
+    /**
+     * @brief 获取编码后的数据（首次请求时编码并缓存）
+     * @param mimeType MIME类型
+     * @return 编码结果（不支持的类型为空）
+     */
+    QByteArray encoded(const QString &mimeType) const;
+
+private:
+    QImage m_image;                                 ///< 原图
+    mutable QHash<QString, QByteArray> m_encoded;   ///< MIME类型 → 编码结果
+};
+
+#endif // CLIPBOARDMIMEDATA_H
@@ -0,0 +1,200 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file EncodedImageCache.cpp
+ * @brief 编码结果缓存实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "EncodedImageCache.h"
+#include "PngEncoder.h"
+#include "QoiCodec.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QBuffer>
+#include <QImageWriter>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+
+constexpr int kBudgetKB = 64 * 1024;    ///< 缓存字节预算（约为十几张4K截图的PNG）
+
+/**
+ * @brief 条目代价：字节数（KB，至少为1），只有文件的条目代价为1
+ */
+int costOf(const QByteArray &bytes)
+{
+    return int(qMax<qint64>(1, bytes.size() >> 10));
+}
+
+} // namespace
+
+EncodedImageCache &EncodedImageCache::instance() {
+    static EncodedImageCache cache;
+    return cache;
+}
+
+EncodedImageCache::EncodedImageCache()
+    : m_cache(kBudgetKB)
+{
+}
+
+QByteArray EncodedImageCache::formatForPath(const QString &path) {
+    QByteArray format = QFileInfo(path).suffix().toLower().toLatin1();
+    if (format == "jpeg") {
+        format = "jpg";
+    }
+    return format;
+}
+
+EncodedImageCache::Blob EncodedImageCache::find(const Key &key) {
+    Blob *blob = m_cache.object(key);
+    if (!blob) {
+        return Blob();
+    }
+    // 历史文件可能已被保留策略删除或转换格式
+    if (blob->bytes.isEmpty() && !QFileInfo::exists(blob->filePath)) {
+        m_cache.remove(key);
+        return Blob();
+    }
+    return *blob;
+}
+
+QByteArray EncodedImageCache::lookup(const QImage &image, const QByteArray &format) {
+    if (image.isNull()) {
+        return QByteArray();
+    }
+    Blob blob;
+    {
+        QMutexLocker locker(&m_mutex);
+        blob = find(Key(image.cacheKey(), format));
+    }
+    if (!blob.bytes.isEmpty() || blob.filePath.isEmpty()) {
+        return blob.bytes;
+    }
+    // 只有文件：读回字节（远快于重新编码）并缓存
+    QFile file(blob.filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    const QByteArray bytes = file.readAll();
+    insertBytes(image, format, bytes);
+    return bytes;
+}
+
+QByteArray EncodedImageCache::encode(const QImage &image, const QByteArray &format) {
+    QByteArray bytes = lookup(image, format);
+    if (!bytes.isEmpty() || image.isNull()) {
+        return bytes;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    bytes = encodeBytes(image, format);
+    qDebug() << "[EncodeCache] Encoded" << format << image.size() << "in" << timer.elapsed() << "ms";
+    insertBytes(image, format, bytes);
+    return bytes;
+}
+
+bool EncodedImageCache::save(const QImage &image, const QString &path) {
+    const QByteArray format = formatForPath(path);
+    if (image.isNull() || format.isEmpty()) {
+        return false;
+    }
+
+    // 未编辑过的截图已写入历史：另存为就是复制文件
+    QString source;
+    {
+        QMutexLocker locker(&m_mutex);
+        source = find(Key(image.cacheKey(), format)).filePath;
+    }
+    if (!source.isEmpty() && QFileInfo(source).absoluteFilePath() != QFileInfo(path).absoluteFilePath()) {
+        if (QFile::exists(path)) {
+            QFile::remove(path);
+        }
+        if (QFile::copy(source, path)) {
+            qDebug() << "[EncodeCache] Saved by copying" << QFileInfo(source).fileName();
+            return true;
+        }
+    }
+
+    const QByteArray bytes = encode(image, format);
+    if (bytes.isEmpty()) {
+        return false;
+    }
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size()) {
+        return false;
+    }
+    return file.commit();
+}
+
+void EncodedImageCache::insertBytes(const QImage &image, const QByteArray &format, const QByteArray &bytes) {
+    if (image.isNull() || bytes.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    const Key key(image.cacheKey(), format);
+    Blob *blob = new Blob;
+    blob->bytes = bytes;
+    if (Blob *existing = m_cache.object(key)) {
+        blob->filePath = existing->filePath;
+    }
+    m_cache.insert(key, blob, costOf(bytes));
+}
+
+void EncodedImageCache::insertFile(const QImage &image, const QByteArray &format, const QString &filePath) {
+    if (image.isNull() || filePath.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    const Key key(image.cacheKey(), format);
+    Blob *blob = new Blob;
+    blob->filePath = filePath;
+    if (Blob *existing = m_cache.object(key)) {
+        blob->bytes = existing->bytes;
+    }
+    m_cache.insert(key, blob, costOf(blob->bytes));
+}
+
+QByteArray EncodedImageCache::encodeBytes(const QImage &image, const QByteArray &format) {
+    if (format == QoiCodec::Suffix) {
+        return QoiCodec::encode(image);
+    }
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    if (format == "png") {
+        if (!PngEncoder::write(image, &buffer)) {
+            return QByteArray();
+        }
+        return bytes;
+    }
+    QImageWriter writer(&buffer, format);
+    if (!writer.write(image)) {
+        qWarning() << "[EncodeCache] Encode failed:" << format << writer.errorString();
+        return QByteArray();
+    }
+    return bytes;
+}
@@ -0,0 +1,123 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file EncodedImageCache.h
+ * @brief 编码结果缓存：同一图像内容只编码一次
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef ENCODEDIMAGECACHE_H
+#define ENCODEDIMAGECACHE_H
+
+#include <QImage>
+#include <QByteArray>
+#include <QString>
+#include <QCache>
+#include <QPair>
+#include <QMutex>
+
+/**
+ * @class EncodedImageCache
+ * @brief 进程内共享的编码结果缓存
+ *
+ * 以 QImage::cacheKey()（像素内容的代号，图像被修改时改变）和格式为键，
+ * 历史写入、剪贴板和另存为共享同一份编码结果：
+ * - 编码得到的字节按字节数计入LRU预算
+ * - 已写入磁盘的编码（历史文件）只记录路径，需要字节时读文件，另存为时直接复制文件
+ *
+ * 可在任意线程调用
+ */
+class EncodedImageCache
+{
+public:
+    /**
+     * @brief 获取全局实例
+     */
+    static EncodedImageCache &instance();
+
+    /**
+     * @brief 获取编码结果（缓存中没有时编码并缓存）
+     * @param image 图像
+     * @param format 格式（png、qoi、bmp、jpg等小写扩展名）
+     * @return 编码结果（失败时为空）
+     */
+    QByteArray encode(const QImage &image, const QByteArray &format);
+
+    /**
+     * @brief 查找已有的编码结果，不编码
+     * @return 编码结果（没有时为空）
+     */
+    QByteArray lookup(const QImage &image, const QByteArray &format);
+
+    /**
+     * @brief 按扩展名保存图像：有同格式的文件时复制文件，有缓存字节时直接写出，否则编码
+     * @param image 图像
+     * @param path 目标路径（已存在时覆盖）
+     * @return 是否成功
+     */
+    bool save(const QImage &image, const QString &path);
+
+    /**
+     * @brief 记录已编码的字节
+     */
+    void insertBytes(const QImage &image, const QByteArray &format, const QByteArray &bytes);
+
+    /**
+     * @brief 记录已写入磁盘的编码文件
+     */
+    void insertFile(const QImage &image, const QByteArray &format, const QString &filePath);
+
+    /**
+     * @brief 由路径扩展名得到格式名
+     */
+    static QByteArray formatForPath(const QString &path);
+
+private:
+    EncodedImageCache();
+    Q_DISABLE_COPY(EncodedImageCache)
+
+    /**
+     * @brief 一份编码结果
+     */
+    struct Blob {
+        QByteArray bytes;       ///< 编码字节（只有文件时为空）
+        QString filePath;       ///< 内容相同的文件（没有时为空）
+    };
+
+    using Key = QPair<qint64, QByteArray>;
+
+    /**
+     * @brief 查找仍然有效的条目（持有锁时调用），文件已不存在的条目被移除
+     */
+    Blob find(const Key &key);
+
+    /**
+     * @brief 按格式编码
+     */
+    static QByteArray encodeBytes(const QImage &image, const QByteArray &format);
+
+private:
+    QMutex m_mutex;
+    QCache<Key, Blob> m_cache;      ///< 代价单位为KB
+};
+
+#endif // ENCODEDIMAGECACHE_H
@@ -0,0 +1,282 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file FrameSource.cpp
+ * @brief 可替换的屏幕帧来源实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "FrameSource.h"
+#ifdef CAPSTEP_HAVE_XSHM
+#include "XShmFrameSource.h"
+#endif
+#include <QGuiApplication>
+#include <QScreen>
+#include <QPixmap>
+#include <QRegularExpression>
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+FrameSource *s_current = nullptr;
+
+inline quint32 mixBits(quint32 v)
+{
+    v ^= v >> 16;
+    v *= 0x7FEB352Du;
+    v ^= v >> 15;
+    v *= 0x846CA68Bu;
+    v ^= v >> 16;
+    return v;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// FrameSource
+// ---------------------------------------------------------------------------
+
+FrameSource::~FrameSource()
+{
+}
+
+QList<FrameSource::Screen> FrameSource::screens() const {
+    QList<Screen> result;
+    const QList<QScreen*> screens = QGuiApplication::screens();
+    for (QScreen *screen : screens) {
+        if (!screen) continue;
+        Screen info;
+        info.name = screen->name();
+        info.geometry = screen->geometry();
+        info.devicePixelRatio = screen->devicePixelRatio();
+        result.append(info);
+    }
+    return result;
+}
+
+QImage FrameSource::grabScreenAt(const Screen &screen, const QRect &localRect) {
+    const QList<Screen> all = screens();
+    for (int i = 0; i < all.size(); ++i) {
+        if (all.at(i).name == screen.name && all.at(i).geometry == screen.geometry) {
+            return grabScreen(i, localRect);
+        }
+    }
+    return QImage();
+}
+
+QRect FrameSource::virtualGeometry() const {
+    QRect rect;
+    const QList<Screen> all = screens();
+    for (const Screen &screen : all) {
+        rect = rect.united(screen.geometry);
+    }
+    return rect;
+}
+
+QRect FrameSource::toDeviceRect(const Screen &screen, const QRect &localRect) {
+    const qreal dpr = screen.devicePixelRatio;
+    const QRect bounds(0, 0, qRound(screen.geometry.width() * dpr), qRound(screen.geometry.height() * dpr));
+    if (localRect.isNull()) {
+        return bounds;
+    }
+    // 按边缘取整，相邻区域之间不留缝
+    const int left = int(std::floor(localRect.left() * dpr));
+    const int top = int(std::floor(localRect.top() * dpr));
+    const int right = int(std::ceil((localRect.left() + localRect.width()) * dpr));
+    const int bottom = int(std::ceil((localRect.top() + localRect.height()) * dpr));
+    return QRect(QPoint(left, top), QPoint(right - 1, bottom - 1)).intersected(bounds);
+}
+
+FrameSource *FrameSource::current() {
+    if (!s_current) {
+        const QString requested = QString::fromLocal8Bit(qgetenv("CAPSTEP_FRAME_SOURCE"));
+        if (!requested.isEmpty()) {
+            bool ok = false;
+            const Kind kind = kindFromName(requested, &ok);
+            if (ok) {
+                s_current = create(kind);
+            }
+            if (!s_current) {
+                qWarning() << "[FrameSource] Requested source" << requested << "unavailable, using Qt";
+            }
+        }
+        if (!s_current) {
+            s_current = create(KindQt);
+        }
+        qDebug() << "[FrameSource] Using" << kindName(s_current->kind());
+    }
+    return s_current;
+}
+
+bool FrameSource::setCurrent(Kind kind) {
+    if (s_current && s_current->kind() == kind) {
+        return true;
+    }
+    FrameSource *source = create(kind);
+    if (!source) {
+        qWarning() << "[FrameSource]" << kindName(kind) << "is not available";
+        return false;
+    }
+    delete s_current;
+    s_current = source;
+    qDebug() << "[FrameSource] Switched to" << kindName(kind);
+    return true;
+}
+
+FrameSource *FrameSource::create(Kind kind) {
+    switch (kind) {
+    case KindQt:
+        return new QtFrameSource();
+    case KindXShm:
+#ifdef CAPSTEP_HAVE_XSHM
+        return XShmFrameSource::create();
+#else
+        return nullptr;
+#endif
+    case KindSynthetic:
+        return new SyntheticFrameSource();
+    }
+    return nullptr;
+}
+
+FrameSource::Kind FrameSource::kindFromName(const QString &name, bool *ok) {
+    const QString key = name.trimmed().toLower();
+    if (ok) *ok = true;
+    if (key == "qt") return KindQt;
+    if (key == "xshm") return KindXShm;
+    if (key == "synthetic") return KindSynthetic;
+    if (ok) *ok = false;
+    return KindQt;
+}
+
+QString FrameSource::kindName(Kind kind) {
+    switch (kind) {
+    case KindQt: return "qt";
+    case KindXShm: return "xshm";
+    case KindSynthetic: return "synthetic";
+    }
+    return "unknown";
+}
+
+// ---------------------------------------------------------------------------
+// QtFrameSource
+// ---------------------------------------------------------------------------
+
+QImage QtFrameSource::grabScreen(int screenIndex, const QRect &localRect) {
+    QScreen *screen = QGuiApplication::screens().value(screenIndex);
+    if (!screen) {
+        return QImage();
+    }
+    // 光栅后端下整屏抓取的toImage()为浅拷贝，区域抓取时平台层已只复制区域像素
+    if (localRect.isNull()) {
+        return screen->grabWindow(0).toImage();
+    }
+    return screen->grabWindow(0, localRect.x(), localRect.y(), localRect.width(), localRect.height()).toImage();
+}
+
+// ---------------------------------------------------------------------------
+// SyntheticFrameSource
+// ---------------------------------------------------------------------------
+
+SyntheticFrameSource::SyntheticFrameSource()
+    : m_screens()
+    , m_scrollOffset(0)
+{
+    const QString layout = QString::fromLocal8Bit(qgetenv("CAPSTEP_SYNTHETIC_SCREENS"));
+    const QRegularExpression pattern("^(\\d+)x(\\d+)(?:@([\\d.]+))?(?:([+-]\\d+)([+-]\\d+))?$");
+    const QStringList parts = layout.split(';', Qt::SkipEmptyParts);
+    for (const QString &part : parts) {
+        const QRegularExpressionMatch match = pattern.match(part.trimmed());
+        if (!match.hasMatch()) {
+            qWarning() << "[FrameSource] Ignoring synthetic screen spec:" << part;
+            continue;
+        }
+        Screen screen;
+        screen.name = QString("synthetic-%1").arg(m_screens.size());
+        screen.devicePixelRatio = match.captured(3).isEmpty() ? 1.0 : qMax(0.5, match.captured(3).toDouble());
+        // 与Qt6一致：屏幕左上角保持原生坐标，只有尺寸按DPR换算为逻辑尺寸
+        screen.geometry = QRect(match.captured(4).toInt(), match.captured(5).toInt(),
+                                qRound(match.captured(1).toInt() / screen.devicePixelRatio),
+                                qRound(match.captured(2).toInt() / screen.devicePixelRatio));
+        m_screens.append(screen);
+    }
+    if (m_screens.isEmpty()) {
+        Screen screen;
+        screen.name = "synthetic-0";
+        screen.geometry = QRect(0, 0, 1920, 1080);
+        m_screens.append(screen);
+    }
+}
+
+quint32 SyntheticFrameSource::pixelAt(int x, int y) {
+    // 背景：柔和的水平/垂直渐变
+    quint32 r = 200 + ((x >> 4) & 0x1f);
+    quint32 g = 200 + ((y >> 4) & 0x1f);
+    quint32 b = 230;
+
+    // 每22行一行“文字”：按单词随机出现深色块
+    const int line = y / 22;
+    const int lineRow = y - line * 22;
+    if (lineRow >= 5 && lineRow < 17) {
+        const int word = x / 48;
+        const quint32 h = mixBits(quint32(line) * 0x9E3779B1u ^ quint32(word));
+        const int wordLength = 12 + int(h & 31);
+        if ((h >> 8) % 5 != 0 && (x - word * 48) < wordLength) {
+            r = 30 + (h >> 16 & 0x3f);
+            g = 30 + (h >> 22 & 0x3f);
+            b = 40;
+        }
+    }
+
+    // 每256像素一条网格线
+    if ((x & 0xff) == 0 || (y & 0xff) == 0) {
+        r = g = b = 128;
+    }
+    return 0xff000000u | (r << 16) | (g << 8) | b;
+}
+
+QImage SyntheticFrameSource::grabScreen(int screenIndex, const QRect &localRect) {
+    if (screenIndex < 0 || screenIndex >= m_screens.size()) {
+        return QImage();
+    }
+    const Screen &screen = m_screens.at(screenIndex);
+    const QRect deviceRect = toDeviceRect(screen, localRect);
+    if (deviceRect.isEmpty()) {
+        return QImage();
+    }
+
+    QImage image(deviceRect.size(), QImage::Format_RGB32);
+    if (image.isNull()) {
+        return QImage();
+    }
+    const int originX = screen.geometry.x() + deviceRect.x();
+    const int originY = screen.geometry.y() + deviceRect.y() + m_scrollOffset;
+    for (int y = 0; y < image.height(); ++y) {
+        quint32 *row = reinterpret_cast<quint32 *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            row[x] = pixelAt(originX + x, originY + y);
+        }
+    }
+    image.setDevicePixelRatio(screen.devicePixelRatio);
+    return image;
+}
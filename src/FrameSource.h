@@ -0,0 +1,210 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file FrameSource.h
+ * @brief 可替换的屏幕帧来源
+ *
+ * 所有屏幕抓取都经过 FrameSource::current()，后端可在运行时切换：
+ * - Qt：QScreen::grabWindow（默认，全平台）
+ * - XShm：X11共享内存，直接把服务器端像素写入进程内存（X11/Xvfb）
+ * - Synthetic：确定性合成画面，无需显示器，用于基准测试
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include <QImage>
+#include <QRect>
+#include <QString>
+#include <QList>
+
+/**
+ * @class FrameSource
+ * @brief 屏幕帧来源接口
+ *
+ * 坐标约定：屏幕几何为全局逻辑坐标；grabScreen() 的区域为屏幕内的逻辑坐标，
+ * 返回设备像素的QImage并带上该屏幕的DPR。只能在GUI线程调用，
+ * isThreadSafe() 为真的来源可以在工作线程调用 grabScreenAt()
+ */
+class FrameSource
+{
+public:
+    /**
+     * @brief 后端类型
+     */
+    enum Kind {
+        KindQt = 0,         ///< QScreen::grabWindow
+        KindXShm,           ///< X11 共享内存
+        KindSynthetic       ///< 合成画面
+    };
+
+    /**
+     * @brief 屏幕描述
+     */
+    struct Screen {
+        QString name;               ///< 屏幕名称
+        QRect geometry;             ///< 全局逻辑几何
+        qreal devicePixelRatio = 1.0; ///< 设备像素比
+    };
+
+    virtual ~FrameSource();
+
+    /**
+     * @brief 后端类型
+     */
+    virtual Kind kind() const = 0;
+
+    /**
+     * @brief 当前屏幕布局
+     */
+    virtual QList<Screen> screens() const;
+
+    /**
+     * @brief 抓取屏幕
+     * @param screenIndex screens() 中的索引
+     * @param localRect 屏幕内的逻辑区域（空矩形表示整个屏幕）
+     * @return 设备像素图像（DPR为该屏幕的DPR，失败时为空）
+     */
+    virtual QImage grabScreen(int screenIndex, const QRect &localRect = QRect()) = 0;
+
+    /**
+     * @brief 按屏幕描述抓取（不查询屏幕布局）
+     *
+     * 默认实现在 screens() 中查找同名同几何的屏幕后调用 grabScreen()，只能在GUI线程调用
+     *
+     * @param screen 在GUI线程取得的屏幕描述
+     * @param localRect 屏幕内的逻辑区域（空矩形表示整个屏幕）
+     * @return 设备像素图像（失败或屏幕已不存在时为空）
+     */
+    virtual QImage grabScreenAt(const Screen &screen, const QRect &localRect = QRect());
+
+    /**
+     * @brief grabScreenAt() 能否在工作线程调用（与GUI线程的抓取互斥）
+     *
+     * 切换当前帧来源会销毁旧实例，调用方需保证此时没有进行中的工作线程抓取
+     */
+    virtual bool isThreadSafe() const { return false; }
+
+    /**
+     * @brief 虚拟桌面几何（所有屏幕的并集）
+     */
+    QRect virtualGeometry() const;
+
+    /**
+     * @brief 获取当前进程使用的帧来源
+     *
+     * 首次调用时按 CAPSTEP_FRAME_SOURCE 环境变量（qt / xshm / synthetic）选择，
+     * 后端不可用时回退到Qt
+     */
+    static FrameSource *current();
+
+    /**
+     * @brief 切换当前帧来源
+     * @param kind 后端类型
+     * @return 是否切换成功（后端不可用时保持原来源）
+     */
+    static bool setCurrent(Kind kind);
+
+    /**
+     * @brief 创建指定后端
+     * @param kind 后端类型
+     * @return 新实例（不可用时返回nullptr，调用方负责释放）
+     */
+    static FrameSource *create(Kind kind);
+
+    /**
+     * @brief 解析后端名称
+     * @param name 名称（qt / xshm / synthetic，不区分大小写）
+     * @param ok 是否解析成功
+     */
+    static Kind kindFromName(const QString &name, bool *ok = nullptr);
+
+    /**
+     * @brief 后端名称
+     */
+    static QString kindName(Kind kind);
+
+protected:
+    /**
+     * @brief 将屏幕内逻辑区域换算为设备像素区域（按边缘取整）
+     */
+    static QRect toDeviceRect(const Screen &screen, const QRect &localRect);
+};
+
+/**
+ * @class QtFrameSource
+ * @brief 基于 QScreen::grabWindow 的帧来源
+ */
+class QtFrameSource : public FrameSource
+{
+public:
+    Kind kind() const override { return KindQt; }
+    QImage grabScreen(int screenIndex, const QRect &localRect = QRect()) override;
+};
+
+/**
+ * @class SyntheticFrameSource
+ * @brief 确定性合成帧来源
+ *
+ * 画面只取决于屏幕布局、设备像素坐标和滚动偏移，相同参数下逐字节可复现。
+ * 画面包含渐变、网格和类文字色块，便于测试重采样和长截图拼接
+ */
+class SyntheticFrameSource : public FrameSource
+{
+public:
+    /**
+     * @brief 构造函数
+     *
+     * 默认布局为单屏1920x1080、DPR 1；CAPSTEP_SYNTHETIC_SCREENS 可指定布局，
+     * 格式为 "宽x高@DPR+X+Y;..."，例如 "1920x1080@1+0+0;1280x720@2+1920+0"
+     */
+    SyntheticFrameSource();
+
+    Kind kind() const override { return KindSynthetic; }
+    QList<Screen> screens() const override { return m_screens; }
+    QImage grabScreen(int screenIndex, const QRect &localRect = QRect()) override;
+
+    /**
+     * @brief 设置屏幕布局
+     */
+    void setScreens(const QList<Screen> &screens) { m_screens = screens; }
+
+    /**
+     * @brief 设置内容垂直滚动偏移（设备像素）
+     */
+    void setScrollOffset(int offset) { m_scrollOffset = offset; }
+    int scrollOffset() const { return m_scrollOffset; }
+
+    /**
+     * @brief 合成像素值
+     * @param x 全局设备像素横坐标
+     * @param y 全局设备像素纵坐标（已包含滚动偏移）
+     */
+    static quint32 pixelAt(int x, int y);
+
+private:
+    QList<Screen> m_screens;    ///< 屏幕布局
+    int m_scrollOffset;         ///< 滚动偏移
+};
+
+#endif // FRAMESOURCE_H
@@ -0,0 +1,132 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file FrozenAtlas.cpp
+ * @brief 虚拟桌面冻结画面图集实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "FrozenAtlas.h"
+#include "ImageView.h"
+#include "FrameSource.h"
+#include <QElapsedTimer>
+#include <QDebug>
+
+FrozenAtlas::FrozenAtlas()
+    : m_entries()
+    , m_virtualGeometry()
+{
+}
+
+int FrozenAtlas::freeze() {
+    FrameSource *source = FrameSource::current();
+    return freeze(source, source->screens());
+}
+
+int FrozenAtlas::freeze(FrameSource *source, const QList<FrameSource::Screen> &screens) {
+    clear();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 所有屏幕背靠背连续抓取，中间不插入任何绘制或事件处理，使各屏画面尽量处于同一时刻
+    for (int i = 0; i < screens.size(); ++i) {
+        const FrameSource::Screen &screen = screens.at(i);
+
+        Entry entry;
+        entry.screenName = screen.name;
+        entry.geometry = screen.geometry;
+        entry.image = source->grabScreenAt(screen);
+        if (entry.image.isNull()) {
+            qWarning() << "[Atlas] Failed to freeze screen:" << entry.screenName;
+            continue;
+        }
+        // 以实际抓取到的像素尺寸推算DPR，避免平台返回的DPR与缓冲区不一致
+        entry.devicePixelRatio = entry.geometry.width() > 0
+            ? qreal(entry.image.width()) / entry.geometry.width()
+            : screen.devicePixelRatio;
+        entry.image.setDevicePixelRatio(entry.devicePixelRatio);
+
+        m_virtualGeometry = m_virtualGeometry.united(entry.geometry);
+        m_entries.append(entry);
+
+        qDebug() << "[Atlas] Frozen screen:" << entry.screenName
+                 << "geometry:" << entry.geometry
+                 << "DPR:" << entry.devicePixelRatio
+                 << "size:" << entry.image.size();
+    }
+
+    qDebug() << "[Atlas] Froze" << m_entries.size() << "screens in" << timer.elapsed() << "ms,"
+             << "virtual geometry:" << m_virtualGeometry;
+    return m_entries.size();
+}
+
+void FrozenAtlas::clear() {
+    m_entries.clear();
+    m_virtualGeometry = QRect();
+}
+
+const FrozenAtlas::Entry *FrozenAtlas::entryAt(const QPoint &globalPos) const {
+    for (const Entry &entry : m_entries) {
+        if (entry.geometry.contains(globalPos)) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+QList<ScreenCaptureInfo> FrozenAtlas::segments(const QRect &globalRect) const {
+    QList<ScreenCaptureInfo> result;
+    if (globalRect.isEmpty()) {
+        return result;
+    }
+
+    for (const Entry &entry : m_entries) {
+        const QRect intersection = globalRect.intersected(entry.geometry);
+        if (intersection.isEmpty()) continue;
+
+        // 坐标转换：全局 → 屏幕本地 → 设备像素
+        const QRect localRect = intersection.translated(-entry.geometry.topLeft());
+        const QRect deviceRect = toDeviceRect(localRect, entry.devicePixelRatio, entry.image.rect());
+        if (deviceRect.isEmpty()) continue;
+
+        ImageView view(entry.image, deviceRect);
+        view.setDevicePixelRatio(entry.devicePixelRatio);
+        result.append({view.image(), intersection.topLeft()});
+
+        qDebug() << "[Atlas] Segment screen=" << entry.screenName
+                 << " intersection=" << intersection
+                 << " deviceRect=" << deviceRect;
+    }
+    return result;
+}
+
+QRect FrozenAtlas::toDeviceRect(const QRect &localRect, qreal dpr, const QRect &bounds) {
+    if (dpr == 1.0) {
+        return localRect.intersected(bounds);
+    }
+    const int left = qRound(localRect.x() * dpr);
+    const int top = qRound(localRect.y() * dpr);
+    const int right = qRound((localRect.x() + localRect.width()) * dpr);
+    const int bottom = qRound((localRect.y() + localRect.height()) * dpr);
+    return QRect(left, top, right - left, bottom - top).intersected(bounds);
+}
@@ -0,0 +1,150 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file FrozenAtlas.h
+ * @brief 虚拟桌面冻结画面图集
+ *
+ * 在区域选择开始时冻结所有屏幕，每个屏幕保留各自的设备像素比，
+ * 跨屏选区直接从图集中裁剪，无需二次截屏
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef FROZENATLAS_H
+#define FROZENATLAS_H
+
+#include <QImage>
+#include <QList>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+#include "FrameSource.h"
+
+/**
+ * @struct ScreenCaptureInfo
+ * @brief 屏幕截图信息结构体
+ *
+ * 用于存储单个屏幕的截图数据和其在全局坐标系中的位置
+ */
+struct ScreenCaptureInfo {
+    QImage image;          ///< 屏幕截图（设备像素，带DPR）
+    QPoint globalPos;      ///< 在全局坐标系中的位置
+};
+
+/**
+ * @class FrozenAtlas
+ * @brief 虚拟桌面冻结画面图集
+ *
+ * - 每个屏幕一张冻结图像，保留该屏幕自己的DPR
+ * - 提供按全局逻辑坐标裁剪的接口，返回共享缓冲区的零拷贝分段
+ * - 不持有任何窗口，可在选择器之外单独使用
+ */
+class FrozenAtlas
+{
+public:
+    /**
+     * @struct Entry
+     * @brief 单个屏幕的冻结画面
+     */
+    struct Entry {
+        QString screenName;     ///< 屏幕名称
+        QRect geometry;         ///< 屏幕几何（全局逻辑坐标）
+        qreal devicePixelRatio; ///< 屏幕DPR
+        QImage image;           ///< 冻结画面（设备像素）
+    };
+
+    FrozenAtlas();
+
+    /**
+     * @brief 冻结所有屏幕
+     *
+     * 所有屏幕在一次调用中连续抓取，保证各屏画面时间一致
+     *
+     * @return 成功冻结的屏幕数量
+     */
+    int freeze();
+
+    /**
+     * @brief 按给定屏幕布局冻结屏幕
+     *
+     * 屏幕布局需在GUI线程取得；source->isThreadSafe() 为真时可在工作线程调用
+     *
+     * @param source 帧来源
+     * @param screens 屏幕布局
+     * @return 成功冻结的屏幕数量
+     */
+    int freeze(FrameSource *source, const QList<FrameSource::Screen> &screens);
+
+    /**
+     * @brief 释放所有冻结画面
+     */
+    void clear();
+
+    /**
+     * @brief 是否为空
+     */
+    bool isEmpty() const { return m_entries.isEmpty(); }
+
+    /**
+     * @brief 获取所有屏幕条目
+     */
+    const QList<Entry> &entries() const { return m_entries; }
+
+    /**
+     * @brief 虚拟桌面几何（所有屏幕几何的并集，逻辑坐标）
+     */
+    QRect virtualGeometry() const { return m_virtualGeometry; }
+
+    /**
+     * @brief 查找包含指定全局坐标的屏幕条目
+     * @param globalPos 全局逻辑坐标
+     * @return 条目指针，未找到时返回nullptr
+     */
+    const Entry *entryAt(const QPoint &globalPos) const;
+
+    /**
+     * @brief 按全局选区裁剪出各屏幕的分段
+     *
+     * 每个分段都是对冻结画面的零拷贝子视图，保持所在屏幕的DPR
+     *
+     * @param globalRect 全局逻辑坐标选区
+     * @return 与选区相交的屏幕分段列表
+     */
+    QList<ScreenCaptureInfo> segments(const QRect &globalRect) const;
+
+    /**
+     * @brief 将屏幕本地逻辑矩形转换为设备像素矩形
+     *
+     * 按边缘取整而非按尺寸取整，保证相邻分段之间没有缝隙
+     *
+     * @param localRect 屏幕本地逻辑矩形
+     * @param dpr 设备像素比
+     * @param bounds 设备像素边界
+     * @return 设备像素矩形
+     */
+    static QRect toDeviceRect(const QRect &localRect, qreal dpr, const QRect &bounds);
+
+private:
+    QList<Entry> m_entries;     ///< 各屏幕冻结画面
+    QRect m_virtualGeometry;    ///< 虚拟桌面几何
+};
+
+#endif // FROZENATLAS_H
@@ -0,0 +1,289 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file HistoryBrowser.cpp
+ * @brief 历史截图浏览窗口实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "HistoryBrowser.h"
+#include "QoiCodec.h"
+#include <QAbstractListModel>
+#include <QStyledItemDelegate>
+#include <QListView>
+#include <QLabel>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPainter>
+#include <QFileSystemWatcher>
+#include <QFileInfo>
+#include <QDir>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QTimer>
+#include <QDesktopServices>
+#include <QUrl>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+
+constexpr int kCellPadding = 8;         ///< 单元格内边距
+constexpr int kLabelHeight = 18;        ///< 时间标签高度
+constexpr int kReloadDelayMs = 200;     ///< 文件变化后延迟刷新
+
+/**
+ * @brief 缩略图委托：直接绘制映射内存中的像素，不经过QPixmap/QIcon
+ */
+class ThumbnailDelegate : public QStyledItemDelegate
+{
+public:
+    ThumbnailDelegate(const ThumbnailPack *pack, QObject *parent)
+        : QStyledItemDelegate(parent)
+        , m_pack(pack)
+    {
+    }
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override
+    {
+        painter->save();
+        const QRect cell = option.rect.adjusted(2, 2, -2, -2);
+        const bool selected = option.state & QStyle::State_Selected;
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(selected ? QColor(0, 120, 215, 60) : QColor(245, 245, 248));
+        painter->drawRoundedRect(cell, 6, 6);
+
+        const int packIndex = m_pack->count() - 1 - index.row();
+        const QImage thumb = m_pack->thumbnail(packIndex);
+        if (!thumb.isNull()) {
+            const QRect area(cell.left() + kCellPadding, cell.top() + kCellPadding,
+                             ThumbnailPack::MaxWidth, ThumbnailPack::MaxHeight);
+            QRect target(QPoint(0, 0), thumb.size());
+            target.moveCenter(area.center());
+            painter->drawImage(target, thumb);
+        }
+
+        const QRect label(cell.left(), cell.bottom() - kLabelHeight - 2, cell.width(), kLabelHeight);
+        painter->setPen(QColor(80, 80, 80));
+        painter->drawText(label, Qt::AlignCenter, index.data(Qt::DisplayRole).toString());
+        painter->restore();
+    }
+
+    QSize sizeHint(const QStyleOptionViewItem &, const QModelIndex &) const override
+    {
+        return QSize(ThumbnailPack::MaxWidth + kCellPadding * 2 + 4,
+                     ThumbnailPack::MaxHeight + kCellPadding * 2 + kLabelHeight + 4);
+    }
+
+private:
+    const ThumbnailPack *m_pack;
+};
+
+} // namespace
+
+/**
+ * @brief 网格数据模型：最新的截图排在最前
+ */
+class HistoryThumbnailModel : public QAbstractListModel
+{
+public:
+    HistoryThumbnailModel(const ThumbnailPack *pack, QObject *parent)
+        : QAbstractListModel(parent)
+        , m_pack(pack)
+    {
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : m_pack->count();
+    }
+
+    QVariant data(const QModelIndex &index, int role) const override
+    {
+        const int packIndex = m_pack->count() - 1 - index.row();
+        switch (role) {
+        case Qt::DisplayRole:
+            return m_pack->timestamp(packIndex).toString("yyyy-MM-dd HH:mm:ss");
+        case Qt::ToolTipRole:
+        case Qt::UserRole:
+            return m_pack->fileName(packIndex);
+        default:
+            return QVariant();
+        }
+    }
+
+    void beginReload() { beginResetModel(); }
+    void endReload() { endResetModel(); }
+
+private:
+    const ThumbnailPack *m_pack;
+};
+
+HistoryBrowser::HistoryBrowser(const QString &folder, QWidget *parent)
+    : QWidget(parent, Qt::Window)
+    , m_folder(folder)
+    , m_pack(folder)
+    , m_model(nullptr)
+    , m_view(nullptr)
+    , m_statusLabel(nullptr)
+    , m_folderBtn(nullptr)
+    , m_watcher(nullptr)
+    , m_reloadTimer(nullptr)
+{
+    setAttribute(Qt::WA_DeleteOnClose);
+    setWindowTitle("历史截图");
+    resize(760, 560);
+
+    QElapsedTimer timer;
+    timer.start();
+    m_pack.openForRead();
+
+    m_model = new HistoryThumbnailModel(&m_pack, this);
+    m_view = new QListView(this);
+    m_view->setViewMode(QListView::IconMode);
+    m_view->setResizeMode(QListView::Adjust);
+    m_view->setMovement(QListView::Static);
+    m_view->setUniformItemSizes(true);
+    m_view->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_view->setItemDelegate(new ThumbnailDelegate(&m_pack, m_view));
+    m_view->setModel(m_model);
+
+    m_statusLabel = new QLabel(this);
+    m_folderBtn = new QPushButton("打开文件夹", this);
+
+    QHBoxLayout *bottom = new QHBoxLayout;
+    bottom->addWidget(m_statusLabel, 1);
+    bottom->addWidget(m_folderBtn);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(8, 8, 8, 8);
+    layout->addWidget(m_view, 1);
+    layout->addLayout(bottom);
+
+    connect(m_view, &QListView::activated, this, &HistoryBrowser::openEntry);
+    connect(m_folderBtn, &QPushButton::clicked, this, &HistoryBrowser::openFolderRequested);
+
+    // 历史写入线程追加缩略图时刷新；索引文件尚不存在时先监视文件夹
+    m_reloadTimer = new QTimer(this);
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(kReloadDelayMs);
+    connect(m_reloadTimer, &QTimer::timeout, this, &HistoryBrowser::reload);
+
+    m_watcher = new QFileSystemWatcher(this);
+    m_watcher->addPath(m_folder);
+    if (QFileInfo::exists(m_pack.indexPath())) {
+        m_watcher->addPath(m_pack.indexPath());
+    }
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, m_reloadTimer, qOverload<>(&QTimer::start));
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, m_reloadTimer, qOverload<>(&QTimer::start));
+
+    updateStatus();
+    qDebug() << "[HistoryBrowser] Opened" << m_pack.count() << "thumbnails in" << timer.elapsed() << "ms";
+}
+
+HistoryBrowser::~HistoryBrowser()
+{
+}
+
+void HistoryBrowser::reload() {
+    // 重新映射期间旧映射失效，必须包在模型重置中
+    const quint32 generation = m_pack.generation();
+    m_model->beginReload();
+    m_pack.refresh();
+    m_model->endReload();
+
+    // 压缩后索引文件被替换，原来的监视仍指向旧文件
+    if (m_pack.generation() != generation) {
+        m_watcher->removePath(m_pack.indexPath());
+    }
+    if (!m_watcher->files().contains(m_pack.indexPath()) && QFileInfo::exists(m_pack.indexPath())) {
+        m_watcher->addPath(m_pack.indexPath());
+    }
+    updateStatus();
+}
+
+void HistoryBrowser::openEntry(const QModelIndex &index) {
+    const QString fileName = index.data(Qt::UserRole).toString();
+    if (fileName.isEmpty()) {
+        return;
+    }
+    const QString filePath = resolveFile(fileName);
+    if (filePath.isEmpty()) {
+        m_statusLabel->setText(QString("原图已删除：%1").arg(fileName));
+        return;
+    }
+    // 系统查看器不认识QOI：尚未转换的截图先导出一份临时PNG
+    if (QFileInfo(filePath).suffix() == QoiCodec::Suffix) {
+        const QString exported = exportPng(filePath);
+        if (exported.isEmpty()) {
+            m_statusLabel->setText(QString("无法转换：%1").arg(fileName));
+            return;
+        }
+        QDesktopServices::openUrl(QUrl::fromLocalFile(exported));
+        return;
+    }
+    QDesktopServices::openUrl(QUrl::fromLocalFile(filePath));
+}
+
+QString HistoryBrowser::resolveFile(const QString &fileName) const {
+    const QString filePath = m_folder + "/" + fileName;
+    if (QFileInfo::exists(filePath)) {
+        return filePath;
+    }
+    // 缩略图记录的是写入时的文件名，QOI可能已在空闲时转为同名PNG
+    const QFileInfo info(filePath);
+    if (info.suffix() == QoiCodec::Suffix) {
+        const QString converted = m_folder + "/" + info.completeBaseName() + ".png";
+        if (QFileInfo::exists(converted)) {
+            return converted;
+        }
+    }
+    return QString();
+}
+
+QString HistoryBrowser::exportPng(const QString &qoiPath) const {
+    const QString dir = QDir::tempPath() + "/CapStep";
+    const QString target = dir + "/" + QFileInfo(qoiPath).completeBaseName() + ".png";
+    if (QFileInfo::exists(target)) {
+        return target;
+    }
+    const QImage image = QoiCodec::load(qoiPath);
+    QSaveFile file(target);
+    if (image.isNull() || !QDir().mkpath(dir) || !file.open(QIODevice::WriteOnly)) {
+        return QString();
+    }
+    QImageWriter writer(&file, "png");
+    if (!writer.write(image)) {
+        file.cancelWriting();
+        return QString();
+    }
+    return file.commit() ? target : QString();
+}
+
+void HistoryBrowser::updateStatus() {
+    if (m_pack.count() == 0) {
+        m_statusLabel->setText("暂无缩略图（新的截图会出现在这里）");
+    } else {
+        m_statusLabel->setText(QString("共 %1 张截图，双击打开原图").arg(m_pack.count()));
+    }
+}
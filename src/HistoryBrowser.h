@@ -0,0 +1,111 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file HistoryBrowser.h
+ * @brief 历史截图浏览窗口
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef HISTORYBROWSER_H
+#define HISTORYBROWSER_H
+
+#include <QWidget>
+#include "ThumbnailPack.h"
+
+class QListView;
+class QLabel;
+class QPushButton;
+class QFileSystemWatcher;
+class QTimer;
+class QModelIndex;
+class HistoryThumbnailModel;
+
+/**
+ * @class HistoryBrowser
+ * @brief 历史截图网格浏览窗口
+ *
+ * 网格直接绘制 ThumbnailPack 映射内存中的缩略图，只有可见单元格的页面会被读入，
+ * 打开时不解码任何原图。监视缩略图索引文件，新截图写入后自动刷新
+ */
+class HistoryBrowser : public QWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param folder 历史文件夹
+     * @param parent 父窗口
+     */
+    explicit HistoryBrowser(const QString &folder, QWidget *parent = nullptr);
+    ~HistoryBrowser();
+
+signals:
+    /**
+     * @brief 请求在文件管理器中打开历史文件夹
+     */
+    void openFolderRequested();
+
+private slots:
+    /**
+     * @brief 重新映射缩略图包并刷新网格
+     */
+    void reload();
+
+    /**
+     * @brief 用系统默认程序打开原图
+     * @param index 网格中的位置
+     */
+    void openEntry(const QModelIndex &index);
+
+private:
+    /**
+     * @brief 更新计数标签
+     */
+    void updateStatus();
+
+    /**
+     * @brief 查找原图（QOI已转为PNG时返回PNG）
+     * @param fileName 缩略图记录的文件名
+     * @return 文件路径（已删除时为空）
+     */
+    QString resolveFile(const QString &fileName) const;
+
+    /**
+     * @brief 把QOI原图导出为临时PNG，供系统查看器打开
+     * @param qoiPath QOI文件路径
+     * @return PNG路径（失败时为空）
+     */
+    QString exportPng(const QString &qoiPath) const;
+
+private:
+    QString m_folder;                   ///< 历史文件夹
+    ThumbnailPack m_pack;               ///< 缩略图包（只读映射）
+    HistoryThumbnailModel *m_model;     ///< 网格数据模型
+    QListView *m_view;                  ///< 网格视图
+    QLabel *m_statusLabel;              ///< 计数/提示标签
+    QPushButton *m_folderBtn;           ///< 打开文件夹按钮
+    QFileSystemWatcher *m_watcher;      ///< 缩略图索引文件监视
+    QTimer *m_reloadTimer;              ///< 合并连续的文件变化通知
+};
+
+#endif // HISTORYBROWSER_H
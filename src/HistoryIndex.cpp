@@ -0,0 +1,410 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file HistoryIndex.cpp
+ * @brief 历史截图二进制索引实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "HistoryIndex.h"
+#include "QoiCodec.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QDebug>
+#include <algorithm>
+#include <utility>
+#include <cstring>
+
+namespace {
+
+constexpr quint32 kMagic = 0x49485343;         ///< "CSHI"
+constexpr quint32 kVersion = 1;
+constexpr quint32 kFlagRemoved = 0x1;
+constexpr quint32 kFlagRecompressed = 0x2;
+
+/// 文件头
+struct DiskHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 recordSize;
+    quint32 reserved;
+};
+
+/// 磁盘记录（本机字节序）
+struct DiskRecord {
+    qint64 timestampMs;
+    quint32 width;
+    quint32 height;
+    double devicePixelRatio;
+    qint64 byteSize;
+    quint64 hashHigh;
+    quint64 hashLow;
+    qint32 rectX;
+    qint32 rectY;
+    qint32 rectWidth;
+    qint32 rectHeight;
+    quint32 flags;
+    quint32 reserved;
+    char screenName[16];
+    char fileName[40];
+};
+
+static_assert(sizeof(DiskHeader) == 16, "DiskHeader must be 16 bytes");
+static_assert(sizeof(DiskRecord) == 128, "DiskRecord must be 128 bytes");
+
+constexpr qint64 kHeaderSize = sizeof(DiskHeader);
+constexpr qint64 kRecordSize = sizeof(DiskRecord);
+
+/**
+ * @brief 按字符截断到指定UTF-8字节数以内并以0结尾
+ */
+void copyName(char *target, int capacity, const QString &name)
+{
+    QByteArray bytes = name.toUtf8();
+    QString truncated = name;
+    while (bytes.size() > capacity - 1) {
+        truncated.chop(1);
+        bytes = truncated.toUtf8();
+    }
+    memset(target, 0, size_t(capacity));
+    memcpy(target, bytes.constData(), size_t(bytes.size()));
+}
+
+DiskRecord toDisk(const HistoryIndex::Record &record)
+{
+    DiskRecord disk;
+    memset(&disk, 0, sizeof(disk));
+    disk.timestampMs = record.timestamp.toMSecsSinceEpoch();
+    disk.width = quint32(qMax(record.size.width(), 0));
+    disk.height = quint32(qMax(record.size.height(), 0));
+    disk.devicePixelRatio = record.devicePixelRatio;
+    disk.byteSize = record.byteSize;
+    disk.hashHigh = record.hash.high;
+    disk.hashLow = record.hash.low;
+    disk.rectX = record.captureRect.x();
+    disk.rectY = record.captureRect.y();
+    disk.rectWidth = qMax(record.captureRect.width(), 0);
+    disk.rectHeight = qMax(record.captureRect.height(), 0);
+    disk.flags = (record.removed ? kFlagRemoved : 0) | (record.recompressed ? kFlagRecompressed : 0);
+    copyName(disk.screenName, int(sizeof(disk.screenName)), record.screenName);
+    copyName(disk.fileName, int(sizeof(disk.fileName)), record.fileName);
+    return disk;
+}
+
+HistoryIndex::Record fromDisk(const DiskRecord &disk)
+{
+    HistoryIndex::Record record;
+    record.timestamp = QDateTime::fromMSecsSinceEpoch(disk.timestampMs);
+    record.size = QSize(int(disk.width), int(disk.height));
+    record.devicePixelRatio = disk.devicePixelRatio > 0 ? disk.devicePixelRatio : 1.0;
+    record.byteSize = disk.byteSize;
+    record.hash.high = disk.hashHigh;
+    record.hash.low = disk.hashLow;
+    if (disk.rectWidth > 0 && disk.rectHeight > 0) {
+        record.captureRect = QRect(disk.rectX, disk.rectY, disk.rectWidth, disk.rectHeight);
+    }
+    record.removed = disk.flags & kFlagRemoved;
+    record.recompressed = disk.flags & kFlagRecompressed;
+    record.screenName = QString::fromUtf8(disk.screenName, int(strnlen(disk.screenName, sizeof(disk.screenName))));
+    record.fileName = QString::fromUtf8(disk.fileName, int(strnlen(disk.fileName, sizeof(disk.fileName))));
+    return record;
+}
+
+QByteArray headerBytes()
+{
+    DiskHeader header = {kMagic, kVersion, quint32(kRecordSize), 0};
+    return QByteArray(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+/**
+ * @brief 历史文件夹中的图片文件（PNG，或以QOI快速写入、尚未转换的截图）
+ */
+QStringList imageFilters()
+{
+    return QStringList() << "*.png" << QString("*.%1").arg(QoiCodec::Suffix);
+}
+
+/**
+ * @brief 从文件名解析截图时间（yyyyMMdd_HHmmss[_zzz]），失败时用修改时间
+ */
+QDateTime timestampFor(const QFileInfo &info)
+{
+    const QString name = info.completeBaseName();
+    if (name.size() >= 23 && name.at(19) == '_') {
+        const QDateTime precise = QDateTime::fromString(name.left(23), "yyyyMMdd_HHmmss_zzz");
+        if (precise.isValid()) {
+            return precise;
+        }
+    }
+    const QDateTime coarse = QDateTime::fromString(name.left(15), "yyyyMMdd_HHmmss");
+    return coarse.isValid() ? coarse : info.lastModified();
+}
+
+} // namespace
+
+HistoryIndex::HistoryIndex(const QString &folder)
+    : m_folder(folder)
+    , m_file(folder + "/.history.idx")
+    , m_writable(false)
+    , m_sorted(true)
+    , m_records()
+{
+}
+
+HistoryIndex::~HistoryIndex()
+{
+    close();
+}
+
+bool HistoryIndex::open(bool writable) {
+    close();
+    if (!writable && !m_file.exists()) {
+        return false;
+    }
+    if (!m_file.open(writable ? QIODevice::ReadWrite : QIODevice::ReadOnly)) {
+        qWarning() << "[HistoryIndex] Cannot open" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+    m_writable = writable;
+
+    DiskHeader header;
+    const bool valid = m_file.read(reinterpret_cast<char *>(&header), sizeof(header)) == kHeaderSize
+                       && header.magic == kMagic && header.version == kVersion && header.recordSize == kRecordSize;
+    if (!valid) {
+        if (!writable) {
+            close();
+            return false;
+        }
+        if (m_file.size() > 0) {
+            qWarning() << "[HistoryIndex] Index unreadable, recreating (run compact to re-add files)";
+        }
+        return m_file.resize(0) && m_file.seek(0) && m_file.write(headerBytes()) == kHeaderSize && m_file.flush();
+    }
+
+    // 一次读入全部记录：一万张截图约1.2MB
+    const qint64 count = (m_file.size() - kHeaderSize) / kRecordSize;
+    const QByteArray data = m_file.read(count * kRecordSize);
+    m_records.reserve(int(count));
+    for (qint64 i = 0; i < count; ++i) {
+        DiskRecord disk;
+        memcpy(&disk, data.constData() + i * kRecordSize, sizeof(disk));
+        Record record = fromDisk(disk);
+        if (!m_records.isEmpty() && record.timestamp < m_records.last().timestamp) {
+            m_sorted = false;
+        }
+        m_records.append(record);
+    }
+    // 写入中途崩溃留下的半条记录
+    if (writable && m_file.size() != kHeaderSize + count * kRecordSize) {
+        m_file.resize(kHeaderSize + count * kRecordSize);
+    }
+    return true;
+}
+
+void HistoryIndex::close() {
+    m_file.close();
+    m_writable = false;
+    m_sorted = true;
+    m_records.clear();
+}
+
+bool HistoryIndex::writeRecord(qint64 position, const Record &record) {
+    const DiskRecord disk = toDisk(record);
+    return m_file.seek(position)
+           && m_file.write(reinterpret_cast<const char *>(&disk), sizeof(disk)) == kRecordSize;
+}
+
+bool HistoryIndex::append(const Record &record) {
+    if (!m_writable) {
+        return false;
+    }
+    if (record.fileName.toUtf8().size() > MaxFileNameBytes) {
+        qWarning() << "[HistoryIndex] File name too long for index:" << record.fileName;
+        return false;
+    }
+    if (!writeRecord(kHeaderSize + m_records.size() * kRecordSize, record) || !m_file.flush()) {
+        qWarning() << "[HistoryIndex] Failed to append record";
+        return false;
+    }
+    if (!m_records.isEmpty() && record.timestamp < m_records.last().timestamp) {
+        m_sorted = false;
+    }
+    m_records.append(record);
+    return true;
+}
+
+bool HistoryIndex::update(int index, const Record &record) {
+    if (!m_writable || index < 0 || index >= m_records.size()) {
+        return false;
+    }
+    Record updated = record;
+    if (updated.fileName.isEmpty() || updated.fileName.toUtf8().size() > MaxFileNameBytes) {
+        updated.fileName = m_records.at(index).fileName;
+    }
+    updated.timestamp = m_records.at(index).timestamp;
+    if (!writeRecord(kHeaderSize + index * kRecordSize, updated) || !m_file.flush()) {
+        return false;
+    }
+    m_records[index] = updated;
+    return true;
+}
+
+int HistoryIndex::lowerBound(const QDateTime &timestamp) const {
+    if (!m_sorted) {
+        for (int i = 0; i < m_records.size(); ++i) {
+            if (m_records.at(i).timestamp >= timestamp) {
+                return i;
+            }
+        }
+        return m_records.size();
+    }
+    auto it = std::lower_bound(m_records.cbegin(), m_records.cend(), timestamp,
+                               [](const Record &record, const QDateTime &value) { return record.timestamp < value; });
+    return int(it - m_records.cbegin());
+}
+
+QVector<int> HistoryIndex::range(const QDateTime &from, const QDateTime &to, bool includeRemoved) const {
+    QVector<int> result;
+    if (m_sorted) {
+        for (int i = lowerBound(from); i < m_records.size() && m_records.at(i).timestamp < to; ++i) {
+            if (includeRemoved || !m_records.at(i).removed) {
+                result.append(i);
+            }
+        }
+        return result;
+    }
+    for (int i = 0; i < m_records.size(); ++i) {
+        const Record &record = m_records.at(i);
+        if (record.timestamp >= from && record.timestamp < to && (includeRemoved || !record.removed)) {
+            result.append(i);
+        }
+    }
+    std::stable_sort(result.begin(), result.end(), [this](int a, int b) {
+        return m_records.at(a).timestamp < m_records.at(b).timestamp;
+    });
+    return result;
+}
+
+int HistoryIndex::find(const QString &fileName) const {
+    for (int i = m_records.size() - 1; i >= 0; --i) {
+        if (m_records.at(i).fileName == fileName) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int HistoryIndex::resync() {
+    if (!m_writable) {
+        return 0;
+    }
+    // 一次目录枚举代替逐条stat
+    const QStringList names = QDir(m_folder).entryList(imageFilters(), QDir::Files);
+    const QSet<QString> present(names.cbegin(), names.cend());
+
+    int marked = 0;
+    for (int i = 0; i < m_records.size(); ++i) {
+        Record &record = m_records[i];
+        if (record.removed || present.contains(record.fileName)) {
+            continue;
+        }
+        record.removed = true;
+        writeRecord(kHeaderSize + i * kRecordSize, record);
+        ++marked;
+    }
+    if (marked > 0) {
+        m_file.flush();
+        qDebug() << "[HistoryIndex] Resync marked" << marked << "removed files";
+    }
+    return marked;
+}
+
+bool HistoryIndex::compact(int *added, int *dropped) {
+    if (!m_writable) {
+        return false;
+    }
+    const QFileInfoList files = QDir(m_folder).entryInfoList(imageFilters(), QDir::Files);
+    QSet<QString> present;
+    for (const QFileInfo &info : files) {
+        present.insert(info.fileName());
+    }
+
+    QVector<Record> records;
+    QSet<QString> indexed;
+    for (const Record &record : std::as_const(m_records)) {
+        if (!record.removed && present.contains(record.fileName) && !indexed.contains(record.fileName)) {
+            records.append(record);
+            indexed.insert(record.fileName);
+        }
+    }
+    const int droppedCount = m_records.size() - records.size();
+
+    // 补录没有索引的图片（旧版本写入或索引丢失）
+    int addedCount = 0;
+    for (const QFileInfo &info : files) {
+        if (indexed.contains(info.fileName()) || info.fileName().toUtf8().size() > MaxFileNameBytes) {
+            continue;
+        }
+        const QImage image = QoiCodec::load(info.filePath());
+        if (image.isNull()) {
+            qWarning() << "[HistoryIndex] Skipping unreadable file" << info.fileName();
+            continue;
+        }
+        Record record;
+        record.timestamp = timestampFor(info);
+        record.size = image.size();
+        record.byteSize = info.size();
+        record.hash = PixelHash::of(image);
+        record.fileName = info.fileName();
+        records.append(record);
+        ++addedCount;
+    }
+    std::stable_sort(records.begin(), records.end(), [](const Record &a, const Record &b) {
+        return a.timestamp < b.timestamp;
+    });
+
+    QSaveFile file(m_file.fileName());
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(headerBytes());
+    for (const Record &record : std::as_const(records)) {
+        const DiskRecord disk = toDisk(record);
+        file.write(reinterpret_cast<const char *>(&disk), sizeof(disk));
+    }
+    // Windows不能替换仍被打开的文件：先关闭，提交后重新打开
+    m_file.close();
+    const bool ok = file.commit();
+    open(true);
+    if (!ok) {
+        qWarning() << "[HistoryIndex] Failed to write compacted index";
+        return false;
+    }
+
+    if (added) *added = addedCount;
+    if (dropped) *dropped = droppedCount;
+    qDebug() << "[HistoryIndex] Compacted:" << m_records.size() << "records," << addedCount << "added,"
+             << droppedCount << "dropped";
+    return true;
+}
@@ -0,0 +1,180 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file HistoryIndex.h
+ * @brief 历史截图二进制索引
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef HISTORYINDEX_H
+#define HISTORYINDEX_H
+
+#include <QFile>
+#include <QRect>
+#include <QString>
+#include <QVector>
+#include <QDateTime>
+#include "PixelHash.h"
+
+/**
+ * @class HistoryIndex
+ * @brief 历史截图二进制索引（历史文件夹中的 .history.idx）
+ *
+ * 每张截图一条128字节的定长记录，按写入顺序追加。写入线程分配的时间戳单调递增，
+ * 因此记录天然按时间排序，时间范围查询用二分查找（O(log n)）；
+ * 时钟回拨等原因导致乱序时退化为线性扫描，直到下一次 compact() 重新排序。
+ *
+ * 外部删除的文件由 resync() 标记为已删除（原地改写标志位，不移动记录），
+ * compact() 重写索引：去掉已删除的记录、补录文件夹中没有索引的图片（PNG/QOI）并按时间排序
+ */
+class HistoryIndex
+{
+public:
+    /**
+     * @brief 一条索引记录
+     */
+    struct Record {
+        QDateTime timestamp;            ///< 截图时间
+        QSize size;                     ///< 像素尺寸
+        qreal devicePixelRatio = 1.0;   ///< 设备像素比
+        qint64 byteSize = 0;            ///< 文件字节数
+        PixelHash hash;                 ///< 像素内容哈希
+        QString screenName;             ///< 来源屏幕（跨屏时为选区中心所在屏幕）
+        QRect captureRect;              ///< 截图区域（逻辑坐标，未知时为空）
+        QString fileName;               ///< 文件名（不含目录）
+        bool removed = false;           ///< 文件已被删除
+        bool recompressed = false;      ///< 已由保留策略重新压缩
+    };
+
+    /// 文件名最大字节数（UTF-8）
+    static constexpr int MaxFileNameBytes = 39;
+
+    /**
+     * @brief 构造函数
+     * @param folder 历史文件夹
+     */
+    explicit HistoryIndex(const QString &folder);
+    ~HistoryIndex();
+
+    /**
+     * @brief 打开索引并载入全部记录
+     * @param writable 是否允许追加和修改（同一时间只应有一个写入方）
+     * @return 是否成功（只读方式下文件不存在时返回false）
+     */
+    bool open(bool writable);
+
+    /**
+     * @brief 关闭索引
+     */
+    void close();
+
+    /**
+     * @brief 是否已打开
+     */
+    bool isOpen() const { return m_file.isOpen(); }
+
+    /**
+     * @brief 获取记录数（包括已删除的记录）
+     */
+    int count() const { return m_records.size(); }
+
+    /**
+     * @brief 获取记录
+     * @param index 序号
+     */
+    const Record &record(int index) const { return m_records.at(index); }
+
+    /**
+     * @brief 追加一条记录
+     * @param record 记录
+     * @return 是否成功
+     */
+    bool append(const Record &record);
+
+    /**
+     * @brief 原地更新一条记录（时间戳以外的字段，包括转换格式后的文件名）
+     * @param index 序号
+     * @param record 新内容
+     * @return 是否成功
+     */
+    bool update(int index, const Record &record);
+
+    /**
+     * @brief 查找第一条时间不早于指定时间的记录
+     * @param timestamp 时间
+     * @return 序号（没有时返回 count()）
+     */
+    int lowerBound(const QDateTime &timestamp) const;
+
+    /**
+     * @brief 查询时间范围 [from, to) 内的记录
+     * @param from 起始时间（包含）
+     * @param to 结束时间（不包含）
+     * @param includeRemoved 是否包括已删除的记录
+     * @return 记录序号列表（按时间顺序）
+     */
+    QVector<int> range(const QDateTime &from, const QDateTime &to, bool includeRemoved = false) const;
+
+    /**
+     * @brief 查找文件对应的最新记录
+     * @param fileName 文件名
+     * @return 序号（没有时返回-1）
+     */
+    int find(const QString &fileName) const;
+
+    /**
+     * @brief 将文件已不存在的记录标记为已删除
+     * @return 本次新标记的记录数
+     */
+    int resync();
+
+    /**
+     * @brief 重写索引：去掉已删除的记录，补录没有索引的图片，按时间排序
+     *
+     * 补录的文件需要解码以计算内容哈希，只应在后台线程或命令行中调用
+     *
+     * @param added 输出：补录的记录数
+     * @param dropped 输出：去掉的记录数
+     * @return 是否成功
+     */
+    bool compact(int *added = nullptr, int *dropped = nullptr);
+
+    /**
+     * @brief 获取索引文件路径
+     */
+    QString filePath() const { return m_file.fileName(); }
+
+private:
+    /**
+     * @brief 把记录写到文件指定位置
+     */
+    bool writeRecord(qint64 position, const Record &record);
+
+private:
+    QString m_folder;               ///< 历史文件夹
+    QFile m_file;                   ///< 索引文件
+    bool m_writable;                ///< 是否可写
+    bool m_sorted;                  ///< 记录是否按时间排序
+    QVector<Record> m_records;      ///< 全部记录
+};
+
+#endif // HISTORYINDEX_H
@@ -0,0 +1,430 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file HistoryRetention.cpp
+ * @brief 历史截图保留策略与后台压缩实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "HistoryRetention.h"
+#include "HistoryIndex.h"
+#include "HistoryWriter.h"
+#include "QoiCodec.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QImageWriter>
+#include <QHash>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <cstdio>
+#endif
+
+namespace {
+
+constexpr int kThrottleSliceMs = 50;    ///< 限速等待时每次休眠的最长时间
+
+/**
+ * @brief 是否为QOI文件名
+ */
+bool isQoiName(const QString &name)
+{
+    return QFileInfo(name).suffix().compare(QoiCodec::Suffix, Qt::CaseInsensitive) == 0;
+}
+
+/**
+ * @brief 重新压缩后的路径：QOI换成同名PNG，PNG保持不变
+ */
+QString pngPathFor(const QString &path)
+{
+    return isQoiName(path) ? path.left(path.size() - 4) + ".png" : path;
+}
+
+/**
+ * @brief 原子地把 from 改名为 to，to 已存在时直接替换（不存在先删除后改名的中间状态）
+ */
+bool replaceFile(const QString &from, const QString &to)
+{
+#ifdef Q_OS_WIN
+    return MoveFileExW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(from).utf16()),
+                       reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(to).utf16()),
+                       MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0;
+#endif
+}
+
+/**
+ * @brief 把 oldPath 替换为指向 source 的硬链接 newPath（两者可以相同）
+ *
+ * 先链接到临时名再原子替换 newPath，新链接就位后才删除 oldPath；
+ * 任何一步失败时旧文件保持不动
+ */
+bool relink(const QString &source, const QString &oldPath, const QString &newPath)
+{
+    const QString temp = newPath + ".relink";
+    QFile::remove(temp);
+    if (!HistoryWriter::createHardLink(source, temp)) {
+        return false;
+    }
+    if (!replaceFile(temp, newPath)) {
+        QFile::remove(temp);
+        return false;
+    }
+    // rename(2) 遇到同一文件的两个链接时什么也不做，临时名可能仍在
+    QFile::remove(temp);
+    if (newPath != oldPath && !QFile::remove(oldPath)) {
+        qWarning() << "[Retention] Cannot remove old link" << QFileInfo(oldPath).fileName();
+    }
+    return true;
+}
+
+/**
+ * @brief 统计每种内容仍存在的链接数
+ */
+QHash<PixelHash, int> liveLinks(const HistoryIndex *index)
+{
+    QHash<PixelHash, int> links;
+    for (int i = 0; i < index->count(); ++i) {
+        const HistoryIndex::Record &record = index->record(i);
+        if (!record.removed && !record.hash.isNull()) {
+            ++links[record.hash];
+        }
+    }
+    return links;
+}
+
+/**
+ * @brief 删除一条记录后是否释放了磁盘空间（同内容的最后一个链接）
+ */
+bool releasesSpace(const HistoryIndex::Record &record, QHash<PixelHash, int> *links)
+{
+    if (record.hash.isNull()) {
+        return true;
+    }
+    auto it = links->find(record.hash);
+    return it == links->end() || --it.value() <= 0;
+}
+
+} // namespace
+
+HistoryRetention::HistoryRetention(const QString &folder, HistoryIndex *index, const Policy &policy)
+    : m_folder(folder)
+    , m_index(index)
+    , m_policy(policy)
+{
+}
+
+HistoryRetention::Result HistoryRetention::run(const std::function<bool()> &shouldYield) {
+    Result result;
+    if (!m_index || !m_policy.isActive()) {
+        return result;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    m_shouldYield = shouldYield;
+    const bool finished = expire(&result) && enforceBudget(&result) && recompress(&result);
+    m_shouldYield = nullptr;
+    result.interrupted = !finished;
+
+    if (result.deleted > 0 || result.recompressed > 0 || result.interrupted) {
+        qDebug() << "[Retention]" << result.deleted << "deleted," << result.recompressed << "recompressed,"
+                 << (result.bytesFreed >> 10) << "KB freed in" << timer.elapsed() << "ms"
+                 << (result.interrupted ? "(interrupted)" : "");
+    }
+    return result;
+}
+
+bool HistoryRetention::removeEntry(int index) {
+    HistoryIndex::Record record = m_index->record(index);
+    const QString path = m_folder + "/" + record.fileName;
+    // 文件被占用（正在查看）时保留，下次再试
+    if (QFile::exists(path) && !QFile::remove(path)) {
+        qWarning() << "[Retention] Cannot remove" << record.fileName;
+        return false;
+    }
+    record.removed = true;
+    m_index->update(index, record);
+    return true;
+}
+
+bool HistoryRetention::expire(Result *result) {
+    if (m_policy.maxAgeDays <= 0) {
+        return true;
+    }
+    const QDateTime cutoff = QDateTime::currentDateTime().addDays(-m_policy.maxAgeDays);
+    QHash<PixelHash, int> links = liveLinks(m_index);
+
+    // 记录基本按时间排序，但时钟回拨后可能乱序，这里不依赖顺序
+    for (int i = 0; i < m_index->count(); ++i) {
+        const HistoryIndex::Record &record = m_index->record(i);
+        if (record.removed || record.timestamp >= cutoff) {
+            continue;
+        }
+        if (m_shouldYield()) {
+            return false;
+        }
+        const qint64 bytes = record.byteSize;
+        const bool freed = releasesSpace(record, &links);
+        if (removeEntry(i)) {
+            ++result->deleted;
+            result->bytesFreed += freed ? bytes : 0;
+        }
+    }
+    return true;
+}
+
+bool HistoryRetention::enforceBudget(Result *result) {
+    if (m_policy.maxTotalBytes <= 0) {
+        return true;
+    }
+
+    // 同内容的硬链接共享数据，只计一份
+    QHash<PixelHash, int> links;
+    QVector<int> order;
+    qint64 total = 0;
+    for (int i = 0; i < m_index->count(); ++i) {
+        const HistoryIndex::Record &record = m_index->record(i);
+        if (record.removed) {
+            continue;
+        }
+        order.append(i);
+        if (record.hash.isNull() || links[record.hash]++ == 0) {
+            total += record.byteSize;
+        }
+    }
+    if (total <= m_policy.maxTotalBytes) {
+        return true;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return m_index->record(a).timestamp < m_index->record(b).timestamp;
+    });
+
+    // 最新的一张总是保留
+    for (int n = 0; n + 1 < order.size() && total > m_policy.maxTotalBytes; ++n) {
+        if (m_shouldYield()) {
+            return false;
+        }
+        const int i = order.at(n);
+        const HistoryIndex::Record &record = m_index->record(i);
+        const qint64 bytes = record.byteSize;
+        const bool freed = releasesSpace(record, &links);
+        if (removeEntry(i)) {
+            ++result->deleted;
+            if (freed) {
+                total -= bytes;
+                result->bytesFreed += bytes;
+            }
+        }
+    }
+    return true;
+}
+
+bool HistoryRetention::recompress(Result *result) {
+    if (m_policy.recompressAfterDays <= 0 && !m_policy.transcodeQoi) {
+        return true;
+    }
+    const QDateTime cutoff = QDateTime::currentDateTime().addDays(-m_policy.recompressAfterDays);
+
+    QHash<PixelHash, QVector<int>> groups;
+    for (int i = 0; i < m_index->count(); ++i) {
+        const HistoryIndex::Record &record = m_index->record(i);
+        if (!record.removed && !record.hash.isNull()) {
+            groups[record.hash].append(i);
+        }
+    }
+
+    for (int i = 0; i < m_index->count(); ++i) {
+        const HistoryIndex::Record &record = m_index->record(i);
+        if (record.removed || record.recompressed) {
+            continue;
+        }
+        // QOI只是快速写入格式，不论新旧都在空闲时转为PNG
+        const bool transcode = m_policy.transcodeQoi && isQoiName(record.fileName);
+        if (!transcode && (m_policy.recompressAfterDays <= 0 || record.timestamp >= cutoff)) {
+            continue;
+        }
+        if (m_shouldYield()) {
+            return false;
+        }
+        const QVector<int> group = record.hash.isNull() ? QVector<int>{i} : groups.value(record.hash);
+        const qint64 io = recompressGroup(i, group, result);
+        if (!throttle(io)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+qint64 HistoryRetention::recompressGroup(int index, const QVector<int> &group, Result *result) {
+    const QString fileName = m_index->record(index).fileName;
+    const QString path = m_folder + "/" + fileName;
+    const QFileInfo info(path);
+    if (!info.exists()) {
+        return 0;
+    }
+    const bool transcode = isQoiName(fileName);
+    const QString target = pngPathFor(path);
+    const qint64 oldSize = info.size();
+    qint64 newSize = -1;
+
+    const QImage image = QoiCodec::load(path);
+    if (image.isNull()) {
+        qWarning() << "[Retention] Cannot decode" << fileName;
+    } else {
+        QSaveFile file(target);
+        if (file.open(QIODevice::WriteOnly)) {
+            QImageWriter writer(&file, "png");
+            // PNG的质量参数映射为zlib压缩级别，0为最高压缩
+            writer.setQuality(0);
+            // QOI总是转换；PNG只在变小时替换，已经足够紧凑（或编码失败）时保留原文件
+            if (writer.write(densest(image)) && (transcode || file.size() < oldSize)) {
+                const qint64 size = file.size();
+                if (file.commit()) {
+                    newSize = size;
+                }
+            } else {
+                file.cancelWriting();
+            }
+        }
+    }
+
+    const bool replaced = newSize >= 0;
+    if (replaced) {
+        // 保留原修改时间，文件管理器中的排序不变
+        QFile touched(target);
+        if (touched.open(QIODevice::Append)) {
+            touched.setFileTime(info.lastModified(), QFileDevice::FileModificationTime);
+        }
+        if (transcode && !QFile::remove(path)) {
+            qWarning() << "[Retention] Cannot remove transcoded" << fileName;
+        }
+        ++result->recompressed;
+        result->bytesFreed += qMax<qint64>(0, oldSize - newSize);
+    }
+
+    for (int i : group) {
+        HistoryIndex::Record record = m_index->record(i);
+        if (record.removed) {
+            continue;
+        }
+        if (replaced) {
+            const QString other = m_folder + "/" + record.fileName;
+            const QString otherTarget = pngPathFor(other);
+            // 同内容的其他记录原先链接到旧文件，改为链接到新文件
+            if (record.fileName == fileName || relink(target, other, otherTarget)) {
+                record.fileName = QFileInfo(otherTarget).fileName();
+                record.byteSize = newSize;
+            } else {
+                qWarning() << "[Retention] Cannot relink" << record.fileName;
+            }
+        }
+        // 解码失败或没有变小的文件也标记，不再反复尝试；同组中还没转换的QOI留到轮到它时再转
+        record.recompressed = !isQoiName(record.fileName) || (i == index && !replaced);
+        m_index->update(i, record);
+    }
+    return oldSize + qMax<qint64>(0, newSize);
+}
+
+bool HistoryRetention::throttle(qint64 bytes) {
+    if (m_policy.ioBytesPerSecond > 0 && bytes > 0) {
+        const qint64 waitMs = bytes * 1000 / m_policy.ioBytesPerSecond;
+        QElapsedTimer timer;
+        timer.start();
+        while (timer.elapsed() < waitMs) {
+            if (m_shouldYield()) {
+                return false;
+            }
+            QThread::msleep(qMin<qint64>(kThrottleSliceMs, waitMs - timer.elapsed()));
+        }
+    }
+    return !m_shouldYield();
+}
+
+QImage HistoryRetention::densest(const QImage &image) {
+    QImage source;
+    switch (image.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+        source = image;
+        break;
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGB888:
+        source = image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+        break;
+    default:
+        // 已是调色板图像，或16位等转换会丢精度的格式
+        return image;
+    }
+
+    QHash<QRgb, int> palette;
+    palette.reserve(256);
+    QImage indexed(source.size(), QImage::Format_Indexed8);
+    if (indexed.isNull()) {
+        return image;
+    }
+
+    for (int y = 0; y < source.height(); ++y) {
+        const QRgb *src = reinterpret_cast<const QRgb *>(source.constScanLine(y));
+        uchar *dst = indexed.scanLine(y);
+        // 界面截图大多是同色连续像素，缓存上一个像素省去大部分查表
+        QRgb lastColor = src[0];
+        int lastIndex = -1;
+        for (int x = 0; x < source.width(); ++x) {
+            const QRgb color = src[x];
+            if (color != lastColor || lastIndex < 0) {
+                auto it = palette.constFind(color);
+                if (it == palette.constEnd()) {
+                    if (palette.size() == 256) {
+                        return image;
+                    }
+                    it = palette.insert(color, palette.size());
+                }
+                lastColor = color;
+                lastIndex = it.value();
+            }
+            dst[x] = uchar(lastIndex);
+        }
+    }
+
+    QVector<QRgb> colorTable(palette.size());
+    for (auto it = palette.constBegin(); it != palette.constEnd(); ++it) {
+        colorTable[it.value()] = it.key();
+    }
+    indexed.setColorTable(colorTable);
+    indexed.setDotsPerMeterX(image.dotsPerMeterX());
+    indexed.setDotsPerMeterY(image.dotsPerMeterY());
+    indexed.setDevicePixelRatio(image.devicePixelRatio());
+    for (const QString &key : image.textKeys()) {
+        indexed.setText(key, image.text(key));
+    }
+    return indexed;
+}
@@ -0,0 +1,147 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file HistoryRetention.h
+ * @brief 历史截图保留策略与后台压缩
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef HISTORYRETENTION_H
+#define HISTORYRETENTION_H
+
+#include <QString>
+#include <QImage>
+#include <QVector>
+#include <functional>
+
+class HistoryIndex;
+
+/**
+ * @class HistoryRetention
+ * @brief 按策略清理和重新压缩历史截图
+ *
+ * 一次 run() 依次执行：
+ * 1. 删除超过保留天数的截图
+ * 2. 总大小超出上限时从最旧的截图开始删除（硬链接的重复截图只计一份大小，
+ *    删除最后一个链接才真正释放空间）
+ * 3. 较旧的截图重新编码为更紧凑的无损PNG（颜色不超过256种时转为调色板图像，
+ *    zlib最高压缩级别），变小才替换；以QOI快速写入的截图不论新旧都转为同名PNG。
+ *    同内容的硬链接重新指向新文件
+ *
+ * 只能在持有可写索引的线程（历史写入线程）中调用。每处理一个文件都会询问是否让出，
+ * 有新截图要写入时立即返回，下次空闲时从头继续；重新编码按字节数限速，避免占满磁盘带宽
+ */
+class HistoryRetention
+{
+public:
+    /**
+     * @brief 保留策略（0表示不限制/不启用）
+     */
+    struct Policy {
+        qint64 maxTotalBytes = 0;           ///< 历史文件夹总大小上限
+        int maxAgeDays = 0;                 ///< 保留天数
+        int recompressAfterDays = 7;        ///< 超过该天数的截图重新压缩
+        bool transcodeQoi = true;           ///< 空闲时把QOI截图转为PNG
+        qint64 ioBytesPerSecond = 8ll << 20; ///< 重新压缩的读写限速
+
+        bool isActive() const
+        {
+            return maxTotalBytes > 0 || maxAgeDays > 0 || recompressAfterDays > 0 || transcodeQoi;
+        }
+    };
+
+    /**
+     * @brief 一次运行的结果
+     */
+    struct Result {
+        int deleted = 0;            ///< 删除的记录数
+        int recompressed = 0;       ///< 重新压缩的文件数
+        qint64 bytesFreed = 0;      ///< 释放的字节数
+        bool interrupted = false;   ///< 是否因让出而提前结束
+    };
+
+    /**
+     * @brief 构造函数
+     * @param folder 历史文件夹
+     * @param index 已以可写方式打开的历史索引
+     * @param policy 保留策略
+     */
+    HistoryRetention(const QString &folder, HistoryIndex *index, const Policy &policy);
+
+    /**
+     * @brief 执行一次清理和压缩
+     * @param shouldYield 返回true时尽快结束（有新截图待写入或正在退出）
+     * @return 运行结果
+     */
+    Result run(const std::function<bool()> &shouldYield);
+
+    /**
+     * @brief 把图像转换为最紧凑的无损表示（颜色不超过256种时转为调色板图像）
+     * @param image 原图
+     * @return 像素完全相同的图像
+     */
+    static QImage densest(const QImage &image);
+
+private:
+    /**
+     * @brief 删除一条记录对应的文件并在索引中标记
+     * @return 文件是否已不存在
+     */
+    bool removeEntry(int index);
+
+    /**
+     * @brief 删除超过保留天数的截图
+     */
+    bool expire(Result *result);
+
+    /**
+     * @brief 删除最旧的截图直到总大小不超过上限
+     */
+    bool enforceBudget(Result *result);
+
+    /**
+     * @brief 重新压缩较旧的截图
+     */
+    bool recompress(Result *result);
+
+    /**
+     * @brief 重新压缩（或把QOI转为PNG）一个文件并把同内容的其他记录链接到新文件
+     * @param index 记录序号
+     * @param group 同内容的全部记录序号（包括 index）
+     * @return 处理的读写字节数
+     */
+    qint64 recompressGroup(int index, const QVector<int> &group, Result *result);
+
+    /**
+     * @brief 按限速等待
+     * @return false表示等待期间需要让出
+     */
+    bool throttle(qint64 bytes);
+
+private:
+    QString m_folder;                       ///< 历史文件夹
+    HistoryIndex *m_index;                  ///< 历史索引
+    Policy m_policy;                        ///< 保留策略
+    std::function<bool()> m_shouldYield;    ///< 让出判断（run期间有效）
+};
+
+#endif // HISTORYRETENTION_H
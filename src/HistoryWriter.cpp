@@ -0,0 +1,550 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file HistoryWriter.cpp
+ * @brief 历史截图后台写入线程实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "HistoryWriter.h"
+#include "ThumbnailPack.h"
+#include "HistoryIndex.h"
+#include "QoiCodec.h"
+#include "PngEncoder.h"
+#include "EncodedImageCache.h"
+#include "TiledImage.h"
+#include <QThread>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QMutexLocker>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include <QSet>
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int kResyncDelayMs = 1000;            ///< 文件夹变化后延迟同步索引
+constexpr int kRetentionIntervalMs = 10 * 60000; ///< 保留策略检查间隔
+constexpr qint64 kRetentionIdleMs = 2 * 60000;   ///< 没有新截图多久后才清理
+constexpr int kCompactRemovedDivisor = 4;        ///< 已删除的记录超过总数的 1/4 时自动重写索引和缩略图包
+
+/**
+ * @brief 记录在队列中占用的像素字节数（分块长图只计常驻内存的部分）
+ */
+qint64 queuedBytes(const HistoryWriter::Entry &entry)
+{
+    return entry.image.sizeInBytes() + (entry.tiled ? entry.tiled->residentBytes() : 0);
+}
+
+/**
+ * @brief 索引中标记为已删除的记录数
+ */
+int removedRecords(const HistoryIndex &index)
+{
+    int removed = 0;
+    for (int i = 0; i < index.count(); ++i) {
+        if (index.record(i).removed) {
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+} // namespace
+
+HistoryWriter::HistoryWriter(const QString &folder, qint64 maxQueuedBytes, OverflowPolicy policy, QObject *parent)
+    : QObject(parent)
+    , m_folder(folder)
+    , m_maxQueuedBytes(qMax<qint64>(maxQueuedBytes, 1))
+    , m_policy(policy)
+    , m_thread(nullptr)
+    , m_fileFormat(FormatPng)
+    , m_lastId(0)
+    , m_lastTimestamp(0)
+    , m_folderReady(false)
+    , m_ownModified()
+    , m_contents()
+    , m_index(nullptr)
+    , m_thumbnails(nullptr)
+    , m_watcher(nullptr)
+    , m_resyncTimer(nullptr)
+    , m_retentionTimer(nullptr)
+    , m_sinceEnqueue()
+    , m_queuedBytes(0)
+    , m_stopping(false)
+    , m_resyncRequested(false)
+    , m_compactRequested(false)
+    , m_retentionRequested(false)
+    , m_retentionPolicy()
+{
+    // 文件夹被外部修改（删除截图）后在写入线程中同步索引；
+    // 自身写入（临时文件重命名、索引和缩略图追加）也会触发通知，由写入线程按文件夹修改时间过滤
+    QDir().mkpath(m_folder);
+    m_resyncTimer = new QTimer(this);
+    m_resyncTimer->setSingleShot(true);
+    m_resyncTimer->setInterval(kResyncDelayMs);
+    connect(m_resyncTimer, &QTimer::timeout, this, &HistoryWriter::requestResync);
+    m_watcher = new QFileSystemWatcher(QStringList() << m_folder, this);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, m_resyncTimer, qOverload<>(&QTimer::start));
+
+    // 保留策略只在空闲时执行，首次检查也在启动一个间隔之后，不拖慢启动
+    m_retentionTimer = new QTimer(this);
+    m_retentionTimer->setInterval(kRetentionIntervalMs);
+    connect(m_retentionTimer, &QTimer::timeout, this, &HistoryWriter::onRetentionTimer);
+    m_retentionTimer->start();
+
+    m_thread = QThread::create([this]() { writerLoop(); });
+    m_thread->setObjectName("HistoryWriter");
+    m_thread->start(QThread::LowPriority);
+}
+
+HistoryWriter::~HistoryWriter()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        if (!m_queue.isEmpty()) {
+            qDebug() << "[History] Flushing" << m_queue.size() << "pending screenshots";
+        }
+        m_notEmpty.wakeAll();
+    }
+    // 退出前写完队列，不丢弃任何截图
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    delete m_thumbnails;
+    m_thumbnails = nullptr;
+    delete m_index;
+    m_index = nullptr;
+}
+
+quint64 HistoryWriter::enqueue(const QImage &image, const QRect &captureRect, const QString &screenName) {
+    if (image.isNull()) {
+        return 0;
+    }
+
+    Entry entry;
+    entry.image = image;
+    entry.captureRect = captureRect;
+    entry.screenName = screenName;
+    return enqueueEntry(entry, m_fileFormat == FormatQoi ? QoiCodec::Suffix : "png");
+}
+
+quint64 HistoryWriter::enqueueTiled(const QSharedPointer<const TiledImage> &image, const QImage &preview,
+                                    const QRect &captureRect, const QString &screenName) {
+    if (!image || image->height() == 0 || preview.isNull()) {
+        return 0;
+    }
+
+    Entry entry;
+    entry.image = preview;
+    entry.tiled = image;
+    entry.captureRect = captureRect;
+    entry.screenName = screenName;
+    // QOI编码需要整幅图像，长图总是按段写PNG
+    return enqueueEntry(entry, "png");
+}
+
+quint64 HistoryWriter::enqueueEntry(Entry entry, const QString &suffix) {
+    // ID与时间戳都只在GUI线程分配：时钟回拨时沿用上一次的时间戳，文件名保持单调递增
+    entry.id = ++m_lastId;
+    m_lastTimestamp = qMax(QDateTime::currentMSecsSinceEpoch(), m_lastTimestamp);
+    entry.timestamp = QDateTime::fromMSecsSinceEpoch(m_lastTimestamp);
+    entry.fileName = QString("%1_%2.%3")
+                         .arg(entry.timestamp.toString("yyyyMMdd_HHmmss_zzz"))
+                         .arg(entry.id, 4, 10, QChar('0'))
+                         .arg(suffix);
+    m_sinceEnqueue.start();
+    const qint64 bytes = queuedBytes(entry);
+
+    QList<Entry> dropped;
+    {
+        QMutexLocker locker(&m_mutex);
+        // 队列为空时总是接收，单张超过上限的截图也能写入
+        while (m_queuedBytes + bytes > m_maxQueuedBytes && !m_queue.isEmpty()) {
+            if (m_policy == OverflowDropOldest) {
+                Entry oldest = m_queue.dequeue();
+                m_queuedBytes -= queuedBytes(oldest);
+                dropped.append(oldest);
+            } else {
+                m_notFull.wait(&m_mutex);
+            }
+        }
+        m_queue.enqueue(entry);
+        m_queuedBytes += bytes;
+        m_notEmpty.wakeOne();
+    }
+
+    for (const Entry &oldest : dropped) {
+        qWarning() << "[History] Queue full, dropped screenshot" << oldest.fileName;
+        report(oldest.id, m_folder + "/" + oldest.fileName, false);
+    }
+    if (!dropped.isEmpty()) {
+        emit entriesDropped(int(dropped.size()));
+    }
+    return entry.id;
+}
+
+void HistoryWriter::requestResync() {
+    QMutexLocker locker(&m_mutex);
+    m_resyncRequested = true;
+    m_notEmpty.wakeOne();
+}
+
+void HistoryWriter::requestCompact() {
+    QMutexLocker locker(&m_mutex);
+    m_compactRequested = true;
+    m_notEmpty.wakeOne();
+}
+
+void HistoryWriter::setRetentionPolicy(const HistoryRetention::Policy &policy) {
+    QMutexLocker locker(&m_mutex);
+    m_retentionPolicy = policy;
+}
+
+void HistoryWriter::requestRetention() {
+    QMutexLocker locker(&m_mutex);
+    m_retentionRequested = true;
+    m_notEmpty.wakeOne();
+}
+
+void HistoryWriter::onRetentionTimer() {
+    if (m_sinceEnqueue.isValid() && m_sinceEnqueue.elapsed() < kRetentionIdleMs) {
+        return;
+    }
+    requestRetention();
+}
+
+bool HistoryWriter::createHardLink(const QString &existing, const QString &link) {
+#ifdef Q_OS_WIN
+    return CreateHardLinkW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(link).utf16()),
+                           reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(existing).utf16()),
+                           nullptr) != 0;
+#else
+    return ::link(QFile::encodeName(existing).constData(), QFile::encodeName(link).constData()) == 0;
+#endif
+}
+
+int HistoryWriter::pendingCount() const {
+    QMutexLocker locker(&m_mutex);
+    return m_queue.size();
+}
+
+void HistoryWriter::writerLoop() {
+    ensureFolder(false);
+    openIndex();
+
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        while (m_queue.isEmpty() && !m_stopping && !m_resyncRequested && !m_compactRequested
+               && !m_retentionRequested) {
+            m_notEmpty.wait(&m_mutex);
+        }
+        // 截图优先，队列清空后再做索引维护
+        if (m_queue.isEmpty()) {
+            const bool resync = m_resyncRequested;
+            const bool compact = m_compactRequested;
+            // 退出时不再开始清理
+            const bool retention = m_retentionRequested && !m_stopping;
+            m_resyncRequested = false;
+            m_compactRequested = false;
+            m_retentionRequested = false;
+            if (!resync && !compact && !retention) {
+                break;
+            }
+            locker.unlock();
+            runMaintenance(resync, compact, retention);
+            noteOwnChanges();
+            locker.relock();
+            continue;
+        }
+        // 正在写入的记录仍计入字节数，直到编码完成、像素可以释放
+        Entry entry = m_queue.dequeue();
+        const qint64 bytes = queuedBytes(entry);
+        locker.unlock();
+
+        QString filePath;
+        const bool ok = writeEntry(entry, &filePath);
+        noteOwnChanges();
+        entry.image = QImage();
+        entry.tiled.reset();
+        report(entry.id, filePath, ok);
+
+        locker.relock();
+        m_queuedBytes -= bytes;
+        m_notFull.wakeAll();
+    }
+}
+
+bool HistoryWriter::writeEntry(const Entry &entry, QString *filePath) {
+    QString path = m_folder + "/" + entry.fileName;
+    // 上次运行留下的同名文件（时钟回拨后重启）不覆盖
+    if (QFile::exists(path)) {
+        const QString extension = QFileInfo(path).suffix();
+        const QString base = path.left(path.size() - extension.size() - 1);
+        int suffix = 1;
+        do {
+            path = QString("%1-%2.%3").arg(base).arg(suffix++).arg(extension);
+        } while (QFile::exists(path));
+    }
+    *filePath = path;
+
+    // 目录只在首次写入时创建；打开失败（目录被删除）时再强制检查一次
+    if (!ensureFolder(false)) {
+        return false;
+    }
+
+    // 与已保存截图内容相同（反复截取未变化的屏幕）时只建立硬链接；
+    // 分块长图不合成整幅图像，没有内容哈希，不参与去重
+    const PixelHash hash = entry.tiled ? PixelHash() : PixelHash::of(entry.image);
+    const bool duplicate = linkDuplicate(hash, path);
+    if (!duplicate && !encodeEntry(entry, path)) {
+        return false;
+    }
+    recordEntry(entry, path, hash, duplicate);
+    appendThumbnail(entry, path);
+    // 未编辑的截图另存为时直接复制这个文件（长图的预览与文件内容不同，不登记）
+    if (!entry.tiled) {
+        EncodedImageCache::instance().insertFile(entry.image, EncodedImageCache::formatForPath(path), path);
+    }
+    return true;
+}
+
+bool HistoryWriter::encodeEntry(const Entry &entry, const QString &path) {
+    const QByteArray format = EncodedImageCache::formatForPath(path);
+    // 剪贴板或另存为已经编码过同一图像时直接写出已有字节
+    const QByteArray cached = entry.tiled ? QByteArray() : EncodedImageCache::instance().lookup(entry.image, format);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (attempt > 0 && !ensureFolder(true)) {
+            return false;
+        }
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            continue;
+        }
+        if (!cached.isEmpty()) {
+            if (file.write(cached) != cached.size()) {
+                qWarning() << "[History] Write failed:" << file.errorString();
+                file.cancelWriting();
+                return false;
+            }
+        } else if (entry.tiled) {
+            if (!PngEncoder::write(*entry.tiled, &file)) {
+                qWarning() << "[History] Banded PNG encode failed:" << file.errorString();
+                file.cancelWriting();
+                return false;
+            }
+        } else if (format == QoiCodec::Suffix) {
+            if (!QoiCodec::write(entry.image, &file)) {
+                qWarning() << "[History] QOI encode failed:" << file.errorString();
+                file.cancelWriting();
+                return false;
+            }
+        } else {
+            if (!PngEncoder::write(entry.image, &file)) {
+                file.cancelWriting();
+                return false;
+            }
+        }
+        // 临时文件写完后原子重命名为目标文件
+        return file.commit();
+    }
+    qWarning() << "[History] Cannot open" << path;
+    return false;
+}
+
+bool HistoryWriter::linkDuplicate(const PixelHash &hash, const QString &path) {
+    auto it = m_contents.find(hash);
+    if (it == m_contents.end()) {
+        return false;
+    }
+    const QString original = m_folder + "/" + it.value();
+    // 写入格式切换后，同内容的旧文件是另一种格式，不能以新扩展名链接
+    if (QFileInfo(original).suffix() != QFileInfo(path).suffix()) {
+        return false;
+    }
+    if (!createHardLink(original, path)) {
+        // 原文件已被删除：本次截图成为该内容的新原件
+        if (!QFile::exists(original)) {
+            m_contents.erase(it);
+        }
+        return false;
+    }
+    qDebug() << "[History] Duplicate of" << it.value() << "linked as" << QFileInfo(path).fileName();
+    return true;
+}
+
+void HistoryWriter::recordEntry(const Entry &entry, const QString &path, const PixelHash &hash, bool duplicate) {
+    const QFileInfo info(path);
+    if (!duplicate && !hash.isNull()) {
+        m_contents.insert(hash, info.fileName());
+    }
+
+    HistoryIndex::Record record;
+    record.timestamp = entry.timestamp;
+    record.size = entry.tiled ? QSize(entry.tiled->width(), entry.tiled->height()) : entry.image.size();
+    record.devicePixelRatio = entry.tiled ? entry.tiled->devicePixelRatio() : entry.image.devicePixelRatio();
+    record.byteSize = info.size();
+    record.hash = hash;
+    record.screenName = entry.screenName;
+    record.captureRect = entry.captureRect;
+    record.fileName = info.fileName();
+    if (!m_index->append(record)) {
+        qWarning() << "[History] Failed to index" << record.fileName;
+    }
+}
+
+void HistoryWriter::openIndex() {
+    m_index = new HistoryIndex(m_folder);
+    if (!m_index->open(true)) {
+        qWarning() << "[History] History index unavailable";
+        return;
+    }
+    // 程序未运行期间被删除的文件
+    m_index->resync();
+    noteOwnChanges();
+    reloadContents();
+    qDebug() << "[History] Index loaded," << m_index->count() << "records," << m_contents.size() << "unique images";
+}
+
+void HistoryWriter::reloadContents() {
+    m_contents.clear();
+    for (int i = 0; i < m_index->count(); ++i) {
+        const HistoryIndex::Record &record = m_index->record(i);
+        if (!record.removed && !record.hash.isNull()) {
+            m_contents.insert(record.hash, record.fileName);
+        }
+    }
+}
+
+void HistoryWriter::runMaintenance(bool resync, bool compact, bool retention) {
+    if (retention && m_index->isOpen()) {
+        HistoryRetention::Policy policy;
+        {
+            QMutexLocker locker(&m_mutex);
+            policy = m_retentionPolicy;
+        }
+        // 有截图入队或正在退出时立即让出，未完成的部分留到下一次空闲
+        HistoryRetention cleaner(m_folder, m_index, policy);
+        const HistoryRetention::Result result = cleaner.run([this]() {
+            QMutexLocker locker(&m_mutex);
+            return !m_queue.isEmpty() || m_stopping;
+        });
+        // 删除和格式转换都会改变去重表中的文件名
+        if (result.deleted > 0 || result.recompressed > 0) {
+            reloadContents();
+        }
+    }
+    if (!compact && resync && changedExternally() && m_index->resync() > 0) {
+        reloadContents();
+    }
+    // 索引和缩略图包都只追加，删除的截图多了就顺带重写，文件不会无限增长
+    if (!compact && m_index->isOpen()) {
+        const int removed = removedRecords(*m_index);
+        compact = removed > 0 && removed * kCompactRemovedDivisor >= m_index->count();
+    }
+    if (compact) {
+        int added = 0;
+        int dropped = 0;
+        if (m_index->compact(&added, &dropped)) {
+            qDebug() << "[History] Index compacted," << added << "added," << dropped << "dropped";
+            compactThumbnails();
+        }
+        reloadContents();
+    }
+}
+
+void HistoryWriter::noteOwnChanges() {
+    m_ownModified = QFileInfo(m_folder).lastModified();
+}
+
+bool HistoryWriter::changedExternally() const {
+    // 只有增删改名会更新目录的修改时间，追加索引和缩略图不会；
+    // 与自身最近一次改动后记下的时间相同，说明这次通知是自身写入引起的，不必枚举目录
+    return !m_ownModified.isValid() || QFileInfo(m_folder).lastModified() != m_ownModified;
+}
+
+void HistoryWriter::appendThumbnail(const Entry &entry, const QString &path) {
+    // 缩略图只是浏览加速，写入失败不影响历史记录本身
+    if (!thumbnails()->append(QFileInfo(path).fileName(), entry.timestamp, entry.image)) {
+        qWarning() << "[History] Failed to add thumbnail for" << path;
+    }
+}
+
+ThumbnailPack *HistoryWriter::thumbnails() {
+    if (!m_thumbnails) {
+        m_thumbnails = new ThumbnailPack(m_folder);
+        m_thumbnails->openForAppend();
+    }
+    return m_thumbnails;
+}
+
+void HistoryWriter::compactThumbnails() {
+    // 刚重写过的索引只含仍存在的文件
+    QSet<QString> live;
+    for (int i = 0; i < m_index->count(); ++i) {
+        live.insert(m_index->record(i).fileName);
+    }
+    const int dropped = thumbnails()->compact([&live](const QString &fileName) {
+        if (live.contains(fileName)) {
+            return fileName;
+        }
+        // 空闲时由QOI转成的PNG沿用原文件名主体
+        const QFileInfo info(fileName);
+        if (info.suffix() == QoiCodec::Suffix) {
+            const QString converted = info.completeBaseName() + ".png";
+            if (live.contains(converted)) {
+                return converted;
+            }
+        }
+        return QString();
+    });
+    if (dropped < 0) {
+        qWarning() << "[History] Thumbnail pack compaction failed, retrying at the next compaction";
+    }
+}
+
+bool HistoryWriter::ensureFolder(bool force) {
+    if (m_folderReady && !force) {
+        return true;
+    }
+    m_folderReady = QDir().mkpath(m_folder);
+    if (!m_folderReady) {
+        qWarning() << "[History] Failed to create history folder:" << m_folder;
+    }
+    return m_folderReady;
+}
+
+void HistoryWriter::report(quint64 id, const QString &filePath, bool success) {
+    QMetaObject::invokeMethod(this, [this, id, filePath, success]() {
+        emit entryWritten(id, filePath, success);
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,327 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file HistoryWriter.h
+ * @brief 历史截图后台写入线程
+ *
+ * 截图由GUI线程放入有界队列，专用线程按顺序编码写入历史文件夹
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef HISTORYWRITER_H
+#define HISTORYWRITER_H
+
+#include <QObject>
+#include <QImage>
+#include <QString>
+#include <QDateTime>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QRect>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include "PixelHash.h"
+#include "HistoryRetention.h"
+
+class QThread;
+class QTimer;
+class QFileSystemWatcher;
+class ThumbnailPack;
+class HistoryIndex;
+class TiledImage;
+
+/**
+ * @class HistoryWriter
+ * @brief 历史截图后台写入线程
+ *
+ * - 每条记录在入队时分配单调递增的ID，文件名为 yyyyMMdd_HHmmss_zzz_序号.png，
+ *   同一秒内的连续截图不会互相覆盖
+ * - 可选用QOI快速写入（.qoi），编码耗时约为PNG的十分之一，空闲时由 HistoryRetention 转为PNG
+ * - 先写临时文件再重命名（QSaveFile），中途失败不会留下半个PNG
+ * - 滚动长截图以分块图像入队，按段编码为PNG，不合成整幅图像
+ * - 目录只在首次写入和写入失败时创建/检查
+ * - 按像素内容去重：与已保存截图内容相同的记录以硬链接写入时间线，不再重复编码和占用磁盘
+ * - 每条写入成功的记录追加到 HistoryIndex（时间、尺寸、DPR、字节数、内容哈希、屏幕、区域），
+ *   文件夹被外部修改时在写入线程中重新同步（自身写入引起的变化通知不触发同步），去重表也由索引恢复
+ * - 每条写入成功的记录同时追加一张缩略图到 ThumbnailPack，历史浏览器无需解码原图；
+ *   重写索引时一并去掉原图已删除的缩略图，已删除的记录超过四分之一时自动重写
+ * - 队列按像素字节数限额：满时按策略等待写入线程腾出空间，或丢弃最旧的未写入记录
+ * - 一段时间没有新截图时在写入线程中按 HistoryRetention 策略清理和重新压缩旧截图，
+ *   有新截图入队时立即让出
+ */
+class HistoryWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 队列满时的处理策略
+     */
+    enum OverflowPolicy {
+        OverflowBlock,      ///< 等待写入线程腾出空间（不丢数据，入队可能无限期等待，不能用于GUI线程）
+        OverflowDropOldest  ///< 丢弃最旧的未写入记录（入队永不等待，丢弃时发出 entriesDropped）
+    };
+
+    /**
+     * @brief 写入格式
+     */
+    enum FileFormat {
+        FormatPng,  ///< PNG（默认）
+        FormatQoi   ///< QOI快速写入，空闲时转为PNG
+    };
+
+    /**
+     * @brief 一条历史记录
+     */
+    struct Entry {
+        quint64 id = 0;             ///< 单调递增ID
+        QString fileName;           ///< 文件名（不含目录）
+        QDateTime timestamp;        ///< 截图时间
+        QImage image;               ///< 图像（写入后释放；分块长图时为预览，只用于缩略图）
+        QSharedPointer<const TiledImage> tiled; ///< 分块长图（全尺寸像素，按段编码）
+        QRect captureRect;          ///< 截图区域（逻辑坐标）
+        QString screenName;         ///< 来源屏幕
+    };
+
+    /**
+     * @brief 构造函数
+     * @param folder 历史文件夹
+     * @param maxQueuedBytes 队列中未写入图像的像素字节上限
+     * @param policy 队列满时的策略
+     * @param parent 父对象
+     */
+    explicit HistoryWriter(const QString &folder, qint64 maxQueuedBytes = 256ll << 20,
+                           OverflowPolicy policy = OverflowBlock, QObject *parent = nullptr);
+
+    /**
+     * @brief 析构时写完队列中的所有记录再退出线程
+     */
+    ~HistoryWriter();
+
+    /**
+     * @brief 放入一张截图
+     * @param image 截图（共享像素，不复制）
+     * @param captureRect 截图区域（逻辑坐标，写入索引）
+     * @param screenName 来源屏幕（写入索引）
+     * @return 记录ID（0表示图像无效）
+     */
+    quint64 enqueue(const QImage &image, const QRect &captureRect = QRect(), const QString &screenName = QString());
+
+    /**
+     * @brief 放入一张分块长图（滚动长截图）
+     *
+     * 全尺寸像素按段编码为PNG（不受QOI设置影响），不合成整幅图像，也不参与去重；
+     * 缩略图取自预览图。入队后调用方不能再读取该分块图像
+     *
+     * @param image 分块长图
+     * @param preview 缩小的预览图
+     * @param captureRect 截图区域（逻辑坐标，写入索引）
+     * @param screenName 来源屏幕（写入索引）
+     * @return 记录ID（0表示图像无效）
+     */
+    quint64 enqueueTiled(const QSharedPointer<const TiledImage> &image, const QImage &preview,
+                         const QRect &captureRect = QRect(), const QString &screenName = QString());
+
+    /**
+     * @brief 请求在写入线程中重写索引（去掉已删除的记录、补录未索引的文件）
+     */
+    void requestCompact();
+
+    /**
+     * @brief 设置之后入队的截图的写入格式
+     * @param format 写入格式
+     */
+    void setFileFormat(FileFormat format) { m_fileFormat = format; }
+
+    /**
+     * @brief 设置保留策略（下一次空闲清理时生效）
+     * @param policy 保留策略
+     */
+    void setRetentionPolicy(const HistoryRetention::Policy &policy);
+
+    /**
+     * @brief 请求在写入线程中按保留策略清理和压缩（队列清空后执行）
+     */
+    void requestRetention();
+
+    /**
+     * @brief 创建硬链接（两个文件共享同一份数据，删除任何一个不影响另一个）
+     * @param existing 已有文件
+     * @param link 新链接路径
+     * @return 是否成功（文件系统不支持时返回false）
+     */
+    static bool createHardLink(const QString &existing, const QString &link);
+
+    /**
+     * @brief 获取历史文件夹
+     */
+    QString folder() const { return m_folder; }
+
+    /**
+     * @brief 获取队列中待写入的记录数
+     */
+    int pendingCount() const;
+
+signals:
+    /**
+     * @brief 记录写入完成（在GUI线程发出）
+     * @param id 记录ID
+     * @param filePath 文件路径
+     * @param success 是否成功（被丢弃的记录也以失败报告）
+     */
+    void entryWritten(quint64 id, const QString &filePath, bool success);
+
+    /**
+     * @brief 队列已满，丢弃了最旧的未写入记录（在入队的线程发出）
+     * @param count 本次丢弃的记录数
+     */
+    void entriesDropped(int count);
+
+private:
+    /**
+     * @brief 写入线程主循环
+     */
+    void writerLoop();
+
+    /**
+     * @brief 分配ID、时间戳和文件名后放入队列
+     * @param entry 记录（图像与区域已填好）
+     * @param suffix 文件扩展名
+     * @return 记录ID
+     */
+    quint64 enqueueEntry(Entry entry, const QString &suffix);
+
+    /**
+     * @brief 写入一条记录（写入线程）
+     */
+    bool writeEntry(const Entry &entry, QString *filePath);
+
+    /**
+     * @brief 按文件扩展名编码写入PNG或QOI（写入线程）
+     */
+    bool encodeEntry(const Entry &entry, const QString &path);
+
+    /**
+     * @brief 与已保存的相同内容截图建立硬链接（写入线程）
+     * @return 是否成功（原文件已不存在或文件系统不支持时返回false）
+     */
+    bool linkDuplicate(const PixelHash &hash, const QString &path);
+
+    /**
+     * @brief 把写入成功的截图加入索引和去重表（写入线程）
+     */
+    void recordEntry(const Entry &entry, const QString &path, const PixelHash &hash, bool duplicate);
+
+    /**
+     * @brief 打开索引并由其恢复去重表（写入线程）
+     */
+    void openIndex();
+
+    /**
+     * @brief 由索引中仍存在的记录重建去重表（写入线程）
+     */
+    void reloadContents();
+
+    /**
+     * @brief 执行排队的索引维护（写入线程，调用时不持有锁）
+     */
+    void runMaintenance(bool resync, bool compact, bool retention);
+
+    /**
+     * @brief 请求在写入线程中重新同步索引（文件夹变化后）
+     */
+    void requestResync();
+
+    /**
+     * @brief 记录自身改动后的文件夹修改时间（写入线程，每次写入和维护之后调用）
+     */
+    void noteOwnChanges();
+
+    /**
+     * @brief 文件夹在自身最近一次改动之后是否又被外部修改过（写入线程，只需一次stat）
+     */
+    bool changedExternally() const;
+
+    /**
+     * @brief 定时检查：最近一段时间没有新截图时请求清理
+     */
+    void onRetentionTimer();
+
+    /**
+     * @brief 追加缩略图（写入线程）
+     */
+    void appendThumbnail(const Entry &entry, const QString &path);
+
+    /**
+     * @brief 获取缩略图包，首次使用时以追加方式打开（写入线程）
+     */
+    ThumbnailPack *thumbnails();
+
+    /**
+     * @brief 去掉原图已不在索引中的缩略图（写入线程，索引重写之后调用）
+     */
+    void compactThumbnails();
+
+    /**
+     * @brief 确保历史文件夹存在（写入线程）
+     */
+    bool ensureFolder(bool force);
+
+    /**
+     * @brief 在GUI线程报告写入结果
+     */
+    void report(quint64 id, const QString &filePath, bool success);
+
+private:
+    const QString m_folder;             ///< 历史文件夹
+    const qint64 m_maxQueuedBytes;      ///< 队列字节上限
+    const OverflowPolicy m_policy;      ///< 溢出策略
+    QThread *m_thread;                  ///< 写入线程
+    FileFormat m_fileFormat;            ///< 写入格式（GUI线程，入队时决定扩展名）
+    quint64 m_lastId;                   ///< 最近分配的ID（GUI线程）
+    qint64 m_lastTimestamp;             ///< 最近分配的时间戳（毫秒，保证文件名单调）
+    bool m_folderReady;                 ///< 文件夹是否已确认存在（写入线程）
+    QDateTime m_ownModified;            ///< 自身最近一次改动后的文件夹修改时间（写入线程）
+    QHash<PixelHash, QString> m_contents; ///< 内容哈希 → 已保存的文件名（写入线程）
+    HistoryIndex *m_index;              ///< 历史索引（写入线程）
+    ThumbnailPack *m_thumbnails;        ///< 缩略图包（写入线程，首次写入时打开）
+    QFileSystemWatcher *m_watcher;      ///< 历史文件夹监视（GUI线程）
+    QTimer *m_resyncTimer;              ///< 合并连续的文件夹变化通知（GUI线程）
+    QTimer *m_retentionTimer;           ///< 定期空闲清理（GUI线程）
+    QElapsedTimer m_sinceEnqueue;       ///< 距最近一次入队的时间（GUI线程）
+
+    // 以下成员由 m_mutex 保护
+    mutable QMutex m_mutex;
+    QWaitCondition m_notEmpty;          ///< 队列非空
+    QWaitCondition m_notFull;           ///< 队列有空间
+    QQueue<Entry> m_queue;              ///< 待写入记录
+    qint64 m_queuedBytes;               ///< 队列中的像素字节数
+    bool m_stopping;                    ///< 写完队列后退出
+    bool m_resyncRequested;             ///< 待执行索引同步
+    bool m_compactRequested;            ///< 待执行索引重写
+    bool m_retentionRequested;          ///< 待执行保留策略清理
+    HistoryRetention::Policy m_retentionPolicy; ///< 保留策略
+};
+
+#endif // HISTORYWRITER_H
@@ -0,0 +1,77 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ImageBuffer.cpp
+ * @brief 统一的CPU图像缓冲区实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "ImageBuffer.h"
+#include <QtGlobal>
+#include <QDebug>
+#include <limits>
+
+namespace {
+
+/**
+ * @brief 释放对齐分配的像素（QImage清理回调）
+ */
+void releaseAligned(void *info)
+{
+    qFreeAligned(info);
+}
+
+} // namespace
+
+QImage ImageBuffer::allocate(const QSize &size, qreal devicePixelRatio, QImage::Format format) {
+    if (size.isEmpty() || format == QImage::Format_Invalid) {
+        return QImage();
+    }
+    const int bitsPerPixel = QImage::toPixelFormat(format).bitsPerPixel();
+    const qint64 rowBytes = (qint64(size.width()) * bitsPerPixel + 7) / 8;
+    const qint64 stride = (rowBytes + Alignment - 1) / Alignment * Alignment;
+    if (stride > std::numeric_limits<qsizetype>::max() / size.height()) {
+        return QImage();
+    }
+    const qint64 bytes = stride * size.height();
+
+    void *data = qMallocAligned(size_t(bytes), Alignment);
+    if (!data) {
+        qWarning() << "[ImageBuffer] Failed to allocate" << size << "(" << bytes << "bytes)";
+        return QImage();
+    }
+    QImage image(static_cast<uchar *>(data), size.width(), size.height(), qsizetype(stride), format,
+                 releaseAligned, data);
+    image.setDevicePixelRatio(devicePixelRatio);
+    return image;
+}
+
+bool ImageBuffer::isNative(QImage::Format format) {
+    return format == Format || format == QImage::Format_RGB32;
+}
+
+QImage ImageBuffer::adopt(const QImage &image) {
+    if (image.isNull() || isNative(image.format())) {
+        return image;
+    }
+    return image.convertToFormat(Format);
+}
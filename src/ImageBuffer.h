@@ -0,0 +1,78 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ImageBuffer.h
+ * @brief 统一的CPU图像缓冲区
+ *
+ * 截图、编辑和贴图之间统一以该格式的QImage传递像素，
+ * 只在窗口绘制时才转换为QPixmap
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef IMAGEBUFFER_H
+#define IMAGEBUFFER_H
+
+#include <QImage>
+#include <QSize>
+
+/**
+ * @class ImageBuffer
+ * @brief 64字节对齐、引用计数、固定像素格式的图像缓冲区
+ *
+ * - 像素格式固定为 ARGB32_Premultiplied（光栅绘制引擎的原生格式，QPainter直接读写）；
+ *   RGB32的alpha恒为0xFF，与之逐字节相同，也视为统一格式，不做转换
+ * - allocate() 的首地址和行跨度都按64字节（缓存行）对齐，SIMD加载不跨缓存行
+ * - 以QImage的隐式共享做引用计数，最后一个引用释放时由清理回调释放内存；
+ *   共享状态下写入会按Qt的规则分离出普通副本（不再对齐），热路径上的缓冲区应独占使用
+ */
+class ImageBuffer
+{
+public:
+    static constexpr QImage::Format Format = QImage::Format_ARGB32_Premultiplied;  ///< 统一像素格式
+    static constexpr int Alignment = 64;    ///< 首地址和行跨度的对齐字节数
+
+    /**
+     * @brief 分配未初始化的对齐缓冲区
+     * @param size 尺寸（设备像素）
+     * @param devicePixelRatio 设备像素比
+     * @param format 像素格式（默认为统一格式，缩放等中间结果可保留RGB32）
+     * @return 图像；尺寸为空或内存不足时为空图像
+     */
+    static QImage allocate(const QSize &size, qreal devicePixelRatio = 1.0, QImage::Format format = Format);
+
+    /**
+     * @brief 是否已是统一格式（ARGB32_Premultiplied 或逐字节相同的 RGB32）
+     */
+    static bool isNative(QImage::Format format);
+
+    /**
+     * @brief 转为统一格式
+     * @param image 图像
+     * @return 已是统一格式时直接共享原图，否则为转换后的图像
+     */
+    static QImage adopt(const QImage &image);
+
+private:
+    ImageBuffer() = delete;
+};
+
+#endif // IMAGEBUFFER_H
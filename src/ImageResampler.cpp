@@ -0,0 +1,577 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ImageResampler.cpp
+ * @brief 向量化图像重采样器实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "ImageResampler.h"
+#include "SimdSupport.h"
+#include "ImageBuffer.h"
+#include "ParallelBands.h"
+#include <QVector>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr int kPrecisionBits = 14;                          ///< 定点权重精度
+constexpr int kRounding = 1 << (kPrecisionBits - 1);        ///< 四舍五入偏置
+constexpr double kPi = 3.14159265358979323846;
+constexpr qint64 kSlowLogMs = 16;                           ///< 超过该耗时（约一帧）才输出日志
+
+/**
+ * @brief 一个方向上的定点卷积系数
+ */
+struct Coefficients {
+    int taps = 0;               ///< 每个输出位置的最大权重数
+    QVector<int> starts;        ///< 每个输出位置的首个输入索引
+    QVector<int> counts;        ///< 每个输出位置的有效权重数
+    QVector<qint16> weights;    ///< 权重（outSize * taps，14位定点）
+
+    const qint16 *at(int i) const { return weights.constData() + qsizetype(i) * taps; }
+};
+
+double boxFilter(double x)
+{
+    return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+}
+
+double triangleFilter(double x)
+{
+    x = std::fabs(x);
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+double sinc(double x)
+{
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x *= kPi;
+    return std::sin(x) / x;
+}
+
+double lanczos3Filter(double x)
+{
+    return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+}
+
+/**
+ * @brief 计算一个方向上的卷积系数
+ *
+ * 缩小时滤波器按缩放比例展宽（面积积分），放大时保持原始支撑半径
+ */
+Coefficients computeCoefficients(int inSize, int outSize, ImageResampler::Filter filter)
+{
+    double (*kernel)(double) = triangleFilter;
+    double support = 1.0;
+    switch (filter) {
+    case ImageResampler::FilterBox:
+        kernel = boxFilter;
+        support = 0.5;
+        break;
+    case ImageResampler::FilterBilinear:
+        kernel = triangleFilter;
+        support = 1.0;
+        break;
+    case ImageResampler::FilterLanczos3:
+        kernel = lanczos3Filter;
+        support = 3.0;
+        break;
+    }
+
+    const double scale = double(inSize) / outSize;
+    const double filterScale = qMax(scale, 1.0);
+    const double radius = support * filterScale;
+
+    Coefficients c;
+    c.taps = int(std::ceil(radius)) * 2 + 1;
+    c.starts.resize(outSize);
+    c.counts.resize(outSize);
+    c.weights.fill(0, qsizetype(outSize) * c.taps);
+
+    QVector<double> raw(c.taps);
+    for (int i = 0; i < outSize; ++i) {
+        const double center = (i + 0.5) * scale;
+        int first = qMax(int(std::floor(center - radius + 0.5)), 0);
+        const int last = qMin(int(std::floor(center + radius + 0.5)), inSize);
+        int count = qBound(1, last - first, c.taps);
+        if (first + count > inSize) {
+            first = inSize - count;
+        }
+
+        double total = 0.0;
+        for (int k = 0; k < count; ++k) {
+            raw[k] = kernel((first + k - center + 0.5) / filterScale);
+            total += raw[k];
+        }
+        if (total == 0.0) {
+            raw[0] = total = 1.0;
+        }
+
+        // 转为定点后把舍入误差补到最大权重上，保证权重和严格为1，纯色区域不漂移
+        qint16 *w = c.weights.data() + qsizetype(i) * c.taps;
+        int fixedSum = 0;
+        int largest = 0;
+        for (int k = 0; k < count; ++k) {
+            w[k] = qint16(qRound(raw[k] / total * (1 << kPrecisionBits)));
+            fixedSum += w[k];
+            if (qAbs(w[k]) > qAbs(w[largest])) {
+                largest = k;
+            }
+        }
+        w[largest] = qint16(w[largest] + (1 << kPrecisionBits) - fixedSum);
+
+        // 去掉两端的零权重，减少无效乘加
+        int lead = 0;
+        while (lead < count - 1 && w[lead] == 0) {
+            ++lead;
+        }
+        while (count - 1 > lead && w[count - 1] == 0) {
+            --count;
+        }
+        if (lead > 0) {
+            std::memmove(w, w + lead, sizeof(qint16) * (count - lead));
+            std::memset(w + count - lead, 0, sizeof(qint16) * lead);
+        }
+        c.starts[i] = first + lead;
+        c.counts[i] = count - lead;
+    }
+    return c;
+}
+
+inline uchar clampToByte(int value)
+{
+    return uchar(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+/// 两个相邻权重打包为一个32位数，供 madd 指令成对相乘
+inline int packWeights(qint16 w0, qint16 w1)
+{
+    return int(quint32(quint16(w0)) | (quint32(quint16(w1)) << 16));
+}
+
+// ---------------------------------------------------------------------------
+// 水平方向：每个输出像素对一段连续输入像素做加权和（4通道同时计算）
+// ---------------------------------------------------------------------------
+
+using HorizontalRowFn = void (*)(const uchar *src, uchar *dst, const Coefficients &c, int outWidth);
+
+void horizontalRowScalar(const uchar *src, uchar *dst, const Coefficients &c, int outWidth)
+{
+    for (int x = 0; x < outWidth; ++x) {
+        const uchar *p = src + qsizetype(c.starts[x]) * 4;
+        const qint16 *w = c.at(x);
+        int acc[4] = { kRounding, kRounding, kRounding, kRounding };
+        for (int k = 0; k < c.counts[x]; ++k) {
+            for (int ch = 0; ch < 4; ++ch) {
+                acc[ch] += p[k * 4 + ch] * w[k];
+            }
+        }
+        for (int ch = 0; ch < 4; ++ch) {
+            dst[x * 4 + ch] = clampToByte(acc[ch] >> kPrecisionBits);
+        }
+    }
+}
+
+#if defined(CAPSTEP_SIMD_SSE2)
+void horizontalRowSse2(const uchar *src, uchar *dst, const Coefficients &c, int outWidth)
+{
+    const __m128i zero = _mm_setzero_si128();
+    for (int x = 0; x < outWidth; ++x) {
+        const uchar *p = src + qsizetype(c.starts[x]) * 4;
+        const qint16 *w = c.at(x);
+        const int count = c.counts[x];
+        __m128i acc = _mm_set1_epi32(kRounding);
+
+        int k = 0;
+        for (; k + 1 < count; k += 2) {
+            // 两个像素展开为16位后交错为 b0 b1 g0 g1 r0 r1 a0 a1，一次madd完成两个抽头
+            __m128i px = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + k * 4));
+            px = _mm_unpacklo_epi8(px, zero);
+            px = _mm_unpacklo_epi16(px, _mm_srli_si128(px, 8));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, _mm_set1_epi32(packWeights(w[k], w[k + 1]))));
+        }
+        if (k < count) {
+            int single;
+            std::memcpy(&single, p + k * 4, sizeof(single));
+            __m128i px = _mm_unpacklo_epi8(_mm_cvtsi32_si128(single), zero);
+            px = _mm_unpacklo_epi16(px, zero);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, _mm_set1_epi32(packWeights(w[k], 0))));
+        }
+
+        acc = _mm_srai_epi32(acc, kPrecisionBits);
+        acc = _mm_packs_epi32(acc, acc);
+        acc = _mm_packus_epi16(acc, acc);
+        const int out = _mm_cvtsi128_si32(acc);
+        std::memcpy(dst + x * 4, &out, sizeof(out));
+    }
+}
+#endif
+
+#if defined(CAPSTEP_SIMD_NEON)
+void horizontalRowNeon(const uchar *src, uchar *dst, const Coefficients &c, int outWidth)
+{
+    for (int x = 0; x < outWidth; ++x) {
+        const uchar *p = src + qsizetype(c.starts[x]) * 4;
+        const qint16 *w = c.at(x);
+        int32x4_t acc = vdupq_n_s32(kRounding);
+        for (int k = 0; k < c.counts[x]; ++k) {
+            uint32_t px;
+            std::memcpy(&px, p + k * 4, sizeof(px));
+            const uint16x8_t wide = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(px)));
+            acc = vmlal_n_s16(acc, vreinterpret_s16_u16(vget_low_u16(wide)), w[k]);
+        }
+        const int16x4_t narrow = vqmovn_s32(vshrq_n_s32(acc, kPrecisionBits));
+        const uint8x8_t bytes = vqmovun_s16(vcombine_s16(narrow, narrow));
+        const uint32_t out = vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+        std::memcpy(dst + x * 4, &out, sizeof(out));
+    }
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// 垂直方向：每个输出行是若干输入行的加权和，按字节连续处理
+// ---------------------------------------------------------------------------
+
+using VerticalRowFn = void (*)(const uchar *src, qsizetype stride, int count,
+                               const qint16 *w, uchar *dst, int bytes);
+
+void verticalSpanScalar(const uchar *src, qsizetype stride, int count,
+                        const qint16 *w, uchar *dst, int from, int bytes)
+{
+    for (int x = from; x < bytes; ++x) {
+        int acc = kRounding;
+        for (int k = 0; k < count; ++k) {
+            acc += src[k * stride + x] * w[k];
+        }
+        dst[x] = clampToByte(acc >> kPrecisionBits);
+    }
+}
+
+void verticalRowScalar(const uchar *src, qsizetype stride, int count,
+                       const qint16 *w, uchar *dst, int bytes)
+{
+    verticalSpanScalar(src, stride, count, w, dst, 0, bytes);
+}
+
+#if defined(CAPSTEP_SIMD_SSE2)
+/**
+ * @brief SSE2垂直卷积：两行交错后一次madd完成两个抽头，16字节一组
+ * @return 已处理的字节数
+ */
+int verticalSpanSse2(const uchar *src, qsizetype stride, int count,
+                     const qint16 *w, uchar *dst, int from, int bytes)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int x = from;
+    for (; x + 16 <= bytes; x += 16) {
+        __m128i acc0 = _mm_set1_epi32(kRounding);
+        __m128i acc1 = acc0;
+        __m128i acc2 = acc0;
+        __m128i acc3 = acc0;
+
+        for (int k = 0; k < count; k += 2) {
+            const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + k * stride + x));
+            const __m128i r1 = (k + 1 < count)
+                ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (k + 1) * stride + x))
+                : zero;
+            const __m128i weights = _mm_set1_epi32(packWeights(w[k], k + 1 < count ? w[k + 1] : 0));
+            const __m128i lo = _mm_unpacklo_epi8(r0, r1);
+            const __m128i hi = _mm_unpackhi_epi8(r0, r1);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), weights));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), weights));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), weights));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), weights));
+        }
+
+        const __m128i lo16 = _mm_packs_epi32(_mm_srai_epi32(acc0, kPrecisionBits),
+                                             _mm_srai_epi32(acc1, kPrecisionBits));
+        const __m128i hi16 = _mm_packs_epi32(_mm_srai_epi32(acc2, kPrecisionBits),
+                                             _mm_srai_epi32(acc3, kPrecisionBits));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(lo16, hi16));
+    }
+    return x;
+}
+
+void verticalRowSse2(const uchar *src, qsizetype stride, int count,
+                     const qint16 *w, uchar *dst, int bytes)
+{
+    const int done = verticalSpanSse2(src, stride, count, w, dst, 0, bytes);
+    verticalSpanScalar(src, stride, count, w, dst, done, bytes);
+}
+#endif
+
+#if defined(CAPSTEP_SIMD_AVX2)
+/**
+ * @brief AVX2垂直卷积：与SSE2相同的交错方式，32字节一组
+ *
+ * 解包与打包都在128位通道内进行，两者顺序互逆，输出字节顺序保持不变
+ */
+CAPSTEP_TARGET_AVX2
+void verticalRowAvx2(const uchar *src, qsizetype stride, int count,
+                     const qint16 *w, uchar *dst, int bytes)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    int x = 0;
+    for (; x + 32 <= bytes; x += 32) {
+        __m256i acc0 = _mm256_set1_epi32(kRounding);
+        __m256i acc1 = acc0;
+        __m256i acc2 = acc0;
+        __m256i acc3 = acc0;
+
+        for (int k = 0; k < count; k += 2) {
+            const __m256i r0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + k * stride + x));
+            const __m256i r1 = (k + 1 < count)
+                ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + (k + 1) * stride + x))
+                : zero;
+            const __m256i weights = _mm256_set1_epi32(packWeights(w[k], k + 1 < count ? w[k + 1] : 0));
+            const __m256i lo = _mm256_unpacklo_epi8(r0, r1);
+            const __m256i hi = _mm256_unpackhi_epi8(r0, r1);
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), weights));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), weights));
+            acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), weights));
+            acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), weights));
+        }
+
+        const __m256i lo16 = _mm256_packs_epi32(_mm256_srai_epi32(acc0, kPrecisionBits),
+                                                _mm256_srai_epi32(acc1, kPrecisionBits));
+        const __m256i hi16 = _mm256_packs_epi32(_mm256_srai_epi32(acc2, kPrecisionBits),
+                                                _mm256_srai_epi32(acc3, kPrecisionBits));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), _mm256_packus_epi16(lo16, hi16));
+    }
+    x = verticalSpanSse2(src, stride, count, w, dst, x, bytes);
+    verticalSpanScalar(src, stride, count, w, dst, x, bytes);
+}
+#endif
+
+#if defined(CAPSTEP_SIMD_NEON)
+void verticalRowNeon(const uchar *src, qsizetype stride, int count,
+                     const qint16 *w, uchar *dst, int bytes)
+{
+    int x = 0;
+    for (; x + 16 <= bytes; x += 16) {
+        int32x4_t acc0 = vdupq_n_s32(kRounding);
+        int32x4_t acc1 = acc0;
+        int32x4_t acc2 = acc0;
+        int32x4_t acc3 = acc0;
+
+        for (int k = 0; k < count; ++k) {
+            const uint8x16_t row = vld1q_u8(src + k * stride + x);
+            const int16x8_t lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(row)));
+            const int16x8_t hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(row)));
+            acc0 = vmlal_n_s16(acc0, vget_low_s16(lo), w[k]);
+            acc1 = vmlal_n_s16(acc1, vget_high_s16(lo), w[k]);
+            acc2 = vmlal_n_s16(acc2, vget_low_s16(hi), w[k]);
+            acc3 = vmlal_n_s16(acc3, vget_high_s16(hi), w[k]);
+        }
+
+        const int16x8_t lo16 = vcombine_s16(vqmovn_s32(vshrq_n_s32(acc0, kPrecisionBits)),
+                                            vqmovn_s32(vshrq_n_s32(acc1, kPrecisionBits)));
+        const int16x8_t hi16 = vcombine_s16(vqmovn_s32(vshrq_n_s32(acc2, kPrecisionBits)),
+                                            vqmovn_s32(vshrq_n_s32(acc3, kPrecisionBits)));
+        vst1q_u8(dst + x, vcombine_u8(vqmovun_s16(lo16), vqmovun_s16(hi16)));
+    }
+    verticalSpanScalar(src, stride, count, w, dst, x, bytes);
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// 预乘格式修正：Lanczos负瓣会让颜色分量超过alpha，需要截断回合法范围
+// ---------------------------------------------------------------------------
+
+void clampPremultipliedRow(uchar *row, int width)
+{
+    int x = 0;
+#if defined(CAPSTEP_SIMD_SSE2)
+    if (SimdSupport::hasSse2()) {
+        for (; x + 4 <= width; x += 4) {
+            __m128i *p = reinterpret_cast<__m128i *>(row + x * 4);
+            const __m128i px = _mm_loadu_si128(p);
+            __m128i alpha = _mm_srli_epi32(px, 24);
+            alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 8));
+            alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+            _mm_storeu_si128(p, _mm_min_epu8(px, alpha));
+        }
+    }
+#endif
+    quint32 *pixels = reinterpret_cast<quint32 *>(row);
+    for (; x < width; ++x) {
+        const quint32 px = pixels[x];
+        const quint32 a = px >> 24;
+        const quint32 r = qMin((px >> 16) & 0xff, a);
+        const quint32 g = qMin((px >> 8) & 0xff, a);
+        const quint32 b = qMin(px & 0xff, a);
+        pixels[x] = (a << 24) | (r << 16) | (g << 8) | b;
+    }
+}
+
+HorizontalRowFn selectHorizontal(SimdSupport::Level level)
+{
+#if defined(CAPSTEP_SIMD_SSE2)
+    if (level >= SimdSupport::LevelSse2) {
+        return horizontalRowSse2;
+    }
+#endif
+#if defined(CAPSTEP_SIMD_NEON)
+    if (level == SimdSupport::LevelNeon) {
+        return horizontalRowNeon;
+    }
+#endif
+    Q_UNUSED(level)
+    return horizontalRowScalar;
+}
+
+VerticalRowFn selectVertical(SimdSupport::Level level)
+{
+#if defined(CAPSTEP_SIMD_AVX2)
+    if (level >= SimdSupport::LevelAvx2) {
+        return verticalRowAvx2;
+    }
+#endif
+#if defined(CAPSTEP_SIMD_SSE2)
+    if (level >= SimdSupport::LevelSse2) {
+        return verticalRowSse2;
+    }
+#endif
+#if defined(CAPSTEP_SIMD_NEON)
+    if (level == SimdSupport::LevelNeon) {
+        return verticalRowNeon;
+    }
+#endif
+    Q_UNUSED(level)
+    return verticalRowScalar;
+}
+
+} // namespace
+
+QImage ImageResampler::resample(const QImage &source, const QSize &targetSize, Filter filter) {
+    if (source.isNull() || targetSize.isEmpty()) {
+        return QImage();
+    }
+    if (source.size() == targetSize) {
+        return source;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 统一为32位格式；RGB32的alpha恒为0xFF，权重和为1时滤波后仍保持不变
+    const QImage src = ImageBuffer::adopt(source);
+    const QImage::Format format = src.format();
+    const bool clampPremultiplied = (format == QImage::Format_ARGB32_Premultiplied && filter == FilterLanczos3);
+
+    const int inWidth = src.width();
+    const int inHeight = src.height();
+    const int outWidth = targetSize.width();
+    const int outHeight = targetSize.height();
+    const bool needHorizontal = (inWidth != outWidth);
+    const bool needVertical = (inHeight != outHeight);
+
+    const SimdSupport::Level level = SimdSupport::level();
+    const HorizontalRowFn horizontalRow = selectHorizontal(level);
+    const VerticalRowFn verticalRow = selectVertical(level);
+
+    Coefficients vertical;
+    int firstRow = 0;
+    int lastRow = inHeight;
+    if (needVertical) {
+        vertical = computeCoefficients(inHeight, outHeight, filter);
+        // 水平遍只需处理垂直遍会读到的输入行
+        firstRow = inHeight;
+        lastRow = 0;
+        for (int y = 0; y < outHeight; ++y) {
+            firstRow = qMin(firstRow, vertical.starts[y]);
+            lastRow = qMax(lastRow, vertical.starts[y] + vertical.counts[y]);
+        }
+    }
+
+    // 第一遍：水平方向，结果为 outWidth × (lastRow - firstRow)
+    QImage horizontal = src;
+    int rowOffset = 0;
+    if (needHorizontal) {
+        const Coefficients coeffs = computeCoefficients(inWidth, outWidth, filter);
+        horizontal = ImageBuffer::allocate(QSize(outWidth, lastRow - firstRow), 1.0, format);
+        if (horizontal.isNull()) {
+            qWarning() << "[Resampler] Failed to allocate intermediate image";
+            return QImage();
+        }
+        rowOffset = firstRow;
+
+        // 在分发前取出裸指针，避免工作线程调用会触发detach的非const接口
+        const uchar *srcBits = src.constBits();
+        const qsizetype srcStride = src.bytesPerLine();
+        uchar *dstBits = horizontal.bits();
+        const qsizetype dstStride = horizontal.bytesPerLine();
+        const bool clampHere = clampPremultiplied && !needVertical;
+        ParallelBands::run(horizontal.height(), qint64(outWidth) * horizontal.height(),
+                   [&](int begin, int end) {
+            for (int r = begin; r < end; ++r) {
+                uchar *dstRow = dstBits + r * dstStride;
+                horizontalRow(srcBits + (r + firstRow) * srcStride, dstRow, coeffs, outWidth);
+                if (clampHere) {
+                    clampPremultipliedRow(dstRow, outWidth);
+                }
+            }
+        });
+    }
+
+    // 第二遍：垂直方向
+    QImage result = horizontal;
+    if (needVertical) {
+        result = ImageBuffer::allocate(QSize(outWidth, outHeight), 1.0, format);
+        if (result.isNull()) {
+            qWarning() << "[Resampler] Failed to allocate result image";
+            return QImage();
+        }
+
+        const uchar *srcBits = horizontal.constBits();
+        const qsizetype srcStride = horizontal.bytesPerLine();
+        uchar *dstBits = result.bits();
+        const qsizetype dstStride = result.bytesPerLine();
+        const int rowBytes = outWidth * 4;
+        ParallelBands::run(outHeight, qint64(outWidth) * outHeight, [&](int begin, int end) {
+            for (int y = begin; y < end; ++y) {
+                uchar *dstRow = dstBits + y * dstStride;
+                verticalRow(srcBits + (vertical.starts[y] - rowOffset) * srcStride, srcStride,
+                            vertical.counts[y], vertical.at(y), dstRow, rowBytes);
+                if (clampPremultiplied) {
+                    clampPremultipliedRow(dstRow, outWidth);
+                }
+            }
+        });
+    }
+
+    result.setDevicePixelRatio(source.devicePixelRatio());
+
+    // 贴图缩放动画每帧都会调用，只记录超过一帧时间的慢调用
+    if (timer.elapsed() >= kSlowLogMs) {
+        qDebug() << "[Resampler]" << source.size() << "->" << targetSize
+                 << "filter:" << filter << "simd:" << SimdSupport::levelName(level)
+                 << "in" << timer.elapsed() << "ms";
+    }
+    return result;
+}
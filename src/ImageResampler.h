@@ -0,0 +1,73 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ImageResampler.h
+ * @brief 向量化图像重采样器
+ *
+ * 可分离的两遍卷积（先水平后垂直），14位定点权重，
+ * 按行带拆分到多个核心并行执行，运行时选择 AVX2 / SSE2 / NEON / 标量路径
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef IMAGERESAMPLER_H
+#define IMAGERESAMPLER_H
+
+#include <QImage>
+#include <QSize>
+
+/**
+ * @class ImageResampler
+ * @brief 向量化图像重采样器
+ *
+ * - 支持盒式、双线性、Lanczos3三种滤波器
+ * - 输入统一为32位格式（RGB32 或 ARGB32_Premultiplied），其他格式先转换
+ * - 所有SIMD路径与标量路径的输出逐字节一致
+ */
+class ImageResampler
+{
+public:
+    /**
+     * @brief 重采样滤波器
+     */
+    enum Filter {
+        FilterBox,          ///< 盒式滤波（面积平均，适合整数倍缩小）
+        FilterBilinear,     ///< 双线性（三角形滤波）
+        FilterLanczos3      ///< Lanczos3（锐利，适合缩小时保留细节）
+    };
+
+    /**
+     * @brief 将图像重采样到目标尺寸（设备像素）
+     *
+     * 输出图像的DPR与输入相同，由调用方按需要重新设置
+     *
+     * @param source 源图像
+     * @param targetSize 目标尺寸（像素）
+     * @param filter 滤波器
+     * @return 重采样结果，尺寸相同时直接共享源图像
+     */
+    static QImage resample(const QImage &source, const QSize &targetSize, Filter filter = FilterLanczos3);
+
+private:
+    ImageResampler() = delete;
+};
+
+#endif // IMAGERESAMPLER_H
@@ -0,0 +1,111 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ImageView.cpp
+ * @brief 零拷贝图像视图实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "ImageView.h"
+
+namespace {
+
+/**
+ * @brief 子视图至少占源图像的该比例（像素数）时才包装源缓冲区，否则复制。
+ * 包装会让整块源缓冲区（可能是共享内存段）随子图像一直存活
+ */
+constexpr qint64 kWrapMinShareDivisor = 2;
+
+/**
+ * @brief 释放视图持有的源图像引用（QImage清理回调）
+ */
+void releaseSourceRef(void *info)
+{
+    delete static_cast<QImage *>(info);
+}
+
+} // namespace
+
+ImageView::ImageView()
+    : m_source()
+    , m_rect()
+    , m_devicePixelRatio(1.0)
+{
+}
+
+ImageView::ImageView(const QImage &source, const QRect &rect)
+    : m_source(source)
+    , m_rect(rect.isNull() ? source.rect() : rect.intersected(source.rect()))
+    , m_devicePixelRatio(source.devicePixelRatio())
+{
+}
+
+const uchar *ImageView::constScanLine(int y) const {
+    const int bytesPerPixel = m_source.depth() / 8;
+    return m_source.constScanLine(m_rect.y() + y) + m_rect.x() * bytesPerPixel;
+}
+
+ImageView ImageView::subView(const QRect &rect) const {
+    ImageView view(m_source, rect.translated(m_rect.topLeft()).intersected(m_rect));
+    view.m_devicePixelRatio = m_devicePixelRatio;
+    return view;
+}
+
+QImage ImageView::image() const {
+    if (isNull()) {
+        return QImage();
+    }
+
+    // 整幅视图：直接共享源图像
+    if (m_rect == m_source.rect() && m_source.devicePixelRatio() == m_devicePixelRatio) {
+        return m_source;
+    }
+
+    // 低于8位深度或带调色板的格式无法直接包装，只能复制；
+    // 小区域也直接复制，避免为少量像素长期占住整个源缓冲区
+    const qint64 viewPixels = qint64(m_rect.width()) * m_rect.height();
+    const qint64 sourcePixels = qint64(m_source.width()) * m_source.height();
+    if (m_source.depth() < 8 || m_source.format() == QImage::Format_Indexed8
+        || viewPixels * kWrapMinShareDivisor < sourcePixels) {
+        QImage copy = m_source.copy(m_rect);
+        copy.setDevicePixelRatio(m_devicePixelRatio);
+        return copy;
+    }
+
+    // 子视图：以源缓冲区的行跨度包装子矩形，清理回调负责释放源图像引用。
+    // 使用const数据构造，写入时QImage会自动分离（仅复制该子区域）
+    QImage *ref = new QImage(m_source);
+    QImage wrapped(constScanLine(0), m_rect.width(), m_rect.height(),
+                   m_source.bytesPerLine(), m_source.format(),
+                   releaseSourceRef, ref);
+    wrapped.setDevicePixelRatio(m_devicePixelRatio);
+    return wrapped;
+}
+
+QImage ImageView::toImage() const {
+    if (isNull()) {
+        return QImage();
+    }
+    QImage copy = m_source.copy(m_rect);
+    copy.setDevicePixelRatio(m_devicePixelRatio);
+    return copy;
+}
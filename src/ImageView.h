@@ -0,0 +1,132 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ImageView.h
+ * @brief 零拷贝图像视图
+ *
+ * 共享缓冲区 + 子矩形，用于在截图流程中传递裁剪结果而不复制像素
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef IMAGEVIEW_H
+#define IMAGEVIEW_H
+
+#include <QImage>
+#include <QRect>
+#include <QSize>
+
+/**
+ * @class ImageView
+ * @brief 引用计数的图像视图（共享缓冲区 + 子矩形）
+ *
+ * - 持有源图像的引用（QImage隐式共享），不复制像素
+ * - 子矩形使用设备像素坐标，按源图像的行跨度（stride）访问
+ * - image() 返回指向源缓冲区的只读QImage，首次写入时才复制该子区域（写时复制）；
+ *   子区域不足源图像一半时直接复制，不让小图像长期占住整个源缓冲区
+ * - 可以在线程间传递（只读访问是线程安全的）
+ */
+class ImageView
+{
+public:
+    ImageView();
+
+    /**
+     * @brief 构造视图
+     * @param source 源图像（共享，不复制）
+     * @param rect 子矩形（设备像素），为空时表示整幅图像
+     */
+    explicit ImageView(const QImage &source, const QRect &rect = QRect());
+
+    /**
+     * @brief 是否为空视图
+     */
+    bool isNull() const { return m_source.isNull() || m_rect.isEmpty(); }
+
+    /**
+     * @brief 视图在源图像中的矩形（设备像素）
+     */
+    QRect rect() const { return m_rect; }
+
+    /**
+     * @brief 视图尺寸（设备像素）
+     */
+    QSize size() const { return m_rect.size(); }
+
+    /**
+     * @brief 行跨度（字节），与源图像一致
+     */
+    qsizetype bytesPerLine() const { return m_source.bytesPerLine(); }
+
+    /**
+     * @brief 设备像素比
+     */
+    qreal devicePixelRatio() const { return m_devicePixelRatio; }
+
+    /**
+     * @brief 设置设备像素比（不影响源图像）
+     * @param dpr 设备像素比
+     */
+    void setDevicePixelRatio(qreal dpr) { m_devicePixelRatio = dpr; }
+
+    /**
+     * @brief 获取源图像
+     */
+    const QImage &source() const { return m_source; }
+
+    /**
+     * @brief 获取视图内某一行的只读指针
+     * @param y 行号（相对视图）
+     * @return 行首指针
+     */
+    const uchar *constScanLine(int y) const;
+
+    /**
+     * @brief 在当前视图上再取子视图
+     * @param rect 子矩形（相对视图的设备像素坐标）
+     * @return 子视图，仍共享同一缓冲区
+     */
+    ImageView subView(const QRect &rect) const;
+
+    /**
+     * @brief 获取零拷贝的只读QImage
+     *
+     * 返回的QImage直接引用源缓冲区并持有其引用；对其绘制或调用bits()时，
+     * Qt会自动分离出该子区域的私有副本，源图像不受影响。
+     * 视图不足源图像一半（像素数）时返回该子区域的副本
+     *
+     * @return 共享源缓冲区的QImage，或小区域的副本
+     */
+    QImage image() const;
+
+    /**
+     * @brief 复制出独立的QImage（立即物化像素）
+     * @return 深拷贝
+     */
+    QImage toImage() const;
+
+private:
+    QImage m_source;            ///< 源图像（共享缓冲区）
+    QRect m_rect;               ///< 子矩形（设备像素）
+    qreal m_devicePixelRatio;   ///< 设备像素比
+};
+
+#endif // IMAGEVIEW_H
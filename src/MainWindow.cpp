@@ -29,6 +29,9 @@
 #include "ScreenshotTool.h"
 #include "GlobalHotkey.h"
 #include "UpdateChecker.h"
+#include "CaptureMetrics.h"
+#include "HistoryBrowser.h"
+#include "CapturePipeline.h"
 #include <QApplication>
 #include <QSettings>
 #include <QPushButton>
@@ -69,6 +72,7 @@ MainWindow::MainWindow(QWidget *parent)
     , m_tray(nullptr)
     , m_hotkey(nullptr)
     , m_toggleShowAction(nullptr)
+    , m_historyBrowser()
     , m_updateChecker(nullptr)
     , m_localServer(nullptr)
 {
@@ -269,6 +273,18 @@ void MainWindow::onNewConnection() {
         QByteArray data = socket->readAll();
         qDebug() << "[LocalServer] Received message:" << data;
         
+        // 查询类命令：回复后直接返回，不打扰用户
+        bool handled = false;
+        const QByteArray reply = handleInstanceCommand(data.trimmed(), &handled);
+        if (handled) {
+            socket->write(reply);
+            socket->flush();
+            socket->waitForBytesWritten(1000);
+            socket->disconnectFromServer();
+            socket->deleteLater();
+            return;
+        }
+        
         // 显示主窗口（如果已显示则置顶）
         if (isVisible()) {
             qDebug() << "[LocalServer] Window already visible, raising to top";
@@ -285,6 +301,33 @@ void MainWindow::onNewConnection() {
     }
 }
 
+QByteArray MainWindow::handleInstanceCommand(const QByteArray &command, bool *handled) {
+    *handled = true;
+    CaptureMetrics &metrics = CaptureMetrics::instance();
+    
+    if (command == "METRICS") {
+        return metrics.report().toUtf8();
+    }
+    if (command == "METRICS_JSON") {
+        return metrics.toJson();
+    }
+    if (command.startsWith("METRICS_DUMP ")) {
+        const QString path = QString::fromUtf8(command.mid(int(qstrlen("METRICS_DUMP ")))).trimmed();
+        return metrics.dumpToFile(path) ? "OK " + path.toUtf8() + "\n" : QByteArray("ERROR failed to write dump\n");
+    }
+    if (command == "METRICS_RESET") {
+        metrics.reset();
+        return "OK\n";
+    }
+    if (command == "HISTORY_COMPACT") {
+        m_screenshotTool->compactHistoryIndex();
+        return "OK history index compaction scheduled\n";
+    }
+    
+    *handled = false;
+    return QByteArray();
+}
+
 void MainWindow::onRegionCapture() {
     // 检查是否有模态窗口正在显示
     if (QApplication::activeModalWidget() != nullptr) {
@@ -311,7 +354,7 @@ void MainWindow::onDelayedCapture() {
     m_screenshotTool->startRegionCapture();
 }
 
-void MainWindow::onScreenshotCaptured(const QPixmap &screenshot) {
+void MainWindow::onScreenshotCaptured(const QImage &screenshot) {
     m_currentScreenshot = screenshot;
     // 编辑窗口已在工具类内部弹出，主窗口保持当前显示状态
     m_lastPosition = pos();
@@ -522,11 +565,30 @@ void MainWindow::setupTray() {
     actAutoStart->setCheckable(true);
     actAutoStart->setChecked(isAutoStartEnabled());
     
+    // 跨屏截图保持最高DPR（关闭后合成到逻辑尺寸）
+    QAction *actNativeDpr = menu->addAction("跨屏截图保持高清");
+    actNativeDpr->setCheckable(true);
+    actNativeDpr->setChecked(m_screenshotTool && m_screenshotTool->mergeMode() == ScreenshotTool::MergeNativeDpr);
+    
+    // 预热截图：后台定时刷新屏幕快照，热键响应降到一帧以内
+    QAction *actWarmMode = menu->addAction("预热截图（低延迟）");
+    actWarmMode->setCheckable(true);
+    actWarmMode->setChecked(m_screenshotTool && m_screenshotTool->isWarmMode());
+    
+    // 滚动长截图：选择区域后边滚动边拼接
+    QAction *actScrollCapture = menu->addAction("滚动长截图");
+    
+    // 连拍：按设置的间隔连续截图，写入图片目录下的 Burst_* 文件夹
+    QMenu *burstMenu = menu->addMenu("连拍截图");
+    QAction *actBurstFull = burstMenu->addAction("开始全屏连拍");
+    QAction *actBurstRegion = burstMenu->addAction("开始区域连拍（上次选区）");
+    QAction *actBurstStop = burstMenu->addAction("停止连拍");
+    
     QAction *actCheckUpdate = menu->addAction("检查更新");
     
     QAction *actQuit = menu->addAction("退出");
     
-    connect(actHistory, &QAction::triggered, this, &MainWindow::onOpenHistoryFolder);
+    connect(actHistory, &QAction::triggered, this, &MainWindow::onShowHistoryBrowser);
     
     // 切换主界面显示/隐藏
     connect(m_toggleShowAction, &QAction::triggered, this, [this]() {
@@ -549,6 +611,65 @@ void MainWindow::setupTray() {
         qDebug() << "[Tray] Auto-start" << (checked ? "enabled" : "disabled");
     });
     
+    // 跨屏合成模式
+    connect(actNativeDpr, &QAction::triggered, this, [this](bool checked) {
+        if (m_screenshotTool) {
+            m_screenshotTool->setMergeMode(checked ? ScreenshotTool::MergeNativeDpr : ScreenshotTool::MergeLogical);
+        }
+    });
+    
+    // 预热截图模式
+    connect(actWarmMode, &QAction::triggered, this, [this](bool checked) {
+        if (m_screenshotTool) {
+            m_screenshotTool->setWarmMode(checked);
+        }
+    });
+    
+    // 滚动长截图
+    connect(actScrollCapture, &QAction::triggered, this, [this]() {
+        if (m_screenshotTool) {
+            m_screenshotTool->startScrollCapture();
+        }
+    });
+    
+    // 连拍
+    connect(burstMenu, &QMenu::aboutToShow, this, [this, actBurstFull, actBurstRegion, actBurstStop]() {
+        const bool running = m_screenshotTool && m_screenshotTool->isBurstCapturing();
+        actBurstFull->setEnabled(m_screenshotTool && !running);
+        actBurstRegion->setEnabled(m_screenshotTool && !running && m_screenshotTool->hasLastCaptureRegion());
+        actBurstStop->setEnabled(running);
+    });
+    connect(actBurstFull, &QAction::triggered, this, [this]() {
+        if (m_screenshotTool) {
+            m_screenshotTool->startBurstCapture(false);
+        }
+    });
+    connect(actBurstRegion, &QAction::triggered, this, [this]() {
+        if (m_screenshotTool) {
+            m_screenshotTool->startBurstCapture(true);
+        }
+    });
+    connect(actBurstStop, &QAction::triggered, this, [this]() {
+        if (m_screenshotTool) {
+            m_screenshotTool->stopBurstCapture();
+        }
+    });
+    if (m_screenshotTool) {
+        connect(m_screenshotTool, &ScreenshotTool::burstCaptureFinished, this,
+                [this](const QString &outputDir, int captured, int written, int dropped) {
+            Q_UNUSED(captured)
+            QString message = QString("已保存 %1 帧到 %2").arg(written).arg(QDir::toNativeSeparators(outputDir));
+            if (dropped > 0) {
+                message += QString("\n写入跟不上，丢弃 %1 帧").arg(dropped);
+            }
+            m_tray->showMessage("连拍完成", message);
+        });
+        connect(m_screenshotTool, &ScreenshotTool::historyDropped, this, [this](int count) {
+            m_tray->showMessage("历史记录", QString("截图过快，写入跟不上，%1 张截图未保存到历史记录").arg(count),
+                                QSystemTrayIcon::Warning);
+        });
+    }
+    
     // 检查更新
     connect(actCheckUpdate, &QAction::triggered, this, [this]() {
         qDebug() << "[Tray] Check update menu clicked";
@@ -695,4 +816,14 @@ void MainWindow::onOpenHistoryFolder() {
     } else {
         qDebug() << "[History] Failed to open history folder:" << historyPath;
     }
-}
\ No newline at end of file
+}
+
+void MainWindow::onShowHistoryBrowser() {
+    if (!m_historyBrowser) {
+        m_historyBrowser = new HistoryBrowser(CapturePipeline::historyFolderPath());
+        connect(m_historyBrowser, &HistoryBrowser::openFolderRequested, this, &MainWindow::onOpenHistoryFolder);
+    }
+    m_historyBrowser->show();
+    m_historyBrowser->raise();
+    m_historyBrowser->activateWindow();
+}
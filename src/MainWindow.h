@@ -47,10 +47,13 @@
 #include <QGuiApplication>
 #include <QTimer>
 #include <QLocalServer>
+#include <QImage>
+#include <QPointer>
 
 class ScreenshotTool;
 class GlobalHotkey;
 class UpdateChecker;
+class HistoryBrowser;
 
 /**
  * @class MainWindow
@@ -156,7 +159,7 @@ private slots:
      * @brief 截图完成处理
      * @param screenshot 截图结果
      */
-    void onScreenshotCaptured(const QPixmap &screenshot);
+    void onScreenshotCaptured(const QImage &screenshot);
 
     /**
      * @brief 编辑窗口关闭处理
@@ -197,6 +200,11 @@ private slots:
      */
     void onOpenHistoryFolder();
 
+    /**
+     * @brief 打开历史截图浏览窗口
+     */
+    void onShowHistoryBrowser();
+
 private:
     /**
      * @brief 初始化用户界面
@@ -253,6 +261,22 @@ private:
      */
     static QString getHistoryFolderPath();
 
+    /**
+     * @brief 处理其他实例通过本地套接字发来的命令
+     *
+     * 支持的命令：
+     * - METRICS：返回热路径延迟统计文本
+     * - METRICS_JSON：返回热路径延迟统计JSON
+     * - METRICS_DUMP <path>：导出统计JSON到文件
+     * - METRICS_RESET：清空统计
+     * - HISTORY_COMPACT：在历史写入线程中重写历史索引
+     *
+     * @param command 命令（已去除首尾空白）
+     * @param handled 输出：是否为已知命令（未知命令按SHOW处理）
+     * @return 回复内容
+     */
+    QByteArray handleInstanceCommand(const QByteArray &command, bool *handled);
+
 private:
     ScreenshotTool *m_screenshotTool;    ///< 截图工具核心
     GlobalHotkey *m_hotkey;                   ///< 全局热键
@@ -270,6 +294,7 @@ private:
     QAction *m_showAction;                    ///< 显示动作
     QAction *m_quitAction;                    ///< 退出动作
     QAction *m_toggleShowAction;              ///< 切换显示/隐藏动作
+    QPointer<HistoryBrowser> m_historyBrowser; ///< 历史截图浏览窗口（关闭时自动销毁）
 
     // 拖拽状态
     bool m_isDragging;                        ///< 是否正在拖拽
@@ -280,7 +305,7 @@ private:
     bool m_isMinimized;                       ///< 是否已最小化
     
     // 截图相关
-    QPixmap m_currentScreenshot;              ///< 当前截图
+    QImage m_currentScreenshot;               ///< 当前截图
     
     // 系统托盘（兼容性）
     QSystemTrayIcon *m_tray;                  ///< 系统托盘图标
@@ -0,0 +1,214 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file MosaicFilter.cpp
+ * @brief 原地网格对齐马赛克实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "MosaicFilter.h"
+#include "SimdSupport.h"
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief 一行中连续像素的各通道之和（sum[0..3]对应内存中的4个字节）
+ */
+void sumRowScalar(const quint32 *row, int width, quint32 *sum)
+{
+    for (int x = 0; x < width; ++x) {
+        const quint32 px = row[x];
+        sum[0] += px & 0xff;
+        sum[1] += (px >> 8) & 0xff;
+        sum[2] += (px >> 16) & 0xff;
+        sum[3] += px >> 24;
+    }
+}
+
+void fillRowScalar(quint32 *row, int width, quint32 value)
+{
+    for (int x = 0; x < width; ++x) {
+        row[x] = value;
+    }
+}
+
+#if defined(CAPSTEP_SIMD_SSE2)
+/**
+ * @brief SSE2求和：每次4个像素，先在16位中两两相加再扩展到32位累加
+ * @return 已处理的像素数
+ */
+int sumRowSse2(const quint32 *row, int width, __m128i &acc)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+        // (p0+p2, p1+p3)，每个16位通道最大510
+        const __m128i pairs = _mm_add_epi16(_mm_unpacklo_epi8(px, zero), _mm_unpackhi_epi8(px, zero));
+        acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(pairs, zero));
+        acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(pairs, zero));
+    }
+    return x;
+}
+
+int fillRowSse2(quint32 *row, int width, quint32 value)
+{
+    const __m128i v = _mm_set1_epi32(int(value));
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(row + x), v);
+    }
+    return x;
+}
+#endif
+
+#if defined(CAPSTEP_SIMD_NEON)
+int sumRowNeon(const quint32 *row, int width, uint32x4_t &acc)
+{
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        const uint8x16_t px = vld1q_u8(reinterpret_cast<const uint8_t *>(row + x));
+        const uint16x8_t pairs = vaddl_u8(vget_low_u8(px), vget_high_u8(px));
+        acc = vaddw_u16(acc, vget_low_u16(pairs));
+        acc = vaddw_u16(acc, vget_high_u16(pairs));
+    }
+    return x;
+}
+
+int fillRowNeon(quint32 *row, int width, quint32 value)
+{
+    const uint32x4_t v = vdupq_n_u32(value);
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        vst1q_u32(reinterpret_cast<uint32_t *>(row + x), v);
+    }
+    return x;
+}
+#endif
+
+/**
+ * @brief 一个格子：求各通道平均值并整体填充
+ */
+void pixelateCell(uchar *bits, qsizetype stride, const QRect &cell, bool sse2, bool neon)
+{
+    quint32 sum[4] = { 0, 0, 0, 0 };
+    const int width = cell.width();
+#if defined(CAPSTEP_SIMD_SSE2)
+    __m128i acc = _mm_setzero_si128();
+#endif
+#if defined(CAPSTEP_SIMD_NEON)
+    uint32x4_t acc = vdupq_n_u32(0);
+#endif
+    for (int y = cell.top(); y <= cell.bottom(); ++y) {
+        const quint32 *row = reinterpret_cast<const quint32 *>(bits + y * stride) + cell.left();
+        int x = 0;
+#if defined(CAPSTEP_SIMD_SSE2)
+        if (sse2) {
+            x = sumRowSse2(row, width, acc);
+        }
+#endif
+#if defined(CAPSTEP_SIMD_NEON)
+        if (neon) {
+            x = sumRowNeon(row, width, acc);
+        }
+#endif
+        sumRowScalar(row + x, width - x, sum);
+    }
+#if defined(CAPSTEP_SIMD_SSE2)
+    if (sse2) {
+        // acc的4个32位通道与p0+p1+p2+p3的4个字节一一对应
+        quint32 lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), acc);
+        for (int c = 0; c < 4; ++c) {
+            sum[c] += lanes[c];
+        }
+    }
+#endif
+#if defined(CAPSTEP_SIMD_NEON)
+    if (neon) {
+        quint32 lanes[4];
+        vst1q_u32(lanes, acc);
+        for (int c = 0; c < 4; ++c) {
+            sum[c] += lanes[c];
+        }
+    }
+#endif
+    Q_UNUSED(sse2)
+    Q_UNUSED(neon)
+
+    const quint32 count = quint32(width) * quint32(cell.height());
+    quint32 value = 0;
+    for (int c = 0; c < 4; ++c) {
+        value |= ((sum[c] + count / 2) / count) << (c * 8);
+    }
+
+    for (int y = cell.top(); y <= cell.bottom(); ++y) {
+        quint32 *row = reinterpret_cast<quint32 *>(bits + y * stride) + cell.left();
+        int x = 0;
+#if defined(CAPSTEP_SIMD_SSE2)
+        if (sse2) {
+            x = fillRowSse2(row, width, value);
+        }
+#endif
+#if defined(CAPSTEP_SIMD_NEON)
+        if (neon) {
+            x = fillRowNeon(row, width, value);
+        }
+#endif
+        fillRowScalar(row + x, width - x, value);
+    }
+}
+
+} // namespace
+
+bool MosaicFilter::supports(QImage::Format format) {
+    return format == QImage::Format_RGB32
+        || format == QImage::Format_ARGB32
+        || format == QImage::Format_ARGB32_Premultiplied;
+}
+
+QRect MosaicFilter::pixelate(QImage &image, const QRect &rect, int cellSize) {
+    const QRect clipped = rect.intersected(image.rect());
+    if (clipped.isEmpty() || cellSize < 1 || !supports(image.format())) {
+        return QRect();
+    }
+
+    // 扩展到格子边界（格子从图像原点开始划分）
+    const int left = clipped.left() / cellSize * cellSize;
+    const int top = clipped.top() / cellSize * cellSize;
+    const int right = clipped.right() / cellSize * cellSize + cellSize - 1;
+    const int bottom = clipped.bottom() / cellSize * cellSize + cellSize - 1;
+    const QRect area = QRect(QPoint(left, top), QPoint(right, bottom)).intersected(image.rect());
+
+    const bool sse2 = SimdSupport::hasSse2();
+    const bool neon = SimdSupport::hasNeon();
+    uchar *bits = image.bits();     // 共享时在此分离，之后不再复制
+    const qsizetype stride = image.bytesPerLine();
+    for (int y = area.top(); y <= area.bottom(); y += cellSize) {
+        for (int x = area.left(); x <= area.right(); x += cellSize) {
+            const QRect cell = QRect(x, y, cellSize, cellSize).intersected(area);
+            pixelateCell(bits, stride, cell, sse2, neon);
+        }
+    }
+    return area;
+}
@@ -0,0 +1,62 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file MosaicFilter.h
+ * @brief 原地网格对齐马赛克
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef MOSAICFILTER_H
+#define MOSAICFILTER_H
+
+#include <QImage>
+#include <QRect>
+
+/**
+ * @class MosaicFilter
+ * @brief 在32位图像缓冲区中原地计算马赛克
+ *
+ * 图像按 cellSize × cellSize 设备像素划分为从原点开始的固定网格，
+ * 与给定矩形相交的每个格子整体替换为格内像素的平均值：
+ * - 直接读写 scanLine()，不分配内存、不转换格式、不经过QPainter
+ * - 网格对齐使结果与重复次数无关（已处理的格子均值不变），拖动中重叠的区域可以反复处理
+ * - 求和与填充使用SSE2/NEON，没有时退回标量实现
+ */
+class MosaicFilter
+{
+public:
+    /**
+     * @brief 是否支持该像素格式（RGB32 / ARGB32 / ARGB32_Premultiplied）
+     */
+    static bool supports(QImage::Format format);
+
+    /**
+     * @brief 对矩形覆盖的格子做马赛克
+     * @param image 图像（共享时先分离）
+     * @param rect 区域（设备像素），相交的格子整体处理
+     * @param cellSize 格子边长（设备像素）
+     * @return 实际改动的区域（设备像素，按格子对齐）；格式不支持时为空
+     */
+    static QRect pixelate(QImage &image, const QRect &rect, int cellSize);
+};
+
+#endif // MOSAICFILTER_H
@@ -0,0 +1,79 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ParallelBands.h
+ * @brief 按行带拆分的并行执行辅助
+ *
+ * 模糊、缩放等逐行（逐列）独立的像素内核共用同一套拆分规则，
+ * 在全局线程池中执行，工作量小时直接在当前线程完成
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef PARALLELBANDS_H
+#define PARALLELBANDS_H
+
+#include <QVector>
+#include <QPair>
+#include <QThread>
+#include <QtConcurrent>
+
+/**
+ * @class ParallelBands
+ * @brief 把 [0, lines) 拆成若干行带并行处理
+ */
+class ParallelBands
+{
+public:
+    static constexpr qint64 Threshold = 256 * 256;   ///< 小于该像素数的任务在当前线程完成，避免调度开销超过计算本身
+    static constexpr int MinLinesPerBand = 16;       ///< 每个行带的最少行数
+
+    /**
+     * @brief 按行带拆分任务并在全局线程池中执行
+     * @param lines 总行数（或列数）
+     * @param work 工作量（像素数），过小时直接在当前线程执行
+     * @param fn 处理 [begin, end) 的函数，各行带之间不能有写冲突
+     */
+    template <typename Fn>
+    static void run(int lines, qint64 work, const Fn &fn)
+    {
+        int bands = 1;
+        if (work >= Threshold) {
+            // 行带数多于线程数，让先完成的线程继续领取，平衡各核负载
+            bands = qBound(1, lines / MinLinesPerBand, QThread::idealThreadCount() * 2);
+        }
+        if (bands <= 1) {
+            fn(0, lines);
+            return;
+        }
+
+        QVector<QPair<int, int>> ranges;
+        ranges.reserve(bands);
+        for (int i = 0; i < bands; ++i) {
+            ranges.append(qMakePair(int(qint64(lines) * i / bands), int(qint64(lines) * (i + 1) / bands)));
+        }
+        QtConcurrent::blockingMap(ranges, [&fn](const QPair<int, int> &range) {
+            fn(range.first, range.second);
+        });
+    }
+};
+
+#endif // PARALLELBANDS_H
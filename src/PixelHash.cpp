@@ -0,0 +1,308 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file PixelHash.cpp
+ * @brief 图像内容哈希实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "PixelHash.h"
+#include "SimdSupport.h"
+#include <cstring>
+
+namespace {
+
+constexpr int kLanes = 4;                   ///< 64位累加通道数
+constexpr int kStripeBytes = 32;            ///< 每个条带的字节数
+constexpr int kStripesPerBlock = 8;         ///< 每个块的条带数（块结束时扰动）
+constexpr quint64 kPrime32 = 0x9E3779B1ull;
+
+inline quint64 mix64(quint64 h)
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+inline quint64 rotl64(quint64 v, int r)
+{
+    return (v << r) | (v >> (64 - r));
+}
+
+/**
+ * @brief 密钥：每个条带位置一组通道密钥，最后一组用于扰动
+ */
+struct Secret {
+    quint64 keys[kStripesPerBlock + 1][kLanes];
+
+    Secret()
+    {
+        quint64 state = 0x243F6A8885A308D3ull;
+        for (auto &stripe : keys) {
+            for (quint64 &key : stripe) {
+                state += 0x9E3779B97F4A7C15ull;
+                key = mix64(state);
+            }
+        }
+    }
+};
+
+const Secret &secret()
+{
+    static const Secret s;
+    return s;
+}
+
+inline quint64 load64(const uchar *p)
+{
+    quint64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// ---------------------------------------------------------------------------
+// 标量实现（参考实现，SIMD路径必须与其逐位一致）
+// ---------------------------------------------------------------------------
+
+inline void stripeScalar(quint64 *acc, const uchar *p, const quint64 *key)
+{
+    for (int i = 0; i < kLanes; ++i) {
+        const quint64 data = load64(p + i * 8);
+        const quint64 mixed = data ^ key[i];
+        acc[i] += (mixed & 0xffffffffull) * (mixed >> 32);
+        acc[i ^ 1] += data;
+    }
+}
+
+inline void scrambleScalar(quint64 *acc, const quint64 *key)
+{
+    for (int i = 0; i < kLanes; ++i) {
+        quint64 v = acc[i];
+        v ^= v >> 47;
+        v ^= key[i];
+        acc[i] = v * kPrime32;
+    }
+}
+
+void hashRowScalar(quint64 *acc, const uchar *row, qsizetype bytes)
+{
+    const Secret &s = secret();
+    qsizetype offset = 0;
+    int stripe = 0;
+    for (; offset + kStripeBytes <= bytes; offset += kStripeBytes) {
+        stripeScalar(acc, row + offset, s.keys[stripe]);
+        if (++stripe == kStripesPerBlock) {
+            scrambleScalar(acc, s.keys[kStripesPerBlock]);
+            stripe = 0;
+        }
+    }
+    if (offset < bytes) {
+        uchar tail[kStripeBytes] = {};
+        memcpy(tail, row + offset, size_t(bytes - offset));
+        stripeScalar(acc, tail, s.keys[stripe]);
+    }
+    scrambleScalar(acc, s.keys[kStripesPerBlock]);
+}
+
+// ---------------------------------------------------------------------------
+// SSE2：_mm_mul_epu32 完成32×32→64位乘法，每个寄存器两条通道
+// ---------------------------------------------------------------------------
+
+#if defined(CAPSTEP_SIMD_SSE2)
+inline __m128i stripeSse2(__m128i acc, const uchar *p, const quint64 *key)
+{
+    const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const __m128i mixed = _mm_xor_si128(data, _mm_loadu_si128(reinterpret_cast<const __m128i *>(key)));
+    const __m128i high = _mm_shuffle_epi32(mixed, _MM_SHUFFLE(0, 3, 0, 1));
+    const __m128i product = _mm_mul_epu32(mixed, high);
+    const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+    return _mm_add_epi64(acc, _mm_add_epi64(product, swapped));
+}
+
+inline __m128i scrambleSse2(__m128i acc, const quint64 *key)
+{
+    const __m128i prime = _mm_set1_epi32(int(kPrime32));
+    acc = _mm_xor_si128(acc, _mm_srli_epi64(acc, 47));
+    acc = _mm_xor_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i *>(key)));
+    const __m128i low = _mm_mul_epu32(acc, prime);
+    const __m128i high = _mm_mul_epu32(_mm_srli_epi64(acc, 32), prime);
+    return _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+}
+
+void hashRowSse2(quint64 *acc, const uchar *row, qsizetype bytes)
+{
+    const Secret &s = secret();
+    __m128i acc0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(acc));
+    __m128i acc1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(acc + 2));
+    qsizetype offset = 0;
+    int stripe = 0;
+    for (; offset + kStripeBytes <= bytes; offset += kStripeBytes) {
+        acc0 = stripeSse2(acc0, row + offset, s.keys[stripe]);
+        acc1 = stripeSse2(acc1, row + offset + 16, s.keys[stripe] + 2);
+        if (++stripe == kStripesPerBlock) {
+            acc0 = scrambleSse2(acc0, s.keys[kStripesPerBlock]);
+            acc1 = scrambleSse2(acc1, s.keys[kStripesPerBlock] + 2);
+            stripe = 0;
+        }
+    }
+    if (offset < bytes) {
+        uchar tail[kStripeBytes] = {};
+        memcpy(tail, row + offset, size_t(bytes - offset));
+        acc0 = stripeSse2(acc0, tail, s.keys[stripe]);
+        acc1 = stripeSse2(acc1, tail + 16, s.keys[stripe] + 2);
+    }
+    acc0 = scrambleSse2(acc0, s.keys[kStripesPerBlock]);
+    acc1 = scrambleSse2(acc1, s.keys[kStripesPerBlock] + 2);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(acc), acc0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(acc + 2), acc1);
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// NEON：vmull_u32 完成32×32→64位乘法
+// ---------------------------------------------------------------------------
+
+#if defined(CAPSTEP_SIMD_NEON)
+inline uint64x2_t stripeNeon(uint64x2_t acc, const uchar *p, const quint64 *key)
+{
+    const uint64x2_t data = vreinterpretq_u64_u8(vld1q_u8(p));
+    const uint64x2_t mixed = veorq_u64(data, vld1q_u64(key));
+    const uint64x2_t product = vmull_u32(vmovn_u64(mixed), vshrn_n_u64(mixed, 32));
+    const uint64x2_t swapped = vextq_u64(data, data, 1);
+    return vaddq_u64(acc, vaddq_u64(product, swapped));
+}
+
+inline uint64x2_t scrambleNeon(uint64x2_t acc, const quint64 *key)
+{
+    const uint32x2_t prime = vdup_n_u32(quint32(kPrime32));
+    acc = veorq_u64(acc, vshrq_n_u64(acc, 47));
+    acc = veorq_u64(acc, vld1q_u64(key));
+    const uint64x2_t low = vmull_u32(vmovn_u64(acc), prime);
+    const uint64x2_t high = vmull_u32(vshrn_n_u64(acc, 32), prime);
+    return vaddq_u64(low, vshlq_n_u64(high, 32));
+}
+
+void hashRowNeon(quint64 *acc, const uchar *row, qsizetype bytes)
+{
+    const Secret &s = secret();
+    uint64x2_t acc0 = vld1q_u64(acc);
+    uint64x2_t acc1 = vld1q_u64(acc + 2);
+    qsizetype offset = 0;
+    int stripe = 0;
+    for (; offset + kStripeBytes <= bytes; offset += kStripeBytes) {
+        acc0 = stripeNeon(acc0, row + offset, s.keys[stripe]);
+        acc1 = stripeNeon(acc1, row + offset + 16, s.keys[stripe] + 2);
+        if (++stripe == kStripesPerBlock) {
+            acc0 = scrambleNeon(acc0, s.keys[kStripesPerBlock]);
+            acc1 = scrambleNeon(acc1, s.keys[kStripesPerBlock] + 2);
+            stripe = 0;
+        }
+    }
+    if (offset < bytes) {
+        uchar tail[kStripeBytes] = {};
+        memcpy(tail, row + offset, size_t(bytes - offset));
+        acc0 = stripeNeon(acc0, tail, s.keys[stripe]);
+        acc1 = stripeNeon(acc1, tail + 16, s.keys[stripe] + 2);
+    }
+    acc0 = scrambleNeon(acc0, s.keys[kStripesPerBlock]);
+    acc1 = scrambleNeon(acc1, s.keys[kStripesPerBlock] + 2);
+    vst1q_u64(acc, acc0);
+    vst1q_u64(acc + 2, acc1);
+}
+#endif
+
+using HashRowFn = void (*)(quint64 *, const uchar *, qsizetype);
+
+HashRowFn selectHashRow()
+{
+#if defined(CAPSTEP_SIMD_SSE2)
+    if (SimdSupport::hasSse2()) {
+        return hashRowSse2;
+    }
+#endif
+#if defined(CAPSTEP_SIMD_NEON)
+    if (SimdSupport::hasNeon()) {
+        return hashRowNeon;
+    }
+#endif
+    return hashRowScalar;
+}
+
+} // namespace
+
+PixelHash PixelHash::of(const QImage &image) {
+    PixelHash result;
+    if (image.isNull()) {
+        return result;
+    }
+
+    const int width = image.width();
+    const int height = image.height();
+    const qsizetype rowBytes = (qsizetype(width) * image.depth() + 7) / 8;
+    const qsizetype stride = image.bytesPerLine();
+    const quint64 shape = (quint64(quint32(width)) << 32) | quint32(height);
+    const quint64 format = quint64(image.format());
+
+    quint64 acc[kLanes];
+    for (int i = 0; i < kLanes; ++i) {
+        acc[i] = mix64(shape + quint64(i) * 0x9E3779B97F4A7C15ull) ^ format;
+    }
+
+    static const HashRowFn hashRow = selectHashRow();
+    const uchar *bits = image.constBits();
+    for (int y = 0; y < height; ++y) {
+        hashRow(acc, bits + y * stride, rowBytes);
+    }
+
+    const quint64 length = quint64(rowBytes) * quint64(height);
+    const quint64 a = mix64(acc[0] ^ rotl64(acc[1], 17) ^ length);
+    const quint64 b = mix64(acc[2] ^ rotl64(acc[3], 31) ^ shape);
+    result.high = mix64(a ^ mix64(b + 0x94D049BB133111EBull));
+    result.low = mix64(b ^ mix64(a + 0xBF58476D1CE4E5B9ull));
+    if (result.isNull()) {
+        result.low = 1;
+    }
+    return result;
+}
+
+PixelHash PixelHash::fromHex(const QString &hex) {
+    PixelHash result;
+    if (hex.size() != 32) {
+        return result;
+    }
+    bool okHigh = false;
+    bool okLow = false;
+    const quint64 high = hex.left(16).toULongLong(&okHigh, 16);
+    const quint64 low = hex.mid(16).toULongLong(&okLow, 16);
+    if (okHigh && okLow) {
+        result.high = high;
+        result.low = low;
+    }
+    return result;
+}
+
+QString PixelHash::toHex() const {
+    return QString("%1%2").arg(high, 16, 16, QChar('0')).arg(low, 16, 16, QChar('0'));
+}
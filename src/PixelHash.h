@@ -0,0 +1,81 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file PixelHash.h
+ * @brief 图像内容哈希
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef PIXELHASH_H
+#define PIXELHASH_H
+
+#include <QImage>
+#include <QString>
+#include <QHashFunctions>
+
+/**
+ * @struct PixelHash
+ * @brief 128位图像内容哈希
+ *
+ * 只覆盖尺寸、像素格式和每行的有效像素字节（不含行尾填充），与DPR等元数据无关。
+ * 4条64位通道按32字节条带累加（32×32→64位乘法），每256字节和每行结束时扰动一次，
+ * SSE2、NEON与标量路径结果逐位一致，可以持久化
+ */
+struct PixelHash
+{
+    quint64 high = 0;   ///< 高64位
+    quint64 low = 0;    ///< 低64位
+
+    /**
+     * @brief 计算图像内容哈希
+     * @param image 图像
+     * @return 哈希（空图像返回空哈希）
+     */
+    static PixelHash of(const QImage &image);
+
+    /**
+     * @brief 从32位十六进制字符串解析
+     * @param hex 十六进制字符串
+     * @return 哈希（格式错误时返回空哈希）
+     */
+    static PixelHash fromHex(const QString &hex);
+
+    /**
+     * @brief 转换为32位十六进制字符串
+     */
+    QString toHex() const;
+
+    /**
+     * @brief 是否为空哈希
+     */
+    bool isNull() const { return high == 0 && low == 0; }
+
+    bool operator==(const PixelHash &other) const { return high == other.high && low == other.low; }
+    bool operator!=(const PixelHash &other) const { return !(*this == other); }
+};
+
+inline size_t qHash(const PixelHash &hash, size_t seed = 0) noexcept
+{
+    return qHash(hash.low ^ (hash.high >> 1), seed);
+}
+
+#endif // PIXELHASH_H
@@ -0,0 +1,485 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file PngEncoder.cpp
+ * @brief 多线程分块PNG编码实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "PngEncoder.h"
+#include "TiledImage.h"
+#include <QIODevice>
+#include <QSaveFile>
+#include <QImageWriter>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QDebug>
+
+#ifdef CAPSTEP_HAVE_ZLIB
+#include <QVector>
+#include <QByteArray>
+#include <QtConcurrent>
+#include <zlib.h>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#endif
+
+namespace {
+
+/**
+ * @brief 用Qt的编码器写入（单线程）
+ */
+bool writeWithQt(const QImage &image, QIODevice *device, int level)
+{
+    QImageWriter writer(device, "png");
+    if (level >= 0) {
+        // Qt把PNG的质量参数按 (100 - quality) * 9 / 91 映射为zlib压缩级别
+        writer.setQuality(100 - (qMin(level, 9) * 91 + 8) / 9);
+    }
+    if (!writer.write(image)) {
+        qWarning() << "[PNG] Encode failed:" << writer.errorString();
+        return false;
+    }
+    return true;
+}
+
+#ifdef CAPSTEP_HAVE_ZLIB
+
+constexpr qint64 kChunkBytes = 256 * 1024;  ///< 每个deflate块的目标输入字节数
+constexpr int kDictionaryBytes = 32768;     ///< deflate窗口大小
+constexpr qint64 kBandBytes = 16 << 20;     ///< 分块图像每次读回的像素字节数
+
+/**
+ * @brief 一个并行块：连续若干行
+ */
+struct Chunk {
+    int firstRow = 0;           ///< 起始行
+    int rowCount = 0;           ///< 行数
+    QByteArray compressed;      ///< 原始deflate数据
+    uLong adler = 1;            ///< 本块滤波后数据的Adler-32
+    bool ok = false;            ///< 是否压缩成功
+};
+
+inline uchar paethPredictor(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return uchar(a);
+    }
+    return uchar(pb <= pc ? b : c);
+}
+
+/**
+ * @brief 对一行选择滤波器并写出（首字节为滤波类型）
+ *
+ * 与libpng的默认启发式相同：取滤波后字节（按有符号数）绝对值之和最小的滤波器
+ */
+void filterRow(const uchar *row, const uchar *prev, int bytes, int bpp, uchar *out)
+{
+    quint64 sums[5] = {0, 0, 0, 0, 0};
+    for (int i = 0; i < bytes; ++i) {
+        const int x = row[i];
+        const int a = i >= bpp ? row[i - bpp] : 0;
+        const int b = prev[i];
+        const int c = i >= bpp ? prev[i - bpp] : 0;
+        sums[0] += std::abs(int(static_cast<signed char>(x)));
+        sums[1] += std::abs(int(static_cast<signed char>(x - a)));
+        sums[2] += std::abs(int(static_cast<signed char>(x - b)));
+        sums[3] += std::abs(int(static_cast<signed char>(x - ((a + b) >> 1))));
+        sums[4] += std::abs(int(static_cast<signed char>(x - paethPredictor(a, b, c))));
+    }
+    int best = 0;
+    for (int f = 1; f < 5; ++f) {
+        if (sums[f] < sums[best]) {
+            best = f;
+        }
+    }
+
+    out[0] = uchar(best);
+    uchar *dst = out + 1;
+    for (int i = 0; i < bytes; ++i) {
+        const int x = row[i];
+        const int a = i >= bpp ? row[i - bpp] : 0;
+        const int b = prev[i];
+        const int c = i >= bpp ? prev[i - bpp] : 0;
+        switch (best) {
+        case 0: dst[i] = uchar(x); break;
+        case 1: dst[i] = uchar(x - a); break;
+        case 2: dst[i] = uchar(x - b); break;
+        case 3: dst[i] = uchar(x - ((a + b) >> 1)); break;
+        default: dst[i] = uchar(x - paethPredictor(a, b, c)); break;
+        }
+    }
+}
+
+/**
+ * @brief 压缩一块滤波后的数据为原始deflate流
+ * @param dictionary 前一块末尾的数据（首块为空）
+ */
+bool deflateChunk(const uchar *data, qint64 size, const uchar *dictionary, int dictionarySize,
+                  int level, bool last, QByteArray *out)
+{
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    if (dictionarySize > 0 && deflateSetDictionary(&stream, dictionary, uInt(dictionarySize)) != Z_OK) {
+        deflateEnd(&stream);
+        return false;
+    }
+
+    // 同步刷新额外输出一个空的存储块（5字节）
+    out->resize(qsizetype(deflateBound(&stream, uLong(size))) + 16);
+    stream.next_in = const_cast<Bytef *>(data);
+    stream.avail_in = uInt(size);
+    const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    int status = Z_OK;
+    qint64 produced = 0;
+    for (;;) {
+        stream.next_out = reinterpret_cast<Bytef *>(out->data()) + produced;
+        stream.avail_out = uInt(out->size() - produced);
+        status = deflate(&stream, flush);
+        produced = qint64(stream.total_out);
+        if (status == Z_STREAM_ERROR) {
+            break;
+        }
+        // 输出缓冲区用完时扩大后继续；否则本块已全部输出
+        if (stream.avail_out != 0 && (!last || status == Z_STREAM_END)) {
+            break;
+        }
+        out->resize(out->size() * 2);
+    }
+    deflateEnd(&stream);
+    if (status == Z_STREAM_ERROR || (last && status != Z_STREAM_END)) {
+        return false;
+    }
+    out->truncate(produced);
+    return true;
+}
+
+void appendBigEndian32(QByteArray *out, quint32 value)
+{
+    const char bytes[4] = {char(value >> 24), char(value >> 16), char(value >> 8), char(value)};
+    out->append(bytes, 4);
+}
+
+/**
+ * @brief 写出一个PNG数据块（长度、类型、数据、CRC）
+ */
+bool writePngChunk(QIODevice *device, const char *type, const QByteArray &data)
+{
+    QByteArray header;
+    appendBigEndian32(&header, quint32(data.size()));
+    header.append(type, 4);
+    uLong crc = crc32(0, reinterpret_cast<const Bytef *>(type), 4);
+    crc = crc32(crc, reinterpret_cast<const Bytef *>(data.constData()), uInt(data.size()));
+    QByteArray trailer;
+    appendBigEndian32(&trailer, quint32(crc));
+    return device->write(header) == header.size() && device->write(data) == data.size()
+           && device->write(trailer) == trailer.size();
+}
+
+/**
+ * @class StreamWriter
+ * @brief 分段送入像素的PNG编码器
+ *
+ * 每段行并行滤波，再以之前数据末尾32KB为预设字典并行压缩后立即写出IDAT，
+ * 内存中只保留当前这一段、上一段的最后一行和末尾32KB滤波数据
+ */
+class StreamWriter
+{
+public:
+    StreamWriter(QIODevice *device, int level)
+        : m_device(device)
+        , m_level(level)
+    {
+    }
+
+    /**
+     * @brief 写出文件头（签名、IHDR、pHYs）
+     * @param dotsPerMeterX 水平分辨率（不大于0时不写pHYs）
+     */
+    bool begin(int width, int height, bool alpha, int dotsPerMeterX, int dotsPerMeterY)
+    {
+        m_width = width;
+        m_height = height;
+        m_alpha = alpha;
+        m_bpp = alpha ? 4 : 3;
+        m_rowBytes = width * m_bpp;
+        m_filteredRowBytes = m_rowBytes + 1;
+        m_previousRow = QByteArray(m_rowBytes, '\0');
+
+        static const char signature[8] = {char(0x89), 'P', 'N', 'G', '\r', '\n', char(0x1a), '\n'};
+        if (m_device->write(signature, 8) != 8) {
+            return false;
+        }
+
+        QByteArray ihdr;
+        appendBigEndian32(&ihdr, quint32(width));
+        appendBigEndian32(&ihdr, quint32(height));
+        ihdr.append(char(8));                  // 位深度
+        ihdr.append(char(alpha ? 6 : 2));      // RGBA / RGB
+        ihdr.append(3, '\0');                  // deflate、自适应滤波、不隔行
+        if (!writePngChunk(m_device, "IHDR", ihdr)) {
+            return false;
+        }
+
+        if (dotsPerMeterX > 0 && dotsPerMeterY > 0) {
+            QByteArray phys;
+            appendBigEndian32(&phys, quint32(dotsPerMeterX));
+            appendBigEndian32(&phys, quint32(dotsPerMeterY));
+            phys.append(char(1));              // 单位：米
+            if (!writePngChunk(m_device, "pHYs", phys)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief 编码并写出下一段行（最后一段以 Z_FINISH 结束并附上Adler-32）
+     */
+    bool addRows(const QImage &band)
+    {
+        // RGB888/RGBA8888 的扫描行字节顺序与PNG相同，不依赖平台字节序
+        const QImage source = band.convertToFormat(m_alpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+        const int rows = source.height();
+        if (source.isNull() || source.width() != m_width || m_rowsDone + rows > m_height) {
+            return false;
+        }
+        const bool lastBand = m_rowsDone + rows == m_height;
+
+        // 缓冲区前部放上一段末尾的滤波数据，作为本段首块的字典
+        const qint64 dictionaryBytes = m_tail.size();
+        QByteArray buffer(qsizetype(dictionaryBytes + m_filteredRowBytes * rows), Qt::Uninitialized);
+        if (buffer.isEmpty()) {
+            return false;
+        }
+        std::memcpy(buffer.data(), m_tail.constData(), size_t(dictionaryBytes));
+        uchar *data = reinterpret_cast<uchar *>(buffer.data());
+        uchar *filteredData = data + dictionaryBytes;
+
+        const int rowsPerChunk = int(qMax<qint64>(1, kChunkBytes / m_filteredRowBytes));
+        QVector<Chunk> chunks;
+        for (int row = 0; row < rows; row += rowsPerChunk) {
+            Chunk chunk;
+            chunk.firstRow = row;
+            chunk.rowCount = qMin(rowsPerChunk, rows - row);
+            chunks.append(chunk);
+        }
+
+        // 第一遍：滤波（只读相邻行的原始像素，各块互不依赖）
+        const uchar *previousRow = reinterpret_cast<const uchar *>(m_previousRow.constData());
+        QtConcurrent::blockingMap(chunks, [&](Chunk &chunk) {
+            for (int y = chunk.firstRow; y < chunk.firstRow + chunk.rowCount; ++y) {
+                const uchar *prev = y > 0 ? source.constScanLine(y - 1) : previousRow;
+                filterRow(source.constScanLine(y), prev, m_rowBytes, m_bpp, filteredData + y * m_filteredRowBytes);
+            }
+        });
+
+        // 第二遍：以前一块末尾为字典独立压缩，同时计算各块的Adler-32
+        const Chunk *lastChunk = &chunks.last();
+        QtConcurrent::blockingMap(chunks, [&](Chunk &chunk) {
+            const qint64 start = dictionaryBytes + chunk.firstRow * m_filteredRowBytes;
+            const qint64 size = chunk.rowCount * m_filteredRowBytes;
+            const int dictionarySize = int(qMin<qint64>(start, kDictionaryBytes));
+            chunk.adler = adler32(1, data + start, uInt(size));
+            chunk.ok = deflateChunk(data + start, size, data + start - dictionarySize, dictionarySize,
+                                    m_level, lastBand && &chunk == lastChunk, &chunk.compressed);
+        });
+
+        for (const Chunk &chunk : std::as_const(chunks)) {
+            if (!chunk.ok) {
+                qWarning() << "[PNG] Deflate failed for rows" << m_rowsDone + chunk.firstRow;
+                return false;
+            }
+            m_adler = adler32_combine(m_adler, chunk.adler, z_off_t(chunk.rowCount * m_filteredRowBytes));
+        }
+
+        // 每块一个IDAT，首块前加zlib头，末块后加Adler-32
+        for (int i = 0; i < chunks.size(); ++i) {
+            QByteArray idat;
+            if (m_rowsDone == 0 && i == 0) {
+                appendZlibHeader(&idat);
+            }
+            idat.append(chunks.at(i).compressed);
+            if (lastBand && i == chunks.size() - 1) {
+                appendBigEndian32(&idat, quint32(m_adler));
+            }
+            if (!writePngChunk(m_device, "IDAT", idat)) {
+                return false;
+            }
+            chunks[i].compressed.clear();
+        }
+
+        const qsizetype tailBytes = qMin<qsizetype>(buffer.size(), kDictionaryBytes);
+        m_tail = buffer.right(tailBytes);
+        m_previousRow = QByteArray(reinterpret_cast<const char *>(source.constScanLine(rows - 1)), m_rowBytes);
+        m_rowsDone += rows;
+        return true;
+    }
+
+    /**
+     * @brief 写出IEND（所有行都已送入时）
+     */
+    bool finish()
+    {
+        return m_rowsDone == m_height && writePngChunk(m_device, "IEND", QByteArray());
+    }
+
+private:
+    /**
+     * @brief zlib头：32K窗口的deflate，FLEVEL按压缩级别，校验位使头部为31的倍数
+     */
+    void appendZlibHeader(QByteArray *out) const
+    {
+        const int effectiveLevel = m_level < 0 ? 6 : m_level;
+        const int flevel = effectiveLevel <= 1 ? 0 : effectiveLevel <= 5 ? 1 : effectiveLevel == 6 ? 2 : 3;
+        const int cmf = 0x78;
+        int flg = flevel << 6;
+        flg += 31 - ((cmf * 256 + flg) % 31);
+        out->append(char(cmf));
+        out->append(char(flg));
+    }
+
+    QIODevice *m_device;            ///< 输出设备
+    int m_level;                    ///< 压缩级别
+    int m_width = 0;                ///< 宽度
+    int m_height = 0;               ///< 总行数
+    bool m_alpha = false;           ///< 是否带alpha
+    int m_bpp = 3;                  ///< 每像素字节数
+    int m_rowBytes = 0;             ///< 每行像素字节数
+    qint64 m_filteredRowBytes = 1;  ///< 每行滤波后字节数（含滤波类型）
+    int m_rowsDone = 0;             ///< 已写出的行数
+    uLong m_adler = 1;              ///< 已写出数据的Adler-32
+    QByteArray m_previousRow;       ///< 上一段最后一行的原始像素（首行滤波的参考行）
+    QByteArray m_tail;              ///< 已写出数据末尾的滤波数据（下一段的字典）
+};
+
+/**
+ * @brief 多线程编码
+ */
+bool writeParallel(const QImage &image, QIODevice *device, int level)
+{
+    StreamWriter writer(device, level);
+    return writer.begin(image.width(), image.height(), image.hasAlphaChannel(),
+                        image.dotsPerMeterX(), image.dotsPerMeterY())
+           && writer.addRows(image) && writer.finish();
+}
+
+/**
+ * @brief 分段读取分块图像并编码
+ */
+bool writeTiled(const TiledImage &image, QIODevice *device, int level)
+{
+    const bool alpha = QImage::toPixelFormat(image.format()).alphaUsage() == QPixelFormat::UsesAlpha;
+    StreamWriter writer(device, level);
+    if (!writer.begin(image.width(), image.height(), alpha, 0, 0)) {
+        return false;
+    }
+    const int bandRows = int(qMax<qint64>(1, kBandBytes / (qint64(image.width()) * 4)));
+    for (int y = 0; y < image.height(); y += bandRows) {
+        const QImage band = image.copy(y, qMin(bandRows, image.height() - y));
+        if (band.isNull() || !writer.addRows(band)) {
+            return false;
+        }
+    }
+    return writer.finish();
+}
+
+#endif // CAPSTEP_HAVE_ZLIB
+
+} // namespace
+
+bool PngEncoder::isParallel(const QImage &image) {
+#ifdef CAPSTEP_HAVE_ZLIB
+    // 单核时逐行试探滤波器反而比Qt慢
+    if (qint64(image.width()) * image.height() < ParallelMinPixels || QThread::idealThreadCount() < 2) {
+        return false;
+    }
+    // 调色板、灰度和16位图像交给Qt，保持原有的位深度和颜色类型
+    switch (image.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGB888:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        return true;
+    default:
+        return false;
+    }
+#else
+    Q_UNUSED(image);
+    return false;
+#endif
+}
+
+bool PngEncoder::write(const QImage &image, QIODevice *device, int level) {
+    if (image.isNull()) {
+        return false;
+    }
+#ifdef CAPSTEP_HAVE_ZLIB
+    if (isParallel(image)) {
+        QElapsedTimer timer;
+        timer.start();
+        const bool ok = writeParallel(image, device, qBound(-1, level, 9));
+        qDebug() << "[PNG] Parallel encode" << image.size() << "in" << timer.elapsed() << "ms";
+        return ok;
+    }
+#endif
+    return writeWithQt(image, device, level);
+}
+
+bool PngEncoder::write(const TiledImage &image, QIODevice *device, int level) {
+    if (image.height() == 0 || image.width() == 0) {
+        return false;
+    }
+#ifdef CAPSTEP_HAVE_ZLIB
+    QElapsedTimer timer;
+    timer.start();
+    const bool ok = writeTiled(image, device, qBound(-1, level, 9));
+    qDebug() << "[PNG] Banded encode" << image.width() << "x" << image.height() << "in" << timer.elapsed() << "ms";
+    return ok;
+#else
+    // 没有zlib时只能交给Qt整幅编码
+    return writeWithQt(image.toImage(), device, level);
+#endif
+}
+
+bool PngEncoder::save(const QImage &image, const QString &path, int level) {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    if (!write(image, &file, level)) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
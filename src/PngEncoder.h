@@ -0,0 +1,90 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file PngEncoder.h
+ * @brief 多线程分块PNG编码
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef PNGENCODER_H
+#define PNGENCODER_H
+
+#include <QImage>
+#include <QString>
+
+class QIODevice;
+class TiledImage;
+
+/**
+ * @class PngEncoder
+ * @brief 多线程分块PNG编码（pigz方式）
+ *
+ * 大图（多屏合并截图可达数千万像素）按行切成约256KB的块：
+ * 1. 并行对每一行选择PNG滤波器（None/Sub/Up/Average/Paeth中绝对值和最小的）
+ * 2. 并行独立deflate每一块，以前一块末尾32KB作为预设字典保持压缩率；
+ *    中间块以 Z_SYNC_FLUSH 结束（字节对齐、不带结束标志），最后一块以 Z_FINISH 结束
+ * 3. 依次拼接为一个zlib流，Adler-32由各块的校验值合并
+ *
+ * 输出是标准的8位RGB/RGBA PNG。需要编译时找到zlib（CAPSTEP_HAVE_ZLIB）；
+ * 没有zlib、单核、图像较小或格式不适合（调色板、16位）时交给Qt的单线程编码器
+ */
+class PngEncoder
+{
+public:
+    /// 低于该像素数时直接用Qt编码（分块和线程调度不划算）
+    static constexpr qint64 ParallelMinPixels = 2 * 1024 * 1024;
+
+    /**
+     * @brief 编码并写入设备
+     * @param image 图像
+     * @param device 已打开的设备
+     * @param level zlib压缩级别（0-9，-1为默认）
+     * @return 是否成功
+     */
+    static bool write(const QImage &image, QIODevice *device, int level = -1);
+
+    /**
+     * @brief 分段编码分块图像并写入设备（长截图）
+     *
+     * 每次用 TiledImage::copy() 读回约16MB像素编码后立即写出，不合成整幅图像；
+     * 没有zlib时退回Qt整幅编码
+     *
+     * @param image 分块图像（编码期间不能再追加行）
+     * @param device 已打开的设备
+     * @param level zlib压缩级别（0-9，-1为默认）
+     * @return 是否成功
+     */
+    static bool write(const TiledImage &image, QIODevice *device, int level = -1);
+
+    /**
+     * @brief 编码并保存到文件（先写临时文件再重命名）
+     * @return 是否成功
+     */
+    static bool save(const QImage &image, const QString &path, int level = -1);
+
+    /**
+     * @brief 是否会使用多线程编码
+     */
+    static bool isParallel(const QImage &image);
+};
+
+#endif // PNGENCODER_H
@@ -0,0 +1,283 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file QoiCodec.cpp
+ * @brief QOI无损图像编解码实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "QoiCodec.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QImageReader>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+constexpr uchar kOpIndex = 0x00;        ///< 00xxxxxx 颜色表索引
+constexpr uchar kOpDiff = 0x40;         ///< 01xxxxxx 与前一像素的小差值
+constexpr uchar kOpLuma = 0x80;         ///< 10xxxxxx 以绿色为基准的差值
+constexpr uchar kOpRun = 0xc0;          ///< 11xxxxxx 重复前一像素
+constexpr uchar kOpRgb = 0xfe;          ///< 完整RGB
+constexpr uchar kOpRgba = 0xff;         ///< 完整RGBA
+constexpr uchar kMask2 = 0xc0;
+
+constexpr int kHeaderSize = 14;
+constexpr int kMaxRun = 62;
+constexpr qint64 kMaxPixels = 400000000;    ///< 与参考实现一致的像素数上限
+constexpr uchar kPadding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+inline int colorHash(QRgb px)
+{
+    return (qRed(px) * 3 + qGreen(px) * 5 + qBlue(px) * 7 + qAlpha(px) * 11) & 63;
+}
+
+inline void writeBigEndian32(uchar *dst, quint32 value)
+{
+    dst[0] = uchar(value >> 24);
+    dst[1] = uchar(value >> 16);
+    dst[2] = uchar(value >> 8);
+    dst[3] = uchar(value);
+}
+
+inline quint32 readBigEndian32(const uchar *src)
+{
+    return (quint32(src[0]) << 24) | (quint32(src[1]) << 16) | (quint32(src[2]) << 8) | quint32(src[3]);
+}
+
+/**
+ * @brief 编码像素（非预乘ARGB32，逐行可带步长）
+ * @return 写入的字节数
+ */
+qint64 encodePixels(const uchar *bits, int width, int height, qsizetype stride, int channels, uchar *out)
+{
+    uchar *p = out;
+    std::memcpy(p, "qoif", 4);
+    writeBigEndian32(p + 4, quint32(width));
+    writeBigEndian32(p + 8, quint32(height));
+    p[12] = uchar(channels);
+    p[13] = 0;  // sRGB，线性alpha
+    p += kHeaderSize;
+
+    QRgb index[64] = {};
+    QRgb prev = qRgba(0, 0, 0, 255);
+    int run = 0;
+
+    for (int y = 0; y < height; ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(bits + y * stride);
+        for (int x = 0; x < width; ++x) {
+            const QRgb px = line[x];
+            if (px == prev) {
+                if (++run == kMaxRun) {
+                    *p++ = uchar(kOpRun | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *p++ = uchar(kOpRun | (run - 1));
+                run = 0;
+            }
+
+            const int hash = colorHash(px);
+            if (index[hash] == px) {
+                *p++ = uchar(kOpIndex | hash);
+            } else {
+                index[hash] = px;
+                if (qAlpha(px) == qAlpha(prev)) {
+                    const signed char vr = static_cast<signed char>(qRed(px) - qRed(prev));
+                    const signed char vg = static_cast<signed char>(qGreen(px) - qGreen(prev));
+                    const signed char vb = static_cast<signed char>(qBlue(px) - qBlue(prev));
+                    const signed char vgr = static_cast<signed char>(vr - vg);
+                    const signed char vgb = static_cast<signed char>(vb - vg);
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                        *p++ = uchar(kOpDiff | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));
+                    } else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8) {
+                        *p++ = uchar(kOpLuma | (vg + 32));
+                        *p++ = uchar(((vgr + 8) << 4) | (vgb + 8));
+                    } else {
+                        *p++ = kOpRgb;
+                        *p++ = uchar(qRed(px));
+                        *p++ = uchar(qGreen(px));
+                        *p++ = uchar(qBlue(px));
+                    }
+                } else {
+                    *p++ = kOpRgba;
+                    *p++ = uchar(qRed(px));
+                    *p++ = uchar(qGreen(px));
+                    *p++ = uchar(qBlue(px));
+                    *p++ = uchar(qAlpha(px));
+                }
+            }
+            prev = px;
+        }
+    }
+    // 行尾不打断游程，最后一个游程在全部像素之后写出
+    if (run > 0) {
+        *p++ = uchar(kOpRun | (run - 1));
+    }
+    std::memcpy(p, kPadding, sizeof(kPadding));
+    p += sizeof(kPadding);
+    return p - out;
+}
+
+/**
+ * @brief 解码像素到预先分配的ARGB32缓冲区
+ * @return 数据是否完整
+ */
+bool decodePixels(const uchar *data, qint64 size, uchar *bits, int width, int height, qsizetype stride)
+{
+    const uchar *p = data + kHeaderSize;
+    const uchar *end = data + size - sizeof(kPadding);
+
+    QRgb index[64] = {};
+    QRgb px = qRgba(0, 0, 0, 255);
+    int run = 0;
+
+    for (int y = 0; y < height; ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(bits + y * stride);
+        for (int x = 0; x < width; ++x) {
+            if (run > 0) {
+                --run;
+                line[x] = px;
+                continue;
+            }
+            if (p >= end) {
+                return false;
+            }
+            const uchar b1 = *p++;
+            if (b1 == kOpRgb) {
+                if (end - p < 3) {
+                    return false;
+                }
+                px = qRgba(p[0], p[1], p[2], qAlpha(px));
+                p += 3;
+            } else if (b1 == kOpRgba) {
+                if (end - p < 4) {
+                    return false;
+                }
+                px = qRgba(p[0], p[1], p[2], p[3]);
+                p += 4;
+            } else if ((b1 & kMask2) == kOpIndex) {
+                px = index[b1];
+            } else if ((b1 & kMask2) == kOpDiff) {
+                px = qRgba((qRed(px) + ((b1 >> 4) & 3) - 2) & 0xff,
+                           (qGreen(px) + ((b1 >> 2) & 3) - 2) & 0xff,
+                           (qBlue(px) + (b1 & 3) - 2) & 0xff,
+                           qAlpha(px));
+            } else if ((b1 & kMask2) == kOpLuma) {
+                if (p >= end) {
+                    return false;
+                }
+                const uchar b2 = *p++;
+                const int vg = (b1 & 0x3f) - 32;
+                px = qRgba((qRed(px) + vg - 8 + ((b2 >> 4) & 0x0f)) & 0xff,
+                           (qGreen(px) + vg) & 0xff,
+                           (qBlue(px) + vg - 8 + (b2 & 0x0f)) & 0xff,
+                           qAlpha(px));
+            } else {
+                run = b1 & 0x3f;
+            }
+            index[colorHash(px)] = px;
+            line[x] = px;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+QByteArray QoiCodec::encode(const QImage &image) {
+    if (image.isNull() || qint64(image.width()) * image.height() > kMaxPixels) {
+        return QByteArray();
+    }
+    const bool alpha = image.hasAlphaChannel();
+    const QImage source = image.convertToFormat(alpha ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    const int channels = alpha ? 4 : 3;
+
+    // 最坏情况每像素 channels+1 字节
+    const qint64 capacity = kHeaderSize + qint64(source.width()) * source.height() * (channels + 1) + sizeof(kPadding);
+    QByteArray data(capacity, Qt::Uninitialized);
+    const qint64 written = encodePixels(source.constBits(), source.width(), source.height(), source.bytesPerLine(),
+                                        channels, reinterpret_cast<uchar *>(data.data()));
+    data.truncate(written);
+    return data;
+}
+
+QImage QoiCodec::decode(const QByteArray &data) {
+    if (!isQoi(data) || data.size() < kHeaderSize + qsizetype(sizeof(kPadding))) {
+        return QImage();
+    }
+    const uchar *bytes = reinterpret_cast<const uchar *>(data.constData());
+    const quint32 width = readBigEndian32(bytes + 4);
+    const quint32 height = readBigEndian32(bytes + 8);
+    const int channels = bytes[12];
+    if (width == 0 || height == 0 || (channels != 3 && channels != 4)
+        || quint64(width) * height > quint64(kMaxPixels)) {
+        qWarning() << "[QOI] Invalid header" << width << height << channels;
+        return QImage();
+    }
+
+    QImage image(int(width), int(height), channels == 4 ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    if (image.isNull()) {
+        return QImage();
+    }
+    if (!decodePixels(bytes, data.size(), image.bits(), image.width(), image.height(), image.bytesPerLine())) {
+        qWarning() << "[QOI] Truncated data";
+        return QImage();
+    }
+    return image;
+}
+
+bool QoiCodec::isQoi(const QByteArray &data) {
+    return data.startsWith("qoif");
+}
+
+bool QoiCodec::write(const QImage &image, QIODevice *device) {
+    const QByteArray data = encode(image);
+    return !data.isEmpty() && device->write(data) == data.size();
+}
+
+QImage QoiCodec::load(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QImage();
+    }
+    if (isQoi(file.peek(4))) {
+        return decode(file.readAll());
+    }
+    QImageReader reader(&file);
+    return reader.read();
+}
+
+bool QoiCodec::save(const QImage &image, const QString &path) {
+    if (QFileInfo(path).suffix().compare(Suffix, Qt::CaseInsensitive) != 0) {
+        return image.save(path);
+    }
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || !write(image, &file)) {
+        return false;
+    }
+    return file.commit();
+}
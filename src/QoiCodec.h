@@ -0,0 +1,90 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file QoiCodec.h
+ * @brief QOI无损图像编解码
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef QOICODEC_H
+#define QOICODEC_H
+
+#include <QImage>
+#include <QByteArray>
+#include <QString>
+
+class QIODevice;
+
+/**
+ * @class QoiCodec
+ * @brief QOI（Quite OK Image）格式编解码
+ *
+ * QOI单遍扫描、无熵编码，编码速度约为PNG的十倍以上，界面截图的压缩率与PNG接近，
+ * 用作历史截图的快速写入格式。系统和其他程序普遍不认识QOI，
+ * 对外提供文件（打开、导出）时应先转为PNG
+ */
+class QoiCodec
+{
+public:
+    /// 文件扩展名（不含点）
+    static constexpr const char *Suffix = "qoi";
+
+    /**
+     * @brief 编码
+     * @param image 图像（任意格式，无透明通道时写为3通道）
+     * @return QOI数据（图像无效时为空）
+     */
+    static QByteArray encode(const QImage &image);
+
+    /**
+     * @brief 解码
+     * @param data QOI数据
+     * @return 图像（3通道为 Format_RGB32，4通道为 Format_ARGB32；数据无效时为空）
+     */
+    static QImage decode(const QByteArray &data);
+
+    /**
+     * @brief 判断数据是否以QOI文件头开始
+     */
+    static bool isQoi(const QByteArray &data);
+
+    /**
+     * @brief 编码并写入设备
+     * @return 是否成功
+     */
+    static bool write(const QImage &image, QIODevice *device);
+
+    /**
+     * @brief 读取图像文件（QOI或Qt支持的任意格式）
+     * @param path 文件路径
+     * @return 图像（失败时为空）
+     */
+    static QImage load(const QString &path);
+
+    /**
+     * @brief 按扩展名保存图像（.qoi 用本编码器，其他交给Qt）
+     * @return 是否成功
+     */
+    static bool save(const QImage &image, const QString &path);
+};
+
+#endif // QOICODEC_H
@@ -38,6 +38,13 @@
 #include <QDebug>
 #include <QTimer>
 #include <QCursor>
+#include <QtConcurrent>
+
+namespace {
+
+constexpr qint64 kWarmAgeSlackMs = 50;  ///< 快照允许超出刷新间隔的时间（覆盖一次抓取的耗时）
+
+} // namespace
 
 RegionSelector::RegionSelector(QWidget *parent)
     : QWidget(parent)
@@ -53,6 +60,13 @@ RegionSelector::RegionSelector(QWidget *parent)
     , m_resizeStartPos()
     , m_resizeStartRect()
     , m_currentScreen(nullptr)
+    , m_warmMode(false)
+    , m_warmRefreshTimer(nullptr)
+    , m_warmFront(0)
+    , m_warmWatcher(nullptr)
+    , m_awaitingFirstPaint(false)
+    , m_usedWarmSnapshot(false)
+    , m_lastOverlayLatencyNs(-1)
 {
     // 设置窗口属性：无边框、工具窗口（移除置顶，避免覆盖弹窗）
     setWindowFlags(Qt::FramelessWindowHint | Qt::Tool | Qt::BypassWindowManagerHint);
@@ -62,14 +76,33 @@ RegionSelector::RegionSelector(QWidget *parent)
     setAttribute(Qt::WA_TransparentForMouseEvents, false);  // 确保接收鼠标事件
     setMouseTracking(true);                      // 启用鼠标跟踪
     setFocusPolicy(Qt::StrongFocus);             // 强焦点策略，支持键盘事件
+    
+    // 预热快照刷新定时器（仅在预热模式下启动）
+    m_warmRefreshTimer = new QTimer(this);
+    connect(m_warmRefreshTimer, &QTimer::timeout, this, &RegionSelector::refreshWarmSnapshot);
+    m_warmWatcher = new QFutureWatcher<FrozenAtlas>(this);
+    connect(m_warmWatcher, &QFutureWatcher<FrozenAtlas>::finished, this, &RegionSelector::onWarmSnapshotReady);
+    
+    // 屏幕增减时立即刷新快照，避免交换到布局已经过时的缓冲
+    connect(qApp, &QGuiApplication::screenAdded, this, [this]() {
+        if (m_warmMode) refreshWarmSnapshot();
+    });
+    connect(qApp, &QGuiApplication::screenRemoved, this, [this]() {
+        if (m_warmMode) refreshWarmSnapshot();
+    });
 }
 
 void RegionSelector::startSelection() {
+    // 延迟测量从这里开始，到首帧绘制结束
+    m_latencyTimer.start();
+    m_awaitingFirstPaint = true;
+    
     m_isSelecting = false;
     m_selectionRect = QRect();
     m_startPoint = QPoint();
     m_endPoint = QPoint();
     m_globalSelection = QRect();
+    m_state = StateIdle;
 
     // 获取当前鼠标所在的屏幕
     QPoint cursorPos = QCursor::pos();
@@ -78,34 +111,147 @@ void RegionSelector::startSelection() {
         m_currentScreen = QGuiApplication::primaryScreen();
     }
     
-    QRect screenRect = getCurrentScreenRect();
-    if (!screenRect.isNull()) {
-        // 先截取当前屏幕画面（冻结画面）
-        qDebug() << "[SelectorStart] Freezing screen:" << m_currentScreen->name() 
-                 << "at cursor pos:" << cursorPos
-                 << "screen geometry:" << screenRect;
-        captureScreenBackground();
-        
-        // 设置窗口几何，覆盖当前屏幕
-        setGeometry(screenRect);
-        qDebug() << "[SelectorStart] Screen rect=" << screenRect << " setGeometry to:" << screenRect;
+    // 预热模式：快照足够新时直接交换缓冲（共享像素，不复制），跳过同步截屏。
+    // 超过约一个刷新间隔的快照可能已漏掉刚打开的菜单或提示，改为同步截屏
+    const int front = m_warmFront;
+    const qint64 maxAgeMs = m_warmRefreshTimer->interval() + kWarmAgeSlackMs;
+    m_usedWarmSnapshot = m_warmMode && !m_warmBuffers[front].isEmpty()
+                         && m_warmAge[front].isValid() && m_warmAge[front].elapsed() <= maxAgeMs;
+    if (m_usedWarmSnapshot) {
+        m_warmRefreshTimer->stop();
+        m_atlas = m_warmBuffers[front];
+        qDebug() << "[SelectorStart] Using warm snapshot, age:" << m_warmAge[front].elapsed() << "ms";
+        showOverlay(getVirtualDesktopRect(), true);
+        return;
+    }
+    
+    // 先冻结所有屏幕（冻结画面），选择器覆盖整个虚拟桌面
+    qDebug() << "[SelectorStart] Freezing all screens, cursor on:"
+             << (m_currentScreen ? m_currentScreen->name() : QString("null"))
+             << "at cursor pos:" << cursorPos;
+    m_warmRefreshTimer->stop();
+    captureScreenBackground();
 
-        show();
-        raise();
-        activateWindow();
-        
-        // 再次确保窗口几何正确
-        QTimer::singleShot(50, [this, screenRect]() {
-            if (isVisible()) {
-                // 强制重新设置几何，防止系统调整
-                setGeometry(screenRect);
-                qDebug() << "[SelectorStart] After show, window geometry:" << geometry();
-                setFocus();
-                setCursor(Qt::CrossCursor);
-                grabKeyboard();
-                update();
-            }
-        });
+    QRect desktopRect = getVirtualDesktopRect();
+    if (!desktopRect.isNull()) {
+        showOverlay(desktopRect, false);
+    }
+}
+
+void RegionSelector::showOverlay(const QRect &desktopRect, bool immediate) {
+    // 设置窗口几何，覆盖整个虚拟桌面（预热窗口已预先设置好，通常无需调整）
+    if (geometry() != desktopRect) {
+        setGeometry(desktopRect);
+        qDebug() << "[SelectorStart] Virtual desktop rect=" << desktopRect << " setGeometry to:" << desktopRect;
+    }
+
+    show();
+    raise();
+    activateWindow();
+    
+    if (immediate) {
+        // 预热窗口的原生句柄与几何早已就绪，直接获取键盘
+        setFocus();
+        setCursor(Qt::CrossCursor);
+        grabKeyboard();
+        update();
+        return;
+    }
+    
+    // 再次确保窗口几何正确
+    QTimer::singleShot(50, this, [this, desktopRect]() {
+        if (isVisible()) {
+            // 强制重新设置几何，防止系统调整
+            setGeometry(desktopRect);
+            qDebug() << "[SelectorStart] After show, window geometry:" << geometry();
+            setFocus();
+            setCursor(Qt::CrossCursor);
+            grabKeyboard();
+            update();
+        }
+    });
+}
+
+void RegionSelector::setWarmMode(bool enabled, int refreshIntervalMs) {
+    m_warmMode = enabled;
+    qDebug() << "[WarmMode]" << (enabled ? "enabled" : "disabled") << "refresh interval:" << refreshIntervalMs << "ms";
+    
+    if (!enabled) {
+        m_warmRefreshTimer->stop();
+        m_warmBuffers[0].clear();
+        m_warmBuffers[1].clear();
+        m_warmAge[0].invalidate();
+        m_warmAge[1].invalidate();
+        return;
+    }
+    
+    m_warmRefreshTimer->setInterval(qMax(refreshIntervalMs, 50));
+    // 快照只在工作线程刷新：帧来源（如默认的Qt来源）只能在GUI线程抓取时不做定时抓屏，
+    // 只保留预创建的窗口，热键触发时同步截屏
+    if (warmSnapshotsSupported()) {
+        refreshWarmSnapshot();
+    } else {
+        qDebug() << "[WarmMode] Frame source" << FrameSource::kindName(FrameSource::current()->kind())
+                 << "cannot grab off the GUI thread, warm snapshots disabled (overlay window still pre-created)";
+    }
+    
+    // 预先创建原生窗口并设置好几何，热键触发时无需再创建/调整窗口
+    const QRect desktopRect = getVirtualDesktopRect();
+    if (!isVisible() && !desktopRect.isNull()) {
+        setGeometry(desktopRect);
+    }
+    winId();
+    
+    if (!isVisible() && warmSnapshotsSupported()) {
+        m_warmRefreshTimer->start();
+    }
+}
+
+bool RegionSelector::warmSnapshotsSupported() const {
+    return FrameSource::current()->isThreadSafe();
+}
+
+void RegionSelector::refreshWarmSnapshot() {
+    // 覆盖层可见时截屏会截到自己，跳过；不能在工作线程抓取时不刷新（不在GUI线程定时抓屏）
+    if (!m_warmMode || isVisible() || !warmSnapshotsSupported()) {
+        return;
+    }
+    
+    // 在工作线程抓取（屏幕布局仍在GUI线程读取），上一次抓取尚未完成时跳过本次
+    if (m_warmWatcher->isRunning()) {
+        return;
+    }
+    FrameSource *source = FrameSource::current();
+    const QList<FrameSource::Screen> screens = source->screens();
+    m_warmPendingAge.start();
+    m_warmWatcher->setFuture(QtConcurrent::run([source, screens]() {
+        FrozenAtlas atlas;
+        atlas.freeze(source, screens);
+        return atlas;
+    }));
+}
+
+void RegionSelector::onWarmSnapshotReady() {
+    // 抓取期间关闭了预热模式，结果作废
+    if (!m_warmMode) {
+        return;
+    }
+    const FrozenAtlas atlas = m_warmWatcher->result();
+    if (!atlas.isEmpty()) {
+        installWarmSnapshot(atlas, m_warmPendingAge);
+    }
+}
+
+void RegionSelector::installWarmSnapshot(const FrozenAtlas &atlas, const QElapsedTimer &age) {
+    // 写入后台缓冲，只有完整成功后才与前台交换，前台快照始终可用
+    const int back = 1 - m_warmFront;
+    m_warmBuffers[back] = atlas;
+    m_warmAge[back] = age;
+    m_warmFront = back;
+    // 屏幕布局变化时同步调整预创建窗口的尺寸（覆盖层可见时不动窗口）
+    const QRect desktopRect = atlas.virtualGeometry();
+    if (!isVisible() && geometry() != desktopRect) {
+        setGeometry(desktopRect);
     }
 }
 
@@ -131,6 +277,18 @@ QRect RegionSelector::getCurrentScreenRect() const {
     return screenRect;
 }
 
+QRect RegionSelector::getVirtualDesktopRect() const {
+    // 优先使用图集记录的几何，保证窗口与冻结画面完全对齐
+    if (!m_atlas.isEmpty()) {
+        return m_atlas.virtualGeometry();
+    }
+    if (!m_warmBuffers[m_warmFront].isEmpty()) {
+        return m_warmBuffers[m_warmFront].virtualGeometry();
+    }
+    QScreen *screen = QGuiApplication::primaryScreen();
+    return screen ? screen->virtualGeometry() : QRect();
+}
+
 QRect RegionSelector::globalToLocalRect(const QRect &globalRect) const {
     // 获取窗口在全局坐标系中的位置
     QRect windowGeometry = this->geometry();
@@ -265,8 +423,15 @@ void RegionSelector::drawTipInfo(QPainter &painter) {
     font.setBold(true);
     painter.setFont(font);
     
-    // 绘制提示背景
-    QRect tipRect(10, 10, 380, 35);
+    // 绘制提示背景（放在鼠标所在屏幕的左上角）
+    QPoint screenOrigin;
+    const FrozenAtlas::Entry *entry = m_atlas.entryAt(QCursor::pos());
+    if (entry) {
+        screenOrigin = entry->geometry.topLeft() - geometry().topLeft();
+    } else if (m_currentScreen) {
+        screenOrigin = m_currentScreen->geometry().topLeft() - geometry().topLeft();
+    }
+    QRect tipRect(screenOrigin + QPoint(10, 10), QSize(380, 35));
     painter.fillRect(tipRect, QColor(0, 0, 0, 200));
     
     // 绘制边框
@@ -287,29 +452,18 @@ void RegionSelector::drawTipInfo(QPainter &painter) {
 }
 
 void RegionSelector::paintEvent(QPaintEvent *event) {
-    Q_UNUSED(event)
-    
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
     painter.setRenderHint(QPainter::SmoothPixmapTransform, true); // 启用平滑变换以获得更好的显示效果
     
-    // 绘制冻结的背景画面
-    if (!m_frozenBackground.isNull()) {
-        // 如果冻结图像的devicePixelRatio不为1，需要调整绘制区域
-        qreal dpr = m_frozenBackground.devicePixelRatio();
-        
-        qDebug() << "[Paint] Frozen background DPR:" << dpr 
-                 << "size:" << m_frozenBackground.size()
-                 << "window rect:" << rect();
-        
-        // 根据DPR调整绘制（从窗口本地坐标0,0开始绘制）
-        if (dpr > 1.0) {
-            // 高DPI图像，需要缩放显示
-            QSize logicalSize = m_frozenBackground.size() / dpr;
-            painter.drawPixmap(0, 0, logicalSize.width(), logicalSize.height(), m_frozenBackground);
-        } else {
-            // 普通DPI，直接绘制
-            painter.drawPixmap(0, 0, m_frozenBackground);
+    // 绘制冻结的背景画面：每个屏幕按自己的逻辑几何绘制，设备像素由绘制器按DPR缩放
+    if (!m_atlas.isEmpty()) {
+        const QPoint windowOrigin = geometry().topLeft();
+        for (const FrozenAtlas::Entry &entry : m_atlas.entries()) {
+            const QRect target = entry.geometry.translated(-windowOrigin);
+            if (target.intersects(event->rect())) {
+                painter.drawImage(target, entry.image);
+            }
         }
     } else {
         // 如果没有冻结画面，绘制半透明背景
@@ -360,6 +514,20 @@ void RegionSelector::paintEvent(QPaintEvent *event) {
     
     // 始终在左上角显示提示信息
     drawTipInfo(painter);
+    
+    // 首帧绘制完成：记录从开始选择到覆盖层可见的延迟，并与一帧时长比较
+    if (m_awaitingFirstPaint) {
+        m_awaitingFirstPaint = false;
+        m_lastOverlayLatencyNs = m_latencyTimer.nsecsElapsed();
+        const qreal refreshRate = (m_currentScreen && m_currentScreen->refreshRate() > 0)
+            ? m_currentScreen->refreshRate() : 60.0;
+        const qint64 frameNs = qint64(1e9 / refreshRate);
+        qDebug() << "[Latency] Overlay first paint:" << m_lastOverlayLatencyNs / 1000 << "us"
+                 << "frame budget:" << frameNs / 1000 << "us"
+                 << (m_usedWarmSnapshot ? "(warm)" : "(cold)")
+                 << (m_lastOverlayLatencyNs <= frameNs ? "within one frame" : "exceeds one frame");
+        emit overlayLatencyMeasured(m_lastOverlayLatencyNs, frameNs, m_usedWarmSnapshot);
+    }
 }
 
 void RegionSelector::mousePressEvent(QMouseEvent *event) {
@@ -533,6 +701,13 @@ void RegionSelector::cleanupAndClose() {
     releaseMouse();
     hide();
     close();
+    // 截图结果只引用所在屏幕的缓冲区，其余屏幕的冻结画面在这里释放
+    m_atlas.clear();
+    
+    // 预热模式：恢复定时刷新（等一个刷新间隔，确保覆盖层已从屏幕上消失再截屏）
+    if (m_warmMode && warmSnapshotsSupported()) {
+        m_warmRefreshTimer->start();
+    }
 }
 
 int RegionSelector::hitTest(const QPoint &pos) const {
@@ -599,23 +774,15 @@ void RegionSelector::updateCursor(int hit) {
 }
 
 void RegionSelector::captureScreenBackground() {
-    qDebug() << "[ScreenFreeze] Capturing current screen background";
+    qDebug() << "[ScreenFreeze] Capturing all screen backgrounds";
     
-    if (!m_currentScreen) {
-        qWarning() << "[ScreenFreeze] No current screen set";
+    // 冻结所有屏幕，每个屏幕保留自己的DPR
+    // 光栅后端下toImage()为浅拷贝，之后的裁剪都在图集上建立视图
+    const int frozen = m_atlas.freeze();
+    if (frozen == 0) {
+        qWarning() << "[ScreenFreeze] No screen could be frozen";
         return;
     }
     
-    // 获取当前屏幕的几何信息
-    QRect screenGeometry = m_currentScreen->geometry();
-    qDebug() << "[ScreenFreeze] Screen:" << m_currentScreen->name() 
-             << "geometry:" << screenGeometry
-             << "DPI:" << m_currentScreen->devicePixelRatio();
-    
-    // 截取当前屏幕（使用屏幕本地坐标，从(0,0)开始）
-    m_frozenBackground = m_currentScreen->grabWindow(0);
-    
-    qDebug() << "[ScreenFreeze] Screen frozen, size:" << m_frozenBackground.size()
-             << "devicePixelRatio:" << m_frozenBackground.devicePixelRatio()
-             << "logical size:" << (m_frozenBackground.size() / m_frozenBackground.devicePixelRatio());
+    qDebug() << "[ScreenFreeze] Frozen" << frozen << "screens, virtual geometry:" << m_atlas.virtualGeometry();
 }
@@ -41,6 +41,11 @@
 #include <QFont>
 #include <QScreen>
 #include <QGuiApplication>
+#include <QImage>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include "FrozenAtlas.h"
 
 /**
  * @class RegionSelector
@@ -68,16 +73,42 @@ public:
     QRect getSelectionRect() const;
     
     /**
-     * @brief 获取冻结的背景画面
-     * @return 冻结的背景图像
+     * @brief 获取冻结的虚拟桌面图集
+     *
+     * 每个屏幕一张冻结画面，截图流程直接在其上建立零拷贝视图
+     *
+     * @return 冻结画面图集
      */
-    QPixmap getFrozenBackground() const { return m_frozenBackground; }
+    const FrozenAtlas &frozenAtlas() const { return m_atlas; }
     
     /**
      * @brief 开始区域选择
      */
     void startSelection();
 
+    /**
+     * @brief 启用/关闭预热模式
+     *
+     * 预热模式下后台定时刷新双缓冲的屏幕快照，并提前创建好覆盖整个虚拟桌面的原生窗口，
+     * 热键触发时只需交换缓冲并显示窗口。快照只在工作线程抓取；帧来源不支持时
+     * （如默认的Qt来源）不做定时抓屏，只预创建窗口。快照超过约一个刷新间隔时放弃使用，改为同步截屏
+     *
+     * @param enabled 是否启用
+     * @param refreshIntervalMs 快照刷新间隔（毫秒）
+     */
+    void setWarmMode(bool enabled, int refreshIntervalMs = 500);
+
+    /**
+     * @brief 是否处于预热模式
+     */
+    bool isWarmMode() const { return m_warmMode; }
+
+    /**
+     * @brief 获取最近一次从触发到首帧绘制的延迟
+     * @return 延迟（纳秒），尚未测量时返回-1
+     */
+    qint64 lastOverlayLatencyNs() const { return m_lastOverlayLatencyNs; }
+
 signals:
     /**
      * @brief 区域选择完成信号
@@ -90,6 +121,14 @@ signals:
      */
     void selectionCancelled();
 
+    /**
+     * @brief 覆盖层首帧绘制完成信号
+     * @param latencyNs 从开始选择到首帧绘制的延迟（纳秒）
+     * @param frameNs 当前屏幕一帧的时长（纳秒）
+     * @param warm 是否使用了预热快照
+     */
+    void overlayLatencyMeasured(qint64 latencyNs, qint64 frameNs, bool warm);
+
 protected:
     /**
      * @brief 绘制事件处理
@@ -128,6 +167,12 @@ private:
      */
     QRect getCurrentScreenRect() const;
 
+    /**
+     * @brief 获取选择器覆盖的矩形（整个虚拟桌面）
+     * @return 虚拟桌面矩形（全局逻辑坐标）
+     */
+    QRect getVirtualDesktopRect() const;
+
     /**
      * @brief 将全局坐标矩形转换为本地坐标矩形
      * @param globalRect 全局坐标矩形
@@ -217,13 +262,57 @@ private:
     QRect m_resizeStartRect;        ///< 调整开始时的矩形
     
     // 画面冻结相关
-    QPixmap m_frozenBackground;     ///< 冻结的背景画面
-    QScreen *m_currentScreen;       ///< 当前操作的屏幕
+    FrozenAtlas m_atlas;            ///< 冻结的虚拟桌面图集（每屏一张）
+    QScreen *m_currentScreen;       ///< 当前操作的屏幕（鼠标所在屏幕，用于放置提示）
     
     /**
-     * @brief 捕获当前屏幕背景（冻结画面）
+     * @brief 捕获所有屏幕背景（冻结画面）
      */
     void captureScreenBackground();
+
+    /**
+     * @brief 显示覆盖层并获取键盘焦点
+     * @param desktopRect 覆盖的虚拟桌面矩形
+     * @param immediate 是否立即获取键盘（预热窗口已就绪，无需等待）
+     */
+    void showOverlay(const QRect &desktopRect, bool immediate);
+
+    /**
+     * @brief 刷新预热快照（写入后台缓冲，成功后与前台交换）
+     */
+    void refreshWarmSnapshot();
+
+    /**
+     * @brief 当前帧来源能否在工作线程刷新快照
+     */
+    bool warmSnapshotsSupported() const;
+
+    /**
+     * @brief 工作线程抓取完成，安装新快照
+     */
+    void onWarmSnapshotReady();
+
+    /**
+     * @brief 把完整的快照写入后台缓冲并与前台交换
+     * @param atlas 快照
+     * @param age 快照的拍摄计时
+     */
+    void installWarmSnapshot(const FrozenAtlas &atlas, const QElapsedTimer &age);
+
+    // 预热模式相关
+    bool m_warmMode;                    ///< 是否启用预热模式
+    QTimer *m_warmRefreshTimer;         ///< 快照刷新定时器
+    FrozenAtlas m_warmBuffers[2];       ///< 双缓冲快照
+    QElapsedTimer m_warmAge[2];         ///< 各缓冲快照的拍摄时间
+    int m_warmFront;                    ///< 最新完整快照所在的缓冲索引
+    QFutureWatcher<FrozenAtlas> *m_warmWatcher; ///< 工作线程抓取
+    QElapsedTimer m_warmPendingAge;     ///< 进行中的工作线程抓取的开始时间
+    
+    // 延迟测量
+    QElapsedTimer m_latencyTimer;       ///< 从开始选择起计时
+    bool m_awaitingFirstPaint;          ///< 是否等待首帧绘制
+    bool m_usedWarmSnapshot;            ///< 本次是否使用了预热快照
+    qint64 m_lastOverlayLatencyNs;      ///< 最近一次首帧延迟（纳秒）
 };
 
 #endif // REGIONSELECTOR_H
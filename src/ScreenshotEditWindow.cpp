@@ -27,6 +27,7 @@
 
 #include "ScreenshotEditWindow.h"
 #include "StylePopover.h"
+#include "ImageBuffer.h"
 #include <QApplication>
 #include <QPushButton>
 #include <QLabel>
@@ -40,18 +41,16 @@
 #include <QKeyEvent>
 #include <QPaintEvent>
 #include <QMoveEvent>
-#include <QFontMetrics>
 #include <QDebug>
 #include <QScreen>
 #include <QGuiApplication>
 #include <QTimer>
 #include <QMenu>
-#include <cmath>
+#include <QSettings>
 
-ScreenshotEditWindow::ScreenshotEditWindow(const QPixmap &screenshot, const QPoint &initialPos, QWidget *parent)
+ScreenshotEditWindow::ScreenshotEditWindow(const QImage &screenshot, const QPoint &initialPos, QWidget *parent)
     : QWidget(parent)
-    , m_screenshot(screenshot)
-    , m_originalScreenshot(screenshot)
+    , m_scene(screenshot)
     , m_imageLabel(nullptr)
     , m_undoBtn(nullptr)
     , m_saveBtn(nullptr)
@@ -64,6 +63,7 @@ ScreenshotEditWindow::ScreenshotEditWindow(const QPixmap &screenshot, const QPoi
     , m_circleToolBtn(nullptr)
     , m_rectToolBtn(nullptr)
     , m_mosaicToolBtn(nullptr)
+    , m_blurToolBtn(nullptr)
     , m_textToolBtn(nullptr)
     , m_toolGroup(nullptr)
     , m_stylePopover(nullptr)
@@ -73,7 +73,9 @@ ScreenshotEditWindow::ScreenshotEditWindow(const QPixmap &screenshot, const QPoi
     , m_currentTool(0)
     , m_drawStartPos()
     , m_drawEndPos()
-    , m_drawHistory()
+    , m_stroke()
+    , m_penSmoothing(true)
+    , m_previewRect()
     , m_textEdit(nullptr)
     , m_isTextEditing(false)
     , m_isDragging(false)
@@ -81,7 +83,6 @@ ScreenshotEditWindow::ScreenshotEditWindow(const QPixmap &screenshot, const QPoi
     , m_isUpdatingDPI(false)
     , m_lastScreen(nullptr)
     , m_dpiUpdateTimer(nullptr)
-    , m_undoStack()
     , m_isClosing(false)
 {
     // 设置窗口属性：无边框、置顶、工具窗口
@@ -90,10 +91,15 @@ ScreenshotEditWindow::ScreenshotEditWindow(const QPixmap &screenshot, const QPoi
     setFocusPolicy(Qt::StrongFocus);             // 强焦点策略，支持键盘事件
     
     // 先计算并存储原始截图尺寸，确保setupUI可以使用
-    QSize displaySize = m_screenshot.size() / m_screenshot.devicePixelRatio();
+    QSize displaySize = m_scene.displaySize();
     m_originalScreenshotSize = displaySize;
     qDebug() << "[ScreenshotEditWindow] Original screenshot size:" << m_originalScreenshotSize 
-             << "DPR:" << m_screenshot.devicePixelRatio();
+             << "DPR:" << screenshot.devicePixelRatio();
+    
+    // 撤销快照按字节预算保留（而不是固定步数），超出预算的更早步骤改为由原图重放
+    QSettings settings("CapStep", "Capture");
+    m_scene.setUndoBudget(qint64(qMax(0, settings.value("editorUndoMB", 64).toInt())) << 20);
+    m_penSmoothing = settings.value("penSmoothing", true).toBool();
     
     setupUI();          // 初始化用户界面
     setupConnections(); // 连接信号槽
@@ -117,9 +123,9 @@ ScreenshotEditWindow::ScreenshotEditWindow(const QPixmap &screenshot, const QPoi
     }
     
     // 计算合理的最小窗口尺寸：
-    // 使用图标按钮后尺寸大幅减小：12×28px + 11×4px(间距) + 20px(边距) ≈ 400px
-    // 设置420px确保有足够空间，图片居中显示
-    int minWindowWidth = qMax(420, displaySize.width());
+    // 使用图标按钮后尺寸大幅减小：13×28px + 12×4px(间距) + 20px(边距) ≈ 432px
+    // 设置440px确保有足够空间，图片居中显示
+    int minWindowWidth = qMax(440, displaySize.width());
     int minWindowHeight = displaySize.height() + 50;
     setMinimumSize(minWindowWidth, minWindowHeight);
     
@@ -162,13 +168,11 @@ ScreenshotEditWindow::~ScreenshotEditWindow() {
     qDebug() << "[ScreenshotEditWindow] Destructor called";
 }
 
-QPixmap ScreenshotEditWindow::getScreenshot() const {
-    return m_screenshot;
+QImage ScreenshotEditWindow::getScreenshot() const {
+    return m_scene.flatten();
 }
 
 void ScreenshotEditWindow::paintEvent(QPaintEvent *event) {
-    Q_UNUSED(event)
-    
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);  // 启用抗锯齿
     painter.setRenderHint(QPainter::SmoothPixmapTransform); // 高质量缩放
@@ -176,60 +180,37 @@ void ScreenshotEditWindow::paintEvent(QPaintEvent *event) {
     // 设置颜色管理，保持原始颜色不变
     painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
     
-    // 绘制截图内容，只在图片区域内绘制
-    if (!m_screenshot.isNull()) {
+    // 绘制截图内容，只绘制图片区域中需要重绘的部分（拖动绘制时只是新旧预览图形的外接矩形）
+    const QImage &composite = m_scene.composite();
+    if (!composite.isNull()) {
         // 计算实际显示尺寸（考虑设备像素比）
-        QSize displaySize = m_screenshot.size() / m_screenshot.devicePixelRatio();
+        QSize displaySize = m_scene.displaySize();
         QRect imageRect(0, 0, displaySize.width(), displaySize.height());
+        const QRect dirtyRect = event->rect().intersected(imageRect);
         
-        // 限制绘制区域为图片区域，不覆盖按钮区域
-        painter.setClipRect(imageRect);
-        painter.drawPixmap(imageRect, m_screenshot);
-        painter.setClipping(false); // 取消裁剪限制
-        
-        // 仅用于界面显示的虚线边框（不影响保存/复制/贴图的图片内容）
-        QPen dashPen(QColor(160, 160, 160, 220));
-        dashPen.setStyle(Qt::DashLine);
-        dashPen.setWidth(2);
-        painter.setPen(dashPen);
-        painter.setBrush(Qt::NoBrush);
-        painter.drawRect(imageRect.adjusted(1, 1, -1, -1));
-
-        // 绘制预览中的图形（仅显示不落盘）
-        if (m_isDrawing && m_currentTool != 0) {
-            QPen previewPen(m_currentColor);
-            previewPen.setWidth(m_currentThickness);
-            previewPen.setCapStyle(Qt::RoundCap);
-            previewPen.setJoinStyle(Qt::RoundJoin);
-            painter.setPen(previewPen);
+        if (!dirtyRect.isEmpty()) {
+            const qreal dpr = composite.devicePixelRatio();
+            painter.drawImage(QRectF(dirtyRect), composite,
+                              QRectF(QPointF(dirtyRect.topLeft()) * dpr, QSizeF(dirtyRect.size()) * dpr));
             
-            if (m_currentTool == 1 && m_drawHistory.size() > 1) { // 画笔工具
-                for (int i = 1; i < m_drawHistory.size(); ++i) {
-                    painter.drawLine(m_drawHistory[i-1].first, m_drawHistory[i].first);
-                }
-            } else if (m_currentTool == 2) { // 直线工具
-                painter.drawLine(m_drawStartPos, m_drawEndPos);
-            } else if (m_currentTool == 3) { // 箭头工具
-                painter.drawLine(m_drawStartPos, m_drawEndPos);
-                // 预览箭头
-                auto drawHead = [&](const QPoint &from, const QPoint &to){
-                    QLineF line(from, to);
-                    double angle = std::atan2(-line.dy(), line.dx());
-                    double len = 12.0;
-                    QPointF p1 = QPointF(to) + QPointF(-len * std::cos(angle + 3.14159265358979323846/6.0), len * std::sin(angle + 3.14159265358979323846/6.0));
-                    QPointF p2 = QPointF(to) + QPointF(-len * std::cos(angle - 3.14159265358979323846/6.0), len * std::sin(angle - 3.14159265358979323846/6.0));
-                    painter.drawLine(to, p1.toPoint());
-                    painter.drawLine(to, p2.toPoint());
-                };
-                drawHead(m_drawStartPos, m_drawEndPos);
-            } else if (m_currentTool == 4) { // 圆形工具
-                QRect rect = QRect(m_drawStartPos, m_drawEndPos).normalized();
-                painter.drawEllipse(rect);
-            } else if (m_currentTool == 5) { // 矩形工具
-                QRect rect = QRect(m_drawStartPos, m_drawEndPos).normalized();
-                painter.drawRect(rect);
+            // 预览图形在独立的绘制层中，这里只叠加（马赛克在拖动时已直接写入合成图，无需预览）
+            if (m_isDrawing && !m_drawingLayer.isNull() && m_previewRect.intersects(dirtyRect)) {
+                const QRect layerRect = m_previewRect.intersected(dirtyRect);
+                const qreal layerDpr = m_drawingLayer.devicePixelRatio();
+                painter.drawImage(QRectF(layerRect), m_drawingLayer,
+                                   QRectF(QPointF(layerRect.topLeft()) * layerDpr, QSizeF(layerRect.size()) * layerDpr));
             }
         }
+        
+        // 仅用于界面显示的虚线边框（不影响保存/复制/贴图的图片内容），重绘区域外的部分由系统裁剪
+        if (!imageRect.adjusted(3, 3, -3, -3).contains(event->rect())) {
+            QPen dashPen(QColor(160, 160, 160, 220));
+            dashPen.setStyle(Qt::DashLine);
+            dashPen.setWidth(2);
+            painter.setPen(dashPen);
+            painter.setBrush(Qt::NoBrush);
+            painter.drawRect(imageRect.adjusted(1, 1, -1, -1));
+        }
         // 按钮区域不绘制任何背景，保持完全透明
     }
 }
@@ -242,7 +223,7 @@ void ScreenshotEditWindow::mousePressEvent(QMouseEvent *event) {
     }
     
     if (event->button() != Qt::LeftButton) return;
-    QSize displaySize = m_screenshot.size() / m_screenshot.devicePixelRatio();
+    QSize displaySize = m_scene.displaySize();
     QRect imageRect(0, 0, displaySize.width(), displaySize.height());
     bool inImage = imageRect.contains(event->pos());
     
@@ -253,19 +234,30 @@ void ScreenshotEditWindow::mousePressEvent(QMouseEvent *event) {
             startDrawingMode(7);
             return;
         }
-        // 在开始一次绘制前保存当前截图到撤销栈
-        m_undoStack.append(m_screenshot.copy());
-        // 限制撤销栈大小，避免内存占用过大
-        if (m_undoStack.size() > 20) {
-            m_undoStack.removeFirst();
-        }
-        qDebug() << "[Undo] Saved state, stack size:" << m_undoStack.size();
-        
         m_isDrawing = true;
         m_drawStartPos = event->pos();
         m_drawEndPos = event->pos();
-        m_drawHistory.clear();
-        m_drawHistory.append(qMakePair(event->pos(), event->pos()));
+        // 所有工具都先擦除上一个图形：绘制中 paintEvent 会叠加绘制层，
+        // 马赛克若保留旧图形，会把它盖在新打的马赛克上（已撤销的图形也会重现）
+        beginPreview();
+        
+        // 马赛克拖动时即时生效：按下时就提交命令，拖动中向命令追加中心点
+        if (m_currentTool == 6) {
+            const Annotation annotation = pendingAnnotation();
+            m_scene.push(annotation);
+            update(annotation.bounds().toAlignedRect());
+            return;
+        }
+        if (m_currentTool == 1) { // 画笔工具：轨迹逐段绘制到绘制层
+            m_stroke = Annotation();
+            m_stroke.type = Annotation::Pen;
+            m_stroke.color = m_currentColor;
+            m_stroke.thickness = m_currentThickness;
+            m_stroke.smooth = m_penSmoothing;
+            m_stroke.points.append(event->pos());
+        } else {
+            updatePreview();
+        }
     } else {
         m_dragOffset = event->pos();
         m_isDragging = true;
@@ -276,12 +268,13 @@ void ScreenshotEditWindow::mouseMoveEvent(QMouseEvent *event) {
     if (m_isDrawing && (event->buttons() & Qt::LeftButton)) {
         m_drawEndPos = event->pos();
         if (m_currentTool == 1) { // 画笔工具
-            m_drawHistory.append(qMakePair(event->pos(), event->pos()));
+            extendStroke(event->pos());
         } else if (m_currentTool == 6) { // 马赛克工具
             // 马赛克工具：拖动过程中即时生效
             applyMosaicAt(event->pos());
+        } else {
+            updatePreview();
         }
-        update();
         return;
     }
     if (m_isDragging && (event->buttons() & Qt::LeftButton)) {
@@ -292,42 +285,25 @@ void ScreenshotEditWindow::mouseMoveEvent(QMouseEvent *event) {
 
 void ScreenshotEditWindow::mouseReleaseEvent(QMouseEvent *event) {
     if (m_isDrawing && event->button() == Qt::LeftButton) {
-        // 将绘制内容落盘到 m_screenshot
-        QPainter p(&m_screenshot);
-        p.setRenderHint(QPainter::Antialiasing);
-        QPen pen(m_currentColor);
-        pen.setWidth(m_currentThickness);
-        pen.setCapStyle(Qt::RoundCap);
-        pen.setJoinStyle(Qt::RoundJoin);
-        p.setPen(pen);
+        // 平滑画笔的最后一段要等到松开时才能确定
+        if (m_currentTool == 1 && m_stroke.smooth) {
+            paintStrokeSegment(int(m_stroke.points.size()) - 2);
+        }
         
-        if (m_currentTool == 1 && m_drawHistory.size() > 1) { // 画笔工具
-            for (int i = 1; i < m_drawHistory.size(); ++i) {
-                p.drawLine(m_drawHistory[i-1].first, m_drawHistory[i].first);
-            }
-        } else if (m_currentTool == 2) { // 直线工具
-            p.drawLine(m_drawStartPos, m_drawEndPos);
-        } else if (m_currentTool == 3) { // 箭头工具
-            QPoint s = m_drawStartPos;
-            QPoint e = m_drawEndPos;
-            p.drawLine(s, e);
-            QLineF line(s, e);
-            double angle = std::atan2(-line.dy(), line.dx());
-            double len = 18.0;
-            QPointF p1 = QPointF(e) + QPointF(-len * std::cos(angle + 3.14159265358979323846/6.0), len * std::sin(angle + 3.14159265358979323846/6.0));
-            QPointF p2 = QPointF(e) + QPointF(-len * std::cos(angle - 3.14159265358979323846/6.0), len * std::sin(angle - 3.14159265358979323846/6.0));
-            p.drawLine(e, p1.toPoint());
-            p.drawLine(e, p2.toPoint());
-        } else if (m_currentTool == 4) { // 圆形工具
-            QRect r = QRect(m_drawStartPos, m_drawEndPos).normalized();
-            p.drawEllipse(r);
-        } else if (m_currentTool == 5) { // 矩形工具
-            QRect r = QRect(m_drawStartPos, m_drawEndPos).normalized();
-            p.drawRect(r);
+        // 提交为标注命令（原图不变）：绘制层中正好是这个图形，直接叠加到合成图，无需重新光栅化。
+        // 模糊工具只点击未拖动时区域为空，不产生撤销步骤（QRectF与模糊命令的区域一致，QRect(p, p)为1×1）
+        QRect changedRect = m_previewRect;
+        if (((m_currentTool >= 1 && m_currentTool <= 5) || m_currentTool == 8)
+            && (m_currentTool != 1 || m_stroke.points.size() > 1)
+            && (m_currentTool != 8 || !QRectF(m_drawStartPos, m_drawEndPos).normalized().isEmpty())) {
+            const Annotation annotation = pendingAnnotation();
+            m_scene.push(annotation, m_drawingLayer);
+            changedRect |= annotation.bounds().toAlignedRect();
         }
+        // 绘制层中的图形留到下次 beginPreview() 时按 m_previewRect 擦除
         m_isDrawing = false;
-        m_drawHistory.clear();
-        update();
+        m_stroke = Annotation();
+        update(changedRect);
         return;
     }
     
@@ -374,12 +350,27 @@ void ScreenshotEditWindow::keyPressEvent(QKeyEvent *event) {
         break;
     case Qt::Key_S:
         if (event->modifiers() & Qt::ControlModifier) {
-            emit saveRequested(m_screenshot);  // Ctrl+S保存截图
+            emit saveRequested(getScreenshot());  // Ctrl+S保存截图
         }
         break;
     case Qt::Key_C:
         if (event->modifiers() & Qt::ControlModifier) {
-            emit copyRequested(m_screenshot);  // Ctrl+C复制截图
+            emit copyRequested(getScreenshot());  // Ctrl+C复制截图
+        }
+        break;
+    case Qt::Key_Z:
+        if (event->modifiers() & Qt::ControlModifier) {
+            // Ctrl+Z 撤销，Ctrl+Shift+Z 重做
+            if (event->modifiers() & Qt::ShiftModifier) {
+                redoAnnotation();
+            } else {
+                undoAnnotation();
+            }
+        }
+        break;
+    case Qt::Key_Y:
+        if (event->modifiers() & Qt::ControlModifier) {
+            redoAnnotation();  // Ctrl+Y 重做
         }
         break;
     case Qt::Key_W:
@@ -423,15 +414,15 @@ void ScreenshotEditWindow::keyPressEvent(QKeyEvent *event) {
 }
 
 void ScreenshotEditWindow::onSaveClicked() {
-    emit saveRequested(m_screenshot);
+    emit saveRequested(getScreenshot());
 }
 
 void ScreenshotEditWindow::onCopyClicked() {
-    emit copyRequested(m_screenshot);
+    emit copyRequested(getScreenshot());
 }
 
 void ScreenshotEditWindow::onStickyNoteClicked() {
-    emit createStickyNoteRequested(m_screenshot);
+    emit createStickyNoteRequested(getScreenshot());
 }
 
 void ScreenshotEditWindow::onCloseClicked() {
@@ -443,7 +434,7 @@ void ScreenshotEditWindow::onCloseClicked() {
 
 void ScreenshotEditWindow::onToolButtonClicked(int id) {
     m_currentTool = id;
-    if (id >= 1 && id <= 6) {
+    if ((id >= 1 && id <= 6) || id == 8) {
         QPushButton *anchor = nullptr;
         switch (id) {
         case 1: anchor = m_penToolBtn; break;
@@ -452,6 +443,7 @@ void ScreenshotEditWindow::onToolButtonClicked(int id) {
         case 4: anchor = m_circleToolBtn; break;
         case 5: anchor = m_rectToolBtn; break;
         case 6: anchor = m_mosaicToolBtn; break;
+        case 8: anchor = m_blurToolBtn; break;
         }
         if (anchor) {
             showStylePopover(anchor);
@@ -471,20 +463,13 @@ void ScreenshotEditWindow::onTextEditFinished() {
     if (!m_textEdit) return;
     QString text = m_textEdit->text().trimmed();
     if (!text.isEmpty()) {
-        // 保存当前状态到撤销栈
-        m_undoStack.append(m_screenshot.copy());
-        if (m_undoStack.size() > 20) {
-            m_undoStack.removeFirst();
-        }
-        qDebug() << "[Undo] Saved state (text), stack size:" << m_undoStack.size();
-        
-        QPainter p(&m_screenshot);
-        p.setRenderHint(QPainter::Antialiasing);
-        p.setPen(m_currentColor);
-        QFont font; font.setPointSize(16); p.setFont(font);
-        QFontMetrics fm(font);
-        QPoint drawPoint = QPoint(m_drawStartPos.x(), m_drawStartPos.y() + fm.ascent());
-        p.drawText(drawPoint, text);
+        Annotation annotation;
+        annotation.type = Annotation::Text;
+        annotation.color = m_currentColor;
+        annotation.points.append(m_drawStartPos);
+        annotation.text = text;
+        annotation.font.setPointSize(16);
+        m_scene.push(annotation);
     }
     m_textEdit->deleteLater();
     m_textEdit = nullptr;
@@ -500,6 +485,7 @@ void ScreenshotEditWindow::setupUI() {
     m_circleToolBtn = new QPushButton(this);
     m_rectToolBtn = new QPushButton(this);
     m_mosaicToolBtn = new QPushButton(this);
+    m_blurToolBtn = new QPushButton(this);
     m_textToolBtn = new QPushButton(this);
     
     // 设置SVG图标 - 矢量图标在任何DPI下都清晰 (使用英文文件名避免编码问题)
@@ -509,6 +495,7 @@ void ScreenshotEditWindow::setupUI() {
     m_circleToolBtn->setIcon(QIcon(":/icons/resources/icons/circle.svg"));
     m_rectToolBtn->setIcon(QIcon(":/icons/resources/icons/rect.svg"));
     m_mosaicToolBtn->setIcon(QIcon(":/icons/resources/icons/mosaic.svg"));
+    m_blurToolBtn->setIcon(QIcon(":/icons/resources/icons/blur.svg"));
     m_textToolBtn->setIcon(QIcon(":/icons/resources/icons/text.svg"));
     
     // 设置图标大小（SVG会自动缩放到此尺寸）
@@ -519,6 +506,7 @@ void ScreenshotEditWindow::setupUI() {
     m_circleToolBtn->setIconSize(iconSize);
     m_rectToolBtn->setIconSize(iconSize);
     m_mosaicToolBtn->setIconSize(iconSize);
+    m_blurToolBtn->setIconSize(iconSize);
     m_textToolBtn->setIconSize(iconSize);
     
     // 设置tooltip提示
@@ -528,6 +516,7 @@ void ScreenshotEditWindow::setupUI() {
     m_circleToolBtn->setToolTip("圆形");
     m_rectToolBtn->setToolTip("矩形");
     m_mosaicToolBtn->setToolTip("马赛克");
+    m_blurToolBtn->setToolTip("模糊");
     m_textToolBtn->setToolTip("文字");
     
     m_penToolBtn->setCheckable(true);
@@ -536,6 +525,7 @@ void ScreenshotEditWindow::setupUI() {
     m_circleToolBtn->setCheckable(true);
     m_rectToolBtn->setCheckable(true);
     m_mosaicToolBtn->setCheckable(true);
+    m_blurToolBtn->setCheckable(true);
     m_textToolBtn->setCheckable(true);
     
     m_toolGroup = new QButtonGroup(this);
@@ -547,6 +537,7 @@ void ScreenshotEditWindow::setupUI() {
     m_toolGroup->addButton(m_rectToolBtn, 5);
     m_toolGroup->addButton(m_mosaicToolBtn, 6);
     m_toolGroup->addButton(m_textToolBtn, 7);
+    m_toolGroup->addButton(m_blurToolBtn, 8);
 
     // 底部一行：左侧绘图工具 + 右侧操作按钮
     QHBoxLayout *bottomLayout = new QHBoxLayout();
@@ -627,6 +618,7 @@ void ScreenshotEditWindow::setupUI() {
     m_circleToolBtn->setStyleSheet(toolBtnStyle);
     m_rectToolBtn->setStyleSheet(toolBtnStyle);
     m_mosaicToolBtn->setStyleSheet(toolBtnStyle);
+    m_blurToolBtn->setStyleSheet(toolBtnStyle);
     m_textToolBtn->setStyleSheet(toolBtnStyle);
     
     // 关键修复：设置按钮最小尺寸（SVG图标模式，矢量图标自适应DPI）
@@ -639,6 +631,7 @@ void ScreenshotEditWindow::setupUI() {
     m_circleToolBtn->setMinimumSize(btnMinSize);
     m_rectToolBtn->setMinimumSize(btnMinSize);
     m_mosaicToolBtn->setMinimumSize(btnMinSize);
+    m_blurToolBtn->setMinimumSize(btnMinSize);
     m_textToolBtn->setMinimumSize(btnMinSize);
     
     m_undoBtn->setMinimumSize(btnMinSize);
@@ -654,6 +647,7 @@ void ScreenshotEditWindow::setupUI() {
     bottomLayout->addWidget(m_circleToolBtn);
     bottomLayout->addWidget(m_rectToolBtn);
     bottomLayout->addWidget(m_mosaicToolBtn);
+    bottomLayout->addWidget(m_blurToolBtn);
     bottomLayout->addWidget(m_textToolBtn);
 
     // 不再在底栏展示颜色/粗细，改为弹窗
@@ -693,14 +687,7 @@ void ScreenshotEditWindow::setupConnections() {
     connect(m_stickyBtn, &QPushButton::clicked, this, &ScreenshotEditWindow::onStickyNoteClicked);
     connect(m_closeBtn, &QPushButton::clicked, this, &ScreenshotEditWindow::onCloseClicked);
     connect(m_undoBtn, &QPushButton::clicked, this, [this]() {
-        // 撤销功能实现：从撤销栈恢复上一个状态
-        if (!m_undoStack.isEmpty()) {
-            m_screenshot = m_undoStack.takeLast();
-            qDebug() << "[Undo] Restored previous state, stack size:" << m_undoStack.size();
-            update();
-        } else {
-            qDebug() << "[Undo] No more undo history";
-        }
+        undoAnnotation();
     });
     
     connect(m_toolGroup, &QButtonGroup::idClicked, this, &ScreenshotEditWindow::onToolButtonClicked);
@@ -770,49 +757,109 @@ void ScreenshotEditWindow::endDrawingMode() {
     m_currentTool = 0;
 }
 
-void ScreenshotEditWindow::drawTool(QPainter &painter, const QPoint &startPos, const QPoint &endPos, int toolType) {
-    QPen pen(m_currentColor);
-    pen.setWidth(m_currentThickness);
-    pen.setCapStyle(Qt::RoundCap);
-    pen.setJoinStyle(Qt::RoundJoin);
-    painter.setPen(pen);
-    
-    switch (toolType) {
-    case 1: // 画笔工具
-        if (m_drawHistory.size() > 1) {
-            for (int i = 1; i < m_drawHistory.size(); ++i) {
-                painter.drawLine(m_drawHistory[i-1].first, m_drawHistory[i].first);
-            }
-        }
-        break;
-    case 2: // 直线工具
-        painter.drawLine(startPos, endPos);
-        break;
-    case 3: // 箭头工具
-        {
-            painter.drawLine(startPos, endPos);
-            // 绘制箭头头部
-            QLineF line(startPos, endPos);
-            double angle = std::atan2(-line.dy(), line.dx());
-            double len = 18.0;
-            QPointF p1 = QPointF(endPos) + QPointF(-len * std::cos(angle + 3.14159265358979323846/6.0), len * std::sin(angle + 3.14159265358979323846/6.0));
-            QPointF p2 = QPointF(endPos) + QPointF(-len * std::cos(angle - 3.14159265358979323846/6.0), len * std::sin(angle - 3.14159265358979323846/6.0));
-            painter.drawLine(endPos, p1.toPoint());
-            painter.drawLine(endPos, p2.toPoint());
-        }
-        break;
-    case 4: // 圆形工具
-        {
-            QRect rect = QRect(startPos, endPos).normalized();
-            painter.drawEllipse(rect);
-        }
-        break;
-    case 5: // 矩形工具
-        {
-            QRect rect = QRect(startPos, endPos).normalized();
-            painter.drawRect(rect);
-        }
-        break;
+Annotation ScreenshotEditWindow::pendingAnnotation() const {
+    Annotation annotation;
+    annotation.color = m_currentColor;
+    annotation.thickness = m_currentThickness;
+    switch (m_currentTool) {
+    case 1: // 画笔工具：轨迹在拖动中逐点累积
+        return m_stroke;
+    case 2: annotation.type = Annotation::Line; break;      // 直线工具
+    case 3: annotation.type = Annotation::Arrow; break;     // 箭头工具
+    case 4: annotation.type = Annotation::Ellipse; break;   // 圆形工具
+    case 5: annotation.type = Annotation::Rect; break;      // 矩形工具
+    case 8: annotation.type = Annotation::Blur; break;      // 模糊工具：拖出区域，松开时模糊
+    case 6: // 马赛克工具：拖动中通过 AnnotationScene::extend 追加中心点
+        annotation.type = Annotation::Mosaic;
+        annotation.points.append(m_drawStartPos);
+        return annotation;
+    }
+    annotation.points << m_drawStartPos << m_drawEndPos;
+    return annotation;
+}
+
+void ScreenshotEditWindow::beginPreview() {
+    // 与截图设备像素比相同时绘制层与合成图逐像素对应，提交时可以直接叠加
+    const qreal dpr = devicePixelRatioF();
+    const QImage &original = m_scene.original();
+    const QSize layerSize = qFuzzyCompare(dpr, original.devicePixelRatio())
+        ? original.size() : m_scene.displaySize() * dpr;
+    if (m_drawingLayer.size() != layerSize || m_drawingLayer.devicePixelRatio() != dpr) {
+        m_drawingLayer = ImageBuffer::allocate(layerSize, dpr);
+        m_drawingLayer.fill(Qt::transparent);
+    } else if (!m_previewRect.isEmpty()) {
+        QPainter painter(&m_drawingLayer);
+        painter.setCompositionMode(QPainter::CompositionMode_Clear);
+        painter.fillRect(m_previewRect, Qt::transparent);
+    }
+    m_previewRect = QRect();
+}
+
+void ScreenshotEditWindow::updatePreview() {
+    // 擦除上一次的预览图形，只重画当前图形
+    const QRect oldRect = m_previewRect;
+    const Annotation annotation = pendingAnnotation();
+    QPainter painter(&m_drawingLayer);
+    if (!oldRect.isEmpty()) {
+        painter.setCompositionMode(QPainter::CompositionMode_Clear);
+        painter.fillRect(oldRect, Qt::transparent);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    }
+    AnnotationScene::paint(painter, annotation);
+    m_previewRect = annotation.bounds().toAlignedRect();
+    
+    // 只重绘新旧图形覆盖的区域
+    update(oldRect | m_previewRect);
+}
+
+void ScreenshotEditWindow::extendStroke(const QPoint &pos) {
+    if (m_stroke.points.last() == QPointF(pos)) {
+        return;
+    }
+    m_stroke.points.append(pos);
+    // 平滑时第 i 段的切线取决于第 i+2 个点：新点到来后前一段才确定
+    const int count = int(m_stroke.points.size());
+    paintStrokeSegment(m_stroke.smooth ? count - 3 : count - 2);
+}
+
+void ScreenshotEditWindow::paintStrokeSegment(int index) {
+    if (index < 0 || index + 1 >= m_stroke.points.size()) {
+        return;
+    }
+    // 只光栅化这一段，每次移动的代价与轨迹长度无关
+    QPainter painter(&m_drawingLayer);
+    AnnotationScene::paintStroke(painter, m_stroke, index, index + 1);
+    
+    // 该段只依赖前后各一个控制点
+    Annotation segment;
+    segment.type = Annotation::Pen;
+    segment.thickness = m_stroke.thickness;
+    segment.smooth = m_stroke.smooth;
+    segment.points = m_stroke.points.mid(qMax(0, index - 1), index == 0 ? 3 : 4);
+    const QRect rect = segment.bounds().toAlignedRect();
+    m_previewRect |= rect;
+    update(rect);
+}
+
+void ScreenshotEditWindow::undoAnnotation() {
+    if (m_isDrawing) {
+        return;
+    }
+    if (m_scene.undo()) {
+        qDebug() << "[Undo] Undone, annotations:" << m_scene.count();
+        update();
+    } else {
+        qDebug() << "[Undo] No more undo history";
+    }
+}
+
+void ScreenshotEditWindow::redoAnnotation() {
+    if (m_isDrawing) {
+        return;
+    }
+    if (m_scene.redo()) {
+        qDebug() << "[Undo] Redone, annotations:" << m_scene.count();
+        update();
     }
 }
 
@@ -836,24 +883,8 @@ void ScreenshotEditWindow::startTextInputAt(const QPoint &pos) {
 }
 
 void ScreenshotEditWindow::applyMosaicAt(const QPoint &center) {
-    if (m_screenshot.isNull()) return;
-    // 马赛克工具即时生效，但撤销栈已在 mousePressEvent 中保存
-    // 基于粗细计算块大小
-    int block = qMax(4, m_currentThickness * 6);
-    int half = block / 2;
-    QRect patchRect(center.x() - half, center.y() - half, block, block);
-    QSize displaySize = m_screenshot.size() / m_screenshot.devicePixelRatio();
-    QRect imageRect(0, 0, displaySize.width(), displaySize.height());
-    patchRect = patchRect.intersected(imageRect);
-    if (patchRect.isEmpty()) return;
-    QImage patch = m_screenshot.copy(patchRect).toImage();
-    QSize smallSize(qMax(1, patch.width() / 6), qMax(1, patch.height() / 6));
-    QImage reduced = patch.scaled(smallSize, Qt::IgnoreAspectRatio, Qt::FastTransformation);
-    QImage pixelated = reduced.scaled(patch.size(), Qt::IgnoreAspectRatio, Qt::FastTransformation);
-    QPainter p(&m_screenshot);
-    p.setRenderHint(QPainter::Antialiasing, false);
-    p.drawImage(patchRect.topLeft(), pixelated);
-    update();
+    // 马赛克命令已在 mousePressEvent 中提交，这里追加中心点，沿上一个点到此点的路径处理，只重绘改动的区域
+    update(m_scene.extend(center).toAlignedRect());
 }
 
 void ScreenshotEditWindow::updateWindowSizeForDPI() {
@@ -910,9 +941,9 @@ void ScreenshotEditWindow::updateWindowSizeForDPI() {
         mainLayout->setSizeConstraint(QLayout::SetNoConstraint);
     }
     
-    // 设置合理的最小窗口尺寸：使用图标按钮后只需420px
+    // 设置合理的最小窗口尺寸：使用图标按钮后只需440px
     // 图标按钮比文字按钮更紧凑
-    int minWindowWidth = qMax(420, imageDisplaySize.width());
+    int minWindowWidth = qMax(440, imageDisplaySize.width());
     int minWindowHeight = imageDisplaySize.height() + 50;
     setMinimumSize(minWindowWidth, minWindowHeight);
     
@@ -967,7 +998,7 @@ void ScreenshotEditWindow::ensureButtonsVisible() {
     // 这个方法在快速多屏移动时被调用，避免按钮消失问题
     QList<QPushButton*> allButtons = {
         m_penToolBtn, m_lineToolBtn, m_arrowToolBtn, m_circleToolBtn,
-        m_rectToolBtn, m_mosaicToolBtn, m_textToolBtn,
+        m_rectToolBtn, m_mosaicToolBtn, m_blurToolBtn, m_textToolBtn,
         m_undoBtn, m_saveBtn, m_copyBtn, m_stickyBtn, m_closeBtn
     };
     
@@ -1020,17 +1051,17 @@ void ScreenshotEditWindow::showContextMenu(const QPoint &pos) {
     // 添加常用操作
     QAction *saveAction = contextMenu.addAction("保存 (Ctrl+S)");
     connect(saveAction, &QAction::triggered, this, [this]() {
-        emit saveRequested(m_screenshot);
+        emit saveRequested(getScreenshot());
     });
     
     QAction *copyAction = contextMenu.addAction("复制 (Ctrl+C)");
     connect(copyAction, &QAction::triggered, this, [this]() {
-        emit copyRequested(m_screenshot);
+        emit copyRequested(getScreenshot());
     });
     
     QAction *stickyAction = contextMenu.addAction("贴图");
     connect(stickyAction, &QAction::triggered, this, [this]() {
-        emit createStickyNoteRequested(m_screenshot);
+        emit createStickyNoteRequested(getScreenshot());
     });
     
     contextMenu.addSeparator();
@@ -31,7 +31,7 @@
 #define SCREENSHOTEDITWINDOW_H
 
 #include <QWidget>
-#include <QPixmap>
+#include <QImage>
 #include <QPoint>
 #include <QPushButton>
 #include <QLabel>
@@ -40,6 +40,7 @@
 #include <QButtonGroup>
 #include <QLineEdit>
 #include <QGraphicsDropShadowEffect>
+#include "AnnotationScene.h"
 
 // 前向声明
 class StylePopover;
@@ -52,8 +53,10 @@ class StylePopover;
  * - 显示截图预览
  * - 提供保存、复制、创建贴图、关闭四个操作按钮
  * - 支持窗口拖拽移动
- * - 支持键盘快捷键操作（Ctrl+S保存，Ctrl+C复制，ESC关闭）
+ * - 支持键盘快捷键操作（Ctrl+S保存，Ctrl+C复制，Ctrl+Z撤销，Ctrl+Y重做，ESC关闭）
  * - 无边框设计，始终置顶显示
+ *
+ * 标注以命令形式记录在 AnnotationScene 中，原图不被修改，保存/复制/贴图时才展平
  */
 class ScreenshotEditWindow : public QWidget
 {
@@ -62,11 +65,14 @@ class ScreenshotEditWindow : public QWidget
 public:
     /**
      * @brief 构造函数
+     *
+     * 截图以共享方式持有，只有在首次绘制标注时合成图才会复制像素
+     *
      * @param screenshot 要显示的截图
      * @param initialPos 初始位置
      * @param parent 父窗口指针
      */
-    explicit ScreenshotEditWindow(const QPixmap &screenshot, const QPoint &initialPos = QPoint(), QWidget *parent = nullptr);
+    explicit ScreenshotEditWindow(const QImage &screenshot, const QPoint &initialPos = QPoint(), QWidget *parent = nullptr);
     
     /**
      * @brief 析构函数
@@ -74,29 +80,29 @@ public:
     ~ScreenshotEditWindow();
 
     /**
-     * @brief 获取当前截图
-     * @return 截图的QPixmap对象
+     * @brief 获取当前截图（原图与标注展平后的结果）
+     * @return 截图的QImage对象，没有标注时为原图
      */
-    QPixmap getScreenshot() const;
+    QImage getScreenshot() const;
 
 signals:
     /**
      * @brief 保存请求信号
      * @param screenshot 要保存的截图
      */
-    void saveRequested(const QPixmap &screenshot);
+    void saveRequested(const QImage &screenshot);
     
     /**
      * @brief 复制请求信号
      * @param screenshot 要复制的截图
      */
-    void copyRequested(const QPixmap &screenshot);
+    void copyRequested(const QImage &screenshot);
     
     /**
      * @brief 创建贴图请求信号
      * @param screenshot 要创建贴图的截图
      */
-    void createStickyNoteRequested(const QPixmap &screenshot);
+    void createStickyNoteRequested(const QImage &screenshot);
     
     /**
      * @brief 关闭请求信号
@@ -230,13 +236,42 @@ private:
     void endDrawingMode();
 
     /**
-     * @brief 绘制工具图形
-     * @param painter 绘图器
-     * @param startPos 起始位置
-     * @param endPos 结束位置
-     * @param toolType 工具类型
+     * @brief 由当前绘制状态生成标注命令（预览与提交共用）
+     * @return 当前工具对应的标注
+     */
+    Annotation pendingAnnotation() const;
+
+    /**
+     * @brief 开始一次拖动绘制：准备绘制层并清除上一次的预览
+     */
+    void beginPreview();
+
+    /**
+     * @brief 在绘制层中重画预览图形，只重绘新旧图形覆盖的区域
+     */
+    void updatePreview();
+
+    /**
+     * @brief 向画笔轨迹追加一个点，只绘制由此确定的一段
+     * @param pos 鼠标位置
+     */
+    void extendStroke(const QPoint &pos);
+
+    /**
+     * @brief 把画笔轨迹的第 index 段绘制到绘制层
+     * @param index 段序号（第 index 到第 index+1 个点）
+     */
+    void paintStrokeSegment(int index);
+
+    /**
+     * @brief 撤销最后一个标注
+     */
+    void undoAnnotation();
+
+    /**
+     * @brief 重做最近撤销的标注
      */
-    void drawTool(QPainter &painter, const QPoint &startPos, const QPoint &endPos, int toolType);
+    void redoAnnotation();
 
     /**
      * @brief 更新窗口大小以适应DPI变化
@@ -265,11 +300,9 @@ private:
     void ensureWindowInScreen();
 
 private:
-    QPixmap m_screenshot;           ///< 当前截图
-    QPixmap m_originalScreenshot;   ///< 原始截图备份
-    QPixmap m_drawingLayer;         ///< 绘制层
+    AnnotationScene m_scene;        ///< 原始截图（共享，不修改）与标注命令
+    QImage m_drawingLayer;          ///< 绘制层（透明，拖动中的预览图形，提交时直接叠加到合成图）
     QSize m_originalScreenshotSize; ///< 原始截图显示尺寸（用于DPI自适应）
-    QList<QPixmap> m_undoStack;     ///< 撤销历史栈
 
     // UI组件
     QLabel *m_imageLabel;           ///< 图片显示标签
@@ -286,6 +319,7 @@ private:
     QPushButton *m_circleToolBtn;   ///< 圆形工具按钮
     QPushButton *m_rectToolBtn;     ///< 矩形工具按钮
     QPushButton *m_mosaicToolBtn;   ///< 马赛克工具按钮
+    QPushButton *m_blurToolBtn;     ///< 模糊工具按钮
     QPushButton *m_textToolBtn;     ///< 文本工具按钮
     QButtonGroup *m_toolGroup;      ///< 工具按钮组
 
@@ -299,7 +333,9 @@ private:
     int m_currentTool;              ///< 当前工具
     QPoint m_drawStartPos;          ///< 绘制起始位置
     QPoint m_drawEndPos;            ///< 绘制结束位置
-    QList<QPair<QPoint, QPoint>> m_drawHistory; ///< 绘制历史
+    Annotation m_stroke;            ///< 正在绘制的画笔轨迹
+    bool m_penSmoothing;            ///< 画笔轨迹是否平滑（Catmull-Rom）
+    QRect m_previewRect;            ///< 绘制层中预览图形的外接矩形（逻辑坐标）
 
     // 文本编辑
     QLineEdit *m_textEdit;          ///< 文本编辑框
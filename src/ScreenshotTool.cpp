@@ -29,6 +29,14 @@
 #include "RegionSelector.h"
 #include "ScreenshotEditWindow.h"
 #include "StickyNoteWindow.h"
+#include "CapturePipeline.h"
+#include "CaptureMetrics.h"
+#include "BurstCapture.h"
+#include "ScrollCapture.h"
+#include "FrameSource.h"
+#include "EncodedImageCache.h"
+#include "ClipboardMimeData.h"
+#include "ImageBuffer.h"
 #include <QApplication>
 #include <QScreen>
 #include <QGuiApplication>
@@ -37,7 +45,6 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QDateTime>
-#include <QClipboard>
 #include <QTimer>
 #include <QDebug>
 #include <QLabel>
@@ -46,6 +53,32 @@
 #include <climits>
 #include <QStandardPaths>
 #include <QDir>
+#include <QSettings>
+#include <QElapsedTimer>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief 将32位图像逐行拷贝到画布指定位置（超出画布的部分裁掉）
+ */
+void blitRows(QImage &canvas, const QImage &source, const QPoint &position)
+{
+    const QRect target = QRect(position, source.size()).intersected(canvas.rect());
+    if (target.isEmpty()) {
+        return;
+    }
+    const int srcX = target.x() - position.x();
+    const int srcY = target.y() - position.y();
+    const qsizetype rowBytes = qsizetype(target.width()) * 4;
+    for (int y = 0; y < target.height(); ++y) {
+        std::memcpy(canvas.scanLine(target.y() + y) + qsizetype(target.x()) * 4,
+                    source.constScanLine(srcY + y) + qsizetype(srcX) * 4,
+                    rowBytes);
+    }
+}
+
+} // namespace
 
 ScreenshotTool::ScreenshotTool(QObject *parent)
     : QObject(parent)
@@ -53,7 +86,63 @@ ScreenshotTool::ScreenshotTool(QObject *parent)
     , m_lastEditPos()
     , m_lastCaptureTopLeft()
     , m_delayedCaptureTimer(nullptr)
+    , m_pipeline(nullptr)
+    , m_mergeMode(MergeNativeDpr)
+    , m_metricsCaptureId(0)
+    , m_jobCaptures()
+    , m_burst(nullptr)
+    , m_lastCaptureRect()
+    , m_scrollCapturePending(false)
 {
+    // 跨屏合成模式：默认保持最高DPR，避免高DPI屏幕上的内容被缩小
+    QSettings settings("CapStep", "Capture");
+    m_mergeMode = settings.value("mergeMode", "native").toString() == "logical" ? MergeLogical : MergeNativeDpr;
+    
+    // 预热截图模式：启动时即创建区域选择器并开始刷新快照
+    if (settings.value("warmMode", false).toBool()) {
+        ensureRegionSelector()->setWarmMode(true, settings.value("warmRefreshMs", 500).toInt());
+    }
+    
+    // 截图后处理流水线：裁剪结果就绪后立即显示编辑窗口，编码/剪贴板在其后异步完成
+    m_pipeline = new CapturePipeline(this);
+    connect(m_pipeline, &CapturePipeline::cropReady, this,
+            [this](quint64 jobId, const QImage &screenshot, const QPoint &editorPos) {
+        Q_UNUSED(jobId)
+        showScreenshotEditWindow(screenshot, editorPos);
+    });
+    
+    // 流水线阶段 → 热路径统计
+    connect(m_pipeline, &CapturePipeline::stageCompleted, this,
+            [this](quint64 jobId, CapturePipeline::Stage stage, qint64 elapsedMs) {
+        Q_UNUSED(elapsedMs)
+        const quint64 captureId = m_jobCaptures.value(jobId);
+        switch (stage) {
+        case CapturePipeline::StageEditor:
+            CaptureMetrics::instance().mark(captureId, CaptureMetrics::StageEditorShown);
+            break;
+        case CapturePipeline::StageClipboard:
+            CaptureMetrics::instance().mark(captureId, CaptureMetrics::StageClipboardPublished);
+            break;
+        case CapturePipeline::StageHistory:
+            CaptureMetrics::instance().mark(captureId, CaptureMetrics::StageHistoryWritten);
+            break;
+        case CapturePipeline::StageCrop:
+            break;
+        }
+    });
+    // 历史队列溢出：转发给主窗口提示
+    connect(m_pipeline, &CapturePipeline::historyDropped, this, &ScreenshotTool::historyDropped);
+    connect(m_pipeline, &CapturePipeline::jobFinished, this, [this](quint64 jobId) {
+        const quint64 captureId = m_jobCaptures.take(jobId);
+        if (captureId) {
+            CaptureMetrics::instance().endCapture(captureId);
+        }
+    });
+    
+    // 连拍：完成后转发给主窗口提示
+    m_burst = new BurstCapture(this);
+    connect(m_burst, &BurstCapture::finished, this, &ScreenshotTool::burstCaptureFinished);
+    
     // 初始化延迟截图定时器
     m_delayedCaptureTimer = new QTimer(this);
     m_delayedCaptureTimer->setSingleShot(true);
@@ -63,15 +152,13 @@ ScreenshotTool::ScreenshotTool(QObject *parent)
         
         // 延迟一小段时间，确保弹窗稳定显示
         QTimer::singleShot(100, this, [this]() {
-            QPixmap screenshot = captureFullScreen();
+            ImageView screenshot(captureFullScreen());
             if (!screenshot.isNull()) {
-                // 自动复制到剪贴板
-                QApplication::clipboard()->setPixmap(screenshot);
-                qDebug() << "[DelayedCapture] Screenshot captured and copied to clipboard";
-                
-                // 显示编辑窗口
-                showScreenshotEditWindow(screenshot, QPoint(100, 100));
-                emit screenshotCaptured(screenshot);
+                // 显示编辑窗口并自动复制到剪贴板（不写入历史）
+                m_pipeline->submit(screenshot, QPoint(100, 100),
+                                   CapturePipeline::StageEditor | CapturePipeline::StageClipboard);
+                qDebug() << "[DelayedCapture] Screenshot captured";
+                emit screenshotCaptured(screenshot.image());
             }
         });
     });
@@ -82,14 +169,22 @@ ScreenshotTool::~ScreenshotTool()
     // 析构函数
 }
 
-QPixmap ScreenshotTool::captureRegion(const QRect &globalRect) {
-    if (globalRect.isEmpty()) return QPixmap();
+void ScreenshotTool::setMergeMode(MergeMode mode) {
+    m_mergeMode = mode;
+    QSettings settings("CapStep", "Capture");
+    settings.setValue("mergeMode", mode == MergeLogical ? "logical" : "native");
+    qDebug() << "[ImageMerge] Merge mode:" << (mode == MergeLogical ? "logical" : "native DPR");
+}
+
+QImage ScreenshotTool::captureRegion(const QRect &globalRect) {
+    if (globalRect.isEmpty()) return QImage();
 
     // 调试信息：显示虚拟桌面信息（按照文档方案）
-    const QList<QScreen*> screens = QGuiApplication::screens();
-    qDebug() << "[VirtualDesktop] screens:" << screens.count();
-    for (auto screen : screens) {
-        qDebug() << "  -" << screen->name() << screen->geometry() << "DPI:" << screen->devicePixelRatio();
+    FrameSource *source = FrameSource::current();
+    const QList<FrameSource::Screen> screens = source->screens();
+    qDebug() << "[VirtualDesktop] screens:" << screens.count() << "source:" << FrameSource::kindName(source->kind());
+    for (const auto &screen : screens) {
+        qDebug() << "  -" << screen.name << screen.geometry << "DPI:" << screen.devicePixelRatio;
     }
 
     qDebug() << "[Selection] globalRect:" << globalRect;
@@ -98,10 +193,10 @@ QPixmap ScreenshotTool::captureRegion(const QRect &globalRect) {
     QList<ScreenCaptureInfo> captures;
     
     // 1. 遍历所有屏幕，计算交集
-    for (QScreen *screen : screens) {
-        if (!screen) continue;
+    for (int i = 0; i < screens.size(); ++i) {
+        const FrameSource::Screen &screen = screens.at(i);
         
-        QRect screenGeo = screen->geometry();
+        QRect screenGeo = screen.geometry;
         QRect intersection = globalRect.intersected(screenGeo);
         
         if (!intersection.isEmpty()) {
@@ -109,13 +204,11 @@ QPixmap ScreenshotTool::captureRegion(const QRect &globalRect) {
             QRect localRect = intersection.translated(-screenGeo.topLeft());
             
             // 3. 抓取屏幕区域
-            QPixmap segment = screen->grabWindow(0, 
-                localRect.x(), localRect.y(),
-                localRect.width(), localRect.height());
+            QImage segment = source->grabScreen(i, localRect);
             
             if (!segment.isNull()) {
                 captures.append({segment, intersection.topLeft()});
-                qDebug() << "[Capture] screen=" << screen->name()
+                qDebug() << "[Capture] screen=" << screen.name
                          << " intersection=" << intersection
                          << " localRect=" << localRect
                          << " segmentSize=" << segment.size()
@@ -128,23 +221,36 @@ QPixmap ScreenshotTool::captureRegion(const QRect &globalRect) {
     
     // 4. 判断模式并处理
     if (captures.size() == 1) {
-        return captures[0].pixmap;  // 单屏直接返回
+        return ImageBuffer::adopt(captures[0].image);  // 单屏直接返回（已是统一格式时不转换）
     } else if (captures.size() > 1) {
         return mergeMultiScreenCaptures(captures, globalRect.size());
     }
     
-    return QPixmap();
+    return QImage();
 }
 
-QPixmap ScreenshotTool::mergeMultiScreenCaptures(const QList<ScreenCaptureInfo> &captures, const QSize &logicalSize) {
-    qDebug() << "[ImageMerge] Starting multi-screen merge with" << captures.size() << "captures, logicalSize:" << logicalSize;
+QImage ScreenshotTool::mergeMultiScreenCaptures(const QList<ScreenCaptureInfo> &captures, const QSize &logicalSize) {
+    QElapsedTimer timer;
+    timer.start();
+
+    // 目标DPR：逻辑模式为1，原生模式取所有分段中最高的DPR
+    qreal targetDpr = 1.0;
+    if (m_mergeMode == MergeNativeDpr) {
+        for (const auto &capture : captures) {
+            targetDpr = qMax(targetDpr, capture.image.devicePixelRatio());
+        }
+    }
     
-    // 创建逻辑尺寸画布
-    QImage canvas(logicalSize, QImage::Format_ARGB32_Premultiplied);
-    canvas.fill(Qt::transparent);
+    qDebug() << "[ImageMerge] Starting multi-screen merge with" << captures.size() << "captures, logicalSize:" << logicalSize
+             << "targetDpr:" << targetDpr;
     
-    QPainter painter(&canvas);
-    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    // 创建目标DPR下的画布（选区可能包含屏幕之间的空隙，保持透明）
+    const QSize canvasSize(qRound(logicalSize.width() * targetDpr), qRound(logicalSize.height() * targetDpr));
+    QImage canvas = ImageBuffer::allocate(canvasSize, targetDpr);
+    if (canvas.isNull()) {
+        return QImage();
+    }
+    canvas.fill(Qt::transparent);
     
     // 找到选区左上角作为基准点
     QPoint selectionTopLeft = QPoint(INT_MAX, INT_MAX);
@@ -157,42 +263,118 @@ QPixmap ScreenshotTool::mergeMultiScreenCaptures(const QList<ScreenCaptureInfo>
     
     for (int i = 0; i < captures.size(); ++i) {
         const auto &capture = captures[i];
-        // 计算在画布中的位置（相对于选区左上角）
-        QPoint position = capture.globalPos - selectionTopLeft;
+        const qreal dpr = capture.image.devicePixelRatio();
+        
+        // 计算在画布中的位置（按边缘取整，相邻分段之间不留缝）
+        const QPoint offset = capture.globalPos - selectionTopLeft;
+        const QSizeF logical = QSizeF(capture.image.size()) / dpr;
+        const int left = qRound(offset.x() * targetDpr);
+        const int top = qRound(offset.y() * targetDpr);
+        const QSize targetSize(qRound((offset.x() + logical.width()) * targetDpr) - left,
+                               qRound((offset.y() + logical.height()) * targetDpr) - top);
         
-        // 缩放到逻辑尺寸（处理不同DPI）
-        QPixmap scaled = scaleToLogicalSize(capture.pixmap, capture.pixmap.size() / capture.pixmap.devicePixelRatio());
+        // 重采样到目标DPR（DPR相同时直接共享原图）
+        const QImage scaled = ImageBuffer::adopt(scaleToLogicalSize(capture.image, targetSize));
         
         qDebug() << "[ImageMerge] capture" << i 
                  << " globalPos:" << capture.globalPos
-                 << " position:" << position
-                 << " originalSize:" << capture.pixmap.size()
+                 << " position:" << QPoint(left, top)
+                 << " originalSize:" << capture.image.size()
                  << " scaledSize:" << scaled.size();
         
-        painter.drawPixmap(position, scaled);
+        // RGB32的alpha恒为0xFF，与预乘ARGB32逐字节兼容，可直接拷贝
+        blitRows(canvas, scaled, QPoint(left, top));
     }
     
-    qDebug() << "[ImageMerge] Final canvas size:" << canvas.size();
-    return QPixmap::fromImage(canvas);
+    qDebug() << "[ImageMerge] Final canvas size:" << canvas.size() << "in" << timer.elapsed() << "ms";
+    return canvas;
 }
 
-QPixmap ScreenshotTool::scaleToLogicalSize(const QPixmap &pixmap, const QSize &logicalSize) {
-    if (pixmap.size() == logicalSize) {
-        return pixmap;
+QImage ScreenshotTool::scaleToLogicalSize(const QImage &image, const QSize &targetSize) {
+    if (image.size() == targetSize) {
+        return image;
     }
-    return pixmap.scaled(logicalSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    const bool downscale = targetSize.width() < image.width() || targetSize.height() < image.height();
+    return ImageResampler::resample(image, targetSize,
+                                    downscale ? ImageResampler::FilterLanczos3 : ImageResampler::FilterBilinear);
+}
+
+void ScreenshotTool::startScrollCapture() {
+    m_scrollCapturePending = true;
+    ensureRegionSelector()->startSelection();
+}
+
+void ScreenshotTool::beginScrollSession(const QRect &rect) {
+    QSettings settings("CapStep", "Capture");
+    const int intervalMs = settings.value("scrollIntervalMs", 150).toInt();
+    const int maxHeight = settings.value("scrollMaxHeight", 60000).toInt();
+    const int previewMaxHeight = qMax(1, settings.value("scrollPreviewMaxHeight", 8192).toInt());
+
+    // 选择器隐藏后再开始截图，避免首帧截到遮罩
+    ScrollCapture *session = new ScrollCapture([this, rect]() { return captureRegion(rect); },
+                                               rect, intervalMs, maxHeight);
+    connect(session, &ScrollCapture::finished, this,
+            [this, previewMaxHeight](const QSharedPointer<TiledImage> &image, const QRect &region) {
+        m_lastCaptureTopLeft = region.topLeft();
+        if (image->height() <= previewMaxHeight) {
+            // 不太长的长图按普通截图处理：编辑窗口、剪贴板、历史记录
+            const QImage full = image->toImage();
+            m_pipeline->submit(ImageView(full), region.topLeft(), CapturePipeline::AllStages, region);
+            emit screenshotCaptured(full);
+            return;
+        }
+        // 更长的页面不合成整幅图像：历史记录按段写入全尺寸PNG，编辑窗口和剪贴板使用缩小的预览
+        const QImage preview = image->preview(previewMaxHeight);
+        if (preview.isNull()) {
+            qWarning() << "[Scroll] Failed to build preview for" << image->width() << "x" << image->height();
+            return;
+        }
+        qDebug() << "[Scroll] Page height" << image->height() << "exceeds" << previewMaxHeight
+                 << ", editor uses preview" << preview.size();
+        m_pipeline->submitTiled(image, preview, region.topLeft(), CapturePipeline::AllStages, region);
+        emit screenshotCaptured(preview);
+    });
+    QTimer::singleShot(100, session, &ScrollCapture::start);
 }
 
 void ScreenshotTool::startRegionCapture() {
+    m_scrollCapturePending = false;
+    // 热键触发时刻作为本次采集的起点
+    m_metricsCaptureId = CaptureMetrics::instance().beginCapture();
+    ensureRegionSelector()->startSelection();
+}
+
+RegionSelector *ScreenshotTool::ensureRegionSelector() {
     if (!m_regionSelector) {
         m_regionSelector = new RegionSelector();
         connect(m_regionSelector, &RegionSelector::regionSelected,
                 this, &ScreenshotTool::onRegionSelected);
         connect(m_regionSelector, &RegionSelector::selectionCancelled,
                 this, &ScreenshotTool::onSelectionCancelled);
+        connect(m_regionSelector, &RegionSelector::overlayLatencyMeasured, this,
+                [this](qint64 latencyNs, qint64 frameNs, bool warm) {
+            Q_UNUSED(latencyNs)
+            Q_UNUSED(frameNs)
+            Q_UNUSED(warm)
+            CaptureMetrics::instance().mark(m_metricsCaptureId, CaptureMetrics::StageOverlayVisible);
+        });
     }
-    
-    m_regionSelector->startSelection();
+    return m_regionSelector;
+}
+
+void ScreenshotTool::setWarmMode(bool enabled) {
+    QSettings settings("CapStep", "Capture");
+    settings.setValue("warmMode", enabled);
+    const int refreshMs = settings.value("warmRefreshMs", 500).toInt();
+    
+    // 关闭时不必为此创建选择器
+    if (enabled || m_regionSelector) {
+        ensureRegionSelector()->setWarmMode(enabled, refreshMs);
+    }
+}
+
+bool ScreenshotTool::isWarmMode() const {
+    return m_regionSelector && m_regionSelector->isWarmMode();
 }
 
 void ScreenshotTool::startDelayedCapture(int delayMs) {
@@ -238,7 +420,8 @@ void ScreenshotTool::startDelayedCapture(int delayMs) {
     QTimer *countdownTimer = new QTimer(countdownWidget);
     countdownTimer->setInterval(1000);
     
-    connect(countdownTimer, &QTimer::timeout, countdownWidget, [countdownLabel, &remainingSeconds]() {
+    // 计数按值捕获：本函数返回后局部变量即失效
+    connect(countdownTimer, &QTimer::timeout, countdownWidget, [countdownLabel, remainingSeconds]() mutable {
         remainingSeconds--;
         if (remainingSeconds > 0) {
             countdownLabel->setText(QString("准备弹窗\n%1").arg(remainingSeconds));
@@ -258,82 +441,91 @@ void ScreenshotTool::startDelayedCapture(int delayMs) {
     m_delayedCaptureTimer->start(delayMs);
 }
 
-QPixmap ScreenshotTool::captureFullScreen() {
-    qDebug() << "[FullScreenCapture] Starting full screen capture";
-    
-    // 获取所有屏幕
-    const QList<QScreen*> screens = QGuiApplication::screens();
-    if (screens.isEmpty()) {
-        qWarning() << "[FullScreenCapture] No screens found";
-        return QPixmap();
+bool ScreenshotTool::startBurstCapture(bool useLastRegion) {
+    if (m_burst->isRunning()) {
+        qWarning() << "[Burst] Burst capture already running";
+        return false;
+    }
+    if (useLastRegion && m_lastCaptureRect.isEmpty()) {
+        qWarning() << "[Burst] No previous region to capture";
+        return false;
     }
     
-    // 计算虚拟桌面总尺寸
-    QRect virtualRect = QGuiApplication::primaryScreen()->virtualGeometry();
-    qDebug() << "[FullScreenCapture] Virtual desktop geometry:" << virtualRect;
+    QSettings settings("CapStep", "Capture");
+    const int intervalMs = settings.value("burstIntervalMs", 1000).toInt();
+    const qint64 budgetBytes = qint64(settings.value("burstMemoryMB", 256).toInt()) << 20;
+    const int maxFrames = settings.value("burstMaxFrames", 0).toInt();
     
-    // 使用更底层的方式截取屏幕，确保能截取到所有内容
-    QPixmap fullScreenPixmap;
+    const QString outputDir = getScreenshotSaveDir()
+        + QString("/Burst_%1").arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"));
     
-    // 尝试使用 QScreen::grabWindow 截取整个虚拟桌面
-    QScreen *primaryScreen = QGuiApplication::primaryScreen();
-    if (primaryScreen) {
-        // 截取整个虚拟桌面
-        fullScreenPixmap = primaryScreen->grabWindow(0, 
-            virtualRect.x(), virtualRect.y(),
-            virtualRect.width(), virtualRect.height());
-        
-        qDebug() << "[FullScreenCapture] Virtual desktop captured, size:" << fullScreenPixmap.size();
+    // 每帧截取的临时图像在复制进环形缓冲后即释放
+    BurstCapture::GrabFunction grab;
+    if (useLastRegion) {
+        const QRect rect = m_lastCaptureRect;
+        grab = [this, rect]() { return captureRegion(rect); };
+    } else {
+        grab = [this]() { return captureFullScreen(); };
     }
+    return m_burst->start(grab, intervalMs, budgetBytes, outputDir, maxFrames);
+}
+
+void ScreenshotTool::stopBurstCapture() {
+    m_burst->stop();
+}
+
+bool ScreenshotTool::isBurstCapturing() const {
+    return m_burst->isRunning();
+}
+
+bool ScreenshotTool::hasLastCaptureRegion() const {
+    return !m_lastCaptureRect.isEmpty();
+}
+
+void ScreenshotTool::compactHistoryIndex() {
+    m_pipeline->compactHistoryIndex();
+}
+
+QString ScreenshotTool::getScreenshotSaveDir() const {
+    QString pictures = QStandardPaths::writableLocation(QStandardPaths::PicturesLocation);
+    if (pictures.isEmpty()) {
+        pictures = QDir::homePath();
+    }
+    return pictures + "/CapStep";
+}
+
+QImage ScreenshotTool::captureFullScreen() {
+    qDebug() << "[FullScreenCapture] Starting full screen capture";
     
-    // 如果虚拟桌面截图失败，回退到多屏截图
-    if (fullScreenPixmap.isNull()) {
-        qDebug() << "[FullScreenCapture] Virtual desktop capture failed, falling back to multi-screen capture";
-        
-        fullScreenPixmap = QPixmap(virtualRect.size());
-        fullScreenPixmap.fill(Qt::transparent);
-        
-        QPainter painter(&fullScreenPixmap);
-        
-        // 遍历所有屏幕进行截图
-        for (QScreen *screen : screens) {
-            if (!screen) continue;
-            
-            QRect screenGeo = screen->geometry();
-            qDebug() << "[FullScreenCapture] Capturing screen:" << screen->name() << "geometry:" << screenGeo;
-            
-            // 截取屏幕
-            QPixmap screenPixmap = screen->grabWindow(0);
-            
-            if (!screenPixmap.isNull()) {
-                // 计算在虚拟桌面中的位置
-                QPoint offset = screenGeo.topLeft() - virtualRect.topLeft();
-                painter.drawPixmap(offset, screenPixmap);
-                qDebug() << "[FullScreenCapture] Screen captured, offset:" << offset << "size:" << screenPixmap.size();
-            }
-        }
-        
-        painter.end();
+    // 整个虚拟桌面按区域截图处理：各屏分别抓取后直接合成，不经过QPixmap和QPainter
+    const QRect virtualRect = FrameSource::current()->virtualGeometry();
+    if (virtualRect.isEmpty()) {
+        qWarning() << "[FullScreenCapture] No screens found";
+        return QImage();
     }
+    qDebug() << "[FullScreenCapture] Virtual desktop geometry:" << virtualRect;
     
-    qDebug() << "[FullScreenCapture] Full screen capture completed, size:" << fullScreenPixmap.size();
-    return fullScreenPixmap;
+    QImage screenshot = captureRegion(virtualRect);
+    qDebug() << "[FullScreenCapture] Full screen capture completed, size:" << screenshot.size();
+    return screenshot;
 }
 
-bool ScreenshotTool::saveScreenshot(const QPixmap &pixmap, const QString &filePath) {
-    return pixmap.save(filePath);
+bool ScreenshotTool::saveScreenshot(const QImage &image, const QString &filePath) {
+    // 未编辑的截图已写入历史时直接复制文件；剪贴板已编码过时复用字节；
+    // 否则按扩展名编码（PNG多线程、QOI内置编码器、其他格式交给Qt）
+    return EncodedImageCache::instance().save(image, filePath);
 }
 
-void ScreenshotTool::showScreenshotEditWindow(const QPixmap &pixmap, const QPoint &initialPos) {
+void ScreenshotTool::showScreenshotEditWindow(const QImage &image, const QPoint &initialPos) {
     // 先创建窗口，不立刻决定位置
-    ScreenshotEditWindow *editWindow = new ScreenshotEditWindow(pixmap, QPoint());
+    ScreenshotEditWindow *editWindow = new ScreenshotEditWindow(image, QPoint());
     
     // 连接信号
-    connect(editWindow, &ScreenshotEditWindow::saveRequested, [this, editWindow](const QPixmap &screenshot) {
+    connect(editWindow, &ScreenshotEditWindow::saveRequested, [this, editWindow](const QImage &screenshot) {
         QString fileName = QFileDialog::getSaveFileName(
             editWindow, "保存截图", 
             QString("screenshot_%1.png").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")),
-            "PNG图片 (*.png);;JPEG图片 (*.jpg);;所有文件 (*.*)"
+            "PNG图片 (*.png);;JPEG图片 (*.jpg);;QOI图片 (*.qoi);;所有文件 (*.*)"
         );
         
         if (!fileName.isEmpty()) {
@@ -346,16 +538,17 @@ void ScreenshotTool::showScreenshotEditWindow(const QPixmap &pixmap, const QPoin
         m_lastEditPos = editWindow->pos();
     });
     
-    connect(editWindow, &ScreenshotEditWindow::copyRequested, [editWindow](const QPixmap &screenshot) {
-        QApplication::clipboard()->setPixmap(screenshot);
+    connect(editWindow, &ScreenshotEditWindow::copyRequested, [](const QImage &screenshot) {
+        ClipboardMimeData::publish(screenshot);
         // 复制后不弹出提示框
     });
     
-    connect(editWindow, &ScreenshotEditWindow::createStickyNoteRequested, [this, editWindow](const QPixmap &screenshot) {
+    connect(editWindow, &ScreenshotEditWindow::createStickyNoteRequested, [this, editWindow](const QImage &screenshot) {
         // 修复：使用编辑窗口的当前位置，而不是原始截图位置
         // 这样用户移动编辑窗口后，贴图会在移动后的位置创建
         QPoint posToUse = editWindow->pos();
         qDebug() << "[StickyNote] Using edit window position:" << posToUse;
+        // 贴图窗口共享同一份像素，绘制时才转换为QPixmap
         createStickyNote(screenshot, posToUse);
         m_lastEditPos = editWindow->pos();
         editWindow->deleteLater();
@@ -414,8 +607,8 @@ void ScreenshotTool::showScreenshotEditWindow(const QPixmap &pixmap, const QPoin
     m_lastEditPos = editWindow->pos();
 }
 
-void ScreenshotTool::createStickyNote(const QPixmap &pixmap, const QPoint &initialPos) {
-    StickyNoteWindow *stickyNote = new StickyNoteWindow(pixmap);
+void ScreenshotTool::createStickyNote(const QImage &screenshot, const QPoint &initialPos) {
+    StickyNoteWindow *stickyNote = new StickyNoteWindow(screenshot);
     
     // 贴图默认不置顶，避免遮挡对话框
     // 注意：构造函数已经设置了正确的窗口属性，这里不需要重新设置
@@ -429,11 +622,11 @@ void ScreenshotTool::createStickyNote(const QPixmap &pixmap, const QPoint &initi
         QString fileName = QFileDialog::getSaveFileName(
             stickyNote, "保存贴图", 
             QString("sticky_note_%1.png").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")),
-            "PNG图片 (*.png);;JPEG图片 (*.jpg);;所有文件 (*.*)"
+            "PNG图片 (*.png);;JPEG图片 (*.jpg);;QOI图片 (*.qoi);;所有文件 (*.*)"
         );
         
         if (!fileName.isEmpty()) {
-            if (saveScreenshot(stickyNote->getPixmap(), fileName)) {
+            if (saveScreenshot(stickyNote->getImage(), fileName)) {
                 // 成功后不弹出提示框
             } else {
                 QMessageBox::critical(stickyNote, "错误", "保存贴图失败！");
@@ -442,7 +635,7 @@ void ScreenshotTool::createStickyNote(const QPixmap &pixmap, const QPoint &initi
     });
     
     connect(stickyNote, &StickyNoteWindow::copyRequested, [stickyNote]() {
-        QApplication::clipboard()->setPixmap(stickyNote->getPixmap());
+        ClipboardMimeData::publish(stickyNote->getImage());
         // 复制后不弹出提示框
     });
     
@@ -464,66 +657,47 @@ void ScreenshotTool::onRegionSelected(const QRect &rect) {
         return;
     }
 
+    if (m_scrollCapturePending) {
+        m_scrollCapturePending = false;
+        if (m_regionSelector) {
+            m_regionSelector->releaseKeyboard();
+            m_regionSelector->releaseMouse();
+            m_regionSelector->hide();
+        }
+        m_lastCaptureRect = rect;
+        beginScrollSession(rect);
+        return;
+    }
+
+    const quint64 captureId = m_metricsCaptureId;
+    m_metricsCaptureId = 0;
+    CaptureMetrics::instance().mark(captureId, CaptureMetrics::StageSelectionConfirmed);
+
     auto rectStr = [](const QRect &r){ return QString("(%1,%2,%3x%4)").arg(r.x()).arg(r.y()).arg(r.width()).arg(r.height()); };
     qDebug() << "[Capture] onRegionSelected rect=" << rectStr(rect);
 
-    // 关键修复：从冻结的背景中截取选择的区域（单屏模式）
-    QPixmap screenshot;
-    if (m_regionSelector && !m_regionSelector->getFrozenBackground().isNull()) {
-        // 使用冻结的背景画面
-        QPixmap frozenBg = m_regionSelector->getFrozenBackground();
-        qreal dpr = frozenBg.devicePixelRatio();
-        
-        qDebug() << "[Capture] Using frozen background (single screen), size:" << frozenBg.size() 
-                 << "DPR:" << dpr
-                 << "logical size:" << (frozenBg.size() / dpr);
-        
-        // 获取选区所在屏幕的几何信息（使用选区左上角确定屏幕）
-        QScreen *currentScreen = QGuiApplication::screenAt(rect.topLeft());
-        if (!currentScreen) {
-            currentScreen = QGuiApplication::primaryScreen();
-        }
-        QRect screenGeometry = currentScreen->geometry();
-        
-        qDebug() << "[Capture] Screen:" << currentScreen->name()
-                 << "geometry:" << screenGeometry;
-        
-        // 将全局坐标转换为屏幕本地坐标（逻辑像素）
-        QRect captureRect = rect.translated(-screenGeometry.topLeft());
+    // 从冻结的虚拟桌面图集中截取选择的区域，跨屏选区也无需二次截屏
+    // 单屏选区只建立指向冻结画面的视图，不复制像素；下游真正写入时才复制
+    ImageView screenshot;
+    if (m_regionSelector && !m_regionSelector->frozenAtlas().isEmpty()) {
+        const QList<ScreenCaptureInfo> segments = m_regionSelector->frozenAtlas().segments(rect);
+        qDebug() << "[Capture] Using frozen atlas, segments:" << segments.size();
         
-        qDebug() << "[Capture] Capture rect (logical):" << captureRect
-                 << "screen geometry:" << screenGeometry
-                 << "selected rect:" << rect;
-        
-        // 根据DPR转换为设备像素坐标
-        QRect deviceCaptureRect;
-        if (dpr > 1.0) {
-            // 高DPI: 将逻辑像素坐标转换为设备像素坐标
-            deviceCaptureRect = QRect(
-                qRound(captureRect.x() * dpr),
-                qRound(captureRect.y() * dpr),
-                qRound(captureRect.width() * dpr),
-                qRound(captureRect.height() * dpr)
-            );
-            qDebug() << "[Capture] Device capture rect:" << deviceCaptureRect;
-        } else {
-            // 普通DPI: 直接使用逻辑像素
-            deviceCaptureRect = captureRect;
+        if (segments.size() == 1) {
+            // 单屏：零拷贝子视图，保持所在屏幕的DPR
+            screenshot = ImageView(segments.first().image);
+        } else if (segments.size() > 1) {
+            // 跨屏：各屏分段已在图集中，只需合成到逻辑画布
+            screenshot = ImageView(mergeMultiScreenCaptures(segments, rect.size()));
         }
         
-        // 从冻结的背景中截取（使用设备像素坐标）
-        screenshot = frozenBg.copy(deviceCaptureRect);
-        
-        // 保持原始DPR，确保高分辨率
-        screenshot.setDevicePixelRatio(dpr);
-        
         qDebug() << "[Capture] Screenshot size:" << screenshot.size() 
-                 << "DPR:" << screenshot.devicePixelRatio()
-                 << "logical size:" << (screenshot.size() / dpr);
-    } else {
-        // 回退：如果没有冻结背景，使用实时截图
-        qDebug() << "[Capture] No frozen background, using live capture";
-        screenshot = captureRegion(rect);
+                 << "DPR:" << screenshot.devicePixelRatio();
+    }
+    if (screenshot.isNull()) {
+        // 回退：如果没有冻结画面，使用实时截图
+        qDebug() << "[Capture] No frozen atlas, using live capture";
+        screenshot = ImageView(captureRegion(rect));
     }
 
     // 先隐藏选择器
@@ -534,49 +708,28 @@ void ScreenshotTool::onRegionSelected(const QRect &rect) {
     }
 
     if (!screenshot.isNull()) {
+        CaptureMetrics::instance().mark(captureId, CaptureMetrics::StageCropReady);
+        
         // 记录最新选择的区域左上角，供贴图使用
         m_lastCaptureTopLeft = rect.topLeft();
+        m_lastCaptureRect = rect;
         
-        // 修复：自动复制截图到剪贴板，用户可以直接Ctrl+V粘贴
-        QApplication::clipboard()->setPixmap(screenshot);
-        qDebug() << "[AutoCopy] Screenshot automatically copied to clipboard";
-        
-        // 自动保存到历史文件夹
-        saveToHistory(screenshot);
-        
-        // 编辑窗口位置：使用选区的全局坐标作为初始位置
-        showScreenshotEditWindow(screenshot, rect.topLeft());
+        // 流水线：编辑窗口立即显示（选区左上角作为初始位置），
+        // 历史PNG编码在工作线程完成，剪贴板发布排在编辑窗口之后。
+        // 编辑窗口在submit内同步显示，需先登记任务与采集的对应关系
+        const quint64 jobId = m_pipeline->nextJobId();
+        if (captureId) {
+            m_jobCaptures.insert(jobId, captureId);
+        }
+        m_pipeline->submit(screenshot, rect.topLeft(), CapturePipeline::AllStages, rect);
         // 同时通知外部（主窗口仅用于隐藏自身）
-        emit screenshotCaptured(screenshot);
+        emit screenshotCaptured(screenshot.image());
     }
 }
 
 void ScreenshotTool::onSelectionCancelled() {
     // 用户取消了区域选择
-}
-
-void ScreenshotTool::saveToHistory(const QPixmap &screenshot) {
-    // 获取历史截图文件夹路径
-    QString appData = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QString historyPath = appData + "/ScreenshotHistory/images";
-    
-    // 确保目录存在
-    QDir dir;
-    if (!dir.exists(historyPath)) {
-        if (!dir.mkpath(historyPath)) {
-            qWarning() << "[History] Failed to create history folder:" << historyPath;
-            return;
-        }
-    }
-    
-    // 生成文件名：年月日_时分秒.png
-    QString fileName = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") + ".png";
-    QString filePath = historyPath + "/" + fileName;
-    
-    // 保存截图
-    if (screenshot.save(filePath)) {
-        qDebug() << "[History] Screenshot saved to:" << filePath;
-    } else {
-        qWarning() << "[History] Failed to save screenshot to:" << filePath;
-    }
+    m_scrollCapturePending = false;
+    CaptureMetrics::instance().endCapture(m_metricsCaptureId);
+    m_metricsCaptureId = 0;
 }
@@ -31,7 +31,7 @@
 #define SCREENSHOTTOOL_H
 
 #include <QObject>
-#include <QPixmap>
+#include <QImage>
 #include <QRect>
 #include <QPoint>
 #include <QList>
@@ -43,21 +43,16 @@
 #include <QDir>
 #include <QStandardPaths>
 #include <QDebug>
+#include <QHash>
+#include "ImageView.h"
+#include "FrozenAtlas.h"
+#include "ImageResampler.h"
 
 class RegionSelector;
 class ScreenshotEditWindow;
 class StickyNoteWindow;
-
-/**
- * @struct ScreenCaptureInfo
- * @brief 屏幕截图信息结构体
- * 
- * 用于存储单个屏幕的截图数据和其在全局坐标系中的位置
- */
-struct ScreenCaptureInfo {
-    QPixmap pixmap;        ///< 屏幕截图
-    QPoint globalPos;      ///< 在全局坐标系中的位置
-};
+class CapturePipeline;
+class BurstCapture;
 
 /**
  * @class ScreenshotTool
@@ -78,32 +73,99 @@ class ScreenshotTool : public QObject
     Q_OBJECT
 
 public:
+    /**
+     * @brief 跨屏合成模式
+     */
+    enum MergeMode {
+        MergeLogical,       ///< 合成到逻辑尺寸（DPR=1），高DPI屏幕上的内容会被缩小
+        MergeNativeDpr      ///< 合成到所有分段中最高的DPR，低DPI分段放大，高DPI细节不丢失
+    };
+
     explicit ScreenshotTool(QObject *parent = nullptr);
     ~ScreenshotTool();
 
+    /**
+     * @brief 设置跨屏合成模式（持久化到设置）
+     * @param mode 合成模式
+     */
+    void setMergeMode(MergeMode mode);
+
+    /**
+     * @brief 获取跨屏合成模式
+     * @return 合成模式
+     */
+    MergeMode mergeMode() const { return m_mergeMode; }
+
+    /**
+     * @brief 启用/关闭预热截图模式（持久化到设置）
+     *
+     * 预热模式下区域选择器常驻并定时刷新屏幕快照，热键到覆盖层显示的延迟可降到一帧以内，
+     * 代价是后台定期截屏的开销
+     *
+     * @param enabled 是否启用
+     */
+    void setWarmMode(bool enabled);
+
+    /**
+     * @brief 是否处于预热截图模式
+     */
+    bool isWarmMode() const;
+
     /**
      * @brief 开始延迟截图（用于截取弹窗）
      * @param delayMs 延迟时间（毫秒）
      */
     void startDelayedCapture(int delayMs = 1000);
 
+    /**
+     * @brief 开始连拍（按设置的间隔截图，写入环形缓冲后由后台线程落盘）
+     * @param useLastRegion true截取上次选区，false截取全屏
+     * @return 是否成功开始
+     */
+    bool startBurstCapture(bool useLastRegion);
+
+    /**
+     * @brief 停止连拍（已缓冲的帧会继续写完）
+     */
+    void stopBurstCapture();
+
+    /**
+     * @brief 是否正在连拍
+     */
+    bool isBurstCapturing() const;
+
+    /**
+     * @brief 是否有可用于连拍的上次选区
+     */
+    bool hasLastCaptureRegion() const;
+
+    /**
+     * @brief 重写历史索引（去掉已删除的截图、补录未索引的文件），在历史写入线程中执行
+     */
+    void compactHistoryIndex();
+
+    /**
+     * @brief 开始滚动长截图（先选择区域，再边滚动边拼接）
+     */
+    void startScrollCapture();
+
     /**
      * @brief 开始区域截图
      */
     void startRegionCapture();
 
     /**
-     * @brief 执行全屏截图
-     * @return 截图结果
+     * @brief 执行全屏截图（整个虚拟桌面）
+     * @return 截图结果（设备像素，带DPR）
      */
-    QPixmap captureFullScreen();
+    QImage captureFullScreen();
 
     /**
      * @brief 捕获指定区域
      * @param globalRect 全局坐标矩形
-     * @return 截图结果
+     * @return 截图结果（设备像素，带DPR）
      */
-    QPixmap captureRegion(const QRect &globalRect);
+    QImage captureRegion(const QRect &globalRect);
 
     /**
      * @brief 保存截图到文件
@@ -111,43 +173,43 @@ public:
      * @param filePath 文件路径
      * @return 是否保存成功
      */
-    bool saveScreenshot(const QPixmap &screenshot, const QString &filePath);
-
-    /**
-     * @brief 复制截图到剪贴板
-     * @param screenshot 要复制的截图
-     */
-    void copyScreenshot(const QPixmap &screenshot);
+    bool saveScreenshot(const QImage &screenshot, const QString &filePath);
 
     /**
      * @brief 创建贴图窗口
      * @param screenshot 要贴图的截图
      * @param position 贴图位置
      */
-    void createStickyNote(const QPixmap &screenshot, const QPoint &position);
+    void createStickyNote(const QImage &screenshot, const QPoint &position);
     
     /**
      * @brief 多屏截图图像合成
+     *
+     * 各分段按合成模式的目标DPR重采样后直接逐行拷贝到画布，不经过QPainter
+     *
      * @param captures 屏幕截图信息列表
      * @param logicalSize 逻辑尺寸
-     * @return 合成后的截图
+     * @return 合成后的截图（DPR为目标DPR）
      */
-    QPixmap mergeMultiScreenCaptures(const QList<ScreenCaptureInfo> &captures, const QSize &logicalSize);
+    QImage mergeMultiScreenCaptures(const QList<ScreenCaptureInfo> &captures, const QSize &logicalSize);
     
     /**
-     * @brief 将截图缩放到逻辑尺寸
-     * @param pixmap 原始截图
-     * @param logicalSize 目标逻辑尺寸
+     * @brief 将截图缩放到指定像素尺寸
+     *
+     * 缩小使用Lanczos3保留细节，放大使用双线性避免振铃
+     *
+     * @param image 原始截图
+     * @param targetSize 目标像素尺寸
      * @return 缩放后的截图
      */
-    QPixmap scaleToLogicalSize(const QPixmap &pixmap, const QSize &logicalSize);
+    QImage scaleToLogicalSize(const QImage &image, const QSize &targetSize);
 
 signals:
     /**
      * @brief 截图完成信号
      * @param screenshot 截图结果
      */
-    void screenshotCaptured(const QPixmap &screenshot);
+    void screenshotCaptured(const QImage &screenshot);
 
     /**
      * @brief 编辑窗口关闭信号
@@ -159,6 +221,21 @@ signals:
      */
     void stickyNoteClosed();
 
+    /**
+     * @brief 连拍结束信号
+     * @param outputDir 输出目录
+     * @param captured 截取的帧数
+     * @param written 写入的帧数
+     * @param dropped 丢弃的帧数
+     */
+    void burstCaptureFinished(const QString &outputDir, int captured, int written, int dropped);
+
+    /**
+     * @brief 历史写入跟不上，丢弃了尚未保存的截图
+     * @param count 丢弃的截图数
+     */
+    void historyDropped(int count);
+
 private slots:
     /**
      * @brief 区域选择完成处理
@@ -177,9 +254,21 @@ public:
      * @param screenshot 截图
      * @param position 窗口位置
      */
-    void showScreenshotEditWindow(const QPixmap &screenshot, const QPoint &position);
+    void showScreenshotEditWindow(const QImage &screenshot, const QPoint &position);
 
 private:
+    /**
+     * @brief 创建区域选择器（已存在时直接返回）
+     * @return 区域选择器
+     */
+    RegionSelector *ensureRegionSelector();
+
+    /**
+     * @brief 在选区上启动滚动拼接
+     * @param rect 选区（全局逻辑坐标）
+     */
+    void beginScrollSession(const QRect &rect);
+
     /**
      * @brief 生成默认文件名
      * @return 文件名
@@ -191,12 +280,6 @@ private:
      * @return 保存目录路径
      */
     QString getScreenshotSaveDir() const;
-    
-    /**
-     * @brief 保存截图到历史文件夹
-     * @param screenshot 要保存的截图
-     */
-    void saveToHistory(const QPixmap &screenshot);
 
 private:
     RegionSelector *m_regionSelector;    ///< 区域选择器
@@ -205,6 +288,13 @@ private:
     QPoint m_lastCaptureTopLeft;               ///< 最近一次选区左上角
     QPoint m_lastEditPos;                      ///< 最近一次编辑窗口位置
     QTimer *m_delayedCaptureTimer;             ///< 延迟截图定时器
+    CapturePipeline *m_pipeline;               ///< 截图后处理流水线
+    MergeMode m_mergeMode;                     ///< 跨屏合成模式
+    quint64 m_metricsCaptureId;                ///< 当前区域截图的统计采集ID
+    QHash<quint64, quint64> m_jobCaptures;     ///< 流水线任务ID → 统计采集ID
+    BurstCapture *m_burst;                     ///< 连拍
+    QRect m_lastCaptureRect;                   ///< 最近一次选区（全局逻辑坐标）
+    bool m_scrollCapturePending;               ///< 下一次选区用于滚动长截图
 };
 
 #endif // SCREENSHOTTOOL_H
@@ -0,0 +1,203 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ScrollCapture.cpp
+ * @brief 滚动长截图控制条实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "ScrollCapture.h"
+#include <QTimer>
+#include <QLabel>
+#include <QPushButton>
+#include <QHBoxLayout>
+#include <QKeyEvent>
+#include <QScreen>
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QDebug>
+
+ScrollCapture::ScrollCapture(const GrabFunction &grab, const QRect &region, int intervalMs, int maxHeight,
+                             QWidget *parent)
+    : QWidget(parent, Qt::Tool | Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint)
+    , m_grab(grab)
+    , m_region(region)
+    , m_stitcher(maxHeight)
+    , m_timer(nullptr)
+    , m_statusLabel(nullptr)
+    , m_finishBtn(nullptr)
+    , m_cancelBtn(nullptr)
+    , m_frames(0)
+    , m_done(false)
+{
+    setAttribute(Qt::WA_DeleteOnClose);
+    setAttribute(Qt::WA_StyledBackground);
+    setStyleSheet("ScrollCapture { background-color: rgba(40, 40, 45, 235); border-radius: 6px; }");
+
+    m_statusLabel = new QLabel("请滚动选区内的内容", this);
+    m_statusLabel->setStyleSheet("QLabel { color: #FFFFFF; font-size: 12px; padding: 0 6px; }");
+    m_statusLabel->setMinimumWidth(160);
+
+    const QString btnStyle = "QPushButton { "
+                             "background-color: rgba(240, 240, 245, 230); "
+                             "color: #333; "
+                             "border: 1px solid rgba(0, 0, 0, 80); "
+                             "padding: 4px 12px; "
+                             "border-radius: 6px; "
+                             "font-size: 12px; "
+                             "} "
+                             "QPushButton:hover { "
+                             "background-color: rgba(230, 230, 240, 250); "
+                             "} ";
+    m_finishBtn = new QPushButton("完成", this);
+    m_cancelBtn = new QPushButton("取消", this);
+    m_finishBtn->setStyleSheet(btnStyle);
+    m_cancelBtn->setStyleSheet(btnStyle);
+
+    QHBoxLayout *layout = new QHBoxLayout(this);
+    layout->setContentsMargins(8, 6, 8, 6);
+    layout->setSpacing(6);
+    layout->addWidget(m_statusLabel);
+    layout->addWidget(m_finishBtn);
+    layout->addWidget(m_cancelBtn);
+
+    connect(m_finishBtn, &QPushButton::clicked, this, &ScrollCapture::finish);
+    connect(m_cancelBtn, &QPushButton::clicked, this, &ScrollCapture::cancel);
+
+    m_timer = new QTimer(this);
+    m_timer->setInterval(qMax(intervalMs, 30));
+    connect(m_timer, &QTimer::timeout, this, &ScrollCapture::captureFrame);
+}
+
+ScrollCapture::~ScrollCapture()
+{
+    m_timer->stop();
+}
+
+void ScrollCapture::start() {
+    adjustSize();
+    placeBesideRegion();
+    show();
+    raise();
+    activateWindow();
+
+    qDebug() << "[Scroll] Started, region:" << m_region << "interval:" << m_timer->interval() << "ms";
+    captureFrame();
+    m_timer->start();
+}
+
+void ScrollCapture::placeBesideRegion() {
+    QScreen *screen = QGuiApplication::screenAt(m_region.center());
+    if (!screen) {
+        screen = QGuiApplication::primaryScreen();
+    }
+    const QRect available = screen->availableGeometry();
+    const int margin = 6;
+
+    int x = qBound(available.left(), m_region.right() - width() + 1, available.right() - width() + 1);
+    int y = m_region.bottom() + 1 + margin;
+    if (y + height() > available.bottom() + 1) {
+        y = m_region.top() - margin - height();
+    }
+    if (y < available.top()) {
+        // 上下都放不下：放在选区内部右上角，固定不动的控制条会被识别为页眉
+        y = m_region.top() + margin;
+        x = m_region.right() - width() - margin;
+    }
+    move(x, y);
+}
+
+void ScrollCapture::captureFrame() {
+    if (m_done) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QImage frame = m_grab ? m_grab() : QImage();
+    if (frame.isNull()) {
+        qWarning() << "[Scroll] Grab failed";
+        return;
+    }
+    const ScrollStitcher::Status status = m_stitcher.addFrame(frame);
+    ++m_frames;
+
+    const int height = m_stitcher.height();
+    switch (status) {
+    case ScrollStitcher::FrameAppended:
+        m_statusLabel->setText(QString("已拼接 %1 像素").arg(height));
+        break;
+    case ScrollStitcher::FrameNoOverlap:
+        m_statusLabel->setText(QString("已拼接 %1 像素（滚动过快）").arg(height));
+        break;
+    default:
+        break;
+    }
+    qDebug() << "[Scroll] Frame" << m_frames << "status:" << status << "offset:" << m_stitcher.lastOffset()
+             << "height:" << height << "cost:" << timer.elapsed() << "ms";
+
+    if (m_stitcher.isFull()) {
+        qDebug() << "[Scroll] Reached max height, finishing";
+        finish();
+    }
+}
+
+void ScrollCapture::finish() {
+    if (m_done) {
+        return;
+    }
+    m_timer->stop();
+    m_done = true;
+    hide();
+
+    m_stitcher.finish();
+    const QSharedPointer<TiledImage> image = m_stitcher.result();
+    qDebug() << "[Scroll] Finished, frames:" << m_frames << "height:" << (image ? image->height() : 0);
+
+    if (!image || image->height() == 0) {
+        emit cancelled();
+    } else {
+        emit finished(image, m_region);
+    }
+    close();
+}
+
+void ScrollCapture::cancel() {
+    if (m_done) {
+        return;
+    }
+    m_timer->stop();
+    m_done = true;
+    qDebug() << "[Scroll] Cancelled";
+    emit cancelled();
+    close();
+}
+
+void ScrollCapture::keyPressEvent(QKeyEvent *event) {
+    if (event->key() == Qt::Key_Escape) {
+        cancel();
+    } else if (event->key() == Qt::Key_Return || event->key() == Qt::Key_Enter) {
+        finish();
+    } else {
+        QWidget::keyPressEvent(event);
+    }
+}
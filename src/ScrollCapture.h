@@ -0,0 +1,129 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ScrollCapture.h
+ * @brief 滚动长截图控制条
+ *
+ * 在选区旁显示一个小控制条，定时截取选区交给 ScrollStitcher 拼接，
+ * 用户滚动内容后点击“完成”得到长图
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef SCROLLCAPTURE_H
+#define SCROLLCAPTURE_H
+
+#include <QWidget>
+#include <QImage>
+#include <QRect>
+#include <QSharedPointer>
+#include <functional>
+#include "ScrollStitcher.h"
+
+class QTimer;
+class QLabel;
+class QPushButton;
+
+/**
+ * @class ScrollCapture
+ * @brief 滚动长截图控制条
+ *
+ * - 控制条放在选区外侧，避免被截进画面
+ * - 每个定时周期截取一次选区并拼接，状态栏显示当前长度
+ * - 达到高度上限时自动结束
+ * - 结果以分块图像输出，不合成整幅长图
+ */
+class ScrollCapture : public QWidget
+{
+    Q_OBJECT
+
+public:
+    /// 截取选区的函数（在GUI线程调用）
+    using GrabFunction = std::function<QImage()>;
+
+    /**
+     * @brief 构造函数
+     * @param grab 截取选区的函数
+     * @param region 选区（全局逻辑坐标，用于放置控制条）
+     * @param intervalMs 截图间隔（毫秒）
+     * @param maxHeight 长图最大高度（设备像素）
+     * @param parent 父窗口
+     */
+    ScrollCapture(const GrabFunction &grab, const QRect &region, int intervalMs, int maxHeight,
+                  QWidget *parent = nullptr);
+    ~ScrollCapture();
+
+    /**
+     * @brief 显示控制条并开始截图
+     */
+    void start();
+
+signals:
+    /**
+     * @brief 长截图完成
+     * @param image 拼接结果（分块图像，按需用 copy()/preview() 读取）
+     * @param region 选区
+     */
+    void finished(const QSharedPointer<TiledImage> &image, const QRect &region);
+
+    /**
+     * @brief 长截图取消
+     */
+    void cancelled();
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override;
+
+private slots:
+    /**
+     * @brief 截取一帧并拼接
+     */
+    void captureFrame();
+
+    /**
+     * @brief 结束拼接并输出结果
+     */
+    void finish();
+
+    /**
+     * @brief 放弃拼接
+     */
+    void cancel();
+
+private:
+    /**
+     * @brief 把控制条放到选区下方（放不下时放在上方）
+     */
+    void placeBesideRegion();
+
+private:
+    GrabFunction m_grab;            ///< 截取选区的函数
+    QRect m_region;                 ///< 选区
+    ScrollStitcher m_stitcher;      ///< 拼接引擎
+    QTimer *m_timer;                ///< 截图定时器
+    QLabel *m_statusLabel;          ///< 状态
+    QPushButton *m_finishBtn;       ///< 完成
+    QPushButton *m_cancelBtn;       ///< 取消
+    int m_frames;                   ///< 已处理帧数
+    bool m_done;                    ///< 是否已结束
+};
+
+#endif // SCROLLCAPTURE_H
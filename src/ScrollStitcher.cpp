@@ -0,0 +1,389 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ScrollStitcher.cpp
+ * @brief 滚动长截图拼接引擎实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "ScrollStitcher.h"
+#include "SimdSupport.h"
+#include <QHash>
+#include <QDebug>
+
+namespace {
+
+constexpr int kTileRows = 512;              ///< 输出分块行数
+constexpr int kResidentTiles = 8;           ///< 输出常驻分块数
+constexpr int kMinWindowRows = 4;           ///< 匹配窗口最小行数
+constexpr int kMaxWindowRows = 32;          ///< 匹配窗口最大行数
+constexpr int kMaxAnchorHits = 8;           ///< 窗口哈希出现次数超过该值视为重复图案，不作锚点
+constexpr double kMinMatchRatio = 0.6;      ///< 候选偏移的最低行匹配率
+constexpr double kStillMatchRatio = 0.9;    ///< 判定为未滚动的行匹配率
+constexpr quint64 kWindowBase = 0x100000001B3ull;
+
+// ---------------------------------------------------------------------------
+// 逐行哈希：4条32位通道做Fletcher式累加（a += 像素, b += a），
+// 像素x落在通道 x % 4，SIMD与标量路径结果逐位一致
+// ---------------------------------------------------------------------------
+
+inline quint64 mix64(quint64 h)
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+quint64 finalizeRow(const quint32 *a, const quint32 *b, int width)
+{
+    quint64 h = mix64(quint64(width));
+    for (int i = 0; i < 4; ++i) {
+        h = mix64(h ^ ((quint64(b[i]) << 32) | a[i]));
+    }
+    return h;
+}
+
+void accumulateTail(const quint32 *pixels, int from, int width, quint32 *a, quint32 *b)
+{
+    for (int x = from; x < width; x += 4) {
+        const int lanes = qMin(4, width - x);
+        for (int j = 0; j < lanes; ++j) {
+            a[j] += pixels[x + j];
+            b[j] += a[j];
+        }
+    }
+}
+
+quint64 hashRowScalar(const quint32 *pixels, int width)
+{
+    quint32 a[4] = {0, 0, 0, 0};
+    quint32 b[4] = {0, 0, 0, 0};
+    accumulateTail(pixels, 0, width, a, b);
+    return finalizeRow(a, b, width);
+}
+
+#if defined(CAPSTEP_SIMD_SSE2)
+quint64 hashRowSse2(const quint32 *pixels, int width)
+{
+    __m128i va = _mm_setzero_si128();
+    __m128i vb = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        va = _mm_add_epi32(va, _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + x)));
+        vb = _mm_add_epi32(vb, va);
+    }
+    quint32 a[4];
+    quint32 b[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(a), va);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(b), vb);
+    accumulateTail(pixels, x, width, a, b);
+    return finalizeRow(a, b, width);
+}
+#endif
+
+#if defined(CAPSTEP_SIMD_NEON)
+quint64 hashRowNeon(const quint32 *pixels, int width)
+{
+    uint32x4_t va = vdupq_n_u32(0);
+    uint32x4_t vb = vdupq_n_u32(0);
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        va = vaddq_u32(va, vld1q_u32(pixels + x));
+        vb = vaddq_u32(vb, va);
+    }
+    quint32 a[4];
+    quint32 b[4];
+    vst1q_u32(a, va);
+    vst1q_u32(b, vb);
+    accumulateTail(pixels, x, width, a, b);
+    return finalizeRow(a, b, width);
+}
+#endif
+
+using HashRowFn = quint64 (*)(const quint32 *, int);
+
+HashRowFn selectHashRow()
+{
+#if defined(CAPSTEP_SIMD_SSE2)
+    if (SimdSupport::hasSse2()) {
+        return hashRowSse2;
+    }
+#endif
+#if defined(CAPSTEP_SIMD_NEON)
+    if (SimdSupport::hasNeon()) {
+        return hashRowNeon;
+    }
+#endif
+    return hashRowScalar;
+}
+
+bool isStitchableFormat(QImage::Format format)
+{
+    return format == QImage::Format_RGB32 || format == QImage::Format_ARGB32
+        || format == QImage::Format_ARGB32_Premultiplied;
+}
+
+/**
+ * @brief 行哈希序列上的滚动窗口哈希（Rabin-Karp）
+ * @return 每个起始位置 p ∈ [from, to] 的窗口哈希（下标相对 from）
+ */
+QVector<quint64> windowHashes(const QVector<quint64> &rows, int from, int to, int window)
+{
+    QVector<quint64> result;
+    if (to < from) {
+        return result;
+    }
+    result.reserve(to - from + 1);
+
+    quint64 highPower = 1;
+    for (int i = 1; i < window; ++i) {
+        highPower *= kWindowBase;
+    }
+    quint64 h = 0;
+    for (int i = 0; i < window; ++i) {
+        h = h * kWindowBase + rows.at(from + i);
+    }
+    result.append(h);
+    for (int p = from + 1; p <= to; ++p) {
+        h = (h - rows.at(p - 1) * highPower) * kWindowBase + rows.at(p + window - 1);
+        result.append(h);
+    }
+    return result;
+}
+
+} // namespace
+
+ScrollStitcher::ScrollStitcher(int maxHeight)
+    : m_maxHeight(qMax(maxHeight, 0))
+    , m_previous()
+    , m_previousHashes()
+    , m_output()
+    , m_pendingFrom(0)
+    , m_lastOffset(0)
+    , m_finished(false)
+{
+}
+
+ScrollStitcher::~ScrollStitcher()
+{
+}
+
+QVector<quint64> ScrollStitcher::rowHashes(const QImage &image) {
+    QVector<quint64> hashes;
+    if (image.isNull() || image.depth() != 32) {
+        return hashes;
+    }
+    static const HashRowFn hashRow = selectHashRow();
+    hashes.resize(image.height());
+    for (int y = 0; y < image.height(); ++y) {
+        hashes[y] = hashRow(reinterpret_cast<const quint32 *>(image.constScanLine(y)), image.width());
+    }
+    return hashes;
+}
+
+int ScrollStitcher::height() const {
+    int h = m_output ? m_output->height() : 0;
+    if (!m_finished && !m_previous.isNull()) {
+        h += m_previous.height() - m_pendingFrom;
+    }
+    return h;
+}
+
+void ScrollStitcher::reset() {
+    m_output.reset();
+    m_previous = QImage();
+    m_previousHashes.clear();
+    m_pendingFrom = 0;
+    m_lastOffset = 0;
+    m_finished = false;
+}
+
+ScrollStitcher::Status ScrollStitcher::addFrame(const QImage &input) {
+    if (m_finished || input.isNull()) {
+        return FrameRejected;
+    }
+
+    QImage frame = input;
+    if (!m_output) {
+        if (!isStitchableFormat(frame.format())) {
+            frame = frame.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        }
+        m_output.reset(new TiledImage(frame.width(), frame.format(), kTileRows, kResidentTiles));
+        m_output->setDevicePixelRatio(frame.devicePixelRatio());
+        m_previous = frame;
+        m_previousHashes = rowHashes(frame);
+        m_pendingFrom = 0;
+        m_lastOffset = 0;
+        return FrameFirst;
+    }
+
+    if (frame.size() != m_previous.size()) {
+        qWarning() << "[Scroll] Frame size changed from" << m_previous.size() << "to" << frame.size();
+        return FrameRejected;
+    }
+    if (isFull()) {
+        return FrameRejected;
+    }
+    if (frame.format() != m_output->format()) {
+        frame = frame.convertToFormat(m_output->format());
+    }
+
+    const QVector<quint64> hashes = rowHashes(frame);
+    const int h = frame.height();
+
+    // 固定区域：从顶部/底部开始逐行相同的部分（各自最多三分之一，避免把留白误判为页眉）
+    const int limit = h / 3;
+    int top = 0;
+    while (top < limit && hashes.at(top) == m_previousHashes.at(top)) {
+        ++top;
+    }
+    int bottom = 0;
+    while (bottom < limit && hashes.at(h - 1 - bottom) == m_previousHashes.at(h - 1 - bottom)) {
+        ++bottom;
+    }
+    const int end = h - bottom;
+
+    const int offset = findOffset(hashes, top, end);
+    if (offset <= 0) {
+        int same = 0;
+        for (int y = 0; y < h; ++y) {
+            same += hashes.at(y) == m_previousHashes.at(y);
+        }
+        m_lastOffset = 0;
+        return same >= h * kStillMatchRatio ? FrameNoMotion : FrameNoOverlap;
+    }
+
+    // 上一帧滚动区内尚未输出的行（第一帧的页眉和内容在此输出）。
+    // 留白行在单帧对比中无法与页脚区分，被误判为页脚的行会推迟到这里或 finish() 输出
+    if (m_pendingFrom < end) {
+        if (!emitRows(m_previous, m_pendingFrom, end - m_pendingFrom)) {
+            return FrameRejected;
+        }
+        m_pendingFrom = end;
+    }
+
+    // 新帧第y行对应上一帧第y+offset行，上一帧已输出到第 m_pendingFrom 行
+    const int start = qMax(top, m_pendingFrom - offset);
+    if (start < end && !emitRows(frame, start, end - start)) {
+        return FrameRejected;
+    }
+
+    m_previous = frame;
+    m_previousHashes = hashes;
+    m_pendingFrom = qMax(end, m_pendingFrom - offset);
+    m_lastOffset = offset;
+    return FrameAppended;
+}
+
+int ScrollStitcher::findOffset(const QVector<quint64> &current, int top, int end) const {
+    const int zone = end - top;
+    const int window = qBound(kMinWindowRows, zone / 8, kMaxWindowRows);
+    if (zone < window * 2) {
+        return 0;
+    }
+
+    // 上一帧滚动区内所有窗口位置
+    const int lastStart = end - window;
+    const QVector<quint64> previousWindows = windowHashes(m_previousHashes, top, lastStart, window);
+    QMultiHash<quint64, int> positions;
+    positions.reserve(previousWindows.size());
+    for (int i = 0; i < previousWindows.size(); ++i) {
+        positions.insert(previousWindows.at(i), top + i);
+    }
+    const QVector<quint64> currentWindows = windowHashes(current, top, lastStart, window);
+
+    QHash<int, double> scored;
+    int bestOffset = 0;
+    double bestRatio = 0.0;
+
+    auto score = [&](int offset) {
+        if (scored.contains(offset)) {
+            return;
+        }
+        const int overlap = end - offset - top;
+        int matches = 0;
+        for (int y = top; y < end - offset; ++y) {
+            matches += current.at(y) == m_previousHashes.at(y + offset);
+        }
+        const double ratio = overlap > 0 ? double(matches) / overlap : 0.0;
+        scored.insert(offset, ratio);
+        // 匹配率相同时取较小的偏移（重叠更多）
+        if (ratio > bestRatio || (ratio == bestRatio && offset < bestOffset)) {
+            bestRatio = ratio;
+            bestOffset = offset;
+        }
+    };
+
+    // 从滚动区顶部、1/4、1/2处各找一个有区分度的锚点窗口（跳过纯色和重复图案）
+    const int anchorStarts[] = { top, top + zone / 4, top + zone / 2 };
+    for (int anchorStart : anchorStarts) {
+        for (int a = anchorStart; a <= lastStart - 1; ++a) {
+            const int hits = int(positions.count(currentWindows.at(a - top)));
+            if (hits == 0 || hits > kMaxAnchorHits) {
+                continue;
+            }
+            bool uniform = true;
+            for (int i = 1; i < window && uniform; ++i) {
+                uniform = current.at(a + i) == current.at(a);
+            }
+            if (uniform) {
+                continue;
+            }
+
+            const auto range = positions.equal_range(currentWindows.at(a - top));
+            for (auto it = range.first; it != range.second; ++it) {
+                const int offset = it.value() - a;
+                if (offset > 0 && end - offset - top >= window) {
+                    score(offset);
+                }
+            }
+            break;
+        }
+    }
+
+    return bestRatio >= kMinMatchRatio ? bestOffset : 0;
+}
+
+bool ScrollStitcher::emitRows(const QImage &frame, int y, int rows) {
+    if (m_maxHeight > 0) {
+        rows = qMin(rows, m_maxHeight - m_output->height());
+    }
+    if (rows <= 0) {
+        return true;
+    }
+    return m_output->appendRows(frame, y, rows);
+}
+
+void ScrollStitcher::finish() {
+    if (m_finished) {
+        return;
+    }
+    if (m_output && !m_previous.isNull() && m_pendingFrom < m_previous.height()) {
+        emitRows(m_previous, m_pendingFrom, m_previous.height() - m_pendingFrom);
+    }
+    m_previous = QImage();
+    m_previousHashes.clear();
+    m_finished = true;
+}
@@ -0,0 +1,147 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ScrollStitcher.h
+ * @brief 滚动长截图拼接引擎
+ *
+ * 对同一区域连续截取的帧计算逐行哈希，通过行哈希序列的滚动匹配求出滚动距离，
+ * 把新出现的行追加到分块图像。不依赖屏幕或窗口，可直接用合成帧序列驱动
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef SCROLLSTITCHER_H
+#define SCROLLSTITCHER_H
+
+#include <QImage>
+#include <QVector>
+#include <QSharedPointer>
+#include "TiledImage.h"
+
+/**
+ * @class ScrollStitcher
+ * @brief 滚动长截图拼接引擎
+ *
+ * 每帧与上一帧比较：
+ * - 顶部/底部逐行哈希相同的行视为固定区域（页眉、页脚、工具栏），只输出一次
+ * - 中间滚动区以若干连续行的哈希窗口做Rabin-Karp滚动匹配，候选偏移再用逐行哈希打分确认
+ * - 只追加新出现的行，结果流式写入 TiledImage，内存中只保留上一帧
+ */
+class ScrollStitcher
+{
+public:
+    /**
+     * @brief 单帧处理结果
+     */
+    enum Status {
+        FrameFirst,         ///< 第一帧（作为基准）
+        FrameAppended,      ///< 检测到滚动并追加了新行
+        FrameNoMotion,      ///< 内容没有滚动
+        FrameNoOverlap,     ///< 与上一帧没有可靠重叠（滚动过快或内容变化），已忽略
+        FrameRejected,      ///< 尺寸不一致或已达到高度上限，已忽略
+    };
+
+    /**
+     * @brief 构造函数
+     * @param maxHeight 拼接结果的最大高度（像素，0表示不限制）
+     */
+    explicit ScrollStitcher(int maxHeight = 0);
+    ~ScrollStitcher();
+
+    /**
+     * @brief 添加一帧
+     * @param frame 同一区域的截图（尺寸需与第一帧一致）
+     * @return 处理结果
+     */
+    Status addFrame(const QImage &frame);
+
+    /**
+     * @brief 结束拼接，输出最后一帧的底部固定区域
+     *
+     * 调用后不能再添加帧；调用 reset() 可重新开始
+     */
+    void finish();
+
+    /**
+     * @brief 重置状态，丢弃已拼接内容
+     */
+    void reset();
+
+    /**
+     * @brief 最近一帧检测到的滚动距离（像素）
+     */
+    int lastOffset() const { return m_lastOffset; }
+
+    /**
+     * @brief 当前拼接高度（包括尚未输出的上一帧）
+     */
+    int height() const;
+
+    /**
+     * @brief 是否已达到高度上限
+     */
+    bool isFull() const { return m_maxHeight > 0 && height() >= m_maxHeight; }
+
+    /**
+     * @brief 拼接结果（finish()之后调用）
+     *
+     * 长图可能有数万行，按需用 TiledImage::copy() 分段读取，不要一次合成整幅图像。
+     * 结果与拼接器共享，reset() 或析构后调用方持有的结果仍然有效
+     *
+     * @return 分块图像（没有任何帧时为空）
+     */
+    QSharedPointer<TiledImage> result() const { return m_output; }
+
+    /**
+     * @brief 计算图像逐行哈希（SIMD）
+     * @param image 32位图像
+     * @return 每行一个64位哈希
+     */
+    static QVector<quint64> rowHashes(const QImage &image);
+
+private:
+    ScrollStitcher(const ScrollStitcher &) = delete;
+    ScrollStitcher &operator=(const ScrollStitcher &) = delete;
+
+    /**
+     * @brief 在滚动区内查找偏移：新帧第y行等于上一帧第y+offset行
+     * @param top 滚动区起始行
+     * @param end 滚动区结束行（不含）
+     * @return 偏移（未找到时返回0）
+     */
+    int findOffset(const QVector<quint64> &current, int top, int end) const;
+
+    /**
+     * @brief 输出上一帧中尚未输出的行
+     */
+    bool emitRows(const QImage &frame, int y, int rows);
+
+private:
+    int m_maxHeight;                    ///< 高度上限
+    QImage m_previous;                  ///< 上一帧
+    QVector<quint64> m_previousHashes;  ///< 上一帧逐行哈希
+    QSharedPointer<TiledImage> m_output; ///< 拼接结果
+    int m_pendingFrom;                  ///< 上一帧中从这一行起尚未输出
+    int m_lastOffset;                   ///< 最近一次滚动距离
+    bool m_finished;                    ///< 是否已结束
+};
+
+#endif // SCROLLSTITCHER_H
@@ -0,0 +1,111 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file SimdSupport.cpp
+ * @brief SIMD运行时检测实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "SimdSupport.h"
+#include <QByteArray>
+#include <QDebug>
+
+#if defined(_MSC_VER) && defined(CAPSTEP_SIMD_SSE2)
+#include <intrin.h>
+#endif
+
+namespace {
+
+/**
+ * @brief 检测CPU与操作系统是否都支持AVX2
+ */
+bool detectAvx2()
+{
+#if !defined(CAPSTEP_SIMD_AVX2)
+    return false;
+#elif defined(_MSC_VER)
+    int info[4] = {0, 0, 0, 0};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) {
+        return false;
+    }
+    // 操作系统需要保存YMM寄存器状态
+    if ((_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+SimdSupport::Level detectLevel()
+{
+    SimdSupport::Level detected = SimdSupport::LevelScalar;
+#if defined(CAPSTEP_SIMD_SSE2)
+    detected = detectAvx2() ? SimdSupport::LevelAvx2 : SimdSupport::LevelSse2;
+#elif defined(CAPSTEP_SIMD_NEON)
+    detected = SimdSupport::LevelNeon;
+#endif
+
+    // 环境变量只能降低级别，不能启用CPU不支持的指令集
+    const QByteArray cap = qgetenv("CAPSTEP_SIMD").toLower();
+    if (cap == "scalar") {
+        detected = SimdSupport::LevelScalar;
+    } else if (cap == "sse2" && detected == SimdSupport::LevelAvx2) {
+        detected = SimdSupport::LevelSse2;
+    }
+
+    qDebug() << "[SIMD] Using" << SimdSupport::levelName(detected);
+    return detected;
+}
+
+} // namespace
+
+namespace SimdSupport {
+
+Level level()
+{
+    static const Level cached = detectLevel();
+    return cached;
+}
+
+QString levelName(Level level)
+{
+    switch (level) {
+    case LevelAvx2: return QStringLiteral("AVX2");
+    case LevelSse2: return QStringLiteral("SSE2");
+    case LevelNeon: return QStringLiteral("NEON");
+    case LevelScalar: break;
+    }
+    return QStringLiteral("scalar");
+}
+
+} // namespace SimdSupport
@@ -0,0 +1,105 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file SimdSupport.h
+ * @brief SIMD指令集编译期开关与运行时检测
+ *
+ * 编译期决定可以生成哪些指令集的代码路径，运行时根据CPU能力选择实际执行的路径。
+ * 可通过环境变量 CAPSTEP_SIMD=scalar|sse2 限制最高使用的指令集（用于对比调试）
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef SIMDSUPPORT_H
+#define SIMDSUPPORT_H
+
+#include <QString>
+
+// x86：SSE2为x86-64基线，AVX2通过函数级target属性生成，运行时再检测
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define CAPSTEP_SIMD_SSE2 1
+#  include <emmintrin.h>
+#  if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+#    define CAPSTEP_SIMD_AVX2 1
+#    include <immintrin.h>
+#  endif
+#endif
+
+// ARM：NEON在AArch64上为基线
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#  define CAPSTEP_SIMD_NEON 1
+#  include <arm_neon.h>
+#endif
+
+// 为单个函数启用AVX2代码生成（MSVC无需属性即可使用AVX2内建函数）
+#if defined(CAPSTEP_SIMD_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#  define CAPSTEP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#  define CAPSTEP_TARGET_AVX2
+#endif
+
+/**
+ * @namespace SimdSupport
+ * @brief 运行时SIMD能力检测
+ */
+namespace SimdSupport {
+
+/**
+ * @brief 指令集级别（按能力递增）
+ */
+enum Level {
+    LevelScalar = 0,    ///< 纯C++实现
+    LevelNeon,          ///< ARM NEON
+    LevelSse2,          ///< x86 SSE2
+    LevelAvx2           ///< x86 AVX2
+};
+
+/**
+ * @brief 获取当前进程可用的最高指令集级别（结果在首次调用后缓存）
+ * @return 指令集级别
+ */
+Level level();
+
+/**
+ * @brief 是否可以执行SSE2路径
+ */
+inline bool hasSse2() { return level() >= LevelSse2; }
+
+/**
+ * @brief 是否可以执行AVX2路径
+ */
+inline bool hasAvx2() { return level() >= LevelAvx2; }
+
+/**
+ * @brief 是否可以执行NEON路径
+ */
+inline bool hasNeon() { return level() == LevelNeon; }
+
+/**
+ * @brief 获取指令集级别名称（用于日志）
+ * @param level 指令集级别
+ * @return 名称
+ */
+QString levelName(Level level);
+
+} // namespace SimdSupport
+
+#endif // SIMDSUPPORT_H
@@ -26,6 +26,7 @@
  */
 
 #include "StickyNoteWindow.h"
+#include "ImageResampler.h"
 #include <QApplication>
 #include <QPushButton>
 #include <QLabel>
@@ -51,9 +52,10 @@
 #include <QEasingCurve>
 #include <cmath>
 
-StickyNoteWindow::StickyNoteWindow(const QPixmap &pixmap, QWidget *parent)
+StickyNoteWindow::StickyNoteWindow(const QImage &image, QWidget *parent)
     : QWidget(parent)
-    , m_pixmap(pixmap)
+    , m_image(image)
+    , m_displayCache()
     , m_isDragging(false)
     , m_dragOffset()
     , m_isResizing(false)
@@ -61,7 +63,7 @@ StickyNoteWindow::StickyNoteWindow(const QPixmap &pixmap, QWidget *parent)
     , m_handleSize(12)
     , m_minSize(100, 100)
     , m_scaleFactor(1.0f)
-    , m_originalSize(pixmap.size())
+    , m_originalSize(image.size())
     , m_smoothScaling(true)
     , m_targetScaleFactor(1.0f)
     , m_scaleAnimation(nullptr)
@@ -75,8 +77,8 @@ StickyNoteWindow::StickyNoteWindow(const QPixmap &pixmap, QWidget *parent)
     
     // 设置初始大小为"显示尺寸"（按DPR换算），保证与编辑窗口一致
     {
-        const qreal dpr = (m_pixmap.devicePixelRatio() > 0) ? m_pixmap.devicePixelRatio() : 1.0;
-        m_originalSize = QSize(qRound(m_pixmap.width() / dpr), qRound(m_pixmap.height() / dpr));
+        const qreal dpr = (m_image.devicePixelRatio() > 0) ? m_image.devicePixelRatio() : 1.0;
+        m_originalSize = QSize(qRound(m_image.width() / dpr), qRound(m_image.height() / dpr));
         resize(m_originalSize);
     }
     
@@ -90,17 +92,18 @@ StickyNoteWindow::StickyNoteWindow(const QPixmap &pixmap, QWidget *parent)
     updateHandles();
 }
 
-void StickyNoteWindow::setPixmap(const QPixmap &pixmap) {
-    m_pixmap = pixmap;
-    const qreal dpr = (m_pixmap.devicePixelRatio() > 0) ? m_pixmap.devicePixelRatio() : 1.0;
-    m_originalSize = QSize(qRound(m_pixmap.width() / dpr), qRound(m_pixmap.height() / dpr));
+void StickyNoteWindow::setImage(const QImage &image) {
+    m_image = image;
+    m_displayCache = QPixmap();
+    const qreal dpr = (m_image.devicePixelRatio() > 0) ? m_image.devicePixelRatio() : 1.0;
+    m_originalSize = QSize(qRound(m_image.width() / dpr), qRound(m_image.height() / dpr));
     resize(m_originalSize);
     m_scaleFactor = 1.0f;
     update();
 }
 
-QPixmap StickyNoteWindow::getPixmap() const {
-    return m_pixmap;
+QImage StickyNoteWindow::getImage() const {
+    return m_image;
 }
 
 void StickyNoteWindow::setAlwaysOnTop(bool onTop) {
@@ -125,24 +128,16 @@ void StickyNoteWindow::paintEvent(QPaintEvent *event) {
     
     QPainter painter(this);
     
-    if (!m_pixmap.isNull()) {
+    if (!m_image.isNull()) {
         int targetW = qMax(1, qRound(m_originalSize.width() * m_scaleFactor));
         int targetH = qMax(1, qRound(m_originalSize.height() * m_scaleFactor));
         int x = (width() - targetW) / 2;
         int y = (height() - targetH) / 2;
         QRect imgRect(x, y, targetW, targetH);
         
-        // 关键优化：原始尺寸时直接绘制，避免缩放导致的模糊
-        if (qAbs(m_scaleFactor - 1.0f) < 0.001f) {
-            // 1:1 显示，直接绘制原始图片，保持完美清晰
-            painter.drawPixmap(imgRect, m_pixmap);
-        } else {
-            // 需要缩放时才启用抗锯齿和平滑变换
-            painter.setRenderHint(QPainter::Antialiasing);
-            painter.setRenderHint(QPainter::SmoothPixmapTransform);
-            QPixmap scaledPixmap = m_pixmap.scaled(QSize(targetW, targetH), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-            painter.drawPixmap(imgRect, scaledPixmap);
-        }
+        // 缓存的像素已按显示尺寸缩放到设备分辨率，逐像素绘制，不再经过QPainter缩放
+        // （原始尺寸且DPR一致时就是原图本身，保持完美清晰）
+        painter.drawPixmap(imgRect.topLeft(), displayPixmap(imgRect.size()));
 
         // 仅显示用的灰色虚线边框（不影响复制/保存的像素）
         QPen dashPen(QColor(160, 160, 160, 220));
@@ -490,3 +485,20 @@ void StickyNoteWindow::onToggleAlwaysOnTop() {
 void StickyNoteWindow::onResetScale() {
     startSmoothScale(1.0f);
 }
+
+QPixmap StickyNoteWindow::displayPixmap(const QSize &size) {
+    const qreal dpr = devicePixelRatioF();
+    const QSize deviceSize(qMax(1, qRound(size.width() * dpr)), qMax(1, qRound(size.height() * dpr)));
+    if (!m_displayCache.isNull() && m_displayCache.size() == deviceSize
+        && qFuzzyCompare(m_displayCache.devicePixelRatio(), dpr)) {
+        return m_displayCache;
+    }
+
+    // 缩小用Lanczos3保留细节，放大用双线性（向量化、多线程，远快于QPixmap::scaled）
+    const bool downscale = deviceSize.width() < m_image.width() || deviceSize.height() < m_image.height();
+    QImage scaled = ImageResampler::resample(m_image, deviceSize,
+                                             downscale ? ImageResampler::FilterLanczos3 : ImageResampler::FilterBilinear);
+    scaled.setDevicePixelRatio(dpr);
+    m_displayCache = QPixmap::fromImage(scaled);
+    return m_displayCache;
+}
@@ -31,6 +31,7 @@
 #define STICKYNOTEWINDOW_H
 
 #include <QWidget>
+#include <QImage>
 #include <QPixmap>
 #include <QPoint>
 #include <QSize>
@@ -66,22 +67,22 @@ class StickyNoteWindow : public QWidget
 public:
     /**
      * @brief 构造函数
-     * @param pixmap 要显示的截图
+     * @param image 要显示的截图（共享像素，不复制）
      * @param parent 父窗口指针
      */
-    explicit StickyNoteWindow(const QPixmap &pixmap, QWidget *parent = nullptr);
+    explicit StickyNoteWindow(const QImage &image, QWidget *parent = nullptr);
 
     /**
      * @brief 获取当前截图
-     * @return 截图的QPixmap对象
+     * @return 截图（与创建时共享像素，另存为/复制可复用已有的编码结果）
      */
-    QPixmap getPixmap() const;
+    QImage getImage() const;
     
     /**
      * @brief 设置截图
-     * @param pixmap 新的截图
+     * @param image 新的截图
      */
-    void setPixmap(const QPixmap &pixmap);
+    void setImage(const QImage &image);
 
     /**
      * @brief 设置始终置顶
@@ -218,6 +219,13 @@ private:
      */
     void setupScaleAnimation();
 
+    /**
+     * @brief 按显示尺寸缩放后的截图（窗口边界处才转换为QPixmap，尺寸不变时复用）
+     * @param size 显示尺寸（逻辑像素）
+     * @return 设备像素尺寸与显示尺寸一致的QPixmap
+     */
+    QPixmap displayPixmap(const QSize &size);
+
     /**
      * @brief 开始平滑缩放
      * @param targetScale 目标缩放因子
@@ -274,7 +282,8 @@ private:
 
 private:
     // 图片相关成员变量
-    QPixmap m_pixmap;              // 当前显示的截图
+    QImage m_image;                // 当前显示的截图
+    QPixmap m_displayCache;        // 按当前显示尺寸缩放后的截图
     QSize m_originalSize;          // 截图原始尺寸
     float m_scaleFactor;           // 当前缩放比例（1.0为原始大小）
     
@@ -0,0 +1,494 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ThumbnailPack.cpp
+ * @brief 历史截图缩略图包实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "ThumbnailPack.h"
+#include "ImageResampler.h"
+#include <QSaveFile>
+#include <QVector>
+#include <QPair>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+constexpr quint32 kPackMagic = 0x50545343;     ///< "CSTP"
+constexpr quint32 kIndexMagic = 0x49545343;    ///< "CSTI"
+constexpr quint32 kRecordMagic = 0x424d4854;   ///< "THMB"
+constexpr quint32 kVersion = 1;
+constexpr qint64 kAlignment = 16;
+
+/// 文件头（两个文件共用布局）
+struct FileHeader {
+    quint32 magic;
+    quint32 version;
+    quint16 maxWidth;
+    quint16 maxHeight;
+    quint32 generation; ///< 文件代数，每次压缩加一
+};
+
+/// 索引项
+struct IndexEntry {
+    quint64 offset;     ///< 记录在 .pack 中的偏移
+    quint16 width;
+    quint16 height;
+    quint32 reserved;
+};
+
+static_assert(sizeof(FileHeader) == 16, "FileHeader must be 16 bytes");
+static_assert(sizeof(IndexEntry) == 16, "IndexEntry must be 16 bytes");
+
+inline qint64 alignUp(qint64 value)
+{
+    return (value + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+bool checkHeader(const uchar *data, qint64 size, quint32 magic, quint32 *generation)
+{
+    if (size < qint64(sizeof(FileHeader))) {
+        return false;
+    }
+    FileHeader header;
+    memcpy(&header, data, sizeof(header));
+    *generation = header.generation;
+    return header.magic == magic && header.version == kVersion;
+}
+
+bool readHeader(QFile &file, quint32 magic, quint32 *generation)
+{
+    FileHeader header;
+    if (!file.seek(0) || file.read(reinterpret_cast<char *>(&header), sizeof(header)) != qint64(sizeof(header))) {
+        return false;
+    }
+    *generation = header.generation;
+    return header.magic == magic && header.version == kVersion;
+}
+
+bool writeHeader(QFileDevice &file, quint32 magic, quint32 generation)
+{
+    FileHeader header = {magic, kVersion, quint16(ThumbnailPack::MaxWidth), quint16(ThumbnailPack::MaxHeight), generation};
+    return file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == qint64(sizeof(header));
+}
+
+bool resetFile(QFile &file, quint32 magic)
+{
+    return file.resize(0) && file.seek(0) && writeHeader(file, magic, 0);
+}
+
+} // namespace
+
+/// 记录头，之后依次为文件名（UTF-8）、对齐填充、像素、对齐填充
+struct ThumbnailPack::Record {
+    quint32 magic;
+    quint16 width;
+    quint16 height;
+    quint32 nameBytes;
+    quint32 reserved;
+    qint64 timestampMs;
+    qint64 reserved2;
+
+    qint64 pixelOffset() const { return alignUp(qint64(sizeof(Record)) + nameBytes); }
+    qint64 totalBytes() const { return alignUp(pixelOffset() + qint64(width) * height * 4); }
+};
+
+ThumbnailPack::ThumbnailPack(const QString &folder)
+    : m_pack(folder + "/.thumbnails.pack")
+    , m_index(folder + "/.thumbnails.idx")
+    , m_writable(false)
+    , m_packEnd(0)
+    , m_count(0)
+    , m_generation(0)
+    , m_packMap(nullptr)
+    , m_packMapSize(0)
+    , m_indexMap(nullptr)
+    , m_indexMapSize(0)
+{
+}
+
+ThumbnailPack::~ThumbnailPack()
+{
+    close();
+}
+
+bool ThumbnailPack::openForAppend() {
+    close();
+    if (!m_pack.open(QIODevice::ReadWrite) || !m_index.open(QIODevice::ReadWrite)) {
+        qWarning() << "[Thumbs] Cannot open thumbnail pack:" << m_pack.errorString();
+        close();
+        return false;
+    }
+    m_writable = true;
+
+    quint32 packGeneration = 0;
+    quint32 indexGeneration = 0;
+    if (!readHeader(m_pack, kPackMagic, &packGeneration) || !readHeader(m_index, kIndexMagic, &indexGeneration)
+        || packGeneration != indexGeneration) {
+        // 新建、格式不符或压缩时只替换了一个文件：两个文件一起重建
+        if (m_pack.size() > 0 || m_index.size() > 0) {
+            qWarning() << "[Thumbs] Thumbnail pack unreadable, recreating";
+        }
+        if (!resetFile(m_pack, kPackMagic) || !resetFile(m_index, kIndexMagic)) {
+            close();
+            return false;
+        }
+        m_packEnd = sizeof(FileHeader);
+        m_count = 0;
+        m_generation = 0;
+        return true;
+    }
+    m_generation = packGeneration;
+
+    // 从尾部找到最后一条记录完整的索引项，之后的残留留在原处，由后续追加覆盖
+    const qint64 packSize = m_pack.size();
+    int count = int((m_index.size() - qint64(sizeof(FileHeader))) / qint64(sizeof(IndexEntry)));
+    m_packEnd = sizeof(FileHeader);
+    while (count > 0) {
+        IndexEntry entry;
+        Record record;
+        const qint64 entryOffset = qint64(sizeof(FileHeader)) + qint64(count - 1) * qint64(sizeof(IndexEntry));
+        if (m_index.seek(entryOffset)
+            && m_index.read(reinterpret_cast<char *>(&entry), sizeof(entry)) == qint64(sizeof(entry))
+            && m_pack.seek(qint64(entry.offset))
+            && m_pack.read(reinterpret_cast<char *>(&record), sizeof(record)) == qint64(sizeof(record))
+            && record.magic == kRecordMagic
+            && qint64(entry.offset) + record.totalBytes() <= packSize) {
+            m_packEnd = qint64(entry.offset) + record.totalBytes();
+            break;
+        }
+        --count;
+    }
+    m_count = count;
+
+    // 不截断文件：读取方可能正映射着残留部分，缩短文件后访问会触发SIGBUS。
+    // 残留的索引项清零（偏移0指向文件头，读取方校验记录头时视为无效），
+    // 避免之后覆盖写入的记录恰好落在旧索引项指向的位置
+    const qint64 validIndexEnd = qint64(sizeof(FileHeader)) + qint64(count) * qint64(sizeof(IndexEntry));
+    const qint64 staleBytes = m_index.size() - validIndexEnd;
+    if (staleBytes > 0) {
+        const QByteArray zeros(int(staleBytes), '\0');
+        if (!m_index.seek(validIndexEnd) || m_index.write(zeros) != staleBytes || !m_index.flush()) {
+            qWarning() << "[Thumbs] Failed to clear stale index entries";
+            close();
+            return false;
+        }
+        qDebug() << "[Thumbs] Cleared" << staleBytes / qint64(sizeof(IndexEntry)) << "stale index entries";
+    }
+    return true;
+}
+
+bool ThumbnailPack::openForRead() {
+    close();
+    if (!m_pack.exists() || !m_index.exists()) {
+        return false;
+    }
+    if (!m_pack.open(QIODevice::ReadOnly) || !m_index.open(QIODevice::ReadOnly)) {
+        close();
+        return false;
+    }
+    return mapFiles();
+}
+
+bool ThumbnailPack::refresh() {
+    if (m_writable) {
+        return false;
+    }
+    const int previous = m_count;
+    if (!m_pack.isOpen() || !m_packMap) {
+        openForRead();
+        return m_count != previous;
+    }
+    // 写入方压缩后替换了两个文件：旧映射仍然有效但不会再增长，切换到新文件
+    QFile current(m_index.fileName());
+    quint32 generation = 0;
+    if (current.open(QIODevice::ReadOnly) && readHeader(current, kIndexMagic, &generation)
+        && generation != m_generation) {
+        openForRead();
+        return true;
+    }
+    if (m_pack.size() == m_packMapSize && m_index.size() == m_indexMapSize) {
+        // 写入方在原有大小内覆盖了残留尾部：共享映射已能看到新写入的内容
+        while (record(m_count)) {
+            ++m_count;
+        }
+        return m_count != previous;
+    }
+    unmapFiles();
+    mapFiles();
+    return m_count != previous;
+}
+
+void ThumbnailPack::close() {
+    unmapFiles();
+    m_pack.close();
+    m_index.close();
+    m_writable = false;
+    m_packEnd = 0;
+    m_count = 0;
+    m_generation = 0;
+}
+
+bool ThumbnailPack::mapFiles() {
+    m_count = 0;
+    m_packMapSize = m_pack.size();
+    m_indexMapSize = m_index.size();
+    if (m_packMapSize < qint64(sizeof(FileHeader)) || m_indexMapSize < qint64(sizeof(FileHeader))) {
+        return false;
+    }
+    m_packMap = m_pack.map(0, m_packMapSize);
+    m_indexMap = m_index.map(0, m_indexMapSize);
+    quint32 packGeneration = 0;
+    quint32 indexGeneration = 0;
+    if (!m_packMap || !m_indexMap
+        || !checkHeader(m_packMap, m_packMapSize, kPackMagic, &packGeneration)
+        || !checkHeader(m_indexMap, m_indexMapSize, kIndexMagic, &indexGeneration)
+        || packGeneration != indexGeneration) {
+        unmapFiles();
+        return false;
+    }
+    m_generation = packGeneration;
+
+    // 写入方先写记录再写索引：只有尾部的索引项可能指向尚未完整写入的记录
+    int count = int((m_indexMapSize - qint64(sizeof(FileHeader))) / qint64(sizeof(IndexEntry)));
+    m_count = count;
+    while (m_count > 0 && !record(m_count - 1)) {
+        --m_count;
+    }
+    return true;
+}
+
+void ThumbnailPack::unmapFiles() {
+    if (m_packMap) {
+        m_pack.unmap(m_packMap);
+        m_packMap = nullptr;
+    }
+    if (m_indexMap) {
+        m_index.unmap(m_indexMap);
+        m_indexMap = nullptr;
+    }
+    m_packMapSize = 0;
+    m_indexMapSize = 0;
+}
+
+const ThumbnailPack::Record *ThumbnailPack::record(int index) const {
+    static_assert(sizeof(Record) == 32, "Record must be 32 bytes");
+    if (!m_indexMap || index < 0) {
+        return nullptr;
+    }
+    const qint64 entryOffset = qint64(sizeof(FileHeader)) + qint64(index) * qint64(sizeof(IndexEntry));
+    if (entryOffset + qint64(sizeof(IndexEntry)) > m_indexMapSize) {
+        return nullptr;
+    }
+    const IndexEntry *entry = reinterpret_cast<const IndexEntry *>(m_indexMap + entryOffset);
+    const qint64 offset = qint64(entry->offset);
+    if (offset % kAlignment != 0 || offset + qint64(sizeof(Record)) > m_packMapSize) {
+        return nullptr;
+    }
+    const Record *rec = reinterpret_cast<const Record *>(m_packMap + offset);
+    if (rec->magic != kRecordMagic || rec->width != entry->width || rec->height != entry->height
+        || offset + rec->totalBytes() > m_packMapSize) {
+        return nullptr;
+    }
+    return rec;
+}
+
+bool ThumbnailPack::append(const QString &fileName, const QDateTime &timestamp, const QImage &image) {
+    if (!m_writable || image.isNull()) {
+        return false;
+    }
+
+    const QSize size = thumbnailSize(image.size());
+    QImage source = image;
+    if (source.format() != QImage::Format_RGB32 && source.format() != QImage::Format_ARGB32_Premultiplied) {
+        source = source.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+    QImage thumb = ImageResampler::resample(source, size, ImageResampler::FilterBox);
+    // 不透明的RGB32像素同时也是合法的预乘像素
+    thumb = thumb.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    if (thumb.isNull()) {
+        return false;
+    }
+
+    const QByteArray bytes = encodeRecord(fileName, timestamp.toMSecsSinceEpoch(), thumb);
+    const qint64 offset = m_packEnd;
+    if (!m_pack.seek(offset) || m_pack.write(bytes) != bytes.size() || !m_pack.flush()) {
+        qWarning() << "[Thumbs] Failed to write thumbnail record";
+        return false;
+    }
+
+    IndexEntry entry = {quint64(offset), quint16(thumb.width()), quint16(thumb.height()), 0};
+    const qint64 entryOffset = qint64(sizeof(FileHeader)) + qint64(m_count) * qint64(sizeof(IndexEntry));
+    if (!m_index.seek(entryOffset)
+        || m_index.write(reinterpret_cast<const char *>(&entry), sizeof(entry)) != qint64(sizeof(entry))
+        || !m_index.flush()) {
+        qWarning() << "[Thumbs] Failed to write thumbnail index";
+        return false;
+    }
+
+    m_packEnd = offset + bytes.size();
+    ++m_count;
+    return true;
+}
+
+QByteArray ThumbnailPack::encodeRecord(const QString &fileName, qint64 timestampMs, const QImage &thumb) {
+    const QByteArray name = fileName.toUtf8();
+    Record record;
+    memset(&record, 0, sizeof(record));
+    record.magic = kRecordMagic;
+    record.width = quint16(thumb.width());
+    record.height = quint16(thumb.height());
+    record.nameBytes = quint32(name.size());
+    record.timestampMs = timestampMs;
+
+    QByteArray bytes(int(record.totalBytes()), '\0');
+    memcpy(bytes.data(), &record, sizeof(record));
+    memcpy(bytes.data() + sizeof(record), name.constData(), size_t(name.size()));
+    uchar *pixels = reinterpret_cast<uchar *>(bytes.data()) + record.pixelOffset();
+    const qsizetype rowBytes = qsizetype(thumb.width()) * 4;
+    for (int y = 0; y < thumb.height(); ++y) {
+        memcpy(pixels + y * rowBytes, thumb.constScanLine(y), size_t(rowBytes));
+    }
+    return bytes;
+}
+
+int ThumbnailPack::compact(const std::function<QString(const QString &)> &currentName) {
+    if (!m_writable) {
+        return -1;
+    }
+
+    // 先确认有需要去掉的记录，大多数维护周期不必重写
+    QVector<QPair<IndexEntry, QString>> kept;
+    kept.reserve(m_count);
+    for (int i = 0; i < m_count; ++i) {
+        IndexEntry entry;
+        Record record;
+        const qint64 entryOffset = qint64(sizeof(FileHeader)) + qint64(i) * qint64(sizeof(IndexEntry));
+        if (!m_index.seek(entryOffset)
+            || m_index.read(reinterpret_cast<char *>(&entry), sizeof(entry)) != qint64(sizeof(entry))
+            || !m_pack.seek(qint64(entry.offset))
+            || m_pack.read(reinterpret_cast<char *>(&record), sizeof(record)) != qint64(sizeof(record))
+            || record.magic != kRecordMagic || qint64(entry.offset) + record.totalBytes() > m_packEnd) {
+            continue;
+        }
+        const QString name = currentName(QString::fromUtf8(m_pack.read(record.nameBytes)));
+        if (!name.isEmpty()) {
+            kept.append(qMakePair(entry, name));
+        }
+    }
+    const int dropped = m_count - kept.size();
+    if (dropped == 0) {
+        return 0;
+    }
+
+    const quint32 generation = m_generation + 1;
+    QSaveFile pack(m_pack.fileName());
+    QSaveFile index(m_index.fileName());
+    if (!pack.open(QIODevice::WriteOnly) || !index.open(QIODevice::WriteOnly)
+        || !writeHeader(pack, kPackMagic, generation) || !writeHeader(index, kIndexMagic, generation)) {
+        qWarning() << "[Thumbs] Cannot create compacted thumbnail pack:" << pack.errorString();
+        return -1;
+    }
+    qint64 packEnd = sizeof(FileHeader);
+    for (const auto &item : std::as_const(kept)) {
+        Record record;
+        if (!m_pack.seek(qint64(item.first.offset))
+            || m_pack.read(reinterpret_cast<char *>(&record), sizeof(record)) != qint64(sizeof(record))
+            || !m_pack.seek(qint64(item.first.offset) + record.pixelOffset())) {
+            qWarning() << "[Thumbs] Failed to read thumbnail record";
+            return -1;
+        }
+        const QByteArray pixels = m_pack.read(qint64(record.width) * record.height * 4);
+        if (pixels.size() != qint64(record.width) * record.height * 4) {
+            qWarning() << "[Thumbs] Failed to read thumbnail record";
+            return -1;
+        }
+        const QImage thumb(reinterpret_cast<const uchar *>(pixels.constData()), record.width, record.height,
+                           qsizetype(record.width) * 4, QImage::Format_ARGB32_Premultiplied);
+        const QByteArray bytes = encodeRecord(item.second, record.timestampMs, thumb);
+        const IndexEntry entry = {quint64(packEnd), record.width, record.height, 0};
+        if (pack.write(bytes) != bytes.size()
+            || index.write(reinterpret_cast<const char *>(&entry), sizeof(entry)) != qint64(sizeof(entry))) {
+            qWarning() << "[Thumbs] Failed to write compacted thumbnail pack:" << pack.errorString();
+            return -1;
+        }
+        packEnd += bytes.size();
+    }
+
+    // 先替换记录文件再替换索引：读取方以索引的代数判断是否切换，
+    // 两次替换之间打开的读取方看到代数不一致，视为不可用并在下次刷新时重试。
+    // Windows下不能替换仍打开着的文件，替换前先关闭自己的句柄
+    close();
+    if (!pack.commit()) {
+        qWarning() << "[Thumbs] Failed to replace thumbnail pack:" << pack.errorString();
+        index.cancelWriting();
+        openForAppend();
+        return -1;
+    }
+    if (!index.commit()) {
+        // 只替换了记录文件，代数不一致，下面重新打开时两个文件一起重建
+        qWarning() << "[Thumbs] Failed to replace thumbnail index:" << index.errorString();
+        openForAppend();
+        return -1;
+    }
+    if (!openForAppend()) {
+        return -1;
+    }
+    qDebug() << "[Thumbs] Compacted thumbnail pack," << kept.size() << "kept," << dropped << "dropped";
+    return dropped;
+}
+
+QImage ThumbnailPack::thumbnail(int index) const {
+    const Record *rec = record(index);
+    if (!rec) {
+        return QImage();
+    }
+    const uchar *pixels = reinterpret_cast<const uchar *>(rec) + rec->pixelOffset();
+    return QImage(pixels, rec->width, rec->height, qsizetype(rec->width) * 4, QImage::Format_ARGB32_Premultiplied);
+}
+
+QString ThumbnailPack::fileName(int index) const {
+    const Record *rec = record(index);
+    if (!rec) {
+        return QString();
+    }
+    return QString::fromUtf8(reinterpret_cast<const char *>(rec) + sizeof(Record), int(rec->nameBytes));
+}
+
+QDateTime ThumbnailPack::timestamp(int index) const {
+    const Record *rec = record(index);
+    if (!rec) {
+        return QDateTime();
+    }
+    return QDateTime::fromMSecsSinceEpoch(rec->timestampMs);
+}
+
+QSize ThumbnailPack::thumbnailSize(const QSize &imageSize) {
+    if (imageSize.isEmpty()) {
+        return QSize();
+    }
+    return imageSize.boundedTo(QSize(MaxWidth, MaxHeight)) == imageSize
+               ? imageSize
+               : imageSize.scaled(MaxWidth, MaxHeight, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+}
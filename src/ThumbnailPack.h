@@ -0,0 +1,191 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ThumbnailPack.h
+ * @brief 历史截图缩略图包
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef THUMBNAILPACK_H
+#define THUMBNAILPACK_H
+
+#include <QFile>
+#include <QImage>
+#include <QString>
+#include <QDateTime>
+#include <functional>
+
+/**
+ * @class ThumbnailPack
+ * @brief 只追加、可内存映射的缩略图容器
+ *
+ * 历史文件夹中的两个文件：
+ * - .thumbnails.pack：记录头 + 文件名 + 未压缩的 ARGB32_Premultiplied 像素，每条记录16字节对齐
+ * - .thumbnails.idx：每张缩略图一个16字节索引项（记录偏移与尺寸），第 i 张缩略图 O(1) 定位
+ *
+ * 写入方（历史写入线程）先写记录再写索引，崩溃时最多留下一条没有索引的孤立记录，
+ * 下次以追加方式打开时从最后一条完整记录之后覆盖写入。两个文件从不缩短
+ * （读取方可能正映射着它们，截断后访问映射尾部会触发SIGBUS），残留的索引项清零作废。
+ * 读取方把两个文件整体映射到内存，
+ * 缩略图直接引用映射内存，打开数千张缩略图的网格无需解码任何原图。
+ *
+ * 原图被删除后的记录由 compact() 清除：另写两个新文件再原子替换，同样不缩短旧文件。
+ * 两个文件头记录同一个代数，每次压缩加一；读取方发现路径上的文件代数变化时重新打开，
+ * 代数不一致（只替换了一个文件）时视为不可用。
+ * 文件按本机字节序（小端）存储
+ */
+class ThumbnailPack
+{
+public:
+    static constexpr int MaxWidth = 160;    ///< 缩略图最大宽度
+    static constexpr int MaxHeight = 100;   ///< 缩略图最大高度
+
+    /**
+     * @brief 构造函数
+     * @param folder 历史文件夹
+     */
+    explicit ThumbnailPack(const QString &folder);
+    ~ThumbnailPack();
+
+    /**
+     * @brief 以追加方式打开（不存在时创建）
+     * @return 是否成功
+     */
+    bool openForAppend();
+
+    /**
+     * @brief 以只读映射方式打开
+     * @return 是否成功（文件不存在时返回false，count()为0）
+     */
+    bool openForRead();
+
+    /**
+     * @brief 重新映射已增长的文件（只读方式）
+     *
+     * 文件大小不变时（写入方覆盖了崩溃残留的尾部）只检查之后的索引项是否已生效。
+     * 之前通过 thumbnail() 取得的图像引用旧映射，调用后不得再使用
+     *
+     * @return 缩略图数量是否变化
+     */
+    bool refresh();
+
+    /**
+     * @brief 关闭文件并解除映射
+     */
+    void close();
+
+    /**
+     * @brief 追加一张缩略图（追加方式）
+     * @param fileName 原图文件名（不含目录）
+     * @param timestamp 截图时间
+     * @param image 原图（在此缩放）
+     * @return 是否成功
+     */
+    bool append(const QString &fileName, const QDateTime &timestamp, const QImage &image);
+
+    /**
+     * @brief 重写两个文件，去掉原图已删除的缩略图（追加方式）
+     *
+     * 新文件写完后替换旧文件，已映射旧文件的读取方不受影响，refresh() 时切换到新文件。
+     * Windows下读取方正映射着旧文件时无法替换，返回失败，留到下一次压缩
+     *
+     * @param currentName 原图文件名 → 当前文件名（格式转换后可能改变），原图已删除时返回空字符串
+     * @return 去掉的缩略图数量，失败时返回-1（没有可去掉的记录时不重写）
+     */
+    int compact(const std::function<QString(const QString &)> &currentName);
+
+    /**
+     * @brief 获取缩略图数量
+     */
+    int count() const { return m_count; }
+
+    /**
+     * @brief 获取缩略图（只读方式，直接引用映射内存，不复制）
+     * @param index 序号（按写入顺序）
+     * @return 缩略图，记录损坏时返回空图像
+     */
+    QImage thumbnail(int index) const;
+
+    /**
+     * @brief 获取原图文件名
+     */
+    QString fileName(int index) const;
+
+    /**
+     * @brief 获取截图时间
+     */
+    QDateTime timestamp(int index) const;
+
+    /**
+     * @brief 计算缩略图尺寸（保持宽高比，不放大）
+     * @param imageSize 原图尺寸
+     * @return 缩略图尺寸
+     */
+    static QSize thumbnailSize(const QSize &imageSize);
+
+    /**
+     * @brief 获取索引文件路径（供文件监视使用）
+     */
+    QString indexPath() const { return m_index.fileName(); }
+
+    /**
+     * @brief 获取当前打开的文件代数（每次压缩加一，供读取方判断文件是否已被替换）
+     */
+    quint32 generation() const { return m_generation; }
+
+private:
+    struct Record;
+
+    /**
+     * @brief 按索引项定位并校验记录（只读方式）
+     */
+    const Record *record(int index) const;
+
+    /**
+     * @brief 编码一条记录（记录头、文件名与像素，按16字节对齐）
+     */
+    static QByteArray encodeRecord(const QString &fileName, qint64 timestampMs, const QImage &thumb);
+
+    /**
+     * @brief 映射两个文件并统计有效索引项
+     */
+    bool mapFiles();
+
+    /**
+     * @brief 解除映射
+     */
+    void unmapFiles();
+
+private:
+    QFile m_pack;                   ///< 记录文件
+    QFile m_index;                  ///< 索引文件
+    bool m_writable;                ///< 是否以追加方式打开
+    qint64 m_packEnd;               ///< 最后一条有效记录的结尾（追加方式）
+    int m_count;                    ///< 有效缩略图数量
+    quint32 m_generation;           ///< 文件代数（两个文件头一致）
+    uchar *m_packMap;               ///< 记录文件映射（只读方式）
+    qint64 m_packMapSize;           ///< 记录文件映射大小
+    uchar *m_indexMap;              ///< 索引文件映射（只读方式）
+    qint64 m_indexMapSize;          ///< 索引文件映射大小
+};
+
+#endif // THUMBNAILPACK_H
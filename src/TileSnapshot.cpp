@@ -0,0 +1,92 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file TileSnapshot.cpp
+ * @brief 分块局部快照实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "TileSnapshot.h"
+#include <cstring>
+
+namespace {
+
+quint32 tileKey(int tx, int ty)
+{
+    return (quint32(ty) << 16) | quint32(tx);
+}
+
+} // namespace
+
+TileSnapshot::TileSnapshot()
+    : m_tiles()
+    , m_bytes(0)
+    , m_valid(false)
+{
+}
+
+void TileSnapshot::capture(const QImage &image, const QRect &deviceRect) {
+    m_valid = true;
+    const QRect rect = deviceRect.intersected(image.rect());
+    if (rect.isEmpty() || image.depth() % 8 != 0) {
+        return;
+    }
+    const int tx0 = rect.left() / TileSize;
+    const int tx1 = rect.right() / TileSize;
+    const int ty0 = rect.top() / TileSize;
+    const int ty1 = rect.bottom() / TileSize;
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            const quint32 key = tileKey(tx, ty);
+            if (m_tiles.contains(key)) {
+                continue;   // 已保存操作前的内容
+            }
+            const QRect tileRect = QRect(tx * TileSize, ty * TileSize, TileSize, TileSize).intersected(image.rect());
+            const QImage tile = image.copy(tileRect);
+            m_bytes += tile.sizeInBytes();
+            m_tiles.insert(key, tile);
+        }
+    }
+}
+
+int TileSnapshot::restore(QImage &image) const {
+    if (!m_valid || m_tiles.isEmpty()) {
+        return 0;
+    }
+    const int bytesPerPixel = image.depth() / 8;
+    for (auto it = m_tiles.constBegin(); it != m_tiles.constEnd(); ++it) {
+        const int x = int(it.key() & 0xffff) * TileSize;
+        const int y = int(it.key() >> 16) * TileSize;
+        const QImage &tile = it.value();
+        const size_t rowBytes = size_t(tile.width()) * bytesPerPixel;
+        for (int row = 0; row < tile.height(); ++row) {
+            std::memcpy(image.scanLine(y + row) + x * bytesPerPixel, tile.constScanLine(row), rowBytes);
+        }
+    }
+    return int(m_tiles.size());
+}
+
+void TileSnapshot::clear() {
+    m_tiles.clear();
+    m_bytes = 0;
+    m_valid = false;
+}
@@ -0,0 +1,86 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file TileSnapshot.h
+ * @brief 按分块保存的局部图像快照（用于撤销）
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef TILESNAPSHOT_H
+#define TILESNAPSHOT_H
+
+#include <QImage>
+#include <QHash>
+#include <QRect>
+
+/**
+ * @class TileSnapshot
+ * @brief 图像中被一次操作改动的分块的原内容
+ *
+ * 图像按 TileSize × TileSize 设备像素划分为固定网格，操作前只复制它将要改动的分块，
+ * 未改动的分块不占内存；同一分块多次 capture() 只保存第一次（即操作前）的内容。
+ * 撤销时 restore() 把这些分块写回，代价与改动面积成正比，与整幅图像大小无关
+ */
+class TileSnapshot
+{
+public:
+    /// 分块边长（设备像素）
+    static constexpr int TileSize = 128;
+
+    TileSnapshot();
+
+    /**
+     * @brief 是否可用于恢复（capture()过且未被clear()）
+     */
+    bool isValid() const { return m_valid; }
+
+    /**
+     * @brief 保存的像素字节数
+     */
+    qint64 byteSize() const { return m_bytes; }
+
+    /**
+     * @brief 保存矩形覆盖的分块中尚未保存的部分
+     * @param image 操作前的图像
+     * @param deviceRect 将要改动的矩形（设备像素）
+     */
+    void capture(const QImage &image, const QRect &deviceRect);
+
+    /**
+     * @brief 把保存的分块写回图像
+     * @param image 目标图像（尺寸和格式需与capture时一致）
+     * @return 写回的分块数
+     */
+    int restore(QImage &image) const;
+
+    /**
+     * @brief 释放保存的分块并置为无效
+     */
+    void clear();
+
+private:
+    QHash<quint32, QImage> m_tiles;     ///< (行号 << 16 | 列号) → 分块原内容
+    qint64 m_bytes;                     ///< 保存的像素字节数
+    bool m_valid;                       ///< 是否可用于恢复
+};
+
+#endif // TILESNAPSHOT_H
@@ -0,0 +1,233 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file TiledImage.cpp
+ * @brief 按行追加的分块图像实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "TiledImage.h"
+#include "ImageResampler.h"
+#include <QPainter>
+#include <QDir>
+#include <QDebug>
+#include <cstring>
+
+TiledImage::TiledImage(int width, QImage::Format format, int tileRows, int maxResidentTiles)
+    : m_width(qMax(width, 0))
+    , m_format(format)
+    , m_tileRows(qMax(tileRows, 1))
+    , m_maxResidentTiles(qMax(maxResidentTiles, 1))
+    , m_height(0)
+    , m_firstResident(0)
+    , m_devicePixelRatio(1.0)
+    , m_tiles()
+    , m_spillFile(QDir::tempPath() + "/CapStep_tiles_XXXXXX.raw")
+{
+    if (QImage::toPixelFormat(format).bitsPerPixel() != 32) {
+        qWarning() << "[TiledImage] Unsupported format" << format << ", using ARGB32_Premultiplied";
+        m_format = QImage::Format_ARGB32_Premultiplied;
+    }
+}
+
+TiledImage::~TiledImage()
+{
+    // QTemporaryFile 析构时自动删除落盘文件
+}
+
+qint64 TiledImage::residentBytes() const {
+    qint64 bytes = 0;
+    for (int i = m_firstResident; i < m_tiles.size(); ++i) {
+        bytes += m_tiles.at(i).image.sizeInBytes();
+    }
+    return bytes;
+}
+
+bool TiledImage::appendRows(const uchar *bits, qsizetype stride, int rows) {
+    const qsizetype bytes = rowBytes();
+    while (rows > 0) {
+        const int tileIndex = m_height / m_tileRows;
+        const int rowInTile = m_height % m_tileRows;
+        if (tileIndex == m_tiles.size()) {
+            Tile tile;
+            tile.image = QImage(m_width, m_tileRows, m_format);
+            if (tile.image.isNull()) {
+                qWarning() << "[TiledImage] Failed to allocate tile" << tileIndex;
+                return false;
+            }
+            m_tiles.append(tile);
+        }
+
+        const int count = qMin(rows, m_tileRows - rowInTile);
+        QImage &image = m_tiles[tileIndex].image;
+        for (int i = 0; i < count; ++i) {
+            std::memcpy(image.scanLine(rowInTile + i), bits + i * stride, size_t(bytes));
+        }
+        bits += count * stride;
+        rows -= count;
+        m_height += count;
+
+        // 分块写满后才可能落盘
+        if (rowInTile + count == m_tileRows && !spillOldTiles()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TiledImage::appendRows(const QImage &image, int y, int rows) {
+    if (image.width() != m_width || image.format() != m_format) {
+        qWarning() << "[TiledImage] Row source mismatch:" << image.width() << image.format()
+                   << "expected" << m_width << m_format;
+        return false;
+    }
+    y = qBound(0, y, image.height());
+    rows = qBound(0, rows, image.height() - y);
+    if (rows == 0) {
+        return true;
+    }
+    return appendRows(image.constScanLine(y), image.bytesPerLine(), rows);
+}
+
+bool TiledImage::spillOldTiles() {
+    const qint64 tileBytes = qint64(rowBytes()) * m_tileRows;
+
+    // 正在写入的最后一个分块总是常驻
+    while (m_tiles.size() - m_firstResident > m_maxResidentTiles
+           && m_firstResident < m_tiles.size() - 1) {
+        if (!m_spillFile.isOpen() && !m_spillFile.open()) {
+            qWarning() << "[TiledImage] Failed to open spill file:" << m_spillFile.errorString();
+            return false;
+        }
+
+        Tile &tile = m_tiles[m_firstResident];
+        const qint64 offset = qint64(m_firstResident) * tileBytes;
+        if (!m_spillFile.seek(offset)
+            || m_spillFile.write(reinterpret_cast<const char *>(tile.image.constBits()), tileBytes) != tileBytes) {
+            qWarning() << "[TiledImage] Failed to spill tile" << m_firstResident << ":" << m_spillFile.errorString();
+            return false;
+        }
+        tile.spillOffset = offset;
+        tile.image = QImage();
+        ++m_firstResident;
+    }
+    return true;
+}
+
+bool TiledImage::readRows(int tileIndex, int firstRow, int rows, uchar *dst, qsizetype dstStride) const {
+    const Tile &tile = m_tiles.at(tileIndex);
+    const qsizetype bytes = rowBytes();
+
+    if (!tile.image.isNull()) {
+        for (int i = 0; i < rows; ++i) {
+            std::memcpy(dst + i * dstStride, tile.image.constScanLine(firstRow + i), size_t(bytes));
+        }
+        return true;
+    }
+
+    if (!m_spillFile.seek(tile.spillOffset + qint64(firstRow) * bytes)) {
+        return false;
+    }
+    if (dstStride == bytes) {
+        const qint64 total = qint64(bytes) * rows;
+        return m_spillFile.read(reinterpret_cast<char *>(dst), total) == total;
+    }
+    for (int i = 0; i < rows; ++i) {
+        if (m_spillFile.read(reinterpret_cast<char *>(dst + i * dstStride), bytes) != bytes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QImage TiledImage::copy(int y, int rows) const {
+    y = qBound(0, y, m_height);
+    rows = qBound(0, rows, m_height - y);
+    if (rows == 0 || m_width == 0) {
+        return QImage();
+    }
+
+    QImage result(m_width, rows, m_format);
+    if (result.isNull()) {
+        qWarning() << "[TiledImage] Failed to allocate" << m_width << "x" << rows;
+        return QImage();
+    }
+
+    int done = 0;
+    while (done < rows) {
+        const int row = y + done;
+        const int tileIndex = row / m_tileRows;
+        const int rowInTile = row % m_tileRows;
+        const int count = qMin(rows - done, m_tileRows - rowInTile);
+        if (!readRows(tileIndex, rowInTile, count, result.scanLine(done), result.bytesPerLine())) {
+            qWarning() << "[TiledImage] Failed to read tile" << tileIndex << ":" << m_spillFile.errorString();
+            return QImage();
+        }
+        done += count;
+    }
+
+    result.setDevicePixelRatio(m_devicePixelRatio);
+    return result;
+}
+
+QImage TiledImage::preview(int maxHeight) const {
+    if (m_height <= maxHeight || maxHeight <= 0) {
+        return toImage();
+    }
+
+    // 整数倍缩小时盒式平均的每个输出像素只取自对应的 factor × factor 块，
+    // 按 factor 的整数倍行分段缩小再拼接，结果与整幅缩小一致
+    const int factor = (m_height + maxHeight - 1) / maxHeight;
+    const int width = qMax(1, m_width / factor);
+    const int bandRows = qMax(1, m_tileRows / factor) * factor;
+    QImage result(width, (m_height + factor - 1) / factor, m_format);
+    if (result.isNull()) {
+        qWarning() << "[TiledImage] Failed to allocate preview" << width << "x" << result.height();
+        return QImage();
+    }
+
+    QPainter painter(&result);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (int y = 0; y < m_height; y += bandRows) {
+        const QImage band = copy(y, qMin(bandRows, m_height - y));
+        if (band.isNull()) {
+            return QImage();
+        }
+        const QSize size(width, (band.height() + factor - 1) / factor);
+        QImage scaled = ImageResampler::resample(band, size, ImageResampler::FilterBox);
+        scaled.setDevicePixelRatio(1.0);
+        painter.drawImage(0, y / factor, scaled);
+    }
+    painter.end();
+
+    result.setDevicePixelRatio(m_devicePixelRatio);
+    return result;
+}
+
+void TiledImage::clear() {
+    m_tiles.clear();
+    m_height = 0;
+    m_firstResident = 0;
+    if (m_spillFile.isOpen()) {
+        m_spillFile.resize(0);
+    }
+}
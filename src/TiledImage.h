@@ -0,0 +1,153 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file TiledImage.h
+ * @brief 按行追加的分块图像
+ *
+ * 图像按固定行数切分为分块，只在内存中保留最近的若干分块，
+ * 较早的分块写入临时文件，追加任意多行时内存占用保持不变
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef TILEDIMAGE_H
+#define TILEDIMAGE_H
+
+#include <QImage>
+#include <QVector>
+#include <QTemporaryFile>
+
+/**
+ * @class TiledImage
+ * @brief 按行追加的分块图像（宽度固定，高度只增不减）
+ *
+ * - 只支持32位像素格式（RGB32 / ARGB32 / ARGB32_Premultiplied）
+ * - 常驻分块数超过上限时，最旧的已写满分块落盘到临时文件
+ * - copy()/toImage() 从内存或临时文件读回任意行区间
+ */
+class TiledImage
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param width 图像宽度（像素）
+     * @param format 像素格式（32位）
+     * @param tileRows 每个分块的行数
+     * @param maxResidentTiles 内存中最多保留的分块数
+     */
+    TiledImage(int width, QImage::Format format, int tileRows = 512, int maxResidentTiles = 8);
+    ~TiledImage();
+
+    TiledImage(const TiledImage &) = delete;
+    TiledImage &operator=(const TiledImage &) = delete;
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    QImage::Format format() const { return m_format; }
+
+    /**
+     * @brief 设置设备像素比（copy()/toImage()的结果带此DPR）
+     */
+    void setDevicePixelRatio(qreal dpr) { m_devicePixelRatio = dpr; }
+    qreal devicePixelRatio() const { return m_devicePixelRatio; }
+
+    /**
+     * @brief 当前常驻内存的像素字节数
+     */
+    qint64 residentBytes() const;
+
+    /**
+     * @brief 追加若干行
+     * @param bits 第一行像素指针（宽度需等于图像宽度）
+     * @param stride 源行跨度（字节）
+     * @param rows 行数
+     * @return 是否成功（落盘失败时返回false）
+     */
+    bool appendRows(const uchar *bits, qsizetype stride, int rows);
+
+    /**
+     * @brief 追加图像中的若干行
+     * @param image 源图像（宽度与格式需与本图像一致）
+     * @param y 起始行
+     * @param rows 行数
+     * @return 是否成功
+     */
+    bool appendRows(const QImage &image, int y, int rows);
+
+    /**
+     * @brief 复制行区间为独立图像
+     * @param y 起始行
+     * @param rows 行数
+     * @return 图像（失败时为空）
+     */
+    QImage copy(int y, int rows) const;
+
+    /**
+     * @brief 合成完整图像
+     */
+    QImage toImage() const { return copy(0, m_height); }
+
+    /**
+     * @brief 按整数倍缩小为预览图（分段读回后盒式平均，不合成整幅原图）
+     * @param maxHeight 预览图最大高度（像素）
+     * @return 预览图（高度不超过 maxHeight 时为完整原图，DPR与本图像相同）
+     */
+    QImage preview(int maxHeight) const;
+
+    /**
+     * @brief 清空所有行并删除临时文件
+     */
+    void clear();
+
+private:
+    /**
+     * @brief 分块：常驻内存或已落盘
+     */
+    struct Tile {
+        QImage image;               ///< 常驻像素（落盘后为空）
+        qint64 spillOffset = -1;    ///< 临时文件中的偏移（-1表示未落盘）
+    };
+
+    qsizetype rowBytes() const { return qsizetype(m_width) * 4; }
+
+    /**
+     * @brief 将超出常驻上限的最旧分块写入临时文件
+     */
+    bool spillOldTiles();
+
+    /**
+     * @brief 读取一个分块中的若干行
+     */
+    bool readRows(int tileIndex, int firstRow, int rows, uchar *dst, qsizetype dstStride) const;
+
+private:
+    int m_width;                        ///< 宽度（像素）
+    QImage::Format m_format;            ///< 像素格式
+    int m_tileRows;                     ///< 每块行数
+    int m_maxResidentTiles;             ///< 常驻分块上限
+    int m_height;                       ///< 当前高度
+    int m_firstResident;                ///< 第一个常驻分块的索引
+    qreal m_devicePixelRatio;           ///< 设备像素比
+    QVector<Tile> m_tiles;              ///< 分块
+    mutable QTemporaryFile m_spillFile; ///< 落盘文件（首次落盘时创建）
+};
+
+#endif // TILEDIMAGE_H
@@ -0,0 +1,320 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file XShmFrameSource.cpp
+ * @brief X11共享内存帧来源实现
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#include "XShmFrameSource.h"
+#include "SimdSupport.h"
+#include <QGuiApplication>
+#include <QAtomicInt>
+#include <QMutexLocker>
+#include <QDebug>
+
+// X11头文件定义了大量宏（Bool、Status、None…），放在所有Qt头文件之后
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+namespace {
+
+constexpr int kMaxPooledSegments = 3;       ///< 池中保留的内存段数
+
+/// 内存段状态
+enum SegmentState {
+    SegmentFree = 0,        ///< 空闲，可复用
+    SegmentInUse,           ///< 被QImage引用
+    SegmentOrphaned         ///< 被QImage引用，但已不属于任何池，释放时直接销毁
+};
+
+int s_xError = 0;
+
+int recordXError(Display *, XErrorEvent *event)
+{
+    s_xError = event->error_code;
+    return 0;
+}
+
+/**
+ * @brief 临时安装X错误处理器：默认处理器遇到错误会直接退出进程
+ */
+class XErrorTrap
+{
+public:
+    explicit XErrorTrap(Display *display)
+        : m_display(display)
+    {
+        XSync(m_display, False);
+        s_xError = 0;
+        m_previous = XSetErrorHandler(recordXError);
+    }
+    ~XErrorTrap()
+    {
+        XSync(m_display, False);
+        XSetErrorHandler(m_previous);
+    }
+    bool failed() const
+    {
+        XSync(m_display, False);
+        return s_xError != 0;
+    }
+
+private:
+    Display *m_display;
+    int (*m_previous)(Display *, XErrorEvent *);
+};
+
+/**
+ * @brief 24位色深的X图像alpha字节未定义，补成0xFF以符合Format_RGB32
+ */
+void forceOpaque(uchar *bits, qsizetype stride, int width, int height)
+{
+    for (int y = 0; y < height; ++y) {
+        quint32 *row = reinterpret_cast<quint32 *>(bits + y * stride);
+        int x = 0;
+#if defined(CAPSTEP_SIMD_SSE2)
+        if (SimdSupport::hasSse2()) {
+            const __m128i alpha = _mm_set1_epi32(int(0xff000000u));
+            for (; x + 4 <= width; x += 4) {
+                __m128i *p = reinterpret_cast<__m128i *>(row + x);
+                _mm_storeu_si128(p, _mm_or_si128(_mm_loadu_si128(p), alpha));
+            }
+        }
+#endif
+        for (; x < width; ++x) {
+            row[x] |= 0xff000000u;
+        }
+    }
+}
+
+} // namespace
+
+struct XShmFrameSource::Segment {
+    XShmSegmentInfo info;       ///< 共享内存段
+    qsizetype capacity = 0;     ///< 容量（字节）
+    QAtomicInt state;           ///< SegmentState
+};
+
+XShmFrameSource *XShmFrameSource::create() {
+    Display *display = XOpenDisplay(nullptr);
+    if (!display) {
+        qDebug() << "[XShm] Cannot open X display";
+        return nullptr;
+    }
+    if (!XShmQueryExtension(display)) {
+        qDebug() << "[XShm] MIT-SHM extension not available";
+        XCloseDisplay(display);
+        return nullptr;
+    }
+
+    const Window root = DefaultRootWindow(display);
+    XWindowAttributes attributes;
+    if (!XGetWindowAttributes(display, root, &attributes)) {
+        XCloseDisplay(display);
+        return nullptr;
+    }
+    // 只支持 32 位/像素、BGRX 排列的真彩色，与 QImage::Format_RGB32 一致
+    Visual *visual = attributes.visual;
+    if ((attributes.depth != 24 && attributes.depth != 32) || !visual
+        || visual->red_mask != 0xff0000 || visual->green_mask != 0xff00 || visual->blue_mask != 0xff
+        || ImageByteOrder(display) != LSBFirst) {
+        qDebug() << "[XShm] Unsupported root visual, depth:" << attributes.depth;
+        XCloseDisplay(display);
+        return nullptr;
+    }
+
+    qDebug() << "[XShm] Root window" << attributes.width << "x" << attributes.height << "depth" << attributes.depth;
+    return new XShmFrameSource(display, root, attributes.width, attributes.height, attributes.depth, visual);
+}
+
+XShmFrameSource::XShmFrameSource(_XDisplay *display, unsigned long root, int width, int height, int depth, void *visual)
+    : m_display(display)
+    , m_root(root)
+    , m_rootWidth(width)
+    , m_rootHeight(height)
+    , m_depth(depth)
+    , m_visual(visual)
+    , m_segments()
+{
+}
+
+XShmFrameSource::~XShmFrameSource()
+{
+    for (Segment *segment : m_segments) {
+        XShmDetach(m_display, &segment->info);
+        // 仍被QImage引用的内存段交给清理回调销毁
+        if (segment->state.testAndSetOrdered(SegmentInUse, SegmentOrphaned)) {
+            continue;
+        }
+        shmdt(segment->info.shmaddr);
+        delete segment;
+    }
+    m_segments.clear();
+    XCloseDisplay(m_display);
+}
+
+QList<FrameSource::Screen> XShmFrameSource::screens() const {
+    // xcb平台下与Qt的屏幕布局一致；其他平台（如 offscreen + Xvfb）把根窗口视为单个屏幕
+    if (QGuiApplication::platformName() == "xcb") {
+        return FrameSource::screens();
+    }
+    Screen screen;
+    screen.name = "x11-root";
+    screen.geometry = QRect(0, 0, m_rootWidth, m_rootHeight);
+    return QList<Screen>() << screen;
+}
+
+XShmFrameSource::Segment *XShmFrameSource::acquireSegment(qsizetype bytes) {
+    for (Segment *segment : m_segments) {
+        if (segment->capacity >= bytes && segment->state.testAndSetOrdered(SegmentFree, SegmentInUse)) {
+            return segment;
+        }
+    }
+
+    // 空闲但容量不足的内存段（屏幕或选区变大）直接换掉
+    for (int i = 0; i < m_segments.size(); ++i) {
+        Segment *small = m_segments.at(i);
+        if (small->state.testAndSetOrdered(SegmentFree, SegmentInUse)) {
+            XShmDetach(m_display, &small->info);
+            XSync(m_display, False);
+            shmdt(small->info.shmaddr);
+            delete small;
+            m_segments.removeAt(i);
+            break;
+        }
+    }
+
+    Segment *segment = new Segment;
+    segment->capacity = bytes;
+    segment->info.shmid = shmget(IPC_PRIVATE, size_t(bytes), IPC_CREAT | 0600);
+    if (segment->info.shmid < 0) {
+        qWarning() << "[XShm] shmget failed for" << bytes << "bytes";
+        delete segment;
+        return nullptr;
+    }
+    segment->info.shmaddr = static_cast<char *>(shmat(segment->info.shmid, nullptr, 0));
+    segment->info.readOnly = False;
+    // 立即标记删除：所有附着方分离后系统自动回收，进程崩溃也不会泄漏
+    shmctl(segment->info.shmid, IPC_RMID, nullptr);
+    if (segment->info.shmaddr == reinterpret_cast<char *>(-1)) {
+        qWarning() << "[XShm] shmat failed";
+        delete segment;
+        return nullptr;
+    }
+
+    XErrorTrap trap(m_display);
+    XShmAttach(m_display, &segment->info);
+    if (trap.failed()) {
+        qWarning() << "[XShm] XShmAttach failed";
+        shmdt(segment->info.shmaddr);
+        delete segment;
+        return nullptr;
+    }
+
+    if (m_segments.size() < kMaxPooledSegments) {
+        segment->state.storeRelaxed(SegmentInUse);
+        m_segments.append(segment);
+    } else {
+        // 池已满：一次性内存段，释放时销毁
+        segment->state.storeRelaxed(SegmentOrphaned);
+    }
+    return segment;
+}
+
+void XShmFrameSource::releaseSegment(void *opaque) {
+    Segment *segment = static_cast<Segment *>(opaque);
+    if (segment->state.testAndSetOrdered(SegmentInUse, SegmentFree)) {
+        return;
+    }
+    // 已不属于任何池：X连接可能已关闭，只需分离本进程的映射
+    shmdt(segment->info.shmaddr);
+    delete segment;
+}
+
+QImage XShmFrameSource::grabScreen(int screenIndex, const QRect &localRect) {
+    const QList<Screen> all = screens();
+    if (screenIndex < 0 || screenIndex >= all.size()) {
+        return QImage();
+    }
+    return grabScreenAt(all.at(screenIndex), localRect);
+}
+
+QImage XShmFrameSource::grabScreenAt(const Screen &screen, const QRect &localRect) {
+    // Qt6：屏幕左上角为原生坐标，屏幕内区域按DPR换算
+    QRect deviceRect = toDeviceRect(screen, localRect).translated(screen.geometry.topLeft());
+    deviceRect = deviceRect.intersected(QRect(0, 0, m_rootWidth, m_rootHeight));
+    if (deviceRect.isEmpty()) {
+        return QImage();
+    }
+
+    // Xlib连接不是线程安全的，X错误处理器也是进程全局的
+    QMutexLocker locker(&m_mutex);
+    const int width = deviceRect.width();
+    const int height = deviceRect.height();
+    Segment *segment = acquireSegment(qsizetype(width) * height * 4);
+    if (!segment) {
+        return QImage();
+    }
+
+    XImage *image = XShmCreateImage(m_display, static_cast<Visual *>(m_visual), unsigned(m_depth), ZPixmap,
+                                    segment->info.shmaddr, &segment->info, unsigned(width), unsigned(height));
+    if (!image) {
+        releaseSegment(segment);
+        return QImage();
+    }
+
+    bool ok = image->bits_per_pixel == 32;
+    if (ok) {
+        XErrorTrap trap(m_display);
+        ok = XShmGetImage(m_display, m_root, image, deviceRect.x(), deviceRect.y(), AllPlanes) && !trap.failed();
+    }
+    const qsizetype stride = image->bytes_per_line;
+    // 数据属于共享内存段，XDestroyImage 只能释放结构体本身
+    image->data = nullptr;
+    XDestroyImage(image);
+
+    // 一次性内存段抓取后立即让服务器分离（释放回调可能在其他线程，不能再调用Xlib）
+    if (!m_segments.contains(segment)) {
+        XShmDetach(m_display, &segment->info);
+        XSync(m_display, False);
+    }
+
+    if (!ok) {
+        qWarning() << "[XShm] XShmGetImage failed for" << deviceRect;
+        releaseSegment(segment);
+        return QImage();
+    }
+
+    uchar *bits = reinterpret_cast<uchar *>(segment->info.shmaddr);
+    if (m_depth == 24) {
+        forceOpaque(bits, stride, width, height);
+    }
+
+    // 直接引用共享内存，QImage释放时内存段回到池中
+    QImage result(bits, width, height, stride, QImage::Format_RGB32, &XShmFrameSource::releaseSegment, segment);
+    result.setDevicePixelRatio(screen.devicePixelRatio);
+    return result;
+}
@@ -0,0 +1,91 @@
+/*
+ * CapStep - Smart Screenshot Tool
+ * Copyright (C) 2024-2025 CapStep Development Team
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file XShmFrameSource.h
+ * @brief X11共享内存帧来源
+ *
+ * 仅在 CMake 找到 X11 与 XShm 扩展时编译（CAPSTEP_HAVE_XSHM）
+ *
+ * @author CapStep Team
+ * @version 1.0.0
+ * @date 2026-10-17
+ */
+
+#ifndef XSHMFRAMESOURCE_H
+#define XSHMFRAMESOURCE_H
+
+#include "FrameSource.h"
+#include <QList>
+#include <QMutex>
+
+struct _XDisplay;
+
+/**
+ * @class XShmFrameSource
+ * @brief X11共享内存帧来源
+ *
+ * X服务器通过 XShmGetImage 把根窗口像素直接写入共享内存段，
+ * 返回的QImage直接引用该内存段（不再复制），QImage释放后内存段回到池中复用。
+ * 使用独立的X连接，不依赖Qt的平台插件，因此在 offscreen 平台 + Xvfb 下同样可用。
+ * 连接和内存段池由互斥锁保护，grabScreenAt() 可以在工作线程调用
+ */
+class XShmFrameSource : public FrameSource
+{
+public:
+    /**
+     * @brief 创建实例
+     * @return 实例（无法连接X服务器或不支持XShm时返回nullptr）
+     */
+    static XShmFrameSource *create();
+
+    ~XShmFrameSource() override;
+
+    Kind kind() const override { return KindXShm; }
+    QList<Screen> screens() const override;
+    QImage grabScreen(int screenIndex, const QRect &localRect = QRect()) override;
+    QImage grabScreenAt(const Screen &screen, const QRect &localRect = QRect()) override;
+    bool isThreadSafe() const override { return true; }
+
+private:
+    struct Segment;
+
+    XShmFrameSource(_XDisplay *display, unsigned long root, int width, int height, int depth, void *visual);
+
+    /**
+     * @brief 取一个容量足够的空闲内存段（没有时新建，调用方持有 m_mutex）
+     */
+    Segment *acquireSegment(qsizetype bytes);
+
+    /**
+     * @brief 释放内存段（QImage清理回调，可在任意线程调用）
+     */
+    static void releaseSegment(void *segment);
+
+private:
+    _XDisplay *m_display;           ///< 独立的X连接
+    unsigned long m_root;           ///< 根窗口
+    int m_rootWidth;                ///< 根窗口宽度（设备像素）
+    int m_rootHeight;               ///< 根窗口高度（设备像素）
+    int m_depth;                    ///< 根窗口色深
+    void *m_visual;                 ///< 根窗口Visual
+    QList<Segment*> m_segments;     ///< 内存段池
+    QMutex m_mutex;                 ///< 保护X连接和内存段池（抓取可能来自工作线程）
+};
+
+#endif // XSHMFRAMESOURCE_H
@@ -34,11 +34,155 @@
 #include <QLockFile>
 #include <QDir>
 #include <QLocalSocket>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QBuffer>
+#include <cstdio>
+#include <algorithm>
 
 // 模块化头文件
 #include "MainWindow.h"
 #include "ScreenshotTool.h"
 #include "GlobalHotkey.h"
+#include "FrameSource.h"
+#include "CapturePipeline.h"
+#include "HistoryIndex.h"
+#include "ScrollStitcher.h"
+#include "PngEncoder.h"
+
+/**
+ * @brief 抓屏基准：逐屏整屏抓取若干次，输出耗时统计
+ * @param iterations 每个屏幕的抓取次数
+ * @return 进程退出码
+ */
+static int runCaptureBenchmark(int iterations)
+{
+    FrameSource *source = FrameSource::current();
+    const QList<FrameSource::Screen> screens = source->screens();
+    printf("frame source: %s, screens: %d, iterations: %d\n",
+           qPrintable(FrameSource::kindName(source->kind())), int(screens.size()), iterations);
+
+    for (int i = 0; i < screens.size(); ++i) {
+        QVector<double> samples;
+        QSize size;
+        for (int n = 0; n < iterations; ++n) {
+            QElapsedTimer timer;
+            timer.start();
+            const QImage image = source->grabScreen(i);
+            samples.append(timer.nsecsElapsed() / 1e6);
+            if (image.isNull()) {
+                fprintf(stderr, "screen %d: grab failed\n", i);
+                return 1;
+            }
+            size = image.size();
+        }
+        std::sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (double ms : samples) {
+            total += ms;
+        }
+        const double mean = total / samples.size();
+        printf("screen %d (%s) %dx%d: min %.2f ms, median %.2f ms, mean %.2f ms, %.1f MPix/s\n",
+               i, qPrintable(screens.at(i).name), size.width(), size.height(),
+               samples.first(), samples.at(samples.size() / 2), mean,
+               double(size.width()) * size.height() / (mean * 1e3));
+    }
+    return 0;
+}
+
+/**
+ * @brief 长截图自检：合成画面模拟滚动，检查拼接高度、逐行像素和按段PNG编码（无需显示器）
+ * @return 进程退出码
+ */
+static int runScrollSelfTest()
+{
+    SyntheticFrameSource source;
+    FrameSource::Screen screen;
+    screen.name = "synthetic";
+    screen.geometry = QRect(0, 0, 640, 480);
+    source.setScreens(QList<FrameSource::Screen>() << screen);
+
+    // 每帧相对上一帧的滚动距离（0为未滚动）：都小于区域高度的一半，且不小于合成画面渐变的16行周期，
+    // 避免顶部/底部的空白行恰好相同而被当成固定区域
+    const QRect region(40, 60, 320, 240);
+    const int steps[] = {0, 37, 80, 80, 0, 45, 64, 72, 100, 53};
+    ScrollStitcher stitcher;
+    ScrollStitcher capped(400);
+    int offset = 0;
+    for (int step : steps) {
+        offset += step;
+        source.setScrollOffset(offset);
+        const QImage frame = source.grabScreen(0, region);
+        stitcher.addFrame(frame);
+        capped.addFrame(frame);
+    }
+    stitcher.finish();
+    capped.finish();
+
+    const QSharedPointer<TiledImage> result = stitcher.result();
+    const int expectedHeight = region.height() + offset;
+    if (!result || result->width() != region.width() || result->height() != expectedHeight) {
+        fprintf(stderr, "scroll stitch: expected %dx%d, got %dx%d\n", region.width(), expectedHeight,
+                result ? result->width() : 0, result ? result->height() : 0);
+        return 1;
+    }
+
+    // 第y行应是合成画面在滚动偏移0时区域内的第y行
+    const int bandRows = 100;
+    for (int y = 0; y < result->height(); y += bandRows) {
+        const QImage band = result->copy(y, bandRows);
+        for (int row = 0; row < band.height(); ++row) {
+            const quint32 *pixels = reinterpret_cast<const quint32 *>(band.constScanLine(row));
+            for (int x = 0; x < band.width(); ++x) {
+                if (pixels[x] != SyntheticFrameSource::pixelAt(region.x() + x, region.y() + y + row)) {
+                    fprintf(stderr, "scroll stitch: row %d differs at x=%d\n", y + row, x);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    const QSharedPointer<TiledImage> cappedResult = capped.result();
+    if (!cappedResult || cappedResult->height() != 400) {
+        fprintf(stderr, "scroll stitch: capped height %d, expected 400\n", cappedResult ? cappedResult->height() : 0);
+        return 1;
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    if (!PngEncoder::write(*result, &buffer)) {
+        fprintf(stderr, "scroll stitch: banded PNG encode failed\n");
+        return 1;
+    }
+    const QImage decoded = QImage::fromData(buffer.data(), "PNG");
+    if (decoded.convertToFormat(QImage::Format_RGB32) != result->toImage().convertToFormat(QImage::Format_RGB32)) {
+        fprintf(stderr, "scroll stitch: banded PNG does not round-trip\n");
+        return 1;
+    }
+
+    printf("scroll stitch: %d frames, %dx%d, capped %d, PNG %lld bytes: OK\n", int(sizeof(steps) / sizeof(steps[0])),
+           result->width(), result->height(), cappedResult->height(), qint64(buffer.size()));
+    return 0;
+}
+
+/**
+ * @brief 离线重写历史索引（没有运行中的实例时使用）
+ * @return 进程退出码
+ */
+static int runHistoryCompaction()
+{
+    const QString folder = CapturePipeline::historyFolderPath();
+    HistoryIndex index(folder);
+    int added = 0;
+    int dropped = 0;
+    if (!index.open(true) || !index.compact(&added, &dropped)) {
+        fprintf(stderr, "Failed to rebuild history index in %s\n", qPrintable(folder));
+        return 1;
+    }
+    printf("history index: %d records, %d added, %d dropped\n", index.count(), added, dropped);
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
@@ -49,6 +193,61 @@ int main(int argc, char *argv[])
     app.setApplicationVersion("0.1.3");
     app.setOrganizationName("CapStep Team");
     
+    // 查询运行中实例的热路径统计：--metrics / --metrics-json / --metrics-dump <path>
+    QByteArray instanceCommand;
+    int benchIterations = 0;
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        if (args[i] == "--frame-source" && i + 1 < args.size()) {
+            // 抓屏后端：qt / xshm / synthetic（也可用 CAPSTEP_FRAME_SOURCE 环境变量）
+            bool ok = false;
+            const FrameSource::Kind kind = FrameSource::kindFromName(args[++i], &ok);
+            if (!ok || !FrameSource::setCurrent(kind)) {
+                fprintf(stderr, "Frame source %s is not available\n", qPrintable(args[i]));
+                return 1;
+            }
+        } else if (args[i] == "--selftest-scroll") {
+            return runScrollSelfTest();
+        } else if (args[i] == "--bench-capture") {
+            benchIterations = (i + 1 < args.size() && args[i + 1].toInt() > 0) ? args[++i].toInt() : 50;
+        } else if (args[i] == "--metrics") {
+            instanceCommand = "METRICS";
+        } else if (args[i] == "--metrics-json") {
+            instanceCommand = "METRICS_JSON";
+        } else if (args[i] == "--metrics-dump" && i + 1 < args.size()) {
+            instanceCommand = "METRICS_DUMP " + QFileInfo(args[++i]).absoluteFilePath().toUtf8();
+        } else if (args[i] == "--compact-history") {
+            // 运行中的实例由其历史写入线程执行，否则在本进程内离线执行
+            instanceCommand = "HISTORY_COMPACT";
+        }
+    }
+    if (benchIterations > 0) {
+        return runCaptureBenchmark(benchIterations);
+    }
+    if (!instanceCommand.isEmpty()) {
+        QLocalSocket socket;
+        socket.connectToServer("CapStepInstance");
+        if (!socket.waitForConnected(1000)) {
+            if (instanceCommand == "HISTORY_COMPACT") {
+                return runHistoryCompaction();
+            }
+            fprintf(stderr, "CapStep is not running: %s\n", qPrintable(socket.errorString()));
+            return 1;
+        }
+        socket.write(instanceCommand);
+        socket.flush();
+        
+        // 读取回复直到对方断开
+        QByteArray reply;
+        while (socket.state() == QLocalSocket::ConnectedState && socket.waitForReadyRead(2000)) {
+            reply += socket.readAll();
+        }
+        reply += socket.readAll();
+        fwrite(reply.constData(), 1, size_t(reply.size()), stdout);
+        fflush(stdout);
+        return reply.startsWith("ERROR") ? 1 : 0;
+    }
+    
     // 单实例锁文件 - 防止多次启动
     QString lockFilePath = QDir::temp().absoluteFilePath("CapStep.lock");
     QLockFile lockFile(lockFilePath);